@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+
+#
+# Times preview PNG exports of the test models, with the size of their
+# normalized CSG trees, to compare the CSG normalization of two builds.
+#
+# Usage: benchmark-csg-normalization.py [--runs N] [--filter REGEX] <openscad> [<openscad>...]
+#
+# Run from the source directory. With several executables, their times are
+# listed side by side, and models with a different number of normalized
+# elements or warnings about the normalization limit are marked.
+#
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+ELEMENTS_RE = re.compile(r'Normalized CSG tree has (\d+) elements')
+ABORTED_RE = re.compile(r'(Normalized tree (?:is growing|would grow) past \d+ elements)')
+
+def find_models(root, pattern):
+    models = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            path = os.path.join(dirpath, filename)
+            if filename.endswith('.scad') and (not pattern or pattern.search(path)):
+                models.append(path)
+    return models
+
+# Returns the best time of several runs, the number of normalized elements and whether normalization was aborted
+def run(openscad, model, runs, outdir):
+    output = os.path.join(outdir, re.sub(r'[^\w.-]', '_', model) + '.png')
+    best = None
+    elements = None
+    aborted = False
+    for _ in range(runs):
+        start = time.perf_counter()
+        try:
+            result = subprocess.run([openscad, '--preview', '-o', output, model],
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.PIPE,
+                                    text=True, timeout=600)
+        except subprocess.TimeoutExpired:
+            return None, None, False
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            return None, None, False
+        best = elapsed if best is None else min(best, elapsed)
+        match = ELEMENTS_RE.search(result.stderr)
+        elements = int(match.group(1)) if match else None
+        aborted = ABORTED_RE.search(result.stderr) is not None
+    return best, elements, aborted
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark CSG normalization over the preview test models')
+    parser.add_argument('openscad', nargs='+', help='OpenSCAD executables to compare')
+    parser.add_argument('--models', default=os.path.join('tests', 'data', 'scad'), help='Directory of the models')
+    parser.add_argument('--filter', help='Only run models whose path matches this regular expression')
+    parser.add_argument('--runs', type=int, default=3, help='Runs per model, of which the fastest is used')
+    args = parser.parse_args()
+
+    models = find_models(args.models, re.compile(args.filter) if args.filter else None)
+    if not models:
+        print('No models found in ' + args.models, file=sys.stderr)
+        return 1
+
+    totals = [0.0] * len(args.openscad)
+    with tempfile.TemporaryDirectory() as outdir:
+        for model in models:
+            # One at a time, so the timings don't interfere
+            results = [run(openscad, model, args.runs, outdir) for openscad in args.openscad]
+            columns = []
+            for i, (elapsed, elements, aborted) in enumerate(results):
+                if elapsed is None:
+                    columns.append('%10s %8s' % ('failed', ''))
+                    continue
+                totals[i] += elapsed
+                columns.append('%9.3fs %8s' % (elapsed, 'aborted' if aborted else elements if elements is not None else '-'))
+            differs = len(set((r[1], r[2]) for r in results)) > 1
+            print('%-60s %s%s' % (os.path.relpath(model, args.models), ' '.join(columns), '  *' if differs else ''))
+            sys.stdout.flush()
+
+    print('%-60s %s' % ('Total', ' '.join('%9.3fs %8s' % (total, '') for total in totals)))
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
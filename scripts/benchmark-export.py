@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+
+#
+# Times ASCII mesh exports of a generated model, to compare the text
+# exporters of two builds.
+#
+# Usage: benchmark-export.py [--runs N] [--fn N] [--formats asciistl,obj,...] <openscad> [<openscad>...]
+#
+# Each format is exported from the same model. Binary STL is exported too,
+# as a reference for the time spent outside of formatting. With several
+# executables, their times are listed side by side, and formats whose output
+# differs between them are marked.
+#
+
+import argparse
+import filecmp
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+SUFFIXES = {'asciistl': 'stl', 'binstl': 'stl', 'obj': 'obj', 'off': 'off', 'wrl': 'wrl', 'amf': 'amf'}
+
+# Returns the best time of several runs
+def run(openscad, model, export_format, output, runs, extra_args):
+    best = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        try:
+            result = subprocess.run([openscad, '--enable=predictible-output', '--export-format', export_format,
+                                     '-o', output, model] + extra_args,
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=600)
+        except subprocess.TimeoutExpired:
+            return None
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            return None
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark ASCII mesh exports')
+    parser.add_argument('openscad', nargs='+', help='OpenSCAD executables to compare')
+    parser.add_argument('--formats', default='binstl,asciistl,obj,off,wrl,amf', help='Comma separated export formats')
+    parser.add_argument('--fn', type=int, default=800, help='$fn of the exported sphere; it has about $fn^2 triangles')
+    parser.add_argument('--backend', help='Rendering backend passed to OpenSCAD')
+    parser.add_argument('--runs', type=int, default=3, help='Runs per format, of which the fastest is used')
+    args = parser.parse_args()
+    extra_args = ['--backend=' + args.backend] if args.backend else []
+
+    with tempfile.TemporaryDirectory() as outdir:
+        model = os.path.join(outdir, 'model.scad')
+        with open(model, 'w') as f:
+            f.write('sphere(r=50, $fn=%d);\n' % args.fn)
+        for export_format in args.formats.split(','):
+            outputs = [os.path.join(outdir, '%s-%d.%s' % (export_format, i, SUFFIXES[export_format]))
+                       for i in range(len(args.openscad))]
+            # One at a time, so the timings don't interfere
+            times = [run(openscad, model, export_format, output, args.runs, extra_args)
+                     for openscad, output in zip(args.openscad, outputs)]
+            columns = ['%9.3fs' % t if t is not None else '%10s' % 'failed' for t in times]
+            written = [output for output, t in zip(outputs, times) if t is not None]
+            differs = any(not filecmp.cmp(written[0], other, shallow=False) for other in written[1:])
+            print('%-10s %s%s' % (export_format, ' '.join(columns), '  * output differs' if differs else ''))
+            sys.stdout.flush()
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+
+#
+# Times OBJ, OFF and STL imports of generated meshes, to compare the
+# importers of two builds.
+#
+# Usage: benchmark-import.py [--runs N] [--size N] [--formats obj,off,stl] <openscad> [<openscad>...]
+#
+# The mesh is a closed, triangulated grid with about 4*size^2 faces, written
+# in each format. Every import is exported to binary STL. With several
+# executables, their times are listed side by side, and formats whose
+# output differs between them are marked.
+#
+
+import argparse
+import filecmp
+import math
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# Returns the vertices and triangles of a torus, with size^2 * 4 triangles
+def torus(size):
+    vertices = []
+    for i in range(size * 2):
+        u = 2 * math.pi * i / (size * 2)
+        for j in range(size):
+            v = 2 * math.pi * j / size
+            r = 30 + 10 * math.cos(v)
+            vertices.append((r * math.cos(u), r * math.sin(u), 10 * math.sin(v)))
+    faces = []
+    for i in range(size * 2):
+        for j in range(size):
+            a = i * size + j
+            b = ((i + 1) % (size * 2)) * size + j
+            c = ((i + 1) % (size * 2)) * size + (j + 1) % size
+            d = i * size + (j + 1) % size
+            faces.append((a, b, c))
+            faces.append((a, c, d))
+    return vertices, faces
+
+def write_obj(filename, vertices, faces):
+    with open(filename, 'w') as f:
+        f.write('# Generated by benchmark-import.py\n')
+        f.writelines('v %.9g %.9g %.9g\n' % v for v in vertices)
+        f.writelines('f %d %d %d\n' % (a + 1, b + 1, c + 1) for a, b, c in faces)
+
+def write_off(filename, vertices, faces):
+    with open(filename, 'w') as f:
+        f.write('OFF\n%d %d 0\n' % (len(vertices), len(faces)))
+        f.writelines('%.9g %.9g %.9g\n' % v for v in vertices)
+        f.writelines('3 %d %d %d\n' % face for face in faces)
+
+def write_stl(filename, vertices, faces):
+    with open(filename, 'w') as f:
+        f.write('solid benchmark\n')
+        for face in faces:
+            f.write('facet normal 0 0 0\nouter loop\n')
+            f.writelines('vertex %.9g %.9g %.9g\n' % vertices[i] for i in face)
+            f.write('endloop\nendfacet\n')
+        f.write('endsolid benchmark\n')
+
+WRITERS = {'obj': write_obj, 'off': write_off, 'stl': write_stl}
+
+# Returns the best time of several runs
+def run(openscad, model, output, runs):
+    best = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        try:
+            result = subprocess.run([openscad, '--export-format', 'binstl', '-o', output, model],
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=600)
+        except subprocess.TimeoutExpired:
+            return None
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            return None
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark mesh imports')
+    parser.add_argument('openscad', nargs='+', help='OpenSCAD executables to compare')
+    parser.add_argument('--formats', default='obj,off,stl', help='Comma separated import formats')
+    parser.add_argument('--size', type=int, default=300, help='Size of the generated mesh, which has 4*size^2 faces')
+    parser.add_argument('--runs', type=int, default=3, help='Runs per format, of which the fastest is used')
+    args = parser.parse_args()
+
+    vertices, faces = torus(args.size)
+    print('%d vertices, %d faces' % (len(vertices), len(faces)))
+    with tempfile.TemporaryDirectory() as outdir:
+        for fmt in args.formats.split(','):
+            meshfile = os.path.join(outdir, 'mesh.' + fmt)
+            WRITERS[fmt](meshfile, vertices, faces)
+            model = os.path.join(outdir, 'import-' + fmt + '.scad')
+            with open(model, 'w') as f:
+                f.write('import("%s");\n' % meshfile.replace('\\', '/'))
+            outputs = [os.path.join(outdir, '%s-%d.stl' % (fmt, i)) for i in range(len(args.openscad))]
+            # One at a time, so the timings don't interfere
+            times = [run(openscad, model, output, args.runs) for openscad, output in zip(args.openscad, outputs)]
+            columns = ['%9.3fs' % t if t is not None else '%10s' % 'failed' for t in times]
+            written = [output for output, t in zip(outputs, times) if t is not None]
+            differs = any(not filecmp.cmp(written[0], other, shallow=False) for other in written[1:])
+            print('%-6s %s%s' % (fmt, ' '.join(columns), '  * output differs' if differs else ''))
+            sys.stdout.flush()
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+
+#
+# Times projection() exports of generated models with the CGAL and the
+# Manifold backend, and checks that both give the same area.
+#
+# Usage: benchmark-projection.py [--runs N] [--backends cgal,manifold] <openscad> [<openscad>...]
+#
+# With several executables, their times are listed side by side. Models
+# whose projected area differs between builds or backends are marked.
+#
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+# name, model source
+MODELS = [
+    ('tube', '''
+projection() difference() {
+  cylinder(r=20, h=10, $fn=2000);
+  translate([0, 0, -1]) cylinder(r=15, h=12, $fn=2000);
+}'''),
+    ('tube-cut', '''
+projection(cut=true) difference() {
+  cylinder(r=20, h=10, center=true, $fn=2000);
+  cylinder(r=15, h=12, center=true, $fn=2000);
+}'''),
+    ('sphere', 'projection() sphere(r=20, $fn=400);'),
+    ('spheres', '''
+projection() for (i = [0:9], j = [0:9]) translate([i * 15, j * 15, (i + j) % 3 * 5]) sphere(r=10, $fn=60);'''),
+    ('plates', '''
+projection() for (i = [0:99]) translate([i % 10 * 12, floor(i / 10) * 12, i]) difference() {
+  cube([10, 10, 1]);
+  translate([5, 5, -1]) cylinder(r=3, h=3, $fn=48);
+}'''),
+]
+
+# Returns the signed area of the outlines of an SVG exported by OpenSCAD
+def svg_area(svgfile):
+    with open(svgfile) as f:
+        data = f.read()
+    area = 0.0
+    for outline in re.findall(r'M([^z]*)z', data):
+        points = [tuple(float(c) for c in p.split(',')) for p in re.findall(r'[-\d.e+]+,[-\d.e+]+', outline)]
+        for i in range(len(points)):
+            x0, y0 = points[i]
+            x1, y1 = points[(i + 1) % len(points)]
+            area += x0 * y1 - x1 * y0
+    return abs(area / 2)
+
+# Returns the best time of several runs and the projected area
+def run(openscad, backend, model, runs, outdir):
+    output = os.path.join(outdir, os.path.basename(model) + '-' + backend + '.svg')
+    best = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        try:
+            result = subprocess.run([openscad, '--backend=' + backend, '-o', output, model],
+                                    stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=600)
+        except subprocess.TimeoutExpired:
+            return None, None
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            return None, None
+        best = elapsed if best is None else min(best, elapsed)
+    return best, svg_area(output)
+
+def main():
+    parser = argparse.ArgumentParser(description='Benchmark projection() with the CGAL and Manifold backends')
+    parser.add_argument('openscad', nargs='+', help='OpenSCAD executables to compare')
+    parser.add_argument('--backends', default='cgal,manifold', help='Comma separated backends to run')
+    parser.add_argument('--runs', type=int, default=3, help='Runs per model, of which the fastest is used')
+    args = parser.parse_args()
+    backends = args.backends.split(',')
+
+    with tempfile.TemporaryDirectory() as outdir:
+        print('%-12s %s' % ('', ' '.join('%20s' % (os.path.basename(o) + ':' + b) for o in args.openscad for b in backends)))
+        for name, source in MODELS:
+            model = os.path.join(outdir, name + '.scad')
+            with open(model, 'w') as f:
+                f.write(source)
+            # One at a time, so the timings don't interfere
+            results = [run(openscad, backend, model, args.runs, outdir) for openscad in args.openscad for backend in backends]
+            columns = ['%19.3fs' % elapsed if elapsed is not None else '%20s' % 'failed' for elapsed, _ in results]
+            areas = [area for _, area in results if area is not None]
+            differs = areas and max(areas) - min(areas) > 1e-6 * max(1.0, max(areas))
+            print('%-12s %s%s' % (name, ' '.join(columns), '  * area differs' if differs else ''))
+            sys.stdout.flush()
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,7 @@
+#version 120
+
+varying float shading;
+
+void main(void) {
+  gl_FragColor = vec4(gl_Color.rgb * shading, gl_Color.a);
+}
@@ -0,0 +1,15 @@
+#version 120
+
+attribute mat4 instance_matrix; // per instance, transforms the shared vertices of a PolySet
+
+varying float shading;      // multiplied by the vertex color
+
+void main(void) {
+  gl_Position = gl_ModelViewProjectionMatrix * instance_matrix * gl_Vertex;
+  gl_FrontColor = gl_Color;
+  vec3 normal, lightDir;
+  // Exact for rotations and uniform scales, which covers most instances
+  normal = normalize(gl_NormalMatrix * mat3(instance_matrix) * gl_Normal);
+  lightDir = normalize(vec3(gl_LightSource[0].position));
+  shading = 0.2 + abs(dot(normal, lightDir));
+}
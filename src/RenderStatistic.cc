@@ -38,6 +38,8 @@
 #include <vector>
 
 #include "utils/printutils.h"
+#include "core/GlyphCache.h"
+#include "io/ImportCache.h"
 #include "geometry/GeometryCache.h"
 #include "geometry/PolySet.h"
 #include "geometry/Polygon2d.h"
@@ -64,6 +66,7 @@ struct StatisticVisitor : public GeometryVisitor
   virtual void printCamera(const Camera& camera) = 0;
   virtual void printCacheStatistic() = 0;
   virtual void printRenderingTime(std::chrono::milliseconds) = 0;
+  virtual void printExportTimes(const RenderStatistic::ExportTimes&) = 0;
   virtual void finish() = 0;
 protected:
   bool is_enabled(const std::string& name) {
@@ -89,6 +92,7 @@ struct LogVisitor : public StatisticVisitor
   void printCamera(const Camera& camera) override;
   void printCacheStatistic() override;
   void printRenderingTime(std::chrono::milliseconds) override;
+  void printExportTimes(const RenderStatistic::ExportTimes&) override;
   void finish() override;
 private:
   void printBoundingBox3(const BoundingBox& bb);
@@ -113,6 +117,7 @@ struct StreamVisitor : public StatisticVisitor
   void printCamera(const Camera& camera) override;
   void printCacheStatistic() override;
   void printRenderingTime(std::chrono::milliseconds) override;
+  void printExportTimes(const RenderStatistic::ExportTimes&) override;
   void finish() override;
 private:
   nlohmann::json json;
@@ -188,6 +193,11 @@ void RenderStatistic::printRenderingTime()
   visitor.printRenderingTime(ms());
 }
 
+void RenderStatistic::addExportTime(const std::string& filename, std::chrono::milliseconds ms)
+{
+  exportTimes.emplace_back(filename, ms);
+}
+
 void RenderStatistic::printAll(const std::shared_ptr<const Geometry>& geom, const Camera& camera, const std::vector<std::string>& options, const std::string& filename)
 {
   //bool is_log = false;
@@ -203,6 +213,7 @@ void RenderStatistic::printAll(const std::shared_ptr<const Geometry>& geom, cons
 
   visitor->printCacheStatistic();
   visitor->printRenderingTime(ms());
+  visitor->printExportTimes(exportTimes);
   if (geom && !geom->isEmpty()) {
     geom->accept(*visitor);
   }
@@ -310,6 +321,8 @@ void LogVisitor::printCacheStatistic()
 #ifdef ENABLE_CGAL
   CGALCache::instance()->print();
 #endif
+  GlyphCache::instance()->print();
+  ImportCache::instance()->print();
 }
 
 void LogVisitor::printRenderingTime(const std::chrono::milliseconds ms)
@@ -322,6 +335,19 @@ void LogVisitor::printRenderingTime(const std::chrono::milliseconds ms)
       (ms.count() % 1000));
 }
 
+void LogVisitor::printExportTimes(const RenderStatistic::ExportTimes& times)
+{
+  if (is_enabled(RenderStatistic::TIME)) {
+    for (const auto& [filename, ms] : times) {
+      LOG("Export time for %1$s: %2$d:%3$02d:%4$02d.%5$03d", filename,
+          (ms.count() / 1000 / 60 / 60),
+          (ms.count() / 1000 / 60 % 60),
+          (ms.count() / 1000 % 60),
+          (ms.count() % 1000));
+    }
+  }
+}
+
 void LogVisitor::finish()
 {
 }
@@ -418,6 +444,13 @@ void StreamVisitor::printCacheStatistic()
 #ifdef ENABLE_CGAL
     cacheJson["cgal_cache"] = getCache(CGALCache::instance());
 #endif // ENABLE_CGAL
+    const auto *glyph_cache = GlyphCache::instance();
+    nlohmann::json fontCacheJson;
+    fontCacheJson["entries"] = glyph_cache->size();
+    fontCacheJson["bytes"] = glyph_cache->totalCost();
+    fontCacheJson["hits"] = glyph_cache->hits();
+    fontCacheJson["misses"] = glyph_cache->misses();
+    cacheJson["font_cache"] = fontCacheJson;
     json["cache"] = cacheJson;
   }
 }
@@ -440,6 +473,20 @@ void StreamVisitor::printRenderingTime(const std::chrono::milliseconds ms)
   }
 }
 
+void StreamVisitor::printExportTimes(const RenderStatistic::ExportTimes& times)
+{
+  if (is_enabled(RenderStatistic::TIME) && !times.empty()) {
+    nlohmann::json exportsJson = nlohmann::json::array();
+    for (const auto& [filename, ms] : times) {
+      nlohmann::json exportJson;
+      exportJson["file"] = filename;
+      exportJson["total"] = ms.count();
+      exportsJson.push_back(exportJson);
+    }
+    json["time"]["exports"] = exportsJson;
+  }
+}
+
 void StreamVisitor::finish()
 {
   stream << json;
@@ -28,6 +28,7 @@
 #include <memory>
 #include <chrono>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "glview/Camera.h"
@@ -74,11 +75,19 @@ public:
    */
   void printRenderingTime();
 
+  /**
+   * Record the time taken by exporting the given file, for the time summary.
+   */
+  void addExportTime(const std::string& filename, std::chrono::milliseconds ms);
+
   /**
    * Print all available statistic information.
    */
   void printAll(const std::shared_ptr<const Geometry>& geom, const Camera& camera, const std::vector<std::string>& options = {}, const std::string& filename = {});
 
+  using ExportTimes = std::vector<std::pair<std::string, std::chrono::milliseconds>>;
+
 private:
   std::chrono::steady_clock::time_point begin;
+  ExportTimes exportTimes;
 };
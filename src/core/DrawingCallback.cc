@@ -78,6 +78,19 @@ void DrawingCallback::add_glyph_advance(double advance_x, double advance_y)
   advance += Vector2d(advance_x, advance_y);
 }
 
+// Add the outlines of an already flattened glyph (in unscaled glyph
+// coordinates) at the current glyph offset and advance.
+void DrawingCallback::add_glyph(const Polygon2d& glyph)
+{
+  for (const auto& outline : glyph.outlines()) {
+    for (const auto& v : outline.vertices) {
+      add_vertex(v);
+    }
+    this->polygon->addOutline(this->outline);
+    this->outline.vertices.clear();
+  }
+}
+
 void DrawingCallback::add_vertex(const Vector2d& v)
 {
   this->outline.vertices.push_back(size * (v + offset + advance));
@@ -44,6 +44,7 @@ public:
   void finish_glyph();
   void set_glyph_offset(double offset_x, double offset_y);
   void add_glyph_advance(double advance_x, double advance_y);
+  void add_glyph(const Polygon2d& glyph);
   std::vector<std::shared_ptr<const Polygon2d>> get_result();
 
   void move_to(const Vector2d& to);
@@ -318,20 +318,22 @@ void FreetypeRenderer::Params::set(Parameters& parameters)
 }
 
 
-FreetypeRenderer::ShapeResults::ShapeResults(
-  const FreetypeRenderer::Params& params)
+std::shared_ptr<const GlyphCache::ShapedText> FreetypeRenderer::ShapeResults::shape(
+  const FreetypeRenderer::Params& params, FT_Face face)
 {
-  FT_Face face = params.get_font_face();
-  if (face == nullptr) {
-    return;
+  auto *glyph_cache = GlyphCache::instance();
+  auto shaped = glyph_cache->getShapedText(params.text, params.font, params.direction, params.script, params.language);
+  if (shaped) {
+    return shaped;
   }
 
-  hb_ft_font = hb_ft_font_create(face, nullptr);
-
-  hb_buf = hb_buffer_create();
+  hb_font_t *hb_ft_font = hb_ft_font_create(face, nullptr);
+  hb_buffer_t *hb_buf = hb_buffer_create();
   hb_buffer_set_direction(hb_buf, hb_direction_from_string(params.direction.c_str(), -1));
   hb_buffer_set_script(hb_buf, hb_script_from_string(params.script.c_str(), -1));
   hb_buffer_set_language(hb_buf, hb_language_from_string(params.language.c_str(), -1));
+  // Results causing warnings are not cached, so the warnings are repeated for each text() call.
+  bool cacheable = true;
   if (FontCache::instance()->is_windows_symbol_font(face)) {
     // Special handling for symbol fonts like Webdings.
     // see http://www.microsoft.com/typography/otspec/recom.htm
@@ -352,6 +354,7 @@ FreetypeRenderer::ShapeResults::ShapeResults(
       LOG(message_group::Warning, params.loc, params.documentPath,
           "Ignoring text with invalid UTF-8 encoding: \"%1$s\"",
           params.text.c_str());
+      cacheable = false;
     }
   } else {
     hb_buffer_add_utf8(hb_buf, params.text.c_str(), strlen(params.text.c_str()), 0, strlen(params.text.c_str()));
@@ -362,30 +365,65 @@ FreetypeRenderer::ShapeResults::ShapeResults(
   hb_glyph_info_t *glyph_info = hb_buffer_get_glyph_infos(hb_buf, &glyph_count);
   hb_glyph_position_t *glyph_pos = hb_buffer_get_glyph_positions(hb_buf, &glyph_count);
 
-  glyph_array.reserve(glyph_count);
+  auto result = std::make_shared<GlyphCache::ShapedText>();
+  result->direction = hb_buffer_get_direction(hb_buf);
+  result->glyphs.reserve(glyph_count);
   for (unsigned int idx = 0; idx < glyph_count; ++idx) {
-    FT_Error error;
-    FT_UInt glyph_index = glyph_info[idx].codepoint;
-    error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
-    if (error) {
-      LOG(message_group::Warning, params.loc, params.documentPath,
-          "Could not load glyph %1$u"
-          " for char at index %2$u in text '%3$s'",
-          glyph_index, idx, params.text);
-      continue;
-    }
+    result->glyphs.push_back({glyph_info[idx].codepoint,
+                              glyph_pos[idx].x_offset, glyph_pos[idx].y_offset,
+                              glyph_pos[idx].x_advance, glyph_pos[idx].y_advance});
+  }
 
-    FT_Glyph glyph;
-    error = FT_Get_Glyph(face->glyph, &glyph);
-    if (error) {
-      LOG(message_group::Warning, params.loc, params.documentPath,
-          "Could not get glyph %1$u"
-          " for char at index %2$u in text '%3$s'",
-          glyph_index, idx, params.text);
-      continue;
+  hb_buffer_destroy(hb_buf);
+  hb_font_destroy(hb_ft_font);
+
+  if (cacheable) {
+    glyph_cache->insertShapedText(params.text, params.font, params.direction, params.script, params.language, result);
+  }
+  return result;
+}
+
+FreetypeRenderer::ShapeResults::ShapeResults(
+  const FreetypeRenderer::Params& params)
+{
+  FT_Face face = params.get_font_face();
+  if (face == nullptr) {
+    return;
+  }
+
+  const auto shaped = shape(params, face);
+
+  auto *glyph_cache = GlyphCache::instance();
+  glyph_array.reserve(shaped->glyphs.size());
+  for (unsigned int idx = 0; idx < shaped->glyphs.size(); ++idx) {
+    const auto& shaped_glyph = shaped->glyphs[idx];
+    FT_UInt glyph_index = shaped_glyph.index;
+    auto cached_glyph = glyph_cache->getGlyph(params.font, glyph_index);
+    if (!cached_glyph) {
+      FT_Error error;
+      error = FT_Load_Glyph(face, glyph_index, FT_LOAD_DEFAULT);
+      if (error) {
+        LOG(message_group::Warning, params.loc, params.documentPath,
+            "Could not load glyph %1$u"
+            " for char at index %2$u in text '%3$s'",
+            glyph_index, idx, params.text);
+        continue;
+      }
+
+      FT_Glyph glyph;
+      error = FT_Get_Glyph(face->glyph, &glyph);
+      if (error) {
+        LOG(message_group::Warning, params.loc, params.documentPath,
+            "Could not get glyph %1$u"
+            " for char at index %2$u in text '%3$s'",
+            glyph_index, idx, params.text);
+        continue;
+      }
+      cached_glyph = std::make_shared<const GlyphCache::Glyph>(glyph);
+      glyph_cache->insertGlyph(params.font, glyph_index, cached_glyph);
     }
 
-    glyph_array.emplace_back(glyph, idx, &glyph_pos[idx]);
+    glyph_array.emplace_back(cached_glyph, idx, shaped_glyph);
   }
 
   ascent = std::numeric_limits<double>::lowest();
@@ -436,8 +474,7 @@ FreetypeRenderer::ShapeResults::ShapeResults(
   // contributed they will flip.  If they're still reversed,
   // there was no ink.
   if (right >= left) {
-    if (HB_DIRECTION_IS_HORIZONTAL(
-          hb_buffer_get_direction(hb_buf))) {
+    if (HB_DIRECTION_IS_HORIZONTAL(shaped->direction)) {
       calc_offsets_horiz(params);
     } else {
       calc_offsets_vert(params);
@@ -456,18 +493,6 @@ FreetypeRenderer::ShapeResults::ShapeResults(
   ok = true;
 }
 
-FreetypeRenderer::ShapeResults::~ShapeResults()
-{
-  if (hb_buf != nullptr) {
-    hb_buffer_destroy(hb_buf);
-    hb_buf = nullptr;
-  }
-  if (hb_ft_font != nullptr) {
-    hb_font_destroy(hb_ft_font);
-    hb_ft_font = nullptr;
-  }
-}
-
 FreetypeRenderer::FontMetrics::FontMetrics(
   const FreetypeRenderer::Params& params)
 {
@@ -546,6 +571,31 @@ FreetypeRenderer::TextMetrics::TextMetrics(
   ok = true;
 }
 
+/*!
+   Returns the flattened outline of the glyph in unscaled glyph coordinates,
+   or nullptr if the glyph has no outline.
+ */
+std::shared_ptr<const Polygon2d> FreetypeRenderer::get_outline(const GlyphData& glyph, const FreetypeRenderer::Params& params) const
+{
+  auto *glyph_cache = GlyphCache::instance();
+  std::shared_ptr<const Polygon2d> result;
+  if (glyph_cache->getOutline(params.font, glyph.get_index(), params.segments, result)) {
+    return result;
+  }
+
+  DrawingCallback callback(params.segments, 1.0);
+  callback.start_glyph();
+  FT_Outline outline = reinterpret_cast<FT_OutlineGlyph>(glyph.get_glyph())->outline;
+  FT_Outline_Decompose(&outline, &funcs, &callback);
+  callback.finish_glyph();
+  const auto polygons = callback.get_result();
+  if (!polygons.empty()) {
+    result = polygons.front();
+  }
+  glyph_cache->insertOutline(params.font, glyph.get_index(), params.segments, result);
+  return result;
+}
+
 std::vector<std::shared_ptr<const Polygon2d>> FreetypeRenderer::render(const FreetypeRenderer::Params& params) const
 {
   ShapeResults sr(params);
@@ -560,8 +610,9 @@ std::vector<std::shared_ptr<const Polygon2d>> FreetypeRenderer::render(const Fre
     callback.set_glyph_offset(
       sr.x_offset + glyph.get_x_offset(),
       sr.y_offset + glyph.get_y_offset());
-    FT_Outline outline = reinterpret_cast<FT_OutlineGlyph>(glyph.get_glyph())->outline;
-    FT_Outline_Decompose(&outline, &funcs, &callback);
+    if (const auto outline = get_outline(glyph, params)) {
+      callback.add_glyph(*outline);
+    }
 
     double adv_x = glyph.get_x_advance() * params.spacing;
     double adv_y = glyph.get_y_advance() * params.spacing;
@@ -27,9 +27,11 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <ostream>
 
+#include "core/GlyphCache.h"
 #include "core/Parameters.h"
 #include <hb.h>
 #include <ft2build.h>
@@ -162,25 +164,24 @@ private:
   const static double scale;
   FT_Outline_Funcs funcs;
 
-  // The GlyphData assumes responsibility for "glyph" and will ensure
-  // that it is freed when the GlyphData is destroyed.
-  // However, glyph_pos points to data that the caller must ensure
-  // remains valid until the GlyphData is destroyed.
+  // The GlyphData shares ownership of the (possibly cached) glyph, and
+  // keeps a copy of the glyph's position in the shaped text.
   class GlyphData
   {
 public:
-    GlyphData(FT_Glyph glyph, unsigned int idx, hb_glyph_position_t *glyph_pos) : glyph(glyph), idx(idx), glyph_pos(glyph_pos) {}
+    GlyphData(std::shared_ptr<const GlyphCache::Glyph> glyph, unsigned int idx, const GlyphCache::ShapedGlyph& glyph_pos)
+      : glyph(std::move(glyph)), idx(idx), glyph_pos(glyph_pos) {}
     [[nodiscard]] unsigned int get_idx() const { return idx; }
-    [[nodiscard]] FT_Glyph get_glyph() const { return glyph; }
-    [[nodiscard]] double get_x_offset() const { return glyph_pos->x_offset / scale; }
-    [[nodiscard]] double get_y_offset() const { return glyph_pos->y_offset / scale; }
-    [[nodiscard]] double get_x_advance() const { return glyph_pos->x_advance / scale; }
-    [[nodiscard]] double get_y_advance() const { return glyph_pos->y_advance / scale; }
-    ~GlyphData() { FT_Done_Glyph(glyph); }
+    [[nodiscard]] unsigned int get_index() const { return glyph_pos.index; }
+    [[nodiscard]] FT_Glyph get_glyph() const { return glyph->get(); }
+    [[nodiscard]] double get_x_offset() const { return glyph_pos.x_offset / scale; }
+    [[nodiscard]] double get_y_offset() const { return glyph_pos.y_offset / scale; }
+    [[nodiscard]] double get_x_advance() const { return glyph_pos.x_advance / scale; }
+    [[nodiscard]] double get_y_advance() const { return glyph_pos.y_advance / scale; }
 private:
-    FT_Glyph glyph;
+    std::shared_ptr<const GlyphCache::Glyph> glyph;
     unsigned int idx;
-    hb_glyph_position_t *glyph_pos;
+    GlyphCache::ShapedGlyph glyph_pos;
   };
 
   class ShapeResults
@@ -203,14 +204,15 @@ public:
     double ascent{0.0};
     double descent{0.0};
     ShapeResults(const FreetypeRenderer::Params& params);
-    virtual ~ShapeResults();
+    virtual ~ShapeResults() = default;
 private:
     void calc_offsets_horiz(const FreetypeRenderer::Params& params);
     void calc_offsets_vert(const FreetypeRenderer::Params& params);
-    hb_font_t *hb_ft_font{nullptr};
-    hb_buffer_t *hb_buf{nullptr};
+    static std::shared_ptr<const GlyphCache::ShapedText> shape(const FreetypeRenderer::Params& params, FT_Face face);
   };
 
+  [[nodiscard]] std::shared_ptr<const class Polygon2d> get_outline(const GlyphData& glyph, const FreetypeRenderer::Params& params) const;
+
   static int outline_move_to_func(const FT_Vector *to, void *user);
   static int outline_line_to_func(const FT_Vector *to, void *user);
   static int outline_conic_to_func(const FT_Vector *c1, const FT_Vector *to, void *user);
@@ -0,0 +1,143 @@
+#include "core/GlyphCache.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "geometry/Polygon2d.h"
+#include "utils/printutils.h"
+
+#include FT_OUTLINE_H
+
+GlyphCache *GlyphCache::inst = nullptr;
+
+namespace {
+
+// Keys are joined with a separator which can't appear in font names, so
+// e.g. font "a" with text "bc" doesn't collide with font "ab" with text "c".
+std::string glyph_key(const std::string& font, unsigned int index)
+{
+  return STR(font, '\x1f', index);
+}
+
+std::string outline_key(const std::string& font, unsigned int index, unsigned int segments)
+{
+  return STR(font, '\x1f', index, '\x1f', segments);
+}
+
+std::string shaped_key(const std::string& text, const std::string& font, const std::string& direction,
+                       const std::string& script, const std::string& language)
+{
+  return STR(font, '\x1f', direction, '\x1f', script, '\x1f', language, '\x1f', text);
+}
+
+} // namespace
+
+size_t GlyphCache::Glyph::memsize() const
+{
+  size_t size = sizeof(*this) + sizeof(FT_OutlineGlyphRec);
+  if (glyph->format == FT_GLYPH_FORMAT_OUTLINE) {
+    const auto& outline = reinterpret_cast<FT_OutlineGlyph>(glyph)->outline;
+    size += outline.n_points * (sizeof(FT_Vector) + sizeof(char)) + outline.n_contours * sizeof(short);
+  }
+  return size;
+}
+
+GlyphCache::GlyphCache(size_t memorylimit)
+  : shaped_cache(memorylimit), glyph_cache(memorylimit), outline_cache(memorylimit)
+{
+}
+
+std::shared_ptr<const GlyphCache::ShapedText> GlyphCache::getShapedText(
+  const std::string& text, const std::string& font, const std::string& direction,
+  const std::string& script, const std::string& language)
+{
+  auto *entry = shaped_cache[shaped_key(text, font, direction, script, language)];
+  if (!entry) {
+    ++shaped_stats.misses;
+    return nullptr;
+  }
+  ++shaped_stats.hits;
+  return entry->value;
+}
+
+void GlyphCache::insertShapedText(const std::string& text, const std::string& font, const std::string& direction,
+                                  const std::string& script, const std::string& language, const std::shared_ptr<const ShapedText>& shaped)
+{
+  const auto key = shaped_key(text, font, direction, script, language);
+  const size_t cost = key.size() + sizeof(ShapedText) + shaped->glyphs.size() * sizeof(ShapedGlyph);
+  shaped_cache.insert(key, new cache_entry<ShapedText>(shaped), cost);
+}
+
+std::shared_ptr<const GlyphCache::Glyph> GlyphCache::getGlyph(const std::string& font, unsigned int index)
+{
+  auto *entry = glyph_cache[glyph_key(font, index)];
+  if (!entry) {
+    ++glyph_stats.misses;
+    return nullptr;
+  }
+  ++glyph_stats.hits;
+  return entry->value;
+}
+
+void GlyphCache::insertGlyph(const std::string& font, unsigned int index, const std::shared_ptr<const Glyph>& glyph)
+{
+  glyph_cache.insert(glyph_key(font, index), new cache_entry<Glyph>(glyph), glyph->memsize());
+}
+
+bool GlyphCache::getOutline(const std::string& font, unsigned int index, unsigned int segments, std::shared_ptr<const Polygon2d>& outline)
+{
+  auto *entry = outline_cache[outline_key(font, index, segments)];
+  if (!entry) {
+    ++outline_stats.misses;
+    return false;
+  }
+  ++outline_stats.hits;
+  outline = entry->value;
+  return true;
+}
+
+void GlyphCache::insertOutline(const std::string& font, unsigned int index, unsigned int segments, const std::shared_ptr<const Polygon2d>& outline)
+{
+  const size_t cost = sizeof(cache_entry<Polygon2d>) + (outline ? outline->memsize() : 0);
+  outline_cache.insert(outline_key(font, index, segments), new cache_entry<Polygon2d>(outline), cost);
+}
+
+void GlyphCache::clear()
+{
+  shaped_cache.clear();
+  glyph_cache.clear();
+  outline_cache.clear();
+  shaped_stats = {};
+  glyph_stats = {};
+  outline_stats = {};
+}
+
+void GlyphCache::print()
+{
+  if (shaped_stats.hits + shaped_stats.misses == 0) return;
+  LOG("Shaped texts in font cache: %1$d (%2$d hits, %3$d misses)", shaped_cache.size(), shaped_stats.hits, shaped_stats.misses);
+  LOG("Glyphs in font cache: %1$d (%2$d hits, %3$d misses)", glyph_cache.size(), glyph_stats.hits, glyph_stats.misses);
+  LOG("Glyph outlines in font cache: %1$d (%2$d hits, %3$d misses)", outline_cache.size(), outline_stats.hits, outline_stats.misses);
+  LOG("Font cache size in bytes: %1$d", totalCost());
+}
+
+size_t GlyphCache::size() const
+{
+  return shaped_cache.size() + glyph_cache.size() + outline_cache.size();
+}
+
+size_t GlyphCache::totalCost() const
+{
+  return shaped_cache.totalCost() + glyph_cache.totalCost() + outline_cache.totalCost();
+}
+
+size_t GlyphCache::hits() const
+{
+  return shaped_stats.hits + glyph_stats.hits + outline_stats.hits;
+}
+
+size_t GlyphCache::misses() const
+{
+  return shaped_stats.misses + glyph_stats.misses + outline_stats.misses;
+}
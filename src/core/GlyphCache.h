@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Cache.h"
+
+#include <hb.h>
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_GLYPH_H
+
+class Polygon2d;
+
+/*!
+   Caches the intermediate results of text() rendering, so repeated text
+   doesn't need to be shaped, loaded from the font and flattened again:
+
+   - Shaped text (glyph indices and positions), keyed by text, font, direction,
+     script and language.
+   - Glyphs loaded from the font, keyed by font and glyph index.
+   - Flattened glyph outlines, keyed by font, glyph index and number of curve
+     segments. The outlines are in unscaled glyph coordinates, so they can be
+     scaled and translated into place when assembling the text.
+
+   Fonts are identified by the font name given to text(), which is what
+   FontCache resolves faces from.
+ */
+class GlyphCache
+{
+public:
+  struct ShapedGlyph {
+    unsigned int index;
+    hb_position_t x_offset;
+    hb_position_t y_offset;
+    hb_position_t x_advance;
+    hb_position_t y_advance;
+  };
+
+  struct ShapedText {
+    hb_direction_t direction{HB_DIRECTION_INVALID};
+    std::vector<ShapedGlyph> glyphs;
+  };
+
+  // Owns a glyph copied from its font face, which stays valid even when
+  // FontCache releases the face.
+  class Glyph
+  {
+public:
+    Glyph(FT_Glyph glyph) : glyph(glyph) {}
+    Glyph(const Glyph&) = delete;
+    Glyph& operator=(const Glyph&) = delete;
+    ~Glyph() { FT_Done_Glyph(glyph); }
+    [[nodiscard]] FT_Glyph get() const { return glyph; }
+    [[nodiscard]] size_t memsize() const;
+private:
+    FT_Glyph glyph;
+  };
+
+  GlyphCache(size_t memorylimit = 16ul * 1024ul * 1024ul);
+
+  static GlyphCache *instance() { if (!inst) inst = new GlyphCache; return inst; }
+
+  std::shared_ptr<const ShapedText> getShapedText(const std::string& text, const std::string& font, const std::string& direction,
+                                                  const std::string& script, const std::string& language);
+  void insertShapedText(const std::string& text, const std::string& font, const std::string& direction,
+                        const std::string& script, const std::string& language, const std::shared_ptr<const ShapedText>& shaped);
+
+  std::shared_ptr<const Glyph> getGlyph(const std::string& font, unsigned int index);
+  void insertGlyph(const std::string& font, unsigned int index, const std::shared_ptr<const Glyph>& glyph);
+
+  // Returns false on a cache miss. An empty glyph (e.g. a space) is a hit with outline set to nullptr.
+  bool getOutline(const std::string& font, unsigned int index, unsigned int segments, std::shared_ptr<const Polygon2d>& outline);
+  void insertOutline(const std::string& font, unsigned int index, unsigned int segments, const std::shared_ptr<const Polygon2d>& outline);
+
+  void clear();
+  void print();
+
+  // Totals over the shaped texts, glyphs and outlines
+  [[nodiscard]] size_t size() const;
+  [[nodiscard]] size_t totalCost() const;
+  [[nodiscard]] size_t hits() const;
+  [[nodiscard]] size_t misses() const;
+
+private:
+  static GlyphCache *inst;
+
+  template <typename T>
+  struct cache_entry {
+    std::shared_ptr<const T> value;
+    cache_entry(const std::shared_ptr<const T>& value) : value(value) {}
+  };
+
+  struct Statistics {
+    size_t hits{0};
+    size_t misses{0};
+  };
+
+  Cache<std::string, cache_entry<ShapedText>> shaped_cache;
+  Cache<std::string, cache_entry<Glyph>> glyph_cache;
+  Cache<std::string, cache_entry<Polygon2d>> outline_cache;
+  Statistics shaped_stats;
+  Statistics glyph_stats;
+  Statistics outline_stats;
+};
@@ -87,6 +87,7 @@ static std::shared_ptr<AbstractNode> do_import(const ModuleInstantiation *inst,
     else if (ext == ".amf") actualtype = ImportType::AMF;
     else if (ext == ".svg") actualtype = ImportType::SVG;
     else if (ext == ".obj") actualtype = ImportType::OBJ;
+    else if (ext == ".osgeo") actualtype = ImportType::OSGEO;
   }
 
   auto node = std::make_shared<ImportNode>(inst, actualtype);
@@ -181,6 +182,10 @@ std::unique_ptr<const Geometry> ImportNode::createGeometry() const
     g = import_obj(this->filename, loc);
     break;
   }
+  case ImportType::OSGEO: {
+    g = import_osgeo(this->filename, loc);
+    break;
+  }
   case ImportType::SVG: {
     g = import_svg(this->fn, this->fs, this->fa, this->filename, this->id, this->layer, this->dpi, this->center, loc);
     break;
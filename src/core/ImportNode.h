@@ -17,6 +17,7 @@ enum class ImportType {
   DXF,
   NEF3,
   OBJ,
+  OSGEO,
 };
 
 class ImportNode : public LeafNode
@@ -37,11 +37,19 @@
 #include "utils/printutils.h"
 #include "io/fileutils.h"
 #include "handle_dep.h"
+#include "io/MappedFile.h"
+#include "io/importutils.h"
+#include "io/scanutils.h"
 #include "lodepng/lodepng.h"
+#include "utils/parallel.h"
 
 #include <algorithm>
+#include <array>
 #include <cstring>
+#include <initializer_list>
+#include <map>
 #include <new>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <memory>
@@ -67,7 +75,7 @@ static std::shared_ptr<AbstractNode> builtin_surface(const ModuleInstantiation *
 {
   auto node = std::make_shared<SurfaceNode>(inst);
 
-  Parameters parameters = Parameters::parse(std::move(arguments), inst->location(), {"file", "center", "convexity"}, {"invert"});
+  Parameters parameters = Parameters::parse(std::move(arguments), inst->location(), {"file", "center", "convexity"}, {"invert", "tolerance"});
 
   std::string fileval = parameters["file"].isUndefined() ? "" : parameters["file"].toString();
   auto filename = lookup_file(fileval, inst->location().filePath().parent_path().string(), parameters.documentRoot());
@@ -86,6 +94,16 @@ static std::shared_ptr<AbstractNode> builtin_surface(const ModuleInstantiation *
     node->invert = parameters["invert"].toBool();
   }
 
+  const auto& tolerance = parameters["tolerance"];
+  if (tolerance.type() == Value::Type::NUMBER) {
+    if (tolerance.toDouble() >= 0) {
+      node->tolerance = tolerance.toDouble();
+    } else {
+      LOG(message_group::Warning, inst->location(), parameters.documentRoot(),
+          "surface(..., tolerance=%1$s) must not be negative, ignoring it", tolerance.toEchoStringNoThrow());
+    }
+  }
+
   return node;
 }
 
@@ -107,39 +125,37 @@ void SurfaceNode::convert_image(img_data_t& data, std::vector<uint8_t>& img, uns
   data.min_val = min_val;
 }
 
-bool SurfaceNode::is_png(std::vector<uint8_t>& png) const
+bool SurfaceNode::is_png(const uint8_t *data, size_t size) const
 {
   const size_t pngHeaderLength = 8;
   const uint8_t pngHeader[pngHeaderLength] = {0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a};
-  return (png.size() >= pngHeaderLength &&
-          std::memcmp(png.data(), pngHeader, pngHeaderLength) == 0);
+  return (size >= pngHeaderLength &&
+          std::memcmp(data, pngHeader, pngHeaderLength) == 0);
 }
 
 img_data_t SurfaceNode::read_png_or_dat(std::string filename) const
 {
   img_data_t data;
-  std::vector<uint8_t> png;
-  int ret_val = 0;
-  try{
-    ret_val = lodepng::load_file(png, filename);
-  } catch (std::bad_alloc& ba) {
-    LOG(message_group::Warning, "bad_alloc caught for '%1$s'.", ba.what());
-    return data;
-  }
-
-  if (ret_val == 78) {
+  const MappedFile file(filename);
+  if (!file.isOpen()) {
     LOG(message_group::Warning, "The file '%1$s' couldn't be opened.", filename);
     return data;
   }
 
-  if (!is_png(png)) {
-    png.clear();
-    return read_dat(filename);
+  const auto png = reinterpret_cast<const uint8_t *>(file.data());
+  if (!is_png(png, file.size())) {
+    return read_dat(filename, file);
   }
 
   unsigned int width, height;
   std::vector<uint8_t> img;
-  auto error = lodepng::decode(img, width, height, png);
+  unsigned int error;
+  try {
+    error = lodepng::decode(img, width, height, png, file.size());
+  } catch (std::bad_alloc& ba) {
+    LOG(message_group::Warning, "bad_alloc caught for '%1$s'.", ba.what());
+    return data;
+  }
   if (error) {
     LOG(message_group::Warning, "Can't read PNG image '%1$s'", filename);
     data.clear();
@@ -151,69 +167,195 @@ img_data_t SurfaceNode::read_png_or_dat(std::string filename) const
   return data;
 }
 
-img_data_t SurfaceNode::read_dat(std::string filename) const
+namespace {
+
+// DAT files are parsed in parallel chunks of about this many bytes
+constexpr size_t DAT_CHUNK_SIZE = 1ul << 20;
+// Heightmaps are meshed in parallel blocks of this many cells square. This is
+// also the largest area which can be simplified into a single block.
+constexpr int MESH_BLOCK_SIZE = 256;
+
+// The values of a chunk of a DAT file, by row
+struct DatChunk
 {
-  img_data_t data;
-  std::ifstream stream(filename.c_str());
+  std::vector<double> values;
+  std::vector<size_t> row_sizes;
+  bool error{false};
+  bool error_at_eof{false}; // The illegal value is on the last line, which has no newline
+};
 
-  if (!stream.good()) {
-    LOG(message_group::Warning, "Can't open DAT file '%1$s'.", filename);
-    return data;
+DatChunk parse_dat_chunk(const char *begin, const char *end, const char *file_end)
+{
+  DatChunk chunk;
+  while (begin < end) {
+    const char *line_end = std::find(begin, end, '\n');
+    const auto line = scan_trim(std::string_view(begin, line_end - begin));
+    const bool last_line = line_end == file_end;
+    begin = line_end == end ? end : line_end + 1;
+    if (line.empty() || line.front() == '#') continue;
+
+    // Values are separated by spaces and tabs only
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos < line.size()) {
+      const size_t token_end = std::min(line.find_first_of(" \t", pos), line.size());
+      if (token_end > pos) {
+        double value;
+        if (!scan_double(line.substr(pos, token_end - pos), value)) {
+          chunk.error = true;
+          chunk.error_at_eof = last_line;
+          return chunk;
+        }
+        chunk.values.push_back(value);
+        ++count;
+      }
+      pos = token_end + 1;
+    }
+    chunk.row_sizes.push_back(count);
   }
+  return chunk;
+}
 
-  int lines = 0, columns = 0;
-  double min_val = 1; // this balances out with the (min_val-1) inside createGeometry, to match old behavior
+/*!
+   Meshes the top surface of a heightmap, one block of cells at a time.
 
-  using tokenizer = boost::tokenizer<boost::char_separator<char>>;
-  boost::char_separator<char> sep(" \t");
+   Each cell is split into four triangles meeting at a center vertex, which has
+   the average height of the cell's corners. With a tolerance, blocks of cells
+   whose heights differ by at most the tolerance are meshed like a single cell:
+   a fan of triangles from a center vertex to every grid vertex on the block's
+   perimeter. As neighboring blocks share all grid vertices along their common
+   edges, the mesh stays closed, and every triangle stays within the heights of
+   its block.
+ */
+class SurfaceMesher
+{
+public:
+  // Faces refer to grid vertices by their index into the heightmap, and to
+  // the block's center vertices as -(index + 1)
+  struct Block {
+    int row_begin, row_end, column_begin, column_end; // Cells, end exclusive
+    std::vector<Vector3d> centers;
+    std::vector<std::array<int, 3>> faces;
+  };
+
+  SurfaceMesher(const img_data_t& data, double ox, double oy, double tolerance)
+    : data(data), ox(ox), oy(oy), tolerance(tolerance) {}
+
+  void mesh(Block& block) const {
+    meshCells(block, block.row_begin, block.row_end, block.column_begin, block.column_end);
+  }
 
-  // We use an unordered map because the data file may not be rectangular,
-  // and we may need to fill in some bits.
-  using unordered_image_data_t = std::unordered_map<std::pair<int, int>, double, boost::hash<std::pair<int, int>>>;
-  unordered_image_data_t unordered_data;
+private:
+  [[nodiscard]] double height(int row, int column) const { return data.storage[column + static_cast<size_t>(row) * data.width]; }
+  [[nodiscard]] int index(int row, int column) const { return column + row * static_cast<int>(data.width); }
 
-  while (!stream.eof()) {
-    std::string line;
-    while (!stream.eof() && (line.size() == 0 || line[0] == '#')) {
-      std::getline(stream, line);
-      boost::trim(line);
+  void meshCells(Block& block, int r0, int r1, int c0, int c1) const {
+    if (r1 - r0 == 1 && c1 - c0 == 1) {
+      // Keeps the original order of summation
+      const double center = (height(r0, c0) + height(r0, c1) + height(r1, c0) + height(r1, c1)) / 4;
+      addFan(block, r0, r1, c0, c1, center);
+      return;
     }
-    if (line.size() == 0 && stream.eof()) break;
-
-    int col = 0;
-    tokenizer tokens(line, sep);
-    try {
-      for (const auto& token : tokens) {
-        auto v = boost::lexical_cast<double>(token);
-        unordered_data[ std::make_pair(lines, col++) ] = v;
-        if (col > columns) columns = col;
-        min_val = std::min(v, min_val);
+    double mean;
+    if (tolerance > 0 && isFlat(r0, r1, c0, c1, mean)) {
+      addFan(block, r0, r1, c0, c1, mean);
+      return;
+    }
+    const int rm = r1 - r0 > 1 ? (r0 + r1) / 2 : r1;
+    const int cm = c1 - c0 > 1 ? (c0 + c1) / 2 : c1;
+    meshCells(block, r0, rm, c0, cm);
+    if (cm < c1) meshCells(block, r0, rm, cm, c1);
+    if (rm < r1) meshCells(block, rm, r1, c0, cm);
+    if (rm < r1 && cm < c1) meshCells(block, rm, r1, cm, c1);
+  }
+
+  // Whether the grid vertices of the cells differ by at most the tolerance
+  bool isFlat(int r0, int r1, int c0, int c1, double& mean) const {
+    double min = height(r0, c0);
+    double max = min;
+    double sum = 0;
+    for (int r = r0; r <= r1; ++r) {
+      for (int c = c0; c <= c1; ++c) {
+        const double h = height(r, c);
+        min = std::min(min, h);
+        max = std::max(max, h);
+        sum += h;
       }
-    } catch (const boost::bad_lexical_cast& blc) {
-      if (!stream.eof()) {
-        LOG(message_group::Warning, "Illegal value in '%1$s': %2$s", filename, blc.what());
+    }
+    mean = sum / ((r1 - r0 + 1) * (c1 - c0 + 1));
+    return max - min <= tolerance;
+  }
+
+  // Adds triangles from the center to the perimeter, counter-clockwise from the bottom left corner
+  void addFan(Block& block, int r0, int r1, int c0, int c1, double center_height) const {
+    block.centers.emplace_back(ox + (c0 + c1) / 2.0, oy + (r0 + r1) / 2.0, center_height);
+    const int center = -static_cast<int>(block.centers.size());
+    int previous = index(r0, c0);
+    const auto add = [&](int r, int c) {
+      const int current = index(r, c);
+      block.faces.push_back({previous, current, center});
+      previous = current;
+    };
+    for (int c = c0 + 1; c <= c1; ++c) add(r0, c);
+    for (int r = r0 + 1; r <= r1; ++r) add(r, c1);
+    for (int c = c1 - 1; c >= c0; --c) add(r1, c);
+    for (int r = r1 - 1; r >= r0; --r) add(r, c0);
+  }
+
+  const img_data_t& data;
+  double ox, oy;
+  double tolerance;
+};
+
+} // namespace
+
+img_data_t SurfaceNode::read_dat(const std::string& filename, const MappedFile& file) const
+{
+  img_data_t data;
+
+  const auto ranges = split_line_chunks(file.begin(), file.end(), DAT_CHUNK_SIZE);
+  std::vector<DatChunk> chunks(ranges.size());
+  parallelizable_transform(ranges.begin(), ranges.end(), chunks.begin(), [&file](const auto& range) {
+    return parse_dat_chunk(range.first, range.second, file.end());
+  });
+
+  size_t lines = 0, columns = 0;
+  double min_val = 1; // this balances out with the (min_val-1) inside createGeometry, to match old behavior
+  std::vector<size_t> first_lines;
+  for (const auto& chunk : chunks) {
+    if (chunk.error) {
+      if (!chunk.error_at_eof) {
+        LOG(message_group::Warning, "Illegal value in '%1$s': %2$s", filename, boost::bad_lexical_cast().what());
       }
       return data;
     }
-
-    lines++;
+    first_lines.push_back(lines);
+    lines += chunk.row_sizes.size();
+    for (const auto size : chunk.row_sizes) columns = std::max(columns, size);
+    for (const auto value : chunk.values) min_val = std::min(value, min_val);
   }
 
   data.width = columns;
   data.height = lines;
   data.min_val = min_val;
 
-  // Now convert the unordered, possibly non-rectangular data into a well ordered vector
-  // for faster access and reduced memory usage.
-  data.resize( (size_t)lines * columns);
-  for (int i = 0; i < lines; ++i)
-    for (int j = 0; j < columns; ++j)
-      data[ i * columns + j ] = unordered_data[std::make_pair(i, j)];
+  // Rows may have different lengths. Missing values are zero.
+  data.resize(lines * columns);
+  std::vector<size_t> chunk_indices(chunks.size());
+  std::iota(chunk_indices.begin(), chunk_indices.end(), 0);
+  parallelizable_for_each(chunk_indices.begin(), chunk_indices.end(), [&](size_t i) {
+    const auto& chunk = chunks[i];
+    auto value = chunk.values.begin();
+    for (size_t row = 0; row < chunk.row_sizes.size(); ++row) {
+      const auto size = chunk.row_sizes[row];
+      std::copy(value, value + size, data.storage.begin() + (first_lines[i] + row) * columns);
+      value += size;
+    }
+  });
 
   return data;
 }
 
-// FIXME: Look for faster way to generate PolySet directly
 std::unique_ptr<const Geometry> SurfaceNode::createGeometry() const
 {
   auto data = read_png_or_dat(filename);
@@ -222,108 +364,125 @@ std::unique_ptr<const Geometry> SurfaceNode::createGeometry() const
   int columns = data.width;
   double min_val = data.min_value() - 1; // make the bottom solid, and match old code
 
-  // reserve the polygon vector size so we don't have to reallocate as often
-
   double ox = center ? -(columns - 1) / 2.0 : 0;
   double oy = center ? -(lines - 1) / 2.0 : 0;
 
-  int num_indices = (lines - 1) * (columns - 1) * 4 + (lines - 1) * 2 + (columns - 1) * 2 + 1;
-  PolySetBuilder builder(0, num_indices);
-  builder.setConvexity(convexity);
-  // the bulk of the heightmap
-  for (int i = 1; i < lines; ++i)
-    for (int j = 1; j < columns; ++j) {
-      double v1 = data[ (j - 1) + (i - 1) * columns ];
-      double v2 = data[ (j) + (i - 1) * columns ];
-      double v3 = data[ (j - 1) + (i) * columns ];
-      double v4 = data[ (j) + (i) * columns ];
-
-      double vx = (v1 + v2 + v3 + v4) / 4;
-
-      builder.appendPolygon({
-                Vector3d(ox + j - 1, oy + i - 1, v1),
-                Vector3d(ox + j, oy + i - 1, v2),
-                Vector3d(ox + j - 0.5, oy + i - 0.5, vx)
-                });
-
-      builder.appendPolygon({
-                Vector3d(ox + j, oy + i - 1, v2),
-                Vector3d(ox + j, oy + i, v4),
-                Vector3d(ox + j - 0.5, oy + i - 0.5, vx)
-                });
-
-      builder.appendPolygon({
-                Vector3d(ox + j, oy + i, v4),
-                Vector3d(ox + j - 1, oy + i, v3),
-                Vector3d(ox + j - 0.5, oy + i - 0.5, vx)
-                });
-
-      builder.appendPolygon({
-                Vector3d(ox + j - 1, oy + i, v3),
-                Vector3d(ox + j - 1, oy + i - 1, v1),
-                Vector3d(ox + j - 0.5, oy + i - 0.5, vx)
-                });
+  // The bulk of the heightmap, meshed in parallel blocks
+  std::vector<SurfaceMesher::Block> blocks;
+  for (int r = 0; r < lines - 1; r += MESH_BLOCK_SIZE) {
+    for (int c = 0; c < columns - 1; c += MESH_BLOCK_SIZE) {
+      blocks.push_back({r, std::min(r + MESH_BLOCK_SIZE, lines - 1), c, std::min(c + MESH_BLOCK_SIZE, columns - 1), {}, {}});
     }
+  }
+  const SurfaceMesher mesher(data, ox, oy, tolerance);
+  parallelizable_for_each(blocks.begin(), blocks.end(), [&mesher](SurfaceMesher::Block& block) {
+    mesher.mesh(block);
+  });
 
-  // edges along Y
-  for (int i = 1; i < lines; ++i) {
-    double v1 = data[ (0) + (i - 1) * columns ];
-    double v2 = data[ (0) + (i) * columns ];
-    double v3 = data[ (columns - 1) + (i - 1) * columns ];
-    double v4 = data[ (columns - 1) + (i) * columns ];
-
-
-    builder.appendPolygon({
-        Vector3d(ox + 0, oy + i - 1, min_val),
-        Vector3d(ox + 0, oy + i - 1, v1),
-        Vector3d(ox + 0, oy + i, v2),
-        Vector3d(ox + 0, oy + i, min_val)
+  // Grid vertices inside simplified blocks aren't used. Those on the edges of
+  // the blocks always are, and only the block itself uses its inner ones.
+  const size_t num_grid = static_cast<size_t>(lines) * columns;
+  std::vector<int> grid_index;
+  if (tolerance > 0) {
+    std::vector<uint8_t> used(num_grid, 1);
+    parallelizable_for_each(blocks.begin(), blocks.end(), [&](const SurfaceMesher::Block& block) {
+      for (int r = block.row_begin + 1; r < block.row_end; ++r) {
+        for (int c = block.column_begin + 1; c < block.column_end; ++c) used[c + static_cast<size_t>(r) * columns] = 0;
+      }
+      for (const auto& face : block.faces) {
+        for (const int i : face) {
+          if (i < 0) continue;
+          const int r = i / columns, c = i % columns;
+          if (r > block.row_begin && r < block.row_end && c > block.column_begin && c < block.column_end) used[i] = 1;
+        }
+      }
     });
+    grid_index.resize(num_grid);
+    int next = 0;
+    for (size_t i = 0; i < num_grid; ++i) grid_index[i] = used[i] ? next++ : -1;
+  }
 
-    builder.appendPolygon({
-        Vector3d(ox + columns - 1, oy + i, min_val),
-        Vector3d(ox + columns - 1, oy + i, v4),
-        Vector3d(ox + columns - 1, oy + i - 1, v3),
-        Vector3d(ox + columns - 1, oy + i - 1, min_val)
-    });
+  auto ps = std::make_unique<PolySet>(3);
+  ps->setConvexity(convexity);
+  for (int r = 0; r < lines; ++r) {
+    for (int c = 0; c < columns; ++c) {
+      const size_t i = c + static_cast<size_t>(r) * columns;
+      if (grid_index.empty() || grid_index[i] >= 0) ps->vertices.emplace_back(ox + c, oy + r, data.storage[i]);
+    }
+  }
+  const auto grid = [&grid_index, columns](int r, int c) {
+    const int i = c + r * columns;
+    return grid_index.empty() ? i : grid_index[i];
+  };
+
+  size_t num_faces = 0;
+  std::vector<size_t> first_center, first_face;
+  for (const auto& block : blocks) {
+    first_center.push_back(ps->vertices.size());
+    ps->vertices.insert(ps->vertices.end(), block.centers.begin(), block.centers.end());
+    first_face.push_back(num_faces);
+    num_faces += block.faces.size();
+  }
+  ps->indices.resize(num_faces);
+  std::vector<size_t> block_indices(blocks.size());
+  std::iota(block_indices.begin(), block_indices.end(), 0);
+  parallelizable_for_each(block_indices.begin(), block_indices.end(), [&](size_t b) {
+    auto face = ps->indices.begin() + first_face[b];
+    for (const auto& triangle : blocks[b].faces) {
+      face->clear();
+      for (const int i : triangle) {
+        face->push_back(i < 0 ? first_center[b] - i - 1 : grid_index.empty() ? i : grid_index[i]);
+      }
+      ++face;
+    }
+  });
+  blocks.clear();
+
+  // The sides and bottom, with vertices at the minimum height below the edges.
+  // Edge vertices which are already at that height are shared, as missing
+  // values in .dat files can be.
+  std::map<std::pair<int, int>, int> bottom_vertices;
+  const auto bottom = [&](int r, int c) {
+    if (data.storage[c + static_cast<size_t>(r) * columns] == min_val) return grid(r, c);
+    const auto [it, inserted] = bottom_vertices.emplace(std::make_pair(r, c), ps->vertices.size());
+    if (inserted) ps->vertices.emplace_back(ox + c, oy + r, min_val);
+    return it->second;
+  };
+  // Skips repeated vertices of degenerate faces, like PolySetBuilder does
+  const auto add_face = [&ps](std::initializer_list<int> vertices) {
+    IndexedFace face;
+    for (const int i : vertices) {
+      if (face.empty() || (i != face.back() && i != face.front())) face.push_back(i);
+    }
+    if (face.size() >= 3) ps->indices.push_back(std::move(face));
+  };
+
+  // edges along Y
+  for (int i = 1; i < lines; ++i) {
+    add_face({bottom(i - 1, 0), grid(i - 1, 0), grid(i, 0), bottom(i, 0)});
+    add_face({bottom(i, columns - 1), grid(i, columns - 1), grid(i - 1, columns - 1), bottom(i - 1, columns - 1)});
   }
 
   // edges along X
   for (int i = 1; i < columns; ++i) {
-    double v1 = data[ (i - 1) + (0) * columns ];
-    double v2 = data[ (i) + (0) * columns ];
-    double v3 = data[ (i - 1) + (lines - 1) * columns ];
-    double v4 = data[ (i) + (lines - 1) * columns ];
-
-    builder.appendPolygon({
-        Vector3d(ox + i, oy + 0, min_val),
-        Vector3d(ox + i, oy + 0, v2),
-        Vector3d(ox + i - 1, oy + 0, v1),
-        Vector3d(ox + i - 1, oy + 0, min_val)
-    });
-
-    builder.appendPolygon({
-        Vector3d(ox + i - 1, oy + lines - 1, min_val),
-        Vector3d(ox + i - 1, oy + lines - 1, v3),
-        Vector3d(ox + i, oy + lines - 1, v4),
-        Vector3d(ox + i, oy + lines - 1, min_val)
-    });
+    add_face({bottom(0, i), grid(0, i), grid(0, i - 1), bottom(0, i - 1)});
+    add_face({bottom(lines - 1, i - 1), grid(lines - 1, i - 1), grid(lines - 1, i), bottom(lines - 1, i)});
   }
 
   // the bottom of the shape (one less than the real minimum value), making it a solid volume
   if (columns > 1 && lines > 1) {
-    builder.beginPolygon(2 * (columns - 1) + 2 * (lines - 1) );
-    for (int i = 0; i < lines - 1; ++i)
-      builder.addVertex(Vector3d(ox + 0, oy + i, min_val));
-    for (int i = 0; i < columns - 1; ++i)
-      builder.addVertex(Vector3d(ox + i, oy + lines - 1, min_val));
-    for (int i = lines - 1; i > 0; i--)
-      builder.addVertex(Vector3d(ox + columns - 1, oy + i, min_val));
-    for (int i = columns - 1; i > 0; i--)
-      builder.addVertex(Vector3d(ox + i, oy + 0, min_val));
+    IndexedFace face;
+    for (int i = 0; i < lines - 1; ++i) face.push_back(bottom(i, 0));
+    for (int i = 0; i < columns - 1; ++i) face.push_back(bottom(lines - 1, i));
+    for (int i = lines - 1; i > 0; i--) face.push_back(bottom(i, columns - 1));
+    for (int i = columns - 1; i > 0; i--) face.push_back(bottom(0, i));
+    ps->indices.push_back(std::move(face));
   }
 
-  return builder.build();
+  // e.g. a single pixel
+  if (ps->indices.empty()) ps->vertices.clear();
+  ps->setTriangular(std::all_of(ps->indices.begin(), ps->indices.end(), [](const IndexedFace& face) { return face.size() == 3; }));
+  return ps;
 }
 
 std::string SurfaceNode::toString() const
@@ -333,8 +492,11 @@ std::string SurfaceNode::toString() const
 
   stream << this->name() << "(file = " << this->filename
          << ", center = " << (this->center ? "true" : "false")
-         << ", invert = " << (this->invert ? "true" : "false")
-         << ", " "timestamp = " << fs_timestamp(path)
+         << ", invert = " << (this->invert ? "true" : "false");
+  if (this->tolerance > 0) {
+    stream << ", tolerance = " << this->tolerance;
+  }
+  stream << ", " "timestamp = " << fs_timestamp(path)
          << ")";
 
   return stream.str();
@@ -344,6 +506,6 @@ void register_builtin_surface()
 {
   Builtins::init("surface", new BuiltinModule(builtin_surface),
   {
-    "surface(string, center = false, invert = false, number)",
+    "surface(string, center = false, invert = false, number, tolerance = 0)",
   });
 }
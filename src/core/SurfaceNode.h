@@ -71,11 +71,13 @@ public:
   bool center{false};
   bool invert{false};
   int convexity{1};
+  // Flat regions whose heights differ by at most this much are simplified
+  double tolerance{0};
 
   std::unique_ptr<const Geometry> createGeometry() const override;
 private:
   void convert_image(img_data_t& data, std::vector<uint8_t>& img, unsigned int width, unsigned int height) const;
-  bool is_png(std::vector<uint8_t>& img) const;
-  img_data_t read_dat(std::string filename) const;
+  bool is_png(const uint8_t *data, size_t size) const;
+  img_data_t read_dat(const std::string& filename, const class MappedFile& file) const;
   img_data_t read_png_or_dat(std::string filename) const;
 };
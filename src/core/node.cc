@@ -98,10 +98,21 @@ std::string AbstractIntersectionNode::name() const
   return "intersection";
 }
 
-void AbstractNode::progress_prepare()
+/*!
+   Numbers the nodes for progress indication, children first. Nodes combining
+   several children are weighted by the number of leaves below them, which
+   estimates the size of their operands before any geometry exists.
+   Returns the number of leaves below this node.
+ */
+int AbstractNode::progress_prepare()
 {
-  std::for_each(this->children.begin(), this->children.end(), std::mem_fn(&AbstractNode::progress_prepare));
-  this->progress_mark = ++progress_report_count;
+  int leaves = 0;
+  for (const auto& child : this->children) leaves += child->progress_prepare();
+  if (this->children.empty()) leaves = 1;
+  this->progress_weight = this->children.size() > 1 ? leaves : 1;
+  progress_report_count += this->progress_weight;
+  this->progress_mark = progress_report_count;
+  return leaves;
 }
 
 void AbstractNode::progress_report() const
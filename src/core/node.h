@@ -56,10 +56,12 @@ public:
   std::vector<std::shared_ptr<AbstractNode>> children;
   const ModuleInstantiation *modinst;
 
-  // progress_mark is a running number used for progress indication
+  // progress_mark is a running number used for progress indication, increased
+  // by progress_weight for each node: the estimated work of its operation
   // FIXME: Make all progress handling external, put it in the traverser class?
   int progress_mark{0};
-  void progress_prepare();
+  int progress_weight{1};
+  int progress_prepare();
   void progress_report() const;
 
   int idx; // Node index (unique per tree)
@@ -1,5 +1,7 @@
 #include "core/progress.h"
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
 #include "core/node.h"
 
@@ -8,11 +10,21 @@ int progress_mark_;
 void (*progress_report_f)(const std::shared_ptr<const AbstractNode> &, void *, int);
 void *progress_report_userdata;
 
+namespace {
+
+std::atomic<bool> progress_cancelled_{false};
+// The node whose operation is running
+const AbstractNode *progress_operation_node = nullptr;
+
+} // namespace
+
 void progress_report_prep(const std::shared_ptr<AbstractNode> &root, void (*f)(const std::shared_ptr<const AbstractNode> &node, void *userdata, int mark), void *userdata)
 {
   progress_report_count = 0;
   progress_report_f = f;
   progress_report_userdata = userdata;
+  progress_mark_ = 0;
+  progress_cancelled_ = false;
   root->progress_prepare();
 }
 
@@ -21,6 +33,7 @@ void progress_report_fin()
   progress_report_count = 0;
   progress_report_f = nullptr;
   progress_report_userdata = nullptr;
+  progress_cancelled_ = false;
 }
 
 void progress_update(const std::shared_ptr<const AbstractNode> &node, int mark)
@@ -31,7 +44,37 @@ void progress_update(const std::shared_ptr<const AbstractNode> &node, int mark)
   }
 }
 
-void progress_tick()
+ProgressOperation::ProgressOperation(const AbstractNode& node) : previous(progress_operation_node)
+{
+  progress_operation_node = &node;
+}
+
+ProgressOperation::~ProgressOperation()
+{
+  progress_operation_node = previous;
+}
+
+void progress_operation(double done, double total)
+{
+  progress_check();
+  const auto *node = progress_operation_node;
+  if (!progress_report_f || !node || !(total > 0)) return;
+  const double part = std::clamp(done / total, 0.0, 1.0);
+  const int mark = node->progress_mark - node->progress_weight + static_cast<int>(part * node->progress_weight);
+  if (mark > progress_mark_) progress_update(node->shared_from_this(), mark);
+}
+
+void progress_cancel()
+{
+  progress_cancelled_ = true;
+}
+
+bool progress_cancelled()
+{
+  return progress_cancelled_;
+}
+
+void progress_check()
 {
-  if (progress_report_f) progress_report_f(std::shared_ptr<const AbstractNode>(), progress_report_userdata, ++progress_mark_);
+  if (progress_cancelled_) throw ProgressCancelException();
 }
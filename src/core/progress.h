@@ -4,7 +4,7 @@
 
 class AbstractNode;
 
-// Reset to 0 in _prep() and increased for each Node instance in progress_prepare()
+// Reset to 0 in _prep() and increased by the weight of each Node instance in progress_prepare()
 extern int progress_report_count;
 
 extern void (*progress_report_f)(const std::shared_ptr<const AbstractNode> &, void *, int);
@@ -13,8 +13,32 @@ extern void *progress_report_userdata;
 void progress_report_prep(const std::shared_ptr<AbstractNode> &root, void (*f)(const std::shared_ptr<const AbstractNode> &node, void *userdata, int mark), void *userdata);
 void progress_report_fin();
 void progress_update(const std::shared_ptr<const AbstractNode> &node, int mark);
-// CGALUtils::applyUnion3D may process nodes out of order, so allow for an increment instead of tracking exact node
-void progress_tick();
+
+/*!
+   Marks the operation of node, e.g. the union of its children, as running
+   while in scope, so progress_operation() can report progress within it.
+ */
+class ProgressOperation
+{
+public:
+  explicit ProgressOperation(const AbstractNode& node);
+  ~ProgressOperation();
+  ProgressOperation(const ProgressOperation&) = delete;
+  ProgressOperation& operator=(const ProgressOperation&) = delete;
+
+private:
+  const AbstractNode *previous;
+};
+
+// Reports that the running operation has done the part done of total, e.g. by the size of its operands.
+// Also a cancellation checkpoint. Only call from the evaluating thread.
+void progress_operation(double done, double total);
+
+// Stops the evaluation at its next checkpoint. May be called from any thread.
+void progress_cancel();
+[[nodiscard]] bool progress_cancelled();
+// Throws ProgressCancelException if the evaluation was cancelled. May be called from any thread, e.g. within parallel loops.
+void progress_check();
 
 class ProgressCancelException
 {
@@ -1,6 +1,7 @@
 #include "geometry/ClipperUtils.h"
 #include "clipper2/clipper.h"
 #include "utils/printutils.h"
+#include "utils/parallel.h"
 
 #include <algorithm>
 #include <clipper2/clipper.engine.h>
@@ -9,12 +10,19 @@
 #include <utility>
 #include <memory>
 #include <cstddef>
+#include <iterator>
+#include <limits>
 #include <vector>
 
 namespace ClipperUtils {
 
 namespace {
 
+// Unions of at least this many operands are split into spatial tiles which are
+// processed in parallel, aiming for roughly TILED_UNION_OPERANDS_PER_TILE operands per tile.
+constexpr size_t TILED_UNION_MIN_OPERANDS = 1024;
+constexpr size_t TILED_UNION_OPERANDS_PER_TILE = 256;
+
 Clipper2Lib::Paths64 process(const Clipper2Lib::Paths64& polygons,
                           Clipper2Lib::ClipType cliptype,
                           Clipper2Lib::FillRule polytype)
@@ -102,6 +110,86 @@ void SimplifyPolyTree(const Clipper2Lib::PolyPath64& polytree, double epsilon, C
   }
 }
 
+/*!
+   Union each spatial tile of the given operands (each operand being a Paths64).
+
+   Operands are assigned to the cell of a regular grid over the total bounds
+   containing the center of their bounding box. Operands are never split, so
+   holes stay together with their outlines. All operands share the same integer
+   coordinates, so the per-tile results can be stitched along the tile seams by
+   simply unioning them again.
+ */
+template <typename Iterator>
+std::vector<Clipper2Lib::Paths64> unionPerTile(Iterator begin, Iterator end)
+{
+  struct Center {
+    const Clipper2Lib::Paths64 *paths;
+    double x, y;
+  };
+  std::vector<Center> centers;
+  centers.reserve(std::distance(begin, end));
+  double minx = std::numeric_limits<double>::max();
+  double miny = std::numeric_limits<double>::max();
+  double maxx = std::numeric_limits<double>::lowest();
+  double maxy = std::numeric_limits<double>::lowest();
+  for (auto it = begin; it != end; ++it) {
+    if (it->empty()) continue;
+    const auto bounds = Clipper2Lib::GetBounds(*it);
+    const double x = (static_cast<double>(bounds.left) + static_cast<double>(bounds.right)) / 2;
+    const double y = (static_cast<double>(bounds.top) + static_cast<double>(bounds.bottom)) / 2;
+    minx = std::min(minx, x);
+    miny = std::min(miny, y);
+    maxx = std::max(maxx, x);
+    maxy = std::max(maxy, y);
+    centers.push_back({&*it, x, y});
+  }
+  if (centers.empty()) return {};
+
+  const size_t num_tiles = (centers.size() + TILED_UNION_OPERANDS_PER_TILE - 1) / TILED_UNION_OPERANDS_PER_TILE;
+  const auto grid_size = std::max<size_t>(1, std::ceil(std::sqrt(static_cast<double>(num_tiles))));
+  const auto cell = [grid_size](double v, double min, double max) -> size_t {
+    if (max <= min) return 0;
+    return std::min(grid_size - 1, static_cast<size_t>((v - min) / (max - min) * grid_size));
+  };
+  std::vector<std::vector<const Clipper2Lib::Paths64 *>> tiles(grid_size * grid_size);
+  for (const auto& center : centers) {
+    tiles[cell(center.y, miny, maxy) * grid_size + cell(center.x, minx, maxx)].push_back(center.paths);
+  }
+
+  std::vector<Clipper2Lib::Paths64> results(tiles.size());
+  parallelizable_transform(tiles.begin(), tiles.end(), results.begin(), [](const auto& tile) {
+    Clipper2Lib::Paths64 result;
+    if (tile.empty()) return result;
+    Clipper2Lib::Clipper64 clipper;
+    clipper.PreserveCollinear(false);
+    for (const auto *paths : tile) clipper.AddSubject(*paths);
+    clipper.Execute(Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero, result);
+    return result;
+  });
+  return results;
+}
+
+/*!
+   Union all operands (each operand being a Paths64) into result, which can be
+   a Paths64 or a PolyTree64. Large operand sets are unioned tile by tile first.
+ */
+template <typename Iterator, typename Result>
+void unionOperands(Iterator begin, Iterator end, Result& result)
+{
+  Clipper2Lib::Clipper64 clipper;
+  clipper.PreserveCollinear(false);
+  if (static_cast<size_t>(std::distance(begin, end)) >= TILED_UNION_MIN_OPERANDS) {
+    for (const auto& paths : unionPerTile(begin, end)) {
+      clipper.AddSubject(paths);
+    }
+  } else {
+    for (auto it = begin; it != end; ++it) {
+      clipper.AddSubject(*it);
+    }
+  }
+  clipper.Execute(Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero, result);
+}
+
 }  // namespace
 
 // Using 1 bit less precision than the maximum possible, to limit the chance
@@ -238,6 +326,25 @@ std::unique_ptr<Polygon2d> apply(const std::vector<Clipper2Lib::Paths64>& pathsv
     return ClipperUtils::toPolygon2d(result, scale_bits);
   }
 
+  if (pathsvector.size() >= TILED_UNION_MIN_OPERANDS) {
+    // Large operand sets (e.g. layouts of many small outlines) are unioned in
+    // parallel spatial tiles. For difference, all negative operands are merged
+    // that way before being subtracted in one go.
+    Clipper2Lib::PolyTree64 result;
+    if (clipType == Clipper2Lib::ClipType::Union) {
+      unionOperands(pathsvector.begin(), pathsvector.end(), result);
+      return ClipperUtils::toPolygon2d(result, scale_bits);
+    }
+    if (clipType == Clipper2Lib::ClipType::Difference) {
+      Clipper2Lib::Paths64 negative;
+      unionOperands(pathsvector.begin() + 1, pathsvector.end(), negative);
+      clipper.AddSubject(pathsvector[0]);
+      clipper.AddClip(negative);
+      clipper.Execute(clipType, Clipper2Lib::FillRule::NonZero, result);
+      return ClipperUtils::toPolygon2d(result, scale_bits);
+    }
+  }
+
   bool first = true;
   for (const auto& paths : pathsvector) {
     if (first) {
@@ -295,40 +402,37 @@ std::unique_ptr<Polygon2d> applyMinkowski(const std::vector<std::shared_ptr<cons
   if (it == polygons.end()) return nullptr;
   const int scale_bits = scaleBitsFromPrecision();
 
-  Clipper2Lib::Clipper64 clipper;
-  clipper.PreserveCollinear(false);
   auto lhs = fromPolygon2d(polygons[0] ? *polygons[0] : Polygon2d(), scale_bits);
+  std::vector<Clipper2Lib::Paths64> minkowski_terms;
 
   for (size_t i = 1; i < polygons.size(); ++i) {
     if (!polygons[i]) continue;
-    Clipper2Lib::Paths64 minkowski_terms;
     auto rhs = fromPolygon2d(*polygons[i], scale_bits);
 
     // First, convolve each outline of lhs with the outlines of rhs
-    for (auto const& rhs_path : rhs) {
-      for (auto const& lhs_path : lhs) {
-        Clipper2Lib::Paths64 result;
-        minkowski_outline(lhs_path, rhs_path, result, true, true);
-        minkowski_terms.insert(minkowski_terms.end(), result.begin(), result.end());
-      }
-    }
+    minkowski_terms.assign(lhs.size() * rhs.size(), {});
+    parallelizable_cross_product_transform(rhs, lhs, minkowski_terms.begin(),
+      [](const auto& rhs_path, const auto& lhs_path) {
+      Clipper2Lib::Paths64 result;
+      minkowski_outline(lhs_path, rhs_path, result, true, true);
+      return result;
+    });
 
     // Then, fill the central parts
-    fill_minkowski_insides(lhs, rhs, minkowski_terms);
-    fill_minkowski_insides(rhs, lhs, minkowski_terms);
+    minkowski_terms.emplace_back();
+    fill_minkowski_insides(lhs, rhs, minkowski_terms.back());
+    fill_minkowski_insides(rhs, lhs, minkowski_terms.back());
 
     // This union operation must be performed at each iteration since the minkowski_terms
     // now contain lots of small quads
-    clipper.Clear();
-    clipper.AddSubject(minkowski_terms);
-
     if (i != polygons.size() - 1) {
-      clipper.Execute(Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero, lhs);
+      lhs.clear();
+      unionOperands(minkowski_terms.begin(), minkowski_terms.end(), lhs);
     }
   }
 
   Clipper2Lib::PolyTree64 polytree;
-  clipper.Execute(Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero, polytree);
+  unionOperands(minkowski_terms.begin(), minkowski_terms.end(), polytree);
   return toPolygon2d(polytree, scale_bits);
 }
 
@@ -353,22 +457,31 @@ std::unique_ptr<Polygon2d> applyProjection(const std::vector<std::shared_ptr<con
 {
   const int scale_bits = scaleBitsFromPrecision();
 
-  Clipper2Lib::Clipper64 sumclipper;
-  sumclipper.PreserveCollinear(false);
-  for (const auto &poly : polygons) {
-    Clipper2Lib::Paths64 result = ClipperUtils::fromPolygon2d(*poly, scale_bits);
+  std::vector<Clipper2Lib::Paths64> projected(polygons.size());
+  parallelizable_transform(polygons.begin(), polygons.end(), projected.begin(), [scale_bits](const auto& poly) {
+    Clipper2Lib::Paths64 paths = ClipperUtils::fromPolygon2d(*poly, scale_bits);
     // Using NonZero ensures that we don't create holes from polygons sharing
     // edges since we're unioning a mesh
-    result = ClipperUtils::process(result, Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero);
-    // Add correctly winded polygons to the main clipper
-    sumclipper.AddSubject(result);
-  }
+    if (paths.size() < TILED_UNION_MIN_OPERANDS) {
+      return ClipperUtils::process(paths, Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero);
+    }
+    // Each projected face is an operand of its own, so large meshes can be unioned in tiles
+    std::vector<Clipper2Lib::Paths64> faces;
+    faces.reserve(paths.size());
+    for (auto& path : paths) {
+      faces.push_back({std::move(path)});
+    }
+    Clipper2Lib::Paths64 result;
+    unionOperands(faces.begin(), faces.end(), result);
+    return result;
+  });
 
+  // Add correctly winded polygons to the main union
   Clipper2Lib::PolyTree64 sumresult;
   // This is key - without StrictlySimple, we tend to get self-intersecting results
   // FIXME: StrictlySimple doesn't exist in Clipper2. Check if it still exposes problems without
   //  sumclipper.StrictlySimple(true);
-  sumclipper.Execute(Clipper2Lib::ClipType::Union, Clipper2Lib::FillRule::NonZero, sumresult);
+  unionOperands(projected.begin(), projected.end(), sumresult);
   if (sumresult.Count() > 0) {
     return ClipperUtils::toPolygon2d(sumresult, scale_bits);
   }
@@ -24,6 +24,7 @@
 #include "utils/calc.h"
 #include "utils/printutils.h"
 #include "utils/calc.h"
+#include "core/progress.h"
 #include "io/DxfData.h"
 #include "glview/RenderSettings.h"
 #include "utils/degree_trig.h"
@@ -43,6 +44,7 @@
 #include <CGAL/Point_2.h>
 #endif
 #ifdef ENABLE_MANIFOLD
+#include "geometry/manifold/ManifoldGeometry.h"
 #include "geometry/manifold/manifoldutils.h"
 #endif
 #include "geometry/linear_extrude.h"
@@ -72,7 +74,18 @@ std::shared_ptr<const Geometry> GeometryEvaluator::evaluateGeometry(const Abstra
     // If not found in any caches, we need to evaluate the geometry
     // traverse() will set this->root to a geometry, which can be any geometry
     // (including GeometryList if the lazyunions feature is enabled)
-    this->traverse(node);
+    try {
+      this->traverse(node);
+    } catch (const ProgressCancelException&) {
+      // Keep the subtrees completed before the cancel, so the next render resumes from them
+      for (const auto& [index, children] : this->visitedchildren) {
+        for (const auto& item : children) {
+          if (!item.first->modinst->isBackground()) smartCacheInsert(*item.first, item.second);
+        }
+      }
+      this->visitedchildren.clear();
+      throw;
+    }
     result = this->root;
 
     // Insert the raw result into the cache.
@@ -128,6 +141,7 @@ GeometryEvaluator::ResultObject GeometryEvaluator::applyToChildren(const Abstrac
  */
 GeometryEvaluator::ResultObject GeometryEvaluator::applyToChildren3D(const AbstractNode& node, OpenSCADOperator op)
 {
+  ProgressOperation operation(node);
   Geometry::Geometries children = collectChildren3D(node);
   if (children.empty()) return {};
 
@@ -940,12 +954,16 @@ std::shared_ptr<const Geometry> GeometryEvaluator::projectionCut(const Projectio
   std::shared_ptr<const Geometry> newgeom = applyToChildren3D(node, OpenSCADOperator::UNION).constptr();
   if (newgeom) {
 #ifdef ENABLE_MANIFOLD
-    if (RenderSettings::inst()->backend3D == RenderBackend3D::ManifoldBackend) {
-      auto manifold = ManifoldUtils::createManifoldFromGeometry(newgeom);
-      if (manifold != nullptr) {
-        auto poly2d = manifold->slice();
-        return std::shared_ptr<const Polygon2d>(ClipperUtils::sanitize(poly2d));
-      }
+    // Slicing doesn't need exact arithmetic, so with the CGAL backend we still
+    // slice through Manifold whenever the geometry converts without repairs.
+    auto manifold = RenderSettings::inst()->backend3D == RenderBackend3D::ManifoldBackend
+      ? ManifoldUtils::createManifoldFromGeometry(newgeom)
+      : ManifoldUtils::tryCreateManifoldFromGeometry(newgeom);
+    if (manifold != nullptr) {
+      auto poly2d = manifold->slice();
+      auto poly = ClipperUtils::sanitize(poly2d);
+      poly->setConvexity(node.convexity);
+      return std::shared_ptr<const Polygon2d>(std::move(poly));
     }
 #endif
 #ifdef ENABLE_CGAL
@@ -983,14 +1001,30 @@ std::shared_ptr<const Geometry> GeometryEvaluator::projectionNoCut(const Project
   for (const auto& [chnode, chgeom] : this->visitedchildren[node.index()]) {
     if (chnode->modinst->isBackground()) continue;
 
+#ifdef ENABLE_MANIFOLD
+    // Manifold projects the silhouette of each child without unioning the children first
+    if (const auto manifold = std::dynamic_pointer_cast<const ManifoldGeometry>(chgeom)) {
+      tmp_geom.push_back(ClipperUtils::sanitize(manifold->project()));
+      continue;
+    }
+#endif
+
+    // Other children are converted once, for both Manifold and the fallback
+    auto chPS = PolySetUtils::getGeometryAsPolySet(chgeom);
+    if (!chPS) continue;
+#ifdef ENABLE_MANIFOLD
+    if (const auto manifold = ManifoldUtils::tryCreateManifoldFromPolySet(*chPS)) {
+      tmp_geom.push_back(ClipperUtils::sanitize(manifold->project()));
+      continue;
+    }
+#endif
+
     // Clipper version of Geometry projection
     // Clipper doesn't handle meshes very well.
     // It's better in V6 but not quite there. FIXME: stand-alone example.
     // project chgeom -> polygon2d
-    if (auto chPS = PolySetUtils::getGeometryAsPolySet(chgeom)) {
-      if (auto poly = PolySetUtils::project(*chPS)) {
-        tmp_geom.push_back(std::shared_ptr(std::move(poly)));
-      }
+    if (auto poly = PolySetUtils::project(*chPS)) {
+      tmp_geom.push_back(std::shared_ptr(std::move(poly)));
     }
   }
   auto projected = ClipperUtils::applyProjection(tmp_geom);
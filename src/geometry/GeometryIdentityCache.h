@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "geometry/Geometry.h"
+
+/*!
+   Caches values derived from a geometry (e.g. its convex hull), keyed by the
+   identity of the geometry object.
+
+   Evaluated geometries are immutable once shared (see
+   GeometryEvaluator::ResultObject) and are reused across evaluations through
+   GeometryCache, so a derived value stays valid for as long as the geometry
+   object it was computed from is alive. Entries only hold a weak reference to
+   their geometry, and entries of destroyed geometries are dropped.
+
+   Thread safe, so it can be used from parallel loops.
+ */
+template <typename T>
+class GeometryIdentityCache
+{
+public:
+  std::shared_ptr<const T> get(const std::shared_ptr<const Geometry>& geom) const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(geom.get());
+    if (it == entries.end()) return nullptr;
+    // The address may have been reused by a new geometry after the cached one was destroyed
+    if (it->second.first.lock() != geom) return nullptr;
+    return it->second.second;
+  }
+
+  void insert(const std::shared_ptr<const Geometry>& geom, const std::shared_ptr<const T>& value)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.size() >= next_purge) {
+      purge();
+      next_purge = std::max<size_t>(2 * entries.size(), MIN_PURGE_SIZE);
+    }
+    entries[geom.get()] = std::make_pair(std::weak_ptr<const Geometry>(geom), value);
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    next_purge = MIN_PURGE_SIZE;
+  }
+
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+  }
+
+private:
+  static constexpr size_t MIN_PURGE_SIZE = 64;
+
+  void purge()
+  {
+    for (auto it = entries.begin(); it != entries.end();) {
+      if (it->second.first.expired()) it = entries.erase(it);
+      else ++it;
+    }
+  }
+
+  mutable std::mutex mutex;
+  size_t next_purge{MIN_PURGE_SIZE};
+  std::unordered_map<const Geometry *, std::pair<std::weak_ptr<const Geometry>, std::shared_ptr<const T>>> entries;
+};
@@ -0,0 +1,120 @@
+#include "geometry/MeshSimplification.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <Eigen/SVD>
+
+/*!
+   Simplifies a mesh to roughly max_triangles triangles, for drawing it at a
+   lower level of detail. Vertices are clustered in a grid, and each cluster is
+   replaced by the point minimizing the quadric error of the faces around it,
+   as in Lindstrom's "Out-of-Core Simplification of Large Polygonal Models".
+   Faces whose vertices fall into fewer than three clusters disappear.
+
+   The result may not be manifold, so it is only fit for display. Returns
+   nothing if the mesh already has few enough triangles.
+ */
+std::optional<SimplifiedMesh> simplifyMesh(const std::vector<Vector3d>& vertices, const PolygonIndices& indices,
+                                           const std::vector<int32_t>& color_indices, size_t max_triangles)
+{
+  using Quadric = Eigen::Matrix<double, 4, 4, Eigen::DontAlign>;
+  struct Triangle {
+    int v[3];
+    int32_t color_index;
+  };
+
+  std::vector<Triangle> triangles;
+  triangles.reserve(indices.size());
+  double area = 0;
+  for (size_t i = 0; i < indices.size(); ++i) {
+    const auto& face = indices[i];
+    const int32_t color_index = i < color_indices.size() ? color_indices[i] : -1;
+    for (size_t j = 2; j < face.size(); ++j) {
+      triangles.push_back({{face[0], face[j - 1], face[j]}, color_index});
+      const auto& p0 = vertices[face[0]];
+      area += (vertices[face[j - 1]] - p0).cross(vertices[face[j]] - p0).norm() / 2;
+    }
+  }
+  if (triangles.size() <= max_triangles || max_triangles == 0 || area == 0) return {};
+
+  BoundingBox bbox;
+  for (const auto& v : vertices) bbox.extend(v);
+  // A closed mesh has about half as many vertices as triangles, spread over
+  // its surface, so this cell size leaves about max_triangles triangles.
+  double cell_size = std::sqrt(2 * area / max_triangles);
+  std::optional<SimplifiedMesh> result;
+  // The estimate is poor for very uneven meshes, so coarsen until it fits
+  for (int attempt = 0; attempt < 8; ++attempt, cell_size *= 1.5) {
+    const Eigen::Vector3i dims = ((bbox.sizes() / cell_size).array().floor().cast<int>() + 1).matrix();
+    const auto cell_key = [&](const Vector3d& v) {
+      const Eigen::Vector3i c = ((v - bbox.min()) / cell_size).array().floor().cast<int>().matrix()
+                                .cwiseMax(0).cwiseMin(dims - Eigen::Vector3i::Ones());
+      return (static_cast<uint64_t>(c[2]) * dims[1] + c[1]) * dims[0] + c[0];
+    };
+
+    std::unordered_map<uint64_t, int> cell_index;
+    std::vector<int> vertex_cell(vertices.size());
+    std::vector<Vector3d> cell_sum;
+    std::vector<int> cell_count;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      const auto [it, inserted] = cell_index.emplace(cell_key(vertices[i]), cell_sum.size());
+      if (inserted) {
+        cell_sum.push_back(Vector3d::Zero());
+        cell_count.push_back(0);
+      }
+      vertex_cell[i] = it->second;
+      cell_sum[it->second] += vertices[i];
+      ++cell_count[it->second];
+    }
+
+    // Area weighted plane quadrics of all faces touching a cell
+    std::vector<Quadric> quadrics(cell_sum.size(), Quadric::Zero());
+    for (const auto& t : triangles) {
+      const auto& p0 = vertices[t.v[0]];
+      const Vector3d n = (vertices[t.v[1]] - p0).cross(vertices[t.v[2]] - p0);
+      const double twice_area = n.norm();
+      if (twice_area == 0) continue;
+      Eigen::Vector4d plane;
+      plane << n / twice_area, -p0.dot(n) / twice_area;
+      const Quadric q = twice_area / 2 * plane * plane.transpose();
+      for (const int v : t.v) quadrics[vertex_cell[v]] += q;
+    }
+
+    result.emplace();
+    result->vertices.resize(cell_sum.size());
+    for (size_t c = 0; c < cell_sum.size(); ++c) {
+      const Vector3d mean = cell_sum[c] / cell_count[c];
+      // Solve around the mean, so directions without curvature keep it
+      const Eigen::Matrix3d a = quadrics[c].topLeftCorner<3, 3>();
+      const Vector3d b = -quadrics[c].topRightCorner<3, 1>();
+      Eigen::JacobiSVD<Eigen::Matrix3d> svd(a, Eigen::ComputeFullU | Eigen::ComputeFullV);
+      svd.setThreshold(1e-3);
+      Vector3d point = mean + svd.solve(b - a * mean);
+      // Keep degenerate solutions from pulling vertices far away
+      if (!point.allFinite() || (point - mean).cwiseAbs().maxCoeff() > cell_size) point = mean;
+      result->vertices[c] = point;
+    }
+
+    std::unordered_set<std::array<int, 3>, boost::hash<std::array<int, 3>>> seen;
+    for (const auto& t : triangles) {
+      std::array<int, 3> cells = {vertex_cell[t.v[0]], vertex_cell[t.v[1]], vertex_cell[t.v[2]]};
+      if (cells[0] == cells[1] || cells[1] == cells[2] || cells[0] == cells[2]) continue;
+      auto sorted = cells;
+      std::sort(sorted.begin(), sorted.end());
+      if (!seen.insert(sorted).second) continue;
+      result->indices.push_back({cells[0], cells[1], cells[2]});
+      if (!color_indices.empty()) result->color_indices.push_back(t.color_index);
+    }
+    if (result->indices.size() <= max_triangles + max_triangles / 2) break;
+  }
+  return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "geometry/linalg.h"
+#include "geometry/GeometryUtils.h"
+
+// A mesh with triangular faces, from simplifyMesh()
+struct SimplifiedMesh {
+  std::vector<Vector3d> vertices;
+  PolygonIndices indices;
+  std::vector<int32_t> color_indices; // Per face, if the input mesh had them
+};
+
+std::optional<SimplifiedMesh> simplifyMesh(const std::vector<Vector3d>& vertices, const PolygonIndices& indices,
+                                           const std::vector<int32_t>& color_indices, size_t max_triangles);
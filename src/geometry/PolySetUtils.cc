@@ -5,6 +5,7 @@
 #include <memory>
 #include <cstddef>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include <boost/range/adaptor/reversed.hpp>
@@ -14,6 +15,7 @@
 #include "geometry/Polygon2d.h"
 #include "utils/printutils.h"
 #include "geometry/GeometryUtils.h"
+#include "geometry/MeshSimplification.h"
 #ifdef ENABLE_CGAL
 #include "geometry/cgal/cgalutils.h"
 #endif
@@ -172,6 +174,21 @@ bool is_approximately_convex(const PolySet& ps) {
 #endif
 }
 
+// A simplified copy of the mesh for drawing it at a lower level of detail,
+// or nullptr if it already has few enough triangles. See simplifyMesh().
+std::unique_ptr<PolySet> simplify(const PolySet& ps, size_t max_triangles)
+{
+  auto mesh = simplifyMesh(ps.vertices, ps.indices, ps.color_indices, max_triangles);
+  if (!mesh) return nullptr;
+  auto result = std::make_unique<PolySet>(3);
+  result->setTriangular(true);
+  result->vertices = std::move(mesh->vertices);
+  result->indices = std::move(mesh->indices);
+  result->color_indices = std::move(mesh->color_indices);
+  result->colors = ps.colors;
+  return result;
+}
+
 // Get as or convert the geometry to a PolySet.
 std::shared_ptr<const PolySet> getGeometryAsPolySet(const std::shared_ptr<const Geometry>& geom)
 {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <memory>
 
@@ -13,6 +14,7 @@ namespace PolySetUtils {
 std::unique_ptr<Polygon2d> project(const PolySet& ps);
 std::unique_ptr<PolySet> tessellate_faces(const PolySet& inps);
 bool is_approximately_convex(const PolySet& ps);
+std::unique_ptr<PolySet> simplify(const PolySet& ps, size_t max_triangles);
 
 std::shared_ptr<const PolySet> getGeometryAsPolySet(const std::shared_ptr<const class Geometry>&);
 
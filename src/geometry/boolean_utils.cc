@@ -35,8 +35,15 @@
 #include "geometry/GeometryUtils.h"
 
 #ifdef ENABLE_CGAL
+// Hulls with at least this many input vertices go through CGALUtils::applyHullParallel()
+constexpr size_t PARALLEL_HULL_MIN_POINTS = 10000;
+
 std::unique_ptr<PolySet> applyHull(const Geometry::Geometries& children)
 {
+  if (CGALUtils::hullPointCount(children) >= PARALLEL_HULL_MIN_POINTS) {
+    return CGALUtils::applyHullParallel(children);
+  }
+
   using K = CGAL::Epick;
   // Collect point cloud
   Reindexer<K::Point_3> reindexer;
@@ -117,6 +124,12 @@ std::shared_ptr<const Geometry> applyMinkowski(const Geometry::Geometries& child
   auto it = children.begin();
   t_tot.start();
   std::shared_ptr<const Geometry> operands[2] = {it->second, std::shared_ptr<const Geometry>()};
+  // Progress is weighted by the size of the operands added to the first one
+  double total_facets = 0;
+  for (auto child = std::next(children.begin()); child != children.end(); ++child) {
+    total_facets += child->second->numFacets();
+  }
+  double done_facets = 0;
   try {
     while (++it != children.end()) {
       operands[1] = it->second;
@@ -183,6 +196,7 @@ std::shared_ptr<const Geometry> applyMinkowski(const Geometry::Geometries& child
 
       for (size_t i = 0; i < P[0].size(); ++i) {
         for (size_t j = 0; j < P[1].size(); ++j) {
+          progress_check();
           t.start();
           points[0].clear();
           points[1].clear();
@@ -298,12 +312,16 @@ std::shared_ptr<const Geometry> applyMinkowski(const Geometry::Geometries& child
       } else {
         operands[0] = std::make_shared<CGAL_Nef_polyhedron>();
       }
+      done_facets += it->second->numFacets();
+      progress_operation(done_facets, total_facets);
     }
 
     t_tot.stop();
     PRINTDB("Minkowski: Total execution time %f s", t_tot.time());
     t_tot.reset();
     return operands[0];
+  } catch (const ProgressCancelException&) {
+    throw;
   } catch (...) {
     // If anything throws we simply fall back to Nef Minkowski
     PRINTD("Minkowski: Falling back to Nef Minkowski");
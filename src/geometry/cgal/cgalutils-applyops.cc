@@ -15,7 +15,9 @@
 #endif
 #include "core/node.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <utility>
 #include <exception>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
@@ -54,6 +56,7 @@ Geometry::Geometries::iterator chbegin, Geometry::Geometries::iterator chend)
 
   try {
     // sort children by fewest faces
+    double total_facets = 0;
     for (auto it = chbegin; it != chend; ++it) {
       auto curChild = getNefPolyhedronFromGeometry(it->second);
       if (curChild && !curChild->isEmpty()) {
@@ -62,17 +65,22 @@ Geometry::Geometries::iterator chbegin, Geometry::Geometries::iterator chend)
           node_mark = it->first->progress_mark;
         }
         q.emplace(curChild, node_mark);
+        total_facets += curChild->p3->number_of_facets();
       }
     }
 
-    progress_tick();
+    // Each facet is in about log2(n) unions, as the smallest operands are unioned first
+    const double total_work = total_facets * std::max(1.0, std::log2(static_cast<double>(q.size())));
+    double work = 0;
+    progress_operation(work, total_work);
     while (q.size() > 1) {
       auto p1 = q.top();
       q.pop();
       auto p2 = q.top();
       q.pop();
+      work += p1.first->p3->number_of_facets() + p2.first->p3->number_of_facets();
       q.emplace(std::make_unique<const CGAL_Nef_polyhedron>(*p1.first + *p2.first), -1);
-      progress_tick();
+      progress_operation(work, total_work);
     }
 
     if (q.size() == 1) {
@@ -96,10 +104,16 @@ std::shared_ptr<const Geometry> applyOperator3D(const Geometry::Geometries& chil
 
   assert(op != OpenSCADOperator::UNION && "use applyUnion3D() instead of applyOperator3D()");
   bool foundFirst = false;
+  double total_facets = 0;
+  for (const auto& item : children) {
+    if (item.second) total_facets += item.second->numFacets();
+  }
+  double done_facets = 0;
 
   try {
     for (const auto& item : children) {
       const std::shared_ptr<const Geometry>& chgeom = item.second;
+      if (chgeom) done_facets += chgeom->numFacets();
       auto chN = getNefPolyhedronFromGeometry(chgeom);
 
       // Initialize N with first expected geometric object
@@ -138,7 +152,7 @@ std::shared_ptr<const Geometry> applyOperator3D(const Geometry::Geometries& chil
       default:
         LOG(message_group::Error, "Unsupported CGAL operator: %1$d", static_cast<int>(op));
       }
-      if (item.first) item.first->progress_report();
+      progress_operation(done_facets, total_facets);
     }
   }
   // union && difference assert triggered by tests/data/scad/bugs/rotate-diff-nonmanifold-crash.scad and tests/data/scad/bugs/issue204.scad
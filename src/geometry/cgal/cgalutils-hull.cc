@@ -0,0 +1,286 @@
+#ifdef ENABLE_CGAL
+
+#include "geometry/cgal/cgalutils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <CGAL/convex_hull_3.h>
+#include <CGAL/Surface_mesh.h>
+
+#include "core/progress.h"
+#include "geometry/cgal/CGAL_Nef_polyhedron.h"
+#include "geometry/GeometryIdentityCache.h"
+#include "geometry/PolySet.h"
+#include "utils/parallel.h"
+#include "utils/printutils.h"
+
+#ifdef ENABLE_MANIFOLD
+#include "geometry/manifold/ManifoldGeometry.h"
+#endif
+
+namespace CGALUtils {
+
+namespace {
+
+using HullPoints = std::vector<K::Point_3>;
+
+// Points are hulled in chunks of this size in parallel, before hulling the union of the chunks' hull vertices.
+constexpr size_t HULL_CHUNK_SIZE = 16384;
+
+GeometryIdentityCache<HullPoints>& childHullCache()
+{
+  static GeometryIdentityCache<HullPoints> cache;
+  return cache;
+}
+
+/*!
+   Collects the vertices of a geometry, reading vertex arrays directly.
+   Vertices of PolySets not referenced by any face are skipped.
+ */
+HullPoints collectPoints(const Geometry& geom)
+{
+  HullPoints points;
+  if (const auto *N = dynamic_cast<const CGAL_Nef_polyhedron *>(&geom)) {
+    if (!N->isEmpty()) {
+      points.reserve(N->p3->number_of_vertices());
+      for (auto i = N->p3->vertices_begin(); i != N->p3->vertices_end(); ++i) {
+        points.push_back(vector_convert<K::Point_3>(i->point()));
+      }
+    }
+#ifdef ENABLE_MANIFOLD
+  } else if (const auto *mani = dynamic_cast<const ManifoldGeometry *>(&geom)) {
+    const auto mesh = mani->getManifold().GetMeshGL64();
+    const auto numVert = mesh.NumVert();
+    points.reserve(numVert);
+    for (size_t v = 0; v < numVert; ++v) {
+      const auto p = mesh.GetVertPos(v);
+      points.emplace_back(p[0], p[1], p[2]);
+    }
+#endif
+  } else if (const auto *ps = dynamic_cast<const PolySet *>(&geom)) {
+    std::vector<bool> used(ps->vertices.size());
+    for (const auto& poly : ps->indices) {
+      for (const auto ind : poly) used[ind] = true;
+    }
+    points.reserve(ps->vertices.size());
+    for (size_t i = 0; i < ps->vertices.size(); ++i) {
+      if (used[i]) points.push_back(vector_convert<K::Point_3>(ps->vertices[i]));
+    }
+  }
+  return points;
+}
+
+/*!
+   Akl-Toussaint heuristic: Discards points strictly inside the polytope spanned
+   by the extreme points along a set of directions. Such points can't be
+   vertices of the convex hull.
+
+   The inside test is done in plain double precision, but only discards points
+   which are inside by a safe margin, so rounding can only make us keep more
+   points than necessary.
+ */
+HullPoints prefilterPoints(HullPoints points)
+{
+  if (points.size() < 64) return points;
+
+  // Axes, face diagonals and space diagonals of a cube (one of each +/- pair)
+  static const std::array<std::array<double, 3>, 13> directions{{
+    {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+    {1, 1, 0}, {1, -1, 0}, {1, 0, 1}, {1, 0, -1}, {0, 1, 1}, {0, 1, -1},
+    {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {-1, 1, 1},
+  }};
+  std::vector<size_t> extremes;
+  extremes.reserve(2 * directions.size());
+  for (const auto& d : directions) {
+    size_t min_idx = 0, max_idx = 0;
+    double min_val = std::numeric_limits<double>::max();
+    double max_val = std::numeric_limits<double>::lowest();
+    for (size_t i = 0; i < points.size(); ++i) {
+      const auto& p = points[i];
+      const double val = d[0] * p.x() + d[1] * p.y() + d[2] * p.z();
+      if (val < min_val) { min_val = val; min_idx = i; }
+      if (val > max_val) { max_val = val; max_idx = i; }
+    }
+    extremes.push_back(min_idx);
+    extremes.push_back(max_idx);
+  }
+  std::sort(extremes.begin(), extremes.end());
+  extremes.erase(std::unique(extremes.begin(), extremes.end()), extremes.end());
+  if (extremes.size() < 4) return points;
+
+  HullPoints extreme_points;
+  for (const auto i : extremes) extreme_points.push_back(points[i]);
+  CGAL::Surface_mesh<K::Point_3> polytope;
+  CGAL::convex_hull_3(extreme_points.begin(), extreme_points.end(), polytope);
+  if (!CGAL::is_closed(polytope) || polytope.number_of_faces() < 4) return points; // flat
+
+  const auto bbox = CGAL::bbox_3(points.begin(), points.end());
+  const double extent = std::max({bbox.xmax() - bbox.xmin(), bbox.ymax() - bbox.ymin(), bbox.zmax() - bbox.zmin()});
+  const double margin = 1e-9 * extent;
+
+  struct Plane {
+    double nx, ny, nz, d;
+  };
+  std::vector<Plane> planes;
+  for (const auto f : polytope.faces()) {
+    std::vector<K::Point_3> corners;
+    for (const auto v : CGAL::vertices_around_face(polytope.halfedge(f), polytope)) {
+      corners.push_back(polytope.point(v));
+    }
+    const auto& a = corners[0];
+    const auto& b = corners[1];
+    const auto& c = corners[2];
+    const double ux = b.x() - a.x(), uy = b.y() - a.y(), uz = b.z() - a.z();
+    const double vx = c.x() - a.x(), vy = c.y() - a.y(), vz = c.z() - a.z();
+    double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+    const double len = std::sqrt(nx * nx + ny * ny + nz * nz);
+    if (!(len > 0)) return points; // degenerate face, don't risk discarding hull vertices
+    nx /= len; ny /= len; nz /= len;
+    planes.push_back({nx, ny, nz, nx * a.x() + ny * a.y() + nz * a.z()});
+  }
+
+  HullPoints result;
+  result.reserve(points.size());
+  for (const auto& p : points) {
+    const bool inside = std::all_of(planes.begin(), planes.end(), [&](const Plane& plane) {
+      return plane.nx * p.x() + plane.ny * p.y() + plane.nz * p.z() - plane.d < -margin;
+    });
+    if (!inside) result.push_back(p);
+  }
+  result.insert(result.end(), extreme_points.begin(), extreme_points.end());
+  PRINTDB("Hull: prefilter kept %d of %d points", result.size() % points.size());
+  return result;
+}
+
+HullPoints hullVertices(const HullPoints& points)
+{
+  if (points.size() <= 3) return points;
+  CGAL::Surface_mesh<K::Point_3> mesh;
+  CGAL::convex_hull_3(points.begin(), points.end(), mesh);
+  HullPoints result;
+  result.reserve(mesh.number_of_vertices());
+  for (const auto v : mesh.vertices()) {
+    result.push_back(mesh.point(v));
+  }
+  return result;
+}
+
+/*!
+   Returns the vertices of the convex hull of the given points.
+
+   Large point sets are split into chunks whose hulls are computed in parallel,
+   only the vertices of those partial hulls go into the final hull. The
+   Epick kernel computes in double precision, falling back to exact arithmetic
+   for predicates which can't be decided reliably in doubles.
+ */
+HullPoints parallelHullVertices(HullPoints points)
+{
+  points = prefilterPoints(std::move(points));
+  if (points.size() > 2 * HULL_CHUNK_SIZE) {
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t begin = 0; begin < points.size(); begin += HULL_CHUNK_SIZE) {
+      chunks.emplace_back(begin, std::min(begin + HULL_CHUNK_SIZE, points.size()));
+    }
+    std::vector<HullPoints> chunk_vertices(chunks.size());
+    parallelizable_transform(chunks.begin(), chunks.end(), chunk_vertices.begin(), [&](const auto& chunk) {
+      return hullVertices(HullPoints(points.begin() + chunk.first, points.begin() + chunk.second));
+    });
+    points.clear();
+    for (const auto& vertices : chunk_vertices) {
+      points.insert(points.end(), vertices.begin(), vertices.end());
+    }
+  }
+  return hullVertices(points);
+}
+
+}  // namespace
+
+size_t hullPointCount(const Geometry::Geometries& children)
+{
+  size_t count = 0;
+  for (const auto& item : children) {
+    const auto& chgeom = item.second;
+    if (const auto *N = dynamic_cast<const CGAL_Nef_polyhedron *>(chgeom.get())) {
+      if (!N->isEmpty()) count += N->p3->number_of_vertices();
+#ifdef ENABLE_MANIFOLD
+    } else if (const auto *mani = dynamic_cast<const ManifoldGeometry *>(chgeom.get())) {
+      count += mani->numVertices();
+#endif
+    } else if (const auto *ps = dynamic_cast<const PolySet *>(chgeom.get())) {
+      count += ps->vertices.size();
+    }
+  }
+  return count;
+}
+
+/*!
+   Convex hull of many and/or large children.
+
+   The hull vertices of each child are computed separately (and in parallel) and
+   cached by child geometry identity, so e.g. re-rendering after an edit only
+   needs to hull the changed children again. The final hull is then computed from
+   the union of the children's hull vertices.
+ */
+std::unique_ptr<PolySet> applyHullParallel(const Geometry::Geometries& children)
+{
+  auto& cache = childHullCache();
+
+  std::vector<std::shared_ptr<const HullPoints>> child_vertices;
+  std::vector<std::shared_ptr<const Geometry>> missing;
+  for (const auto& item : children) {
+    if (!item.second) continue;
+    if (auto cached = cache.get(item.second)) {
+      child_vertices.push_back(cached);
+    } else {
+      missing.push_back(item.second);
+    }
+  }
+
+  // Nef polyhedra use exact numbers which are not thread safe, so points are collected serially
+  std::vector<HullPoints> missing_points;
+  missing_points.reserve(missing.size());
+  for (const auto& geom : missing) {
+    missing_points.push_back(collectPoints(*geom));
+  }
+
+  std::vector<std::shared_ptr<const HullPoints>> computed(missing.size());
+  parallelizable_transform(missing_points.begin(), missing_points.end(), computed.begin(), [](auto& points) {
+    if (progress_cancelled()) return std::shared_ptr<const HullPoints>();
+    return std::make_shared<const HullPoints>(parallelHullVertices(std::move(points)));
+  });
+  // Keep the child hulls finished before a cancel so the next render can reuse them
+  for (size_t i = 0; i < missing.size(); ++i) {
+    if (!computed[i]) continue;
+    cache.insert(missing[i], computed[i]);
+    child_vertices.push_back(computed[i]);
+  }
+  progress_check();
+
+  HullPoints points;
+  for (const auto& vertices : child_vertices) {
+    points.insert(points.end(), vertices->begin(), vertices->end());
+  }
+  if (points.size() <= 3) return nullptr;
+
+  try {
+    CGAL::Polyhedron_3<K> r;
+    CGAL::convex_hull_3(points.begin(), points.end(), r);
+    PRINTDB("After hull vertices: %d", r.size_of_vertices());
+    PRINTDB("After hull facets: %d", r.size_of_facets());
+    return createPolySetFromPolyhedron(r);
+  } catch (const CGAL::Failure_exception& e) {
+    LOG(message_group::Error, "CGAL error in applyHull(): %1$s", e.what());
+  }
+  return nullptr;
+}
+
+}  // namespace CGALUtils
+
+#endif // ENABLE_CGAL
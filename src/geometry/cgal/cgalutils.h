@@ -30,6 +30,8 @@ template <typename K>
 bool is_weakly_convex(const CGAL::Surface_mesh<CGAL::Point_3<K>>& m);
 std::shared_ptr<const Geometry> applyOperator3D(const Geometry::Geometries& children, OpenSCADOperator op);
 std::unique_ptr<const Geometry> applyUnion3D(Geometry::Geometries::iterator chbegin, Geometry::Geometries::iterator chend);
+size_t hullPointCount(const Geometry::Geometries& children);
+std::unique_ptr<PolySet> applyHullParallel(const Geometry::Geometries& children);
 //FIXME: Old, can be removed:
 //void applyBinaryOperator(CGAL_Nef_polyhedron &target, const CGAL_Nef_polyhedron &src, OpenSCADOperator op);
 std::unique_ptr<Polygon2d> project(const CGAL_Nef_polyhedron& N, bool cut);
@@ -303,6 +303,22 @@ ManifoldGeometry ManifoldGeometry::operator-(const ManifoldGeometry& other) cons
   return binOp(*this, other, manifold::OpType::Subtract);
 }
 
+ManifoldGeometry ManifoldGeometry::unionAll(const std::vector<std::shared_ptr<const ManifoldGeometry>>& parts) {
+  std::vector<manifold::Manifold> manifolds;
+  manifolds.reserve(parts.size());
+  std::set<uint32_t> originalIDs;
+  std::map<uint32_t, Color4f> originalIDToColor;
+  std::set<uint32_t> subtractedIDs;
+  for (const auto& part : parts) {
+    manifolds.push_back(part->manifold_);
+    originalIDs.insert(part->originalIDs_.begin(), part->originalIDs_.end());
+    originalIDToColor.insert(part->originalIDToColor_.begin(), part->originalIDToColor_.end());
+    subtractedIDs.insert(part->subtractedIDs_.begin(), part->subtractedIDs_.end());
+  }
+  auto mani = manifold::Manifold::BatchBoolean(manifolds, manifold::OpType::Add);
+  return {mani, originalIDs, originalIDToColor, subtractedIDs};
+}
+
 ManifoldGeometry ManifoldGeometry::minkowski(const ManifoldGeometry& other) const {
   std::shared_ptr<ManifoldGeometry> geom = minkowskiOp(*this, other);
   if (geom) return *geom;
@@ -11,6 +11,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 namespace manifold {
   class Manifold;
@@ -58,6 +59,8 @@ public:
   ManifoldGeometry operator-(const ManifoldGeometry& other) const;
   /*! minkowksi operation. */
   ManifoldGeometry minkowski(const ManifoldGeometry& other) const;
+  /*! union of all the parts at once, which lets Manifold pick the order. */
+  static ManifoldGeometry unionAll(const std::vector<std::shared_ptr<const ManifoldGeometry>>& parts);
 
   Polygon2d slice() const;
   Polygon2d project() const;
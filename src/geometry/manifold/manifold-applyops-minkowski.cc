@@ -12,22 +12,38 @@
 
 #include "geometry/cgal/cgal.h"
 #include "geometry/cgal/cgalutils.h"
+#include "geometry/GeometryIdentityCache.h"
 #include "geometry/PolySet.h"
 #include "utils/printutils.h"
+#include "core/progress.h"
 #include "geometry/manifold/manifoldutils.h"
 #include "geometry/manifold/ManifoldGeometry.h"
 #include "utils/parallel.h"
 
 namespace ManifoldUtils {
 
+namespace {
+
+using Hull_kernel = CGAL::Epick;
+using Hull_Points = std::vector<Hull_kernel::Point_3>;
+using Convex_Parts = std::list<Hull_Points>;
+
+// Convex decompositions of minkowski operands (or just their points, if convex),
+// so operands reused across minkowski() calls or renders are only decomposed once.
+GeometryIdentityCache<Convex_Parts>& decompositionCache()
+{
+  static GeometryIdentityCache<Convex_Parts> cache;
+  return cache;
+}
+
+}  // namespace
+
 /*!
    children cannot contain nullptr objects
  */
 std::shared_ptr<const Geometry> applyMinkowskiManifold(const Geometry::Geometries& children)
 {
-  using Hull_kernel = CGAL::Epick;
   using Hull_Mesh = CGAL::Surface_mesh<CGAL::Point_3<Hull_kernel>>;
-  using Hull_Points = std::vector<Hull_kernel::Point_3>;
   using Nef_kernel = CGAL_Kernel3;
   using Polyhedron = CGAL_Polyhedron;
 
@@ -65,16 +81,28 @@ std::shared_ptr<const Geometry> applyMinkowskiManifold(const Geometry::Geometrie
     return out;
   };
 
+  // Progress is weighted by the size of the operands added to the first one
+  double total_facets = 0;
+  for (auto child = std::next(children.begin()); child != children.end(); ++child) {
+    total_facets += child->second->numFacets();
+  }
+  double done_facets = 0;
+
   try {
     // Note: we could parallelize more, e.g. compute all decompositions ahead of time instead of doing them 2 by 2,
     // but this could use substantially more memory.
     while (++it != children.end()) {
       operands[1] = it->second;
 
-      std::vector<std::list<Hull_Points>> part_points(2);
+      std::vector<std::shared_ptr<const Convex_Parts>> part_points(2);
 
       parallelizable_transform(operands.begin(), operands.begin() + 2, part_points.begin(), [&](const auto &operand) {
-        std::list<Hull_Points> part_points;
+        if (auto cached = decompositionCache().get(operand)) {
+          PRINTDB("Minkowski: reusing decomposition into %d convex parts", cached->size());
+          return cached;
+        }
+        auto result = std::make_shared<Convex_Parts>();
+        auto& part_points = *result;
 
         bool is_convex;
         auto poly = polyhedronFromGeometry(operand, &is_convex);
@@ -107,12 +135,15 @@ std::shared_ptr<const Geometry> applyMinkowskiManifold(const Geometry::Geometrie
           t.stop();
           PRINTDB("Minkowski: decomposition took %f s", t.time());
         }
-        return part_points;
+        auto parts = std::shared_ptr<const Convex_Parts>(result);
+        decompositionCache().insert(operand, parts);
+        return parts;
       });
 
       std::vector<Hull_kernel::Point_3> minkowski_points;
 
       auto combineParts = [&](const Hull_Points &points0, const Hull_Points &points1) -> std::shared_ptr<const ManifoldGeometry> {
+        progress_check();
         CGAL::Timer t;
 
         t.start();
@@ -186,9 +217,9 @@ std::shared_ptr<const Geometry> applyMinkowskiManifold(const Geometry::Geometrie
         return ManifoldUtils::createManifoldFromSurfaceMesh(mesh);
       };
 
-      std::vector<std::shared_ptr<const ManifoldGeometry>> result_parts(part_points[0].size() * part_points[1].size());
+      std::vector<std::shared_ptr<const ManifoldGeometry>> result_parts(part_points[0]->size() * part_points[1]->size());
       parallelizable_cross_product_transform(
-          part_points[0], part_points[1],
+          *part_points[0], *part_points[1],
           result_parts.begin(),
           combineParts);
 
@@ -197,28 +228,23 @@ std::shared_ptr<const Geometry> applyMinkowskiManifold(const Geometry::Geometrie
       CGAL::Timer t;
       t.start();
       PRINTDB("Minkowski: Computing union of %d parts", result_parts.size());
-      Geometry::Geometries fake_children;
-      for (const auto& part : result_parts) {
-        fake_children.push_back(std::make_pair(std::shared_ptr<const AbstractNode>(),
-                                                part));
-      }
-      auto N = ManifoldUtils::applyOperator3DManifold(fake_children, OpenSCADOperator::UNION);
-
-      // FIXME: This should really never throw.
-      // Assert once we figured out what went wrong with issue #1069?
-      if (!N) throw 0;
+      auto N = ManifoldUtils::applyUnionBatched(result_parts);
       t.stop();
       PRINTDB("Minkowski: Union done: %f s", t.time());
       t.reset();
 
       N->toOriginal();
       operands[0] = N;
+      done_facets += it->second->numFacets();
+      progress_operation(done_facets, total_facets);
     }
 
     t_tot.stop();
     PRINTDB("Minkowski: Total execution time %f s", t_tot.time());
     t_tot.reset();
     return operands[0];
+  } catch (const ProgressCancelException&) {
+    throw;
   } catch (const std::exception& e) {
     LOG(message_group::Warning,
         "[manifold] Minkowski failed with error, falling back to Nef operation: %1$s\n", e.what());
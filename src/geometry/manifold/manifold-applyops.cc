@@ -4,6 +4,7 @@
 #ifdef ENABLE_MANIFOLD
 
 #include <memory>
+#include <vector>
 #include "geometry/manifold/manifoldutils.h"
 #include "geometry/manifold/ManifoldGeometry.h"
 #include "core/node.h"
@@ -26,8 +27,14 @@ std::shared_ptr<ManifoldGeometry> applyOperator3DManifold(const Geometry::Geomet
   std::shared_ptr<ManifoldGeometry> geom;
 
   bool foundFirst = false;
+  double total_facets = 0;
+  for (const auto& item : children) {
+    if (item.second) total_facets += item.second->numFacets();
+  }
+  double done_facets = 0;
 
   for (const auto& item : children) {
+    if (item.second) done_facets += item.second->numFacets();
     auto chN = item.second ? createManifoldFromGeometry(item.second) : nullptr;
 
     // Intersecting something with nothing results in nothing
@@ -66,11 +73,32 @@ std::shared_ptr<ManifoldGeometry> applyOperator3DManifold(const Geometry::Geomet
     default:
       LOG(message_group::Error, "Unsupported CGAL operator: %1$d", static_cast<int>(op));
     }
-    if (item.first) item.first->progress_report();
+    // Manifold evaluates booleans lazily, batching them, so this mostly tracks the conversion of the operands
+    progress_operation(done_facets, total_facets);
   }
   return geom;
 }
 
+/*!
+   Unions the given parts with one batched boolean. Manifold unions the
+   smallest operands first, in parallel, which keeps the operands of each
+   union small compared to unioning all parts into one growing result.
+
+   Returns an empty geometry if all parts are empty.
+ */
+std::shared_ptr<ManifoldGeometry> applyUnionBatched(const std::vector<std::shared_ptr<const ManifoldGeometry>>& parts)
+{
+  std::vector<std::shared_ptr<const ManifoldGeometry>> nonempty;
+  nonempty.reserve(parts.size());
+  for (const auto& part : parts) {
+    if (part && !part->isEmpty()) nonempty.push_back(part);
+  }
+  if (nonempty.empty()) return std::make_shared<ManifoldGeometry>();
+  if (nonempty.size() == 1) return std::make_shared<ManifoldGeometry>(*nonempty.front());
+  progress_check();
+  return std::make_shared<ManifoldGeometry>(ManifoldGeometry::unionAll(nonempty));
+}
+
 };  // namespace ManifoldUtils
 
 #endif // ENABLE_MANIFOLD
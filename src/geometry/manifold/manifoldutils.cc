@@ -150,7 +150,11 @@ std::shared_ptr<ManifoldGeometry> createManifoldFromTriangularPolySet(const Poly
   return std::make_shared<ManifoldGeometry>(mani, originalIDs, originalIDToColor);
 }
 
-std::shared_ptr<ManifoldGeometry> createManifoldFromPolySet(const PolySet& ps)
+/*!
+   Converts a PolySet to a Manifold object without attempting any repairs.
+   The caller needs to check the status of the result.
+ */
+static std::shared_ptr<ManifoldGeometry> createManifoldFromPolySetWithoutRepair(const PolySet& ps)
 {
   // 1. If the PolySet is already manifold, we should be able to build a Manifold object directly
   // (through using manifold::Mesh).
@@ -178,7 +182,25 @@ std::shared_ptr<ManifoldGeometry> createManifoldFromPolySet(const PolySet& ps)
                          ps.getDimension(), ps.convexValue());
   builder.appendPolySet(triangle_set);
   const std::unique_ptr<PolySet> rebuilt_ps = builder.build();
-  mani = createManifoldFromTriangularPolySet(*rebuilt_ps);
+  return createManifoldFromTriangularPolySet(*rebuilt_ps);
+}
+
+/*!
+   Converts a PolySet with manifold topology to a Manifold object, without
+   attempting any repairs. Returns nullptr if the PolySet isn't manifold.
+ */
+std::shared_ptr<ManifoldGeometry> tryCreateManifoldFromPolySet(const PolySet& ps)
+{
+  auto mani = createManifoldFromPolySetWithoutRepair(ps);
+  if (mani->getManifold().Status() == Error::NoError) {
+    return mani;
+  }
+  return nullptr;
+}
+
+std::shared_ptr<ManifoldGeometry> createManifoldFromPolySet(const PolySet& ps)
+{
+  auto mani = createManifoldFromPolySetWithoutRepair(ps);
   if (mani->getManifold().Status() == Error::NoError) {
     return mani;
   }
@@ -234,6 +256,16 @@ std::shared_ptr<ManifoldGeometry> createManifoldFromPolySet(const PolySet& ps)
   return std::make_shared<ManifoldGeometry>();
 }
 
+std::shared_ptr<const ManifoldGeometry> tryCreateManifoldFromGeometry(const std::shared_ptr<const Geometry>& geom) {
+  if (auto mani = std::dynamic_pointer_cast<const ManifoldGeometry>(geom)) {
+    return mani;
+  }
+  if (auto ps = PolySetUtils::getGeometryAsPolySet(geom)) {
+    return tryCreateManifoldFromPolySet(*ps);
+  }
+  return nullptr;
+}
+
 std::shared_ptr<const ManifoldGeometry> createManifoldFromGeometry(const std::shared_ptr<const Geometry>& geom) {
   if (auto mani = std::dynamic_pointer_cast<const ManifoldGeometry>(geom)) {
     return mani;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "geometry/Geometry.h"
 #include "core/enums.h"
 #include "geometry/manifold/ManifoldGeometry.h"
@@ -11,11 +12,14 @@ namespace ManifoldUtils {
 
   std::shared_ptr<ManifoldGeometry> createManifoldFromPolySet(const PolySet& ps);
   std::shared_ptr<const ManifoldGeometry> createManifoldFromGeometry(const std::shared_ptr<const Geometry>& geom);
+  std::shared_ptr<ManifoldGeometry> tryCreateManifoldFromPolySet(const PolySet& ps);
+  std::shared_ptr<const ManifoldGeometry> tryCreateManifoldFromGeometry(const std::shared_ptr<const Geometry>& geom);
 
   template <class TriangleMesh>
   std::shared_ptr<ManifoldGeometry> createManifoldFromSurfaceMesh(const TriangleMesh& mesh);
 
   std::shared_ptr<ManifoldGeometry> applyOperator3DManifold(const Geometry::Geometries& children, OpenSCADOperator op);
+  std::shared_ptr<ManifoldGeometry> applyUnionBatched(const std::vector<std::shared_ptr<const ManifoldGeometry>>& parts);
 
   Polygon2d polygonsToPolygon2d(const manifold::Polygons& polygons);
 
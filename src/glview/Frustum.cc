@@ -0,0 +1,23 @@
+#include "glview/Frustum.h"
+
+#include <Eigen/Core>
+
+// Extracts the planes from the rows of the clip matrix, after Gribb and Hartmann
+Frustum::Frustum(const Eigen::Matrix4d& clip_matrix)
+{
+  for (int i = 0; i < 3; ++i) {
+    planes[2 * i] = (clip_matrix.row(3) + clip_matrix.row(i)).transpose();
+    planes[2 * i + 1] = (clip_matrix.row(3) - clip_matrix.row(i)).transpose();
+  }
+}
+
+bool Frustum::intersects(const BoundingBox& box) const
+{
+  if (box.isEmpty()) return false;
+  for (const auto& plane : planes) {
+    // The corner furthest inside the plane
+    const Vector3d corner = (plane.head<3>().array() >= 0).select(box.max(), box.min());
+    if (plane.head<3>().dot(corner) + plane[3] < 0) return false;
+  }
+  return true;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+#include <Eigen/Core>
+
+#include "geometry/linalg.h"
+
+/*!
+   The view frustum of a projection and modelview matrix, as the six planes
+   bounding what is drawn. Used to skip objects which are entirely out of view.
+ */
+class Frustum
+{
+public:
+  // clip_matrix is the projection matrix times the modelview matrix
+  explicit Frustum(const Eigen::Matrix4d& clip_matrix);
+
+  // false if the box is certainly outside. Boxes near corners may be kept.
+  [[nodiscard]] bool intersects(const BoundingBox& box) const;
+
+private:
+  std::array<Eigen::Vector4d, 6> planes; // Inside where dot(plane, (x, y, z, 1)) >= 0
+};
@@ -70,6 +70,7 @@ public:
   bool showedges;
   bool showcrosshairs;
   bool showscale;
+  bool camera_moving; // While the user drags the view
   GLdouble modelview[16];
   GLdouble projection[16];
   std::vector<SelectedObject> selected_obj;
@@ -35,3 +35,4 @@ fbo_t *fbo_new() { return nullptr; }
 void fbo_unbind(fbo_t *fbo) {}
 void fbo_delete(fbo_t *fbo) {}
 bool fbo_init(fbo_t *fbo, size_t width, size_t height) { return false; }
+bool fbo_resize(fbo_t *fbo, size_t width, size_t height) { return false; }
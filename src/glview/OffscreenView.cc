@@ -26,19 +26,26 @@ namespace {
 bool save_framebuffer(const OpenGLContext *ctx, std::ostream& output)
 {
   if (!ctx) return false;
+  auto image = read_framebuffer(ctx);
+  return write_png(output, image.pixels.data(), image.width, image.height);
+}
+
+}  // namespace
 
+RGBAImage read_framebuffer(const OpenGLContext *ctx)
+{
   const auto pixels = ctx->getFramebuffer();
 
   const size_t samplesPerPixel = 4; // R, G, B and A
   // Flip it vertically - images read from OpenGL buffers are upside-down
-  std::vector<uint8_t> flippedBuffer(samplesPerPixel * ctx->height() * ctx->width());
-  flip_image(&pixels[0], flippedBuffer.data(), samplesPerPixel, ctx->width(), ctx->height());
-
-  return write_png(output, flippedBuffer.data(), ctx->width(), ctx->height());
+  RGBAImage image;
+  image.width = ctx->width();
+  image.height = ctx->height();
+  image.pixels.resize(samplesPerPixel * ctx->height() * ctx->width());
+  flip_image(&pixels[0], image.pixels.data(), samplesPerPixel, ctx->width(), ctx->height());
+  return image;
 }
 
-}  // namespace
-
 OffscreenView::OffscreenView(uint32_t width, uint32_t height)
 {
   OffscreenContextFactory::ContextAttributes attrib = {
@@ -91,16 +98,29 @@ OffscreenView::OffscreenView(uint32_t width, uint32_t height)
   if (!fbo_init(this->fbo, width, height)) {
     throw OffscreenViewException("Unable to create FBO");
   }
+  RendererUtils::setCurrentShaderCache(&this->shader_cache);
   GLView::initializeGL();
   GLView::resizeGL(width, height);
 }
 
 OffscreenView::~OffscreenView()
 {
+  if (RendererUtils::currentShaderCache() == &this->shader_cache) {
+    RendererUtils::setCurrentShaderCache(nullptr);
+  }
   fbo_unbind(this->fbo);
   fbo_delete(this->fbo);
 }
 
+bool OffscreenView::resize(uint32_t width, uint32_t height)
+{
+  if (width == this->ctx->width() && height == this->ctx->height()) return true;
+  if (!fbo_resize(this->fbo, width, height)) return false;
+  this->ctx->setSize(width, height);
+  GLView::resizeGL(width, height);
+  return true;
+}
+
 #ifdef ENABLE_OPENCSG
 void OffscreenView::display_opencsg_warning()
 {
@@ -126,6 +146,11 @@ bool OffscreenView::save(std::ostream& output) const
   return save_framebuffer(this->ctx.get(), output);
 }
 
+RGBAImage OffscreenView::getImage() const
+{
+  return read_framebuffer(this->ctx.get());
+}
+
 std::string OffscreenView::getRendererInfo() const
 {
   std::ostringstream result;
@@ -9,6 +9,7 @@
 #include "glview/GLView.h"
 #include "glview/OpenGLContext.h"
 #include "glview/fbo.h"
+#include "io/imageutils.h"
 
 class OffscreenViewException : public std::runtime_error
 {
@@ -16,14 +17,22 @@ public:
   OffscreenViewException(const std::string& what_arg) : std::runtime_error(what_arg) {}
 };
 
+// Reads back the current framebuffer of the given context, top row first
+RGBAImage read_framebuffer(const OpenGLContext *ctx);
+
 class OffscreenView : public GLView
 {
 public:
   OffscreenView(uint32_t width, uint32_t height);
   ~OffscreenView() override;
+  // Resizes the framebuffer, so the view can render images of another size
+  bool resize(uint32_t width, uint32_t height);
   bool save(std::ostream& output) const;
+  // Reads back the rendered image, without encoding it
+  [[nodiscard]] RGBAImage getImage() const;
   std::shared_ptr<OpenGLContext> ctx;
   fbo_t *fbo;
+  RendererUtils::ShaderCache shader_cache;
 
   // overrides
   bool save(const char *filename) const override;
@@ -14,6 +14,8 @@ public:
   virtual ~OpenGLContext() = default;
   uint32_t width() const { return this->width_; }
   uint32_t height() const { return this->height_; }
+  // The size read back by getFramebuffer(), after resizing the framebuffer rendered to
+  void setSize(uint32_t width, uint32_t height) { this->width_ = width; this->height_ = height; }
   virtual bool makeCurrent() const = 0;
   virtual std::string getInfo() const = 0;
   std::vector<uint8_t> getFramebuffer() const;
@@ -0,0 +1,229 @@
+#include "glview/PickingBVH.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "glview/cgal/CGALRenderUtils.h"
+#include "utils/parallel.h"
+
+namespace {
+
+// Most primitives in a leaf
+constexpr uint32_t LEAF_SIZE = 4;
+
+/*!
+   Clips the part [t0, t1] of the segment origin + t * dir against the box,
+   given the inverse of dir. Returns false if the segment misses the box.
+ */
+bool clip_segment(const BoundingBox& box, const Vector3d& origin, const Vector3d& inv_dir, double& t0, double& t1)
+{
+  for (int i = 0; i < 3; ++i) {
+    double ta = (box.min()[i] - origin[i]) * inv_dir[i];
+    double tb = (box.max()[i] - origin[i]) * inv_dir[i];
+    if (ta > tb) std::swap(ta, tb);
+    // NaN, for segments within the plane of a side, counts as inside
+    if (ta > t0) t0 = ta;
+    if (tb < t1) t1 = tb;
+    if (t0 > t1) return false;
+  }
+  return true;
+}
+
+} // namespace
+
+PickingBVH::PickingBVH(std::vector<Mesh> meshes) : meshes(std::move(meshes))
+{
+  for (uint32_t m = 0; m < this->meshes.size(); ++m) {
+    const auto& mesh = this->meshes[m];
+    for (uint32_t i = 0; i < mesh.vertices->size(); ++i) {
+      vertices.primitives.push_back({m, 0, {i, 0, 0}});
+    }
+
+    // Edges are shared by neighbouring faces, but only needed once
+    std::vector<std::pair<uint32_t, uint32_t>> mesh_edges;
+    for (uint32_t f = 0; f < mesh.indices->size(); ++f) {
+      const auto& face = (*mesh.indices)[f];
+      for (size_t i = 0; i < face.size(); ++i) {
+        const uint32_t a = face[i];
+        const uint32_t b = face[(i + 1) % face.size()];
+        mesh_edges.emplace_back(std::min(a, b), std::max(a, b));
+      }
+      // Faces of rendered meshes are tessellated, but fan them anyway
+      for (size_t i = 2; i < face.size(); ++i) {
+        triangles.primitives.push_back({m, f, {static_cast<uint32_t>(face[0]), static_cast<uint32_t>(face[i - 1]), static_cast<uint32_t>(face[i])}});
+      }
+    }
+    parallelizable_sort(mesh_edges.begin(), mesh_edges.end(), std::less<>());
+    mesh_edges.erase(std::unique(mesh_edges.begin(), mesh_edges.end()), mesh_edges.end());
+    for (const auto& [a, b] : mesh_edges) {
+      if (a != b) edges.primitives.push_back({m, 0, {a, b, 0}});
+    }
+  }
+
+  const std::array<Tree *, 3> trees{&vertices, &edges, &triangles};
+  parallelizable_for_each(trees.begin(), trees.end(), [this](Tree *tree) { build(*tree); });
+}
+
+void PickingBVH::build(Tree& tree) const
+{
+  if (tree.primitives.empty()) return;
+  std::vector<Item> items;
+  items.reserve(tree.primitives.size());
+  for (const auto& primitive : tree.primitives) {
+    Vector3d center = Vector3d::Zero();
+    for (uint32_t i = 0; i < tree.arity; ++i) center += vertex(primitive, i);
+    items.emplace_back(center / tree.arity, primitive);
+  }
+  tree.nodes.reserve(2 * items.size() / LEAF_SIZE + 1);
+  buildNode(tree, items, 0, items.size());
+  for (size_t i = 0; i < items.size(); ++i) tree.primitives[i] = items[i].second;
+}
+
+// Splits the primitives at the median of their centers along the longest side
+uint32_t PickingBVH::buildNode(Tree& tree, std::vector<Item>& items, uint32_t begin, uint32_t end) const
+{
+  const uint32_t index = tree.nodes.size();
+  tree.nodes.push_back({BoundingBox(), begin, end});
+  if (end - begin <= LEAF_SIZE) {
+    for (uint32_t i = begin; i < end; ++i) {
+      for (uint32_t j = 0; j < tree.arity; ++j) tree.nodes[index].box.extend(vertex(items[i].second, j));
+    }
+    return index;
+  }
+
+  BoundingBox centers;
+  for (uint32_t i = begin; i < end; ++i) centers.extend(items[i].first);
+  int axis;
+  centers.sizes().maxCoeff(&axis);
+  const uint32_t middle = begin + (end - begin) / 2;
+  std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end,
+                   [axis](const Item& a, const Item& b) { return a.first[axis] < b.first[axis]; });
+  buildNode(tree, items, begin, middle);
+  const uint32_t right = buildNode(tree, items, middle, end);
+  auto& node = tree.nodes[index];
+  node.right = right;
+  node.box = tree.nodes[index + 1].box.merged(tree.nodes[right].box);
+  return index;
+}
+
+/*!
+   Calls visit() for the primitives in leaves which the segment passes within
+   tolerance of, nearest first. Leaves starting beyond best_t, which visit()
+   lowers when it finds something, are skipped.
+ */
+template <typename Visit>
+void PickingBVH::traverse(const Tree& tree, const Vector3d& near_pt, const Vector3d& far_pt, double tolerance, double& best_t, const Visit& visit) const
+{
+  if (tree.nodes.empty()) return;
+  const Vector3d inv_dir = (far_pt - near_pt).cwiseInverse();
+  const Vector3d margin = Vector3d::Constant(tolerance);
+  const auto enter = [&](uint32_t index, double& t) {
+    const auto& box = tree.nodes[index].box;
+    double t1 = 1;
+    t = 0;
+    return clip_segment(BoundingBox(box.min() - margin, box.max() + margin), near_pt, inv_dir, t, t1);
+  };
+
+  std::vector<std::pair<double, uint32_t>> stack;
+  double t;
+  if (enter(0, t)) stack.emplace_back(t, 0);
+  while (!stack.empty()) {
+    const auto [t_node, index] = stack.back();
+    stack.pop_back();
+    if (t_node > best_t) continue;
+    const auto& node = tree.nodes[index];
+    if (!node.right) {
+      for (uint32_t i = node.begin; i < node.end; ++i) visit(tree.primitives[i]);
+      continue;
+    }
+    double t_left, t_right;
+    const bool left = enter(index + 1, t_left);
+    const bool right = enter(node.right, t_right);
+    // Pushed last, so the nearer child is visited first
+    if (left && right && t_left > t_right) {
+      stack.emplace_back(t_left, index + 1);
+      stack.emplace_back(t_right, node.right);
+    } else {
+      if (right) stack.emplace_back(t_right, node.right);
+      if (left) stack.emplace_back(t_left, index + 1);
+    }
+  }
+}
+
+std::optional<Vector3d> PickingBVH::findVertex(const Vector3d& near_pt, const Vector3d& far_pt, double tolerance) const
+{
+  const double length = (far_pt - near_pt).norm();
+  if (length == 0) return {};
+  double best_t = 1;
+  std::optional<Vector3d> result;
+  traverse(vertices, near_pt, far_pt, tolerance, best_t, [&](const Primitive& primitive) {
+    const auto& pt = vertex(primitive, 0);
+    double dist_near;
+    const double dist = calculateLinePointDistance(near_pt, far_pt, pt, dist_near);
+    const double t = dist_near / length;
+    if (dist < tolerance && (!result || t < best_t)) {
+      best_t = t;
+      result = pt;
+    }
+  });
+  return result;
+}
+
+std::optional<std::pair<Vector3d, Vector3d>> PickingBVH::findEdge(const Vector3d& near_pt, const Vector3d& far_pt, double tolerance) const
+{
+  const Vector3d dir = far_pt - near_pt;
+  double best_t = 1;
+  std::optional<std::pair<Vector3d, Vector3d>> result;
+  traverse(edges, near_pt, far_pt, tolerance, best_t, [&](const Primitive& primitive) {
+    // The closest points of the lines through the edge and the segment
+    const auto& a = vertex(primitive, 0);
+    const auto& b = vertex(primitive, 1);
+    const Vector3d u = b - a;
+    const Vector3d w = a - near_pt;
+    const double uu = u.dot(u), ud = u.dot(dir), dd = dir.dot(dir), uw = u.dot(w), dw = dir.dot(w);
+    const double denominator = uu * dd - ud * ud;
+    if (denominator <= 1e-12 * uu * dd) return; // Parallel
+    const double s = (ud * dw - dd * uw) / denominator;
+    const double t = (uu * dw - ud * uw) / denominator;
+    if (s < 0 || s > 1 || t < 0 || t > 1) return;
+    if ((a + s * u - (near_pt + t * dir)).norm() < tolerance && (!result || t < best_t)) {
+      best_t = t;
+      result.emplace(a, b);
+    }
+  });
+  return result;
+}
+
+std::optional<PickingBVH::Hit> PickingBVH::intersect(const Vector3d& near_pt, const Vector3d& far_pt) const
+{
+  const Vector3d dir = far_pt - near_pt;
+  double best_t = 1;
+  std::optional<Hit> result;
+  traverse(triangles, near_pt, far_pt, 0, best_t, [&](const Primitive& primitive) {
+    // Möller-Trumbore
+    const auto& a = vertex(primitive, 0);
+    const Vector3d e1 = vertex(primitive, 1) - a;
+    const Vector3d e2 = vertex(primitive, 2) - a;
+    const Vector3d p = dir.cross(e2);
+    const double det = e1.dot(p);
+    if (det == 0) return;
+    const Vector3d s = near_pt - a;
+    const double u = s.dot(p) / det;
+    if (u < 0 || u > 1) return;
+    const Vector3d q = s.cross(e1);
+    const double v = dir.dot(q) / det;
+    if (v < 0 || u + v > 1) return;
+    const double t = e2.dot(q) / det;
+    if (t < 0 || t > 1 || (result && t >= best_t)) return;
+    best_t = t;
+    result = Hit{t, near_pt + t * dir, primitive.mesh, primitive.face};
+  });
+  return result;
+}
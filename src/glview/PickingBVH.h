@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "geometry/linalg.h"
+#include "geometry/GeometryUtils.h"
+
+/*!
+   Bounding volume hierarchies over the vertices, edges and triangles of
+   rendered meshes, for finding what's under the mouse in logarithmic time.
+
+   Queries take the segment from near_pt to far_pt, i.e. the mouse position
+   unprojected onto the near and far clipping planes, and find the feature
+   nearest to near_pt. The meshes are shared, not copied, and must not change.
+ */
+class PickingBVH
+{
+public:
+  // The vertices and faces of a mesh, e.g. of a PolySet, which owner keeps alive
+  struct Mesh {
+    std::shared_ptr<const void> owner;
+    const std::vector<Vector3d> *vertices;
+    const PolygonIndices *indices;
+  };
+
+  explicit PickingBVH(std::vector<Mesh> meshes);
+
+  // The vertex nearest to near_pt which lies within tolerance of the segment
+  [[nodiscard]] std::optional<Vector3d> findVertex(const Vector3d& near_pt, const Vector3d& far_pt, double tolerance) const;
+
+  // The edge nearest to near_pt which passes within tolerance of the segment
+  [[nodiscard]] std::optional<std::pair<Vector3d, Vector3d>> findEdge(const Vector3d& near_pt, const Vector3d& far_pt, double tolerance) const;
+
+  struct Hit {
+    double t; // Position along the segment, from 0 at near_pt to 1 at far_pt
+    Vector3d point;
+    size_t mesh;
+    size_t face;
+  };
+  // The first triangle hit by the segment
+  [[nodiscard]] std::optional<Hit> intersect(const Vector3d& near_pt, const Vector3d& far_pt) const;
+
+private:
+  // A vertex, edge or triangle, by its mesh and vertex indices
+  struct Primitive {
+    uint32_t mesh;
+    uint32_t face;
+    uint32_t v[3];
+  };
+  struct Node {
+    BoundingBox box;
+    uint32_t begin; // Primitives of leaves
+    uint32_t end;
+    uint32_t right{0}; // The right child of inner nodes, whose left child follows them
+  };
+  struct Tree {
+    uint32_t arity; // Vertices per primitive
+    std::vector<Primitive> primitives;
+    std::vector<Node> nodes;
+  };
+  using Item = std::pair<Vector3d, Primitive>; // A primitive and its center, while building
+
+  void build(Tree& tree) const;
+  uint32_t buildNode(Tree& tree, std::vector<Item>& items, uint32_t begin, uint32_t end) const;
+  template <typename Visit>
+  void traverse(const Tree& tree, const Vector3d& near_pt, const Vector3d& far_pt, double tolerance, double& best_t, const Visit& visit) const;
+  [[nodiscard]] const Vector3d& vertex(const Primitive& primitive, size_t i) const {
+    return (*meshes[primitive.mesh].vertices)[primitive.v[i]];
+  }
+
+  std::vector<Mesh> meshes;
+  Tree vertices{1, {}, {}};
+  Tree edges{2, {}, {}};
+  Tree triangles{3, {}, {}};
+};
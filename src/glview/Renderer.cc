@@ -12,6 +12,22 @@
 #include <string>
 #include <vector>
 
+namespace {
+
+RendererUtils::ShaderCache *current_shader_cache = nullptr;
+
+}  // namespace
+
+RendererUtils::ShaderCache *RendererUtils::currentShaderCache()
+{
+  return current_shader_cache;
+}
+
+void RendererUtils::setCurrentShaderCache(ShaderCache *cache)
+{
+  current_shader_cache = cache;
+}
+
 #ifndef NULLGL
 
 
@@ -119,6 +135,15 @@ GLuint compileShaderProgram(const std::string& vs_str, const std::string& fs_str
   return shader_prog;
 }
 
+GLuint ShaderCache::program(const std::string& vs_name, const std::string& fs_name)
+{
+  auto [it, inserted] = programs.try_emplace({vs_name, fs_name}, 0);
+  if (inserted) {
+    it->second = compileShaderProgram(loadShaderSource(vs_name), loadShaderSource(fs_name));
+  }
+  return it->second;
+}
+
 }  // namespace RendererUtils
 
 Renderer::Renderer()
@@ -149,9 +174,14 @@ Renderer::Renderer()
 void Renderer::setupShader() {
   renderer_shader_.progid = 0;
 
-  const std::string vs_str = RendererUtils::loadShaderSource("Preview.vert");
-  const std::string fs_str = RendererUtils::loadShaderSource("Preview.frag");
-  const GLuint shader_prog = RendererUtils::compileShaderProgram(vs_str, fs_str);
+  GLuint shader_prog;
+  if (auto cache = RendererUtils::currentShaderCache()) {
+    shader_prog = cache->program("Preview.vert", "Preview.frag");
+  } else {
+    const std::string vs_str = RendererUtils::loadShaderSource("Preview.vert");
+    const std::string fs_str = RendererUtils::loadShaderSource("Preview.frag");
+    shader_prog = RendererUtils::compileShaderProgram(vs_str, fs_str);
+  }
 
   renderer_shader_.progid = shader_prog;
   renderer_shader_.type = RendererUtils::ShaderType::EDGE_RENDERING;
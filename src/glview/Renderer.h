@@ -12,7 +12,9 @@
 #include <cstdlib>
 #endif
 
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace RendererUtils {
@@ -58,6 +60,25 @@ CSGMode getCsgMode(const bool highlight_mode, const bool background_mode, const
 std::string loadShaderSource(const std::string& name);
 GLuint compileShaderProgram(const std::string& vs_str, const std::string& fs_str);
 
+/*!
+   Shader programs compiled for one OpenGL context, so renderers created one
+   after another in a long-lived context don't compile them again. Whoever
+   owns the context makes its cache current with setCurrentShaderCache().
+ */
+class ShaderCache
+{
+public:
+  // Compiles the program of the given shader sources, or returns the one compiled before
+  GLuint program(const std::string& vs_name, const std::string& fs_name);
+
+private:
+  std::map<std::pair<std::string, std::string>, GLuint> programs;
+};
+
+// The cache of the current context, or nullptr if shaders aren't cached
+ShaderCache *currentShaderCache();
+void setCurrentShaderCache(ShaderCache *cache);
+
 } // namespace RendererUtils
 
 class Renderer
@@ -94,8 +115,14 @@ public:
   virtual void setColorScheme(const ColorScheme& cs);
 
   virtual std::vector<SelectedObject> findModelObject(Vector3d near_pt, Vector3d far_pt, int mouse_x, int mouse_y, double tolerance);
+  // Prepares findModelObject() in the background, so the first query doesn't wait as long
+  virtual void prepareFindModelObject() {}
+
+  // Set by the view while the user moves the camera, when renderers may draw simplified meshes
+  void setCameraMoving(bool moving) { camera_moving_ = moving; }
 
 protected:
+  bool camera_moving_{false};
   std::map<ColorMode, Color4f> colormap_;
   const ColorScheme *colorscheme_{nullptr};
   void setupShader();
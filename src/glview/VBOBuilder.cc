@@ -1,5 +1,6 @@
 #include "glview/VBOBuilder.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cassert>
 #include <array>
@@ -172,10 +173,13 @@ void VBOBuilder::createInterleavedVBOs()
     GL_TRACE0("glBindBuffer(GL_ARRAY_BUFFER, 0)");
     GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
   } else if (!interleaved_buffer_.empty()) {
+    // The buffer was allocated for the worst case, but shared vertices and
+    // instanced surfaces may have used less of it
+    const size_t used_size = std::min(vertices_offset_, interleaved_buffer_.size());
     GL_TRACE("glBindBuffer(GL_ARRAY_BUFFER, %d)", vertices_vbo_);
     GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, vertices_vbo_));
-    GL_TRACE("glBufferData(GL_ARRAY_BUFFER, %d, %p, GL_STATIC_DRAW)", interleaved_buffer_.size() % (void *)interleaved_buffer_.data());
-    GL_CHECKD(glBufferData(GL_ARRAY_BUFFER, interleaved_buffer_.size(), interleaved_buffer_.data(), GL_STATIC_DRAW));
+    GL_TRACE("glBufferData(GL_ARRAY_BUFFER, %d, %p, GL_STATIC_DRAW)", used_size % (void *)interleaved_buffer_.data());
+    GL_CHECKD(glBufferData(GL_ARRAY_BUFFER, used_size, interleaved_buffer_.data(), GL_STATIC_DRAW));
     GL_TRACE0("glBindBuffer(GL_ARRAY_BUFFER, 0)");
     GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
   }
@@ -199,6 +203,14 @@ void VBOBuilder::createInterleavedVBOs()
   }
 }
 
+void VBOBuilder::setVerticesVBO(GLuint vbo)
+{
+  for (const auto& state : states_) {
+    if (state->verticesVBO() == vertices_vbo_) state->setVerticesVBO(vbo);
+  }
+  vertices_vbo_ = vbo;
+}
+
 void VBOBuilder::addAttributePointers(size_t start_offset)
 {
   if (!this->data()) return;
@@ -276,15 +288,12 @@ void VBOBuilder::addAttributePointers(size_t start_offset)
   }
 }
 
-// Allocates GPU memory for vertices (and elements if enabled)
-// for holding the given number of vertices.
+// Allocates memory for vertices (and GPU memory for elements if enabled)
+// for holding the given number of vertices. The vertex VBO is allocated
+// when createInterleavedVBOs() uploads the vertices.
 void VBOBuilder::allocateBuffers(size_t num_vertices) {
   size_t vbo_buffer_size = num_vertices * stride();
   interleaved_buffer_.resize(vbo_buffer_size);
-  GL_TRACE("glBindBuffer(GL_ARRAY_BUFFER, %d)", vertices_vbo_);
-  GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, vertices_vbo_));
-  GL_TRACE("glBufferData(GL_ARRAY_BUFFER, %d, %p, GL_STATIC_DRAW)", vbo_buffer_size % (void *)nullptr);
-  GL_CHECKD(glBufferData(GL_ARRAY_BUFFER, vbo_buffer_size, nullptr, GL_STATIC_DRAW));
   if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
     // Use smallest possible index data type
     if (num_vertices <= 0xff) {
@@ -305,6 +314,17 @@ void VBOBuilder::allocateBuffers(size_t num_vertices) {
   }
 }
 
+GLbyte *VBOBuilder::reserveVertices(size_t num_vertices)
+{
+  const size_t size = num_vertices * data()->stride();
+  if (useElements() || interleaved_buffer_.empty() || vertices_offset_ + size > interleaved_buffer_.size()) {
+    return nullptr;
+  }
+  GLbyte *dst = interleaved_buffer_.data() + vertices_offset_;
+  vertices_offset_ += size;
+  return dst;
+}
+
 void VBOBuilder::addShaderData()
 {
   const std::shared_ptr<VertexData> vertex_data = data();
@@ -301,8 +301,16 @@ public:
     return factory_->createVertexState(draw_mode, draw_size, draw_type, draw_offset, element_offset, vertices_vbo_, elements_vbo_);
   }
 
+  // Sizes the buffers for the given number of vertices. Without elements this
+  // makes no GL calls, so the vertices can be built on any thread, and are
+  // uploaded by createInterleavedVBOs().
   void allocateBuffers(size_t num_vertices);
 
+  // Reserve room for the given number of vertices of the current VertexData in
+  // the interleaved buffer, for writing them directly, and return where it starts.
+  // Returns nullptr unless the buffer was allocated upfront and elements aren't used.
+  GLbyte *reserveVertices(size_t num_vertices);
+
   // Create an interleaved VBO from the VertexData in the array.
   void createInterleavedVBOs();
 
@@ -310,6 +318,9 @@ public:
   void addAttributePointers(size_t start_offset = 0);
 
   inline GLuint verticesVBO() const { return vertices_vbo_; }
+  // Sets the vertex VBO after the vertices were built, e.g. without a GL
+  // context, also in the states which were created for the previous one
+  void setVerticesVBO(GLuint vbo);
   inline size_t verticesOffset() const { return vertices_offset_; }
 
   // Return whether this Vertex Array uses elements (indexed rendering)
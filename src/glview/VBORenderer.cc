@@ -29,13 +29,19 @@
 #include "core/CSGNode.h"
 #include "utils/printutils.h"
 #include "utils/hash.h" // IWYU pragma: keep
+#include "utils/parallel.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <array>
+#include <optional>
 #include <unordered_map>
 #include <utility>
 #include <memory>
 #include <cstddef>
+#include <vector>
 
 namespace VBOUtils {
 
@@ -53,6 +59,167 @@ void shader_attribs_disable(const RendererUtils::ShaderInfo &shaderinfo)
 
 }  // namespace VBOUtils
 
+namespace {
+
+Vector3d triangle_normal(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2)
+{
+  const double ax = p1[0] - p0[0], bx = p1[0] - p2[0];
+  const double ay = p1[1] - p0[1], by = p1[1] - p2[1];
+  const double az = p1[2] - p0[2], bz = p1[2] - p2[2];
+  const double nx = ay * bz - az * by;
+  const double ny = az * bx - ax * bz;
+  const double nz = ax * by - ay * bx;
+  const double nl = std::sqrt(nx * nx + ny * ny + nz * nz);
+  return {nx / nl, ny / nl, nz / nl};
+}
+
+// Barycentric coordinates flagging which edges of a triangle to draw
+std::array<GLubyte, 4> barycentric_flags(size_t active_point_index, size_t primitive_index,
+                                         size_t shape_size, bool outlines)
+{
+  std::array<GLubyte, 4> flags;
+  if (!outlines) {
+    // top / bottom or 3d object
+    if (shape_size == 3) {
+      //true, true, true
+      flags = {0, 0, 0, 0};
+    } else if (shape_size == 4) {
+      //false, true, true
+      flags = {1, 0, 0, 0};
+    } else {
+      //true, false, false
+      flags = {0, 1, 1, 0};
+    }
+  } else {
+    // sides
+    if (primitive_index == 0) {
+      //true, false, true
+      flags = {0, 1, 0, 0};
+    } else {
+      //true, true, false
+      flags = {0, 0, 1, 0};
+    }
+  }
+  flags[active_point_index] = 1;
+  return flags;
+}
+
+template <typename T, size_t N>
+GLbyte *write_attribute(GLbyte *dst, const std::array<T, N>& values)
+{
+  std::memcpy(dst, values.data(), sizeof(values));
+  return dst + sizeof(values);
+}
+
+// Vertex layouts which write_triangles() fills in directly: float position,
+// normal (if any) and color, followed by the barycentric shader attribute (if any).
+struct DirectLayout {
+  bool normal;
+  bool barycentric;
+};
+
+std::optional<DirectLayout> direct_layout(const VertexData& vertex_data, size_t shader_attributes_index)
+{
+  const auto& attributes = vertex_data.attributes();
+  const auto is_float = [&](size_t index, size_t count) {
+    return index < attributes.size() && attributes[index]->glType() == GL_FLOAT && attributes[index]->count() == count;
+  };
+  if (!vertex_data.hasPositionData() || vertex_data.positionIndex() != 0 || !is_float(0, 3)) return {};
+  DirectLayout layout{vertex_data.hasNormalData(), false};
+  size_t index = 1;
+  if (layout.normal) {
+    if (vertex_data.normalIndex() != index || !is_float(index, 3)) return {};
+    ++index;
+  }
+  if (!vertex_data.hasColorData() || vertex_data.colorIndex() != index || !is_float(index, 4)) return {};
+  ++index;
+  if (index < attributes.size()) {
+    if (index != shader_attributes_index || attributes.size() != index + 1 ||
+        attributes[index]->glType() != GL_UNSIGNED_BYTE || attributes[index]->count() != 4) {
+      return {};
+    }
+    layout.barycentric = true;
+  }
+  return layout;
+}
+
+/*!
+   Writes the triangles of a PolySet straight into the preallocated interleaved
+   buffer of vertex_array, giving the same vertices as create_triangle() would.
+   Each face is written to its own range of the buffer, so the faces are
+   written in parallel, and each vertex is transformed once.
+
+   Returns false, having written nothing, if vertex_array needs the generic
+   path, i.e. when it uses elements, has no buffer allocated upfront, or has
+   another vertex layout.
+ */
+template <typename FaceColor>
+bool write_triangles(const PolySet& ps, VBOBuilder& vertex_array, const Transform3d& m,
+                     const FaceColor& face_color, size_t& triangle_count)
+{
+  const auto layout = direct_layout(*vertex_array.data(), vertex_array.shader_attributes_index_);
+  if (!layout) return false;
+
+  std::vector<size_t> first_triangle(ps.indices.size() + 1, 0);
+  for (size_t i = 0; i < ps.indices.size(); ++i) {
+    const size_t size = ps.indices[i].size();
+    // Quads are split in two, other polygons are fanned from their centroid
+    first_triangle[i + 1] = first_triangle[i] + (size == 3 ? 1 : size == 4 ? 2 : size);
+  }
+  GLbyte *const buffer = vertex_array.reserveVertices(first_triangle.back() * 3);
+  if (!buffer) return false;
+  triangle_count = first_triangle.back();
+
+  std::vector<Vector3d> vertices(ps.vertices.size());
+  parallelizable_transform(ps.vertices.begin(), ps.vertices.end(), vertices.begin(),
+                           [&m](const Vector3d& v) -> Vector3d { return m * v; });
+
+  const size_t stride = vertex_array.data()->stride();
+  const bool mirrored = m.matrix().determinant() < 0;
+  const std::array<size_t, 3> order = mirrored ? std::array<size_t, 3>{0, 2, 1} : std::array<size_t, 3>{0, 1, 2};
+
+  parallelizable_for_each(ps.indices.begin(), ps.indices.end(), [&](const IndexedFace& poly) {
+    const size_t i = &poly - ps.indices.data();
+    const Color4f& color = face_color(i);
+    GLbyte *dst = buffer + first_triangle[i] * 3 * stride;
+    const auto triangle = [&](const Vector3d& p0, const Vector3d& p1, const Vector3d& p2, size_t primitive_index) {
+      const std::array<const Vector3d *, 3> points{&p0, &p1, &p2};
+      const Vector3d n = triangle_normal(p0, p1, p2);
+      for (const size_t active : order) {
+        const Vector3d& p = *points[active];
+        dst = write_attribute(dst, std::array<GLfloat, 3>{GLfloat(p[0]), GLfloat(p[1]), GLfloat(p[2])});
+        if (layout->normal) {
+          dst = write_attribute(dst, std::array<GLfloat, 3>{GLfloat(n[0]), GLfloat(n[1]), GLfloat(n[2])});
+        }
+        dst = write_attribute(dst, std::array<GLfloat, 4>{color[0], color[1], color[2], color[3]});
+        if (layout->barycentric) {
+          dst = write_attribute(dst, barycentric_flags(active, primitive_index, poly.size(), false));
+        }
+      }
+    };
+
+    if (poly.size() == 3) {
+      triangle(vertices[poly[0]], vertices[poly[1]], vertices[poly[2]], 0);
+    } else if (poly.size() == 4) {
+      triangle(vertices[poly[0]], vertices[poly[1]], vertices[poly[3]], 0);
+      triangle(vertices[poly[2]], vertices[poly[3]], vertices[poly[1]], 1);
+    } else {
+      Vector3d center = Vector3d::Zero();
+      for (const auto& idx : poly) {
+        center += ps.vertices[idx];
+      }
+      center /= poly.size();
+      const Vector3d p0 = m * center;
+      for (size_t j = 1; j <= poly.size(); j++) {
+        triangle(p0, vertices[poly[j - 1]], vertices[poly[j % poly.size()]], j - 1);
+      }
+    }
+  });
+  return true;
+}
+
+}  // namespace
+
 VBORenderer::VBORenderer()
   : Renderer()
 {
@@ -158,34 +325,8 @@ void VBORenderer::add_shader_attributes(VBOBuilder& vertex_array,
 
   if (getShader().data.color_rendering.barycentric) {
     // Get edge states
-    std::array<GLubyte, 3> barycentric_flags;
-
-    if (!outlines) {
-      // top / bottom or 3d object
-      if (shape_size == 3) {
-        //true, true, true
-        barycentric_flags = {0, 0, 0};
-      } else if (shape_size == 4) {
-        //false, true, true
-        barycentric_flags = {1, 0, 0};
-      } else {
-        //true, false, false
-        barycentric_flags = {0, 1, 1};
-      }
-    } else {
-      // sides
-      if (primitive_index == 0) {
-        //true, false, true
-        barycentric_flags = {0, 1, 0};
-      } else {
-        //true, true, false
-        barycentric_flags = {0, 0, 1};
-      }
-    }
-
-    barycentric_flags[active_point_index] = 1;
-
-    addAttributeValues(*(vertex_data->attributes()[vertex_array.shader_attributes_index_ + BARYCENTRIC_ATTRIB]), barycentric_flags[0], barycentric_flags[1], barycentric_flags[2], 0);
+    const auto flags = barycentric_flags(active_point_index, primitive_index, shape_size, outlines);
+    addAttributeValues(*(vertex_data->attributes()[vertex_array.shader_attributes_index_ + BARYCENTRIC_ATTRIB]), flags[0], flags[1], flags[2], 0);
   }
 }
 
@@ -211,14 +352,7 @@ void VBORenderer::create_triangle(VBOBuilder& vertex_array, const Color4f& color
                                   size_t primitive_index, size_t shape_size,
                                   bool outlines, bool mirror) const
 {
-  const double ax = p1[0] - p0[0], bx = p1[0] - p2[0];
-  const double ay = p1[1] - p0[1], by = p1[1] - p2[1];
-  const double az = p1[2] - p0[2], bz = p1[2] - p2[2];
-  const double nx = ay * bz - az * by;
-  const double ny = az * bx - ax * bz;
-  const double nz = ax * by - ay * bx;
-  const double nl = sqrt(nx * nx + ny * ny + nz * nz);
-  const Vector3d n = Vector3d(nx / nl, ny / nl, nz / nl);
+  const Vector3d n = triangle_normal(p0, p1, p2);
 
   if (!vertex_array.data()) return;
 
@@ -281,49 +415,54 @@ void VBORenderer::create_surface(const PolySet& ps, VBOBuilder& vertex_array,
   }
 
   auto has_colors = !ps.color_indices.empty();
-
-  for (int i = 0, n = ps.indices.size(); i < n; i++) {
-    const auto& poly = ps.indices[i];
+  const auto face_color = [&](size_t i) -> const Color4f& {
     const auto color_index = has_colors && i < ps.color_indices.size() ? ps.color_indices[i] : -1;
-    const auto& color = 
-      !force_default_color && 
-      color_index >= 0 && 
-      color_index < ps.colors.size() && 
-      ps.colors[color_index].isValid() ? 
+    return
+      !force_default_color &&
+      color_index >= 0 &&
+      color_index < ps.colors.size() &&
+      ps.colors[color_index].isValid() ?
       ps.colors[color_index] : default_color;
-    if (poly.size() == 3) {
-      const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
-      const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
-      const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
-
-      create_triangle(vertex_array, color, p0, p1, p2,
-                      0, poly.size(), false, mirrored);
-      triangle_count++;
-    } else if (poly.size() == 4) {
-      const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
-      const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
-      const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
-      const Vector3d p3 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(3)], m);
-
-      create_triangle(vertex_array, color, p0, p1, p3,
-                      0, poly.size(), false, mirrored);
-      create_triangle(vertex_array, color, p2, p3, p1,
-                      1, poly.size(), false, mirrored);
-      triangle_count += 2;
-    } else {
-      Vector3d center = Vector3d::Zero();
-      for (const auto& idx : poly) {
-        center += ps.vertices[idx];
-      }
-      center /= poly.size();
-      for (size_t i = 1; i <= poly.size(); i++) {
-        const Vector3d p0 = uniqueMultiply(vert_mult_map, center, m);
-        const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i % poly.size())], m);
-        const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i - 1)], m);
-
-        create_triangle(vertex_array, color, p0, p2, p1,
-                        i - 1, poly.size(), false, mirrored);
+  };
+
+  if (!write_triangles(ps, vertex_array, m, face_color, triangle_count)) {
+    for (int i = 0, n = ps.indices.size(); i < n; i++) {
+      const auto& poly = ps.indices[i];
+      const auto& color = face_color(i);
+      if (poly.size() == 3) {
+        const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
+        const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
+        const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
+
+        create_triangle(vertex_array, color, p0, p1, p2,
+                        0, poly.size(), false, mirrored);
         triangle_count++;
+      } else if (poly.size() == 4) {
+        const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
+        const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
+        const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
+        const Vector3d p3 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(3)], m);
+
+        create_triangle(vertex_array, color, p0, p1, p3,
+                        0, poly.size(), false, mirrored);
+        create_triangle(vertex_array, color, p2, p3, p1,
+                        1, poly.size(), false, mirrored);
+        triangle_count += 2;
+      } else {
+        Vector3d center = Vector3d::Zero();
+        for (const auto& idx : poly) {
+          center += ps.vertices[idx];
+        }
+        center /= poly.size();
+        for (size_t i = 1; i <= poly.size(); i++) {
+          const Vector3d p0 = uniqueMultiply(vert_mult_map, center, m);
+          const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i % poly.size())], m);
+          const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i - 1)], m);
+
+          create_triangle(vertex_array, color, p0, p2, p1,
+                          i - 1, poly.size(), false, mirrored);
+          triangle_count++;
+        }
       }
     }
   }
@@ -337,6 +476,94 @@ void VBORenderer::create_surface(const PolySet& ps, VBOBuilder& vertex_array,
   vertex_array.addAttributePointers(last_size);
 }
 
+// Shares the vertices of an instance of the same PolySet, so only its draw
+// state and matrix are new. Each instance is drawn with its own modelview
+// matrix, which works with any shader, or without one. Renderers can draw
+// the instances with add_instance_matrices() instead when no shader is used.
+void VBORenderer::create_surface_instance(const VertexState& surface, size_t vertices_offset,
+                                          VBOBuilder& vertex_array, const Transform3d& m) const
+{
+  if (!vertex_array.data()) return;
+
+  vertex_array.states().emplace_back(vertex_array.createVertexState(
+    surface.drawMode(), surface.drawSize(), surface.drawType(),
+    vertex_array.writeIndex(), surface.elementOffset()));
+  vertex_array.addAttributePointers(vertices_offset);
+  add_instance_transform(*vertex_array.states().back(), m);
+}
+
+void VBORenderer::add_instance_transform(VertexState& vs, const Transform3d& m)
+{
+  std::array<GLdouble, 16> matrix;
+  std::copy(m.data(), m.data() + 16, matrix.begin());
+  const bool mirrored = m.matrix().determinant() < 0;
+  vs.glBegin().emplace_back([matrix, mirrored]() {
+    GL_TRACE0("glPushMatrix()");
+    GL_CHECKD(glPushMatrix());
+    GL_TRACE0("glMultMatrixd(matrix)");
+    GL_CHECKD(glMultMatrixd(matrix.data()));
+    // Scaled normals would darken the fixed function lighting
+    GL_TRACE0("glEnable(GL_NORMALIZE)");
+    GL_CHECKD(glEnable(GL_NORMALIZE));
+    if (mirrored) {
+      GL_TRACE0("glFrontFace(GL_CW)");
+      GL_CHECKD(glFrontFace(GL_CW));
+    }
+  });
+  vs.glEnd().emplace_back([mirrored]() {
+    if (mirrored) {
+      GL_TRACE0("glFrontFace(GL_CCW)");
+      GL_CHECKD(glFrontFace(GL_CCW));
+    }
+    GL_TRACE0("glDisable(GL_NORMALIZE)");
+    GL_CHECKD(glDisable(GL_NORMALIZE));
+    GL_TRACE0("glPopMatrix()");
+    GL_CHECKD(glPopMatrix());
+  });
+}
+
+bool VBORenderer::instancing_available()
+{
+  return hasGLExtension(ARB_instanced_arrays) && hasGLExtension(ARB_draw_instanced);
+}
+
+void VBORenderer::add_instance_matrices(VertexState& vs, GLuint program, GLint matrix_location,
+                                        GLuint instances_vbo, size_t first, GLsizei count, bool mirrored)
+{
+  vs.setInstanceCount(count);
+  vs.glBegin().emplace_back([program, matrix_location, instances_vbo, first, mirrored]() {
+    GL_TRACE("glUseProgram(%d)", program);
+    GL_CHECKD(glUseProgram(program));
+    if (mirrored) {
+      GL_TRACE0("glFrontFace(GL_CW)");
+      GL_CHECKD(glFrontFace(GL_CW));
+    }
+    GL_TRACE("glBindBuffer(GL_ARRAY_BUFFER, %d)", instances_vbo);
+    GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, instances_vbo));
+    // A mat4 attribute takes one location per column
+    for (GLuint column = 0; column < 4; ++column) {
+      const GLuint location = matrix_location + column;
+      const size_t offset = (first * 16 + column * 4) * sizeof(GLfloat);
+      GL_CHECKD(glEnableVertexAttribArray(location));
+      // NOLINTNEXTLINE(performance-no-int-to-ptr)
+      GL_CHECKD(glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(GLfloat), (GLvoid *)offset));
+      GL_CHECKD(glVertexAttribDivisorARB(location, 1));
+    }
+  });
+  vs.glEnd().emplace_back([matrix_location, mirrored]() {
+    for (GLuint column = 0; column < 4; ++column) {
+      GL_CHECKD(glVertexAttribDivisorARB(matrix_location + column, 0));
+      GL_CHECKD(glDisableVertexAttribArray(matrix_location + column));
+    }
+    if (mirrored) {
+      GL_TRACE0("glFrontFace(GL_CCW)");
+      GL_CHECKD(glFrontFace(GL_CCW));
+    }
+    GL_TRACE0("glUseProgram(0)");
+    GL_CHECKD(glUseProgram(0));
+  });
+}
+
 void VBORenderer::create_edges(const Polygon2d& polygon,
                                VBOBuilder& vertex_array,
                                const Transform3d& m,
@@ -394,43 +621,46 @@ void VBORenderer::create_polygons(const PolySet& ps, VBOBuilder& vertex_array,
     vertex_array.elementsMap().clear();
   }
 
-  for (const auto& poly : ps.indices) {
-    if (poly.size() == 3) {
-      const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
-      const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
-      const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
+  const auto face_color = [&color](size_t) -> const Color4f& { return color; };
+  if (!write_triangles(ps, vertex_array, m, face_color, triangle_count)) {
+    for (const auto& poly : ps.indices) {
+      if (poly.size() == 3) {
+        const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
+        const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
+        const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
 
-      create_triangle(vertex_array, color, p0, p1, p2,
-                      0, poly.size(), false, mirrored);
-      triangle_count++;
-    } else if (poly.size() == 4) {
-      const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
-      const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
-      const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
-      const Vector3d p3 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(3)], m);
-
-      create_triangle(vertex_array, color, p0, p1, p3,
-                      0, poly.size(), false, mirrored);
-      create_triangle(vertex_array, color, p2, p3, p1,
-                      1, poly.size(), false, mirrored);
-      triangle_count += 2;
-    } else {
-      Vector3d center = Vector3d::Zero();
-      for (const auto& point : poly) {
-        center[0] += ps.vertices[point][0];
-        center[1] += ps.vertices[point][1];
-      }
-      center[0] /= poly.size();
-      center[1] /= poly.size();
-
-      for (size_t i = 1; i <= poly.size(); i++) {
-        const Vector3d p0 = uniqueMultiply(vert_mult_map, center, m);
-        const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i % poly.size())], m);
-        const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i - 1)], m);
-
-        create_triangle(vertex_array, color, p0, p2, p1,
-                        i - 1, poly.size(), false, mirrored);
+        create_triangle(vertex_array, color, p0, p1, p2,
+                        0, poly.size(), false, mirrored);
         triangle_count++;
+      } else if (poly.size() == 4) {
+        const Vector3d p0 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(0)], m);
+        const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(1)], m);
+        const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(2)], m);
+        const Vector3d p3 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(3)], m);
+
+        create_triangle(vertex_array, color, p0, p1, p3,
+                        0, poly.size(), false, mirrored);
+        create_triangle(vertex_array, color, p2, p3, p1,
+                        1, poly.size(), false, mirrored);
+        triangle_count += 2;
+      } else {
+        Vector3d center = Vector3d::Zero();
+        for (const auto& point : poly) {
+          center[0] += ps.vertices[point][0];
+          center[1] += ps.vertices[point][1];
+        }
+        center[0] /= poly.size();
+        center[1] /= poly.size();
+
+        for (size_t i = 1; i <= poly.size(); i++) {
+          const Vector3d p0 = uniqueMultiply(vert_mult_map, center, m);
+          const Vector3d p1 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i % poly.size())], m);
+          const Vector3d p2 = uniqueMultiply(vert_mult_map, ps.vertices[poly.at(i - 1)], m);
+
+          create_triangle(vertex_array, color, p0, p2, p1,
+                          i - 1, poly.size(), false, mirrored);
+          triangle_count++;
+        }
       }
     }
   }
@@ -445,13 +675,16 @@ void VBORenderer::create_polygons(const PolySet& ps, VBOBuilder& vertex_array,
 }
 
 void VBORenderer::add_shader_pointers(VBOBuilder& vertex_array)
+{
+  add_shader_pointers(vertex_array, vertex_array.verticesOffset());
+}
+
+void VBORenderer::add_shader_pointers(VBOBuilder& vertex_array, size_t start_offset)
 {
   const std::shared_ptr<VertexData> vertex_data = vertex_array.data();
 
   if (!vertex_data) return;
 
-  const auto start_offset = vertex_array.verticesOffset();
-
   std::shared_ptr<VertexState> ss = std::make_shared<VBOShaderVertexState>(vertex_array.writeIndex(), 0,
                                                                            vertex_array.verticesVBO(),
                                                                            vertex_array.elementsVBO());
@@ -482,7 +715,12 @@ void VBORenderer::add_shader_pointers(VBOBuilder& vertex_array)
 
 void VBORenderer::add_color(VBOBuilder& vertex_array, const Color4f& color)
 {
-  add_shader_pointers(vertex_array);
+  add_color(vertex_array, color, vertex_array.verticesOffset());
+}
+
+void VBORenderer::add_color(VBOBuilder& vertex_array, const Color4f& color, size_t vertices_offset)
+{
+  add_shader_pointers(vertex_array, vertices_offset);
   const RendererUtils::ShaderInfo shader_info = getShader();
   std::shared_ptr<VertexState> color_state = std::make_shared<VBOShaderVertexState>(0, 0, vertex_array.verticesVBO(), vertex_array.elementsVBO());
   color_state->glBegin().emplace_back([shader_info, color]() {
@@ -59,8 +59,25 @@ public:
                              const std::array<Vector3d, 3>& normals,
                              size_t active_point_index = 0, size_t primitive_index = 0,
                              size_t shape_size = 0, bool outlines = false, bool mirror = false) const;
+  // Draws a surface created earlier by create_surface(), whose vertices start at
+  // vertices_offset, again, transformed by m on the GPU instead of copying its vertices
+  virtual void create_surface_instance(const VertexState& surface, size_t vertices_offset,
+                                       VBOBuilder& vertex_array, const Transform3d& m) const;
+  // Makes a state transform its vertices by m when drawn
+  static void add_instance_transform(VertexState& vs, const Transform3d& m);
+  // Whether add_instance_matrices() can be used, which requires ARB_instanced_arrays
+  static bool instancing_available();
+  // Makes a state draw its vertices once per matrix, in one instanced draw call
+  // with the given program. The count column-major matrices start at matrix
+  // first of instances_vbo, and are passed as the mat4 attribute at matrix_location.
+  static void add_instance_matrices(VertexState& vs, GLuint program, GLint matrix_location,
+                                    GLuint instances_vbo, size_t first, GLsizei count, bool mirrored);
+
   void add_shader_pointers(VBOBuilder& vertex_array); // This could stay protected, were it not for VertexStateManager
+  void add_shader_pointers(VBOBuilder& vertex_array, size_t start_offset);
   void add_color(VBOBuilder& vertex_array, const Color4f& color);
+  // Like add_color(), for the surface whose vertices start at vertices_offset
+  void add_color(VBOBuilder& vertex_array, const Color4f& color, size_t vertices_offset);
 
 protected:
   void add_shader_data(VBOBuilder& vertex_array);
@@ -31,8 +31,14 @@ void VertexState::draw() const
                 draw_type_ == GL_UNSIGNED_SHORT ? "GL_UNSIGNED_SHORT" :
                 draw_type_ == GL_UNSIGNED_INT ? "GL_UNSIGNED_INT" :
                 "UNKNOWN") % element_offset_);
-      // NOLINTNEXTLINE(performance-no-int-to-ptr)
-      glDrawElements(draw_mode_, draw_size_, draw_type_, (GLvoid *)element_offset_);
+      if (instance_count_ > 0) {
+        GL_TRACE("glDrawElementsInstancedARB(%d instances)", instance_count_);
+        // NOLINTNEXTLINE(performance-no-int-to-ptr)
+        glDrawElementsInstancedARB(draw_mode_, draw_size_, draw_type_, (GLvoid *)element_offset_, instance_count_);
+      } else {
+        // NOLINTNEXTLINE(performance-no-int-to-ptr)
+        glDrawElements(draw_mode_, draw_size_, draw_type_, (GLvoid *)element_offset_);
+      }
     } else {
       GL_TRACE("glDrawArrays(%s, 0, %d)",
                (draw_mode_ == GL_POINTS ? "GL_POINTS" :
@@ -46,7 +52,12 @@ void VertexState::draw() const
                 draw_mode_ == GL_QUAD_STRIP ? "GL_QUAD_STRIP" :
                 draw_mode_ == GL_POLYGON ? "GL_POLYGON" :
                 "UNKNOWN") % draw_size_);
-      glDrawArrays(draw_mode_, 0, draw_size_);
+      if (instance_count_ > 0) {
+        GL_TRACE("glDrawArraysInstancedARB(%d instances)", instance_count_);
+        glDrawArraysInstancedARB(draw_mode_, 0, draw_size_, instance_count_);
+      } else {
+        glDrawArrays(draw_mode_, 0, draw_size_);
+      }
     }
   }
   for (const auto& gl_func : gl_end_) {
@@ -58,6 +58,10 @@ public:
   [[nodiscard]] inline size_t elementOffset() const { return element_offset_; }
   // Set the Element VBO offset for glDrawElements call
   inline void setElementOffset(size_t element_offset) { element_offset_ = element_offset; }
+  // Draws the vertices this many times in one instanced draw call, if nonzero.
+  // Requires ARB_draw_instanced.
+  [[nodiscard]] inline GLsizei instanceCount() const { return instance_count_; }
+  inline void setInstanceCount(GLsizei instance_count) { instance_count_ = instance_count; }
 
   // Wrap glDrawArrays/glDrawElements call and use gl_begin/gl_end state information
   virtual void draw() const;
@@ -79,6 +83,7 @@ private:
   size_t element_offset_;
   GLuint vertices_vbo_;
   GLuint elements_vbo_;
+  GLsizei instance_count_{0};
   std::vector<std::function<void()>> gl_begin_;
   std::vector<std::function<void()>> gl_end_;
 };
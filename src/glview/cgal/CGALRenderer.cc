@@ -27,7 +27,12 @@
 #include "glview/cgal/CGALRenderer.h"
 
 #include <cassert>
+#include <chrono>
+#include <exception>
+#include <future>
 #include <limits>
+#include <thread>
+#include <type_traits>
 #include <utility>
 #include <memory>
 
@@ -39,9 +44,10 @@
 #include "Feature.h"
 #include "geometry/PolySet.h"
 #include "geometry/PolySetUtils.h"
+#include "glview/Frustum.h"
+#include "glview/cgal/CGALRenderUtils.h"
 #include "utils/printutils.h"
 
-#include "glview/cgal/CGALRenderUtils.h"
 #ifdef ENABLE_CGAL
 #include "glview/cgal/VBOPolyhedron.h"
 #endif
@@ -54,6 +60,44 @@
 
 // #include "gui/Preferences.h"
 
+namespace {
+
+// Meshes with more triangles are simplified to LOD_TRIANGLES while the camera moves
+constexpr size_t LOD_MIN_TRIANGLES = 1000000;
+constexpr size_t LOD_TRIANGLES = 250000;
+
+// The frustum of the current OpenGL projection and modelview matrices
+Frustum currentFrustum()
+{
+  // OpenGL matrices are column major, like Eigen's
+  Eigen::Matrix4d modelview, projection;
+  glGetDoublev(GL_MODELVIEW_MATRIX, modelview.data());
+  glGetDoublev(GL_PROJECTION_MATRIX, projection.data());
+  return Frustum(projection * modelview);
+}
+
+/*!
+   Runs job on a detached thread. Unlike a future from std::async, the
+   returned one doesn't wait for the job when it's destroyed, so closing or
+   replacing the renderer doesn't block on background work.
+ */
+template <typename Job>
+std::shared_future<std::invoke_result_t<Job>> runInBackground(Job job)
+{
+  std::promise<std::invoke_result_t<Job>> promise;
+  auto future = promise.get_future().share();
+  std::thread([promise = std::move(promise), job = std::move(job)]() mutable {
+    try {
+      promise.set_value(job());
+    } catch (...) {
+      promise.set_exception(std::current_exception());
+    }
+  }).detach();
+  return future;
+}
+
+} // namespace
+
 CGALRenderer::CGALRenderer(const std::shared_ptr<const class Geometry> &geom) {
   this->addGeometry(geom);
   PRINTD("CGALRenderer::CGALRenderer() -> createPolyhedrons()");
@@ -104,6 +148,9 @@ CGALRenderer::~CGALRenderer() {
   if (polyset_elements_vbo_) {
     glDeleteBuffers(1, &polyset_elements_vbo_);
   }
+  if (lod_vertices_vbo_) {
+    glDeleteBuffers(1, &lod_vertices_vbo_);
+  }
 }
 
 #ifdef ENABLE_CGAL
@@ -135,6 +182,8 @@ void CGALRenderer::setColorScheme(const ColorScheme &cs) {
   this->polyhedrons_.clear(); // Mark as dirty
 #endif
   this->vertex_states_.clear(); // Mark as dirty
+  this->lod_vertex_states_.clear();
+  this->lod_states_created_ = false;
   PRINTD("setColorScheme done");
 }
 
@@ -142,6 +191,9 @@ void CGALRenderer::createPolySetStates() {
   PRINTD("createPolySetStates() polyset");
 
   vertex_states_.clear();
+  polyset_states_.clear();
+  lod_vertex_states_.clear();
+  lod_states_created_ = false;
 
   glGenBuffers(1, &polyset_vertices_vbo_);
   if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
@@ -177,6 +229,7 @@ void CGALRenderer::createPolySetStates() {
     getColor(ColorMode::MATERIAL, color);
     this->create_surface(*polyset, vertex_array, RendererUtils::CSGMODE_NORMAL,
                          Transform3d::Identity(), color);
+    polyset_states_.push_back({polyset->getBoundingBox(), vertex_states_.back(), nullptr});
   }
 
   for (const auto &[polygon, polyset] : this->polygons_) {
@@ -232,11 +285,60 @@ void CGALRenderer::createPolySetStates() {
   }
 }
 
+// Uploads the simplified meshes once all of them are done
+void CGALRenderer::createLODStates() {
+  for (const auto &[index, lod_polyset] : lod_polysets_) {
+    if (lod_polyset.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+  }
+  PRINTD("createLODStates()");
+  lod_states_created_ = true;
+
+  size_t num_vertices = 0;
+  for (const auto &[index, lod_polyset] : lod_polysets_) {
+    if (lod_polyset.get()) num_vertices += getSurfaceBufferSize(*lod_polyset.get());
+  }
+  // None of the meshes could be simplified
+  if (num_vertices == 0) return;
+
+  if (!lod_vertices_vbo_) glGenBuffers(1, &lod_vertices_vbo_);
+  VBOBuilder vertex_array(std::make_unique<VertexStateFactory>(),
+                           lod_vertex_states_, lod_vertices_vbo_, 0);
+  vertex_array.addSurfaceData();
+  vertex_array.allocateBuffers(num_vertices);
+
+  Color4f color;
+  getColor(ColorMode::MATERIAL, color);
+  for (const auto &[index, lod_polyset] : lod_polysets_) {
+    if (!lod_polyset.get()) continue;
+    vertex_array.writeSurface();
+    this->create_surface(*lod_polyset.get(), vertex_array, RendererUtils::CSGMODE_NORMAL,
+                         Transform3d::Identity(), color);
+    polyset_states_[index].lod_state = lod_vertex_states_.back();
+  }
+
+  GL_TRACE0("glBindBuffer(GL_ARRAY_BUFFER, 0)");
+  GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
+  vertex_array.createInterleavedVBOs();
+}
+
 void CGALRenderer::prepare(bool /*showedges*/,
                            const RendererUtils::ShaderInfo * /*shaderinfo*/) {
   PRINTD("prepare()");
   if (!vertex_states_.size())
     createPolySetStates();
+
+  // Simplify large meshes only when needed, not for a single still image
+  if (camera_moving_ && lod_polysets_.empty()) {
+    for (size_t i = 0; i < this->polysets_.size(); ++i) {
+      if (this->polysets_[i]->indices.size() < LOD_MIN_TRIANGLES) continue;
+      lod_polysets_.emplace_back(i, runInBackground([polyset = this->polysets_[i]]() {
+        return std::shared_ptr<const PolySet>(PolySetUtils::simplify(*polyset, LOD_TRIANGLES));
+      }));
+    }
+  }
+  if (!lod_polysets_.empty() && !lod_states_created_) {
+    createLODStates();
+  }
 #ifdef ENABLE_CGAL
   if (!this->nefPolyhedrons_.empty() && this->polyhedrons_.empty())
     createPolyhedrons();
@@ -256,7 +358,18 @@ void CGALRenderer::draw(bool showedges, const RendererUtils::ShaderInfo * /*shad
   GL_CHECKD(glGetFloatv(GL_POINT_SIZE, &current_point_size));
   GL_CHECKD(glGetFloatv(GL_LINE_WIDTH, &current_line_width));
 
+  // Skip meshes out of view, and draw large ones simplified while the camera moves
+  const auto frustum = currentFrustum();
+  auto polyset_state = polyset_states_.begin();
   for (const auto &vertex_state : vertex_states_) {
+    if (polyset_state != polyset_states_.end() && vertex_state == polyset_state->state) {
+      const auto &state = *polyset_state++;
+      if (!frustum.intersects(state.bbox)) continue;
+      if (camera_moving_ && state.lod_state) {
+        state.lod_state->draw();
+        continue;
+      }
+    }
     if (vertex_state)
       vertex_state->draw();
   }
@@ -303,9 +416,50 @@ BoundingBox CGALRenderer::getBoundingBox() const {
   return bbox;
 }
 
+void CGALRenderer::prepareFindModelObject() {
+  if (picking_bvh_.valid()) return;
+  std::vector<PickingBVH::Mesh> meshes;
+  for (const auto &ps : this->polysets_) {
+    meshes.push_back({ps, &ps->vertices, &ps->indices});
+  }
+  for (const auto &[polygon, ps] : this->polygons_) {
+    meshes.push_back({ps, &ps->vertices, &ps->indices});
+  }
+  picking_bvh_ = runInBackground([meshes = std::move(meshes)]() mutable {
+    return std::make_shared<const PickingBVH>(std::move(meshes));
+  });
+}
+
 std::vector<SelectedObject>
 CGALRenderer::findModelObject(Vector3d near_pt, Vector3d far_pt, int mouse_x,
                               int mouse_y, double tolerance) {
+  prepareFindModelObject();
+  // Until the hierarchy is built, search every vertex and edge rather than block the GUI
+  if (picking_bvh_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+    return findModelObjectBruteForce(near_pt, far_pt, tolerance);
+  }
+  const auto bvh = picking_bvh_.get();
+  if (const auto pt = bvh->findVertex(near_pt, far_pt, tolerance)) {
+    SelectedObject obj = {
+      .type = SelectionType::SELECTION_POINT,
+      .p1 = *pt
+    };
+    return std::vector<SelectedObject>{obj};
+  }
+  if (const auto edge = bvh->findEdge(near_pt, far_pt, tolerance)) {
+    SelectedObject obj = {
+      .type = SelectionType::SELECTION_LINE,
+      .p1 = edge->first,
+      .p2 = edge->second,
+    };
+    return std::vector<SelectedObject>{obj};
+  }
+  return {};
+}
+
+std::vector<SelectedObject>
+CGALRenderer::findModelObjectBruteForce(const Vector3d& near_pt, const Vector3d& far_pt,
+                                        double tolerance) const {
   double dist_near;
   double dist_nearest = std::numeric_limits<double>::max();
   Vector3d pt1_nearest;
@@ -334,18 +488,26 @@ CGALRenderer::findModelObject(Vector3d near_pt, Vector3d far_pt, int mouse_x,
     return std::vector<SelectedObject>{obj};
   }
 
+  // The closest points of the lines through each edge and the segment, as in PickingBVH::findEdge()
+  const Vector3d dir = far_pt - near_pt;
+  double t_nearest = std::numeric_limits<double>::max();
   const auto find_nearest_line = [&](const std::vector<Vector3d> &vertices, const PolygonIndices& indices) {
     for (const auto &poly : indices) {
-      for (int i = 0; i < poly.size(); i++) {
-        int ind1 = poly[i];
-        int ind2 = poly[(i + 1) % poly.size()];
-        double dist_lat;
-        double dist_norm = fabs(calculateLineLineDistance(
-            vertices[ind1], vertices[ind2], near_pt, far_pt, dist_lat));
-        if (dist_lat >= 0 && dist_lat <= 1 && dist_norm < tolerance) {
-          dist_nearest = dist_lat;
-          pt1_nearest = vertices[ind1];
-          pt2_nearest = vertices[ind2];
+      for (size_t i = 0; i < poly.size(); i++) {
+        const Vector3d &a = vertices[poly[i]];
+        const Vector3d &b = vertices[poly[(i + 1) % poly.size()]];
+        const Vector3d u = b - a;
+        const Vector3d w = a - near_pt;
+        const double uu = u.dot(u), ud = u.dot(dir), dd = dir.dot(dir), uw = u.dot(w), dw = dir.dot(w);
+        const double denominator = uu * dd - ud * ud;
+        if (denominator <= 1e-12 * uu * dd) continue;
+        const double s = (ud * dw - dd * uw) / denominator;
+        const double t = (uu * dw - ud * uw) / denominator;
+        if (s < 0 || s > 1 || t < 0 || t > 1 || t >= t_nearest) continue;
+        if ((a + s * u - (near_pt + t * dir)).norm() < tolerance) {
+          t_nearest = t;
+          pt1_nearest = a;
+          pt2_nearest = b;
         }
       }
     }
@@ -356,7 +518,7 @@ CGALRenderer::findModelObject(Vector3d near_pt, Vector3d far_pt, int mouse_x,
   for (const auto &[polygon, ps] : this->polygons_) {
     find_nearest_line(ps->vertices, ps->indices);
   }
-  if (dist_nearest < std::numeric_limits<double>::max()) {
+  if (t_nearest < std::numeric_limits<double>::max()) {
     SelectedObject obj = {
       .type = SelectionType::SELECTION_LINE,
       .p1 = pt1_nearest,
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <future>
 #include <utility>
 #include <memory>
 #include <vector>
 
+#include "glview/PickingBVH.h"
 #include "glview/VBORenderer.h"
 #ifdef ENABLE_CGAL
 #include "geometry/cgal/CGAL_Nef_polyhedron.h"
@@ -19,14 +21,17 @@ public:
   void setColorScheme(const ColorScheme& cs) override;
   BoundingBox getBoundingBox() const override;
   std::vector<SelectedObject> findModelObject(Vector3d near_pt, Vector3d far_pt, int mouse_x, int mouse_y, double tolerance) override;
+  void prepareFindModelObject() override;
 
 private:
   void addGeometry(const std::shared_ptr<const class Geometry>& geom);
+  std::vector<SelectedObject> findModelObjectBruteForce(const Vector3d& near_pt, const Vector3d& far_pt, double tolerance) const;
 #ifdef ENABLE_CGAL
   const std::vector<std::shared_ptr<class VBOPolyhedron>>& getPolyhedrons() const { return this->polyhedrons_; }
   void createPolyhedrons();
 #endif
   void createPolySetStates();
+  void createLODStates();
   bool last_render_state_; // FIXME: this is temporary to make switching between renderers seamless.
 
   std::vector<std::shared_ptr<const class PolySet>> polysets_;
@@ -36,7 +41,25 @@ private:
   std::vector<std::shared_ptr<const CGAL_Nef_polyhedron>> nefPolyhedrons_;
 #endif
 
+  // Built on a detached background thread when first needed
+  std::shared_future<std::shared_ptr<const PickingBVH>> picking_bvh_;
+
   std::vector<std::shared_ptr<VertexState>> vertex_states_;
   GLuint polyset_vertices_vbo_{0};
   GLuint polyset_elements_vbo_{0};
+
+  // The surface of a 3D PolySet, skipped when it's out of view
+  struct PolySetState {
+    BoundingBox bbox;
+    std::shared_ptr<VertexState> state;
+    std::shared_ptr<VertexState> lod_state; // Drawn instead while the camera moves
+  };
+  std::vector<PolySetState> polyset_states_;
+
+  // Simplified versions of large PolySets, by index into polysets_. They
+  // are built on background threads once the camera first moves.
+  std::vector<std::pair<size_t, std::shared_future<std::shared_ptr<const PolySet>>>> lod_polysets_;
+  std::vector<std::shared_ptr<VertexState>> lod_vertex_states_;
+  bool lod_states_created_{false}; // Also when no mesh could be simplified
+  GLuint lod_vertices_vbo_{0};
 };
@@ -1,9 +1,14 @@
 #include "glview/preview/CSGTreeNormalizer.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
 #include <utility>
 #include <memory>
 #include <stack>
+#include <vector>
 
 #include "core/CSGNode.h"
 #include "utils/printutils.h"
@@ -27,12 +32,205 @@ std::shared_ptr<CSGNode> CSGTreeNormalizer::normalize(const std::shared_ptr<CSGN
 {
   this->aborted = false;
   this->nodecount = 0;
+
+  // Each product adds a node, so trees which would certainly grow past the
+  // limit are rejected before doing the exponential work
+  const auto products = estimateProducts(root, this->limit + 2);
+  if (products && *products > this->limit + 1) {
+    LOG(message_group::Warning, "Normalized tree would grow past %1$d elements. Aborting normalization.\n", this->limit);
+    this->aborted = true;
+    return {};
+  }
+
   std::shared_ptr<CSGNode> temp = root;
   temp = normalizePass(temp);
+  if (OpenSCAD::debug != "" && products && !this->aborted) {
+    // Checked by csgnormalizertest, as the estimate must never exceed the actual count
+    CSGProducts normalized;
+    if (temp) normalized.import(temp);
+    PRINTDB("Estimated at least %d products, normalized to %d", *products % normalized.size());
+  }
   this->rootnode.reset();
+  this->created_nodes.clear();
+  this->normalized_terms.clear();
   return temp;
 }
 
+namespace {
+
+// A product of the normalized tree: the box of its intersected terms, and the subtrees subtracted from it
+struct ProductEstimate {
+  BoundingBox bbox;
+  std::vector<const CSGNode *> subtractions;
+};
+using ProductEstimates = std::vector<ProductEstimate>;
+
+bool overlaps(const BoundingBox& a, const BoundingBox& b)
+{
+  return !a.intersection(b).isEmpty();
+}
+
+} // namespace
+
+/*!
+   Finds a lower bound of the number of products in the normalized tree without
+   building it, by following which products the rewrite rules create.
+
+   x + y has the products of both, and x * y the product of each pair. x - y
+   has the products of x, and y is expanded when it's subtracted from each:
+   x - (y + z) multiplies them by the products of subtracting z (rule 1),
+   x - (y * z) adds those of x - y and x - z (rule 3), and x - (y - z) has at
+   least those of x - y (rule 5).
+
+   Pairs whose bounding boxes don't overlap are dropped, as
+   CSGOperation::createCSGNode() prunes them. Boxes are tested against the
+   intersection of the product's terms, which is never larger than the boxes
+   the rewrite rules test against, so at most as many products are counted.
+
+   Returns max_products + 1 once more are found, or nullopt if the tree is too
+   large to estimate quickly.
+ */
+std::optional<size_t> CSGTreeNormalizer::estimateProducts(const std::shared_ptr<CSGNode>& root, size_t max_products)
+{
+  if (!root) return 0;
+  size_t work = 0;
+  const size_t max_work = std::max<size_t>(1 << 20, 64 * max_products);
+
+  // Subtracted subtrees aren't normalized on their own, so only the left side of differences is followed
+  const auto positive_children = [](const CSGOperation& op) {
+    if (op.getType() == OpenSCADOperator::DIFFERENCE) return std::vector<const CSGNode *>{op.left().get()};
+    return std::vector<const CSGNode *>{op.left().get(), op.right().get()};
+  };
+
+  // Parents of each node, so shared subtrees are estimated once and product lists can be moved once consumed
+  std::unordered_map<const CSGNode *, size_t> parents;
+  std::vector<const CSGNode *> stack{root.get()};
+  parents[root.get()] = 0;
+  while (!stack.empty()) {
+    const auto op = dynamic_cast<const CSGOperation *>(stack.back());
+    stack.pop_back();
+    if (!op) continue;
+    for (const auto child : positive_children(*op)) {
+      if (child && parents[child]++ == 0) stack.push_back(child);
+    }
+    if (++work > max_work) return {};
+  }
+
+  std::unordered_map<const CSGNode *, ProductEstimates> estimates;
+  const auto take = [&](const CSGNode *child) {
+    auto it = estimates.find(child);
+    if (--parents[child] > 0) return it->second;
+    auto products = std::move(it->second);
+    estimates.erase(it);
+    return products;
+  };
+
+  // Post order traversal, without recursion for deep trees
+  std::vector<std::pair<const CSGNode *, bool>> callstack{{root.get(), false}};
+  while (!callstack.empty()) {
+    auto [node, children_done] = callstack.back();
+    callstack.pop_back();
+    if (estimates.count(node)) continue;
+    const auto op = dynamic_cast<const CSGOperation *>(node);
+    if (!op) {
+      ProductEstimates products;
+      if (!node->isEmptySet()) products.push_back({node->getBoundingBox(), {}});
+      estimates.emplace(node, std::move(products));
+      continue;
+    }
+    if (!children_done) {
+      callstack.emplace_back(node, true);
+      for (const auto child : positive_children(*op)) {
+        if (child && !estimates.count(child)) callstack.emplace_back(child, false);
+      }
+      continue;
+    }
+
+    ProductEstimates products;
+    switch (op->getType()) {
+    case OpenSCADOperator::UNION:
+      products = take(op->left().get());
+      for (auto& product : take(op->right().get())) products.push_back(std::move(product));
+      break;
+    case OpenSCADOperator::INTERSECTION: {
+      const auto left = take(op->left().get());
+      const auto right = take(op->right().get());
+      work += left.size() * right.size();
+      if (work > max_work) return {};
+      for (const auto& a : left) {
+        for (const auto& b : right) {
+          auto bbox = a.bbox.intersection(b.bbox);
+          if (bbox.isEmpty()) continue;
+          auto subtractions = a.subtractions;
+          subtractions.insert(subtractions.end(), b.subtractions.begin(), b.subtractions.end());
+          products.push_back({bbox, std::move(subtractions)});
+        }
+      }
+      break;
+    }
+    case OpenSCADOperator::DIFFERENCE:
+      products = take(op->left().get());
+      for (auto& product : products) product.subtractions.push_back(op->right().get());
+      break;
+    default:
+      assert(false);
+    }
+    if (products.size() > max_products) return max_products + 1;
+    estimates.emplace(node, std::move(products));
+  }
+
+  // Number of products left of subtracting term from a product with the given box
+  std::unordered_map<const CSGNode *, double> subtracted;
+  const auto count_subtracted = [&](const CSGNode *term, const BoundingBox& bbox) -> std::optional<double> {
+    subtracted.clear();
+    std::vector<std::pair<const CSGNode *, bool>> callstack{{term, false}};
+    while (!callstack.empty()) {
+      auto [node, children_done] = callstack.back();
+      callstack.pop_back();
+      if (subtracted.count(node)) continue;
+      if (++work > max_work) return {};
+      const auto op = dynamic_cast<const CSGOperation *>(node);
+      if (!op || !overlaps(bbox, node->getBoundingBox())) {
+        subtracted.emplace(node, 1);
+        continue;
+      }
+      const auto left = op->left().get();
+      const auto right = op->right().get();
+      if (!children_done) {
+        callstack.emplace_back(node, true);
+        if (!subtracted.count(left)) callstack.emplace_back(left, false);
+        if (op->getType() != OpenSCADOperator::DIFFERENCE && !subtracted.count(right)) callstack.emplace_back(right, false);
+        continue;
+      }
+      switch (op->getType()) {
+      case OpenSCADOperator::UNION:
+        subtracted.emplace(node, subtracted[left] * subtracted[right]);
+        break;
+      case OpenSCADOperator::INTERSECTION:
+        subtracted.emplace(node, subtracted[left] + subtracted[right]);
+        break;
+      default:
+        subtracted.emplace(node, subtracted[left]);
+      }
+    }
+    return subtracted[term];
+  };
+
+  double total = 0;
+  for (const auto& product : estimates[root.get()]) {
+    double count = 1;
+    for (const auto term : product.subtractions) {
+      const auto terms = count_subtracted(term, product.bbox);
+      if (!terms) return {};
+      count *= *terms;
+      if (total + count > max_products) return max_products + 1;
+    }
+    total += count;
+    if (total > max_products) return max_products + 1;
+  }
+  return static_cast<size_t>(total);
+}
+
 /*!
    After aborting, a subtree might have become invalidated (nullptr child node)
    since terms can be instantiated multiple times.
@@ -87,6 +285,18 @@ std::shared_ptr<CSGNode> CSGTreeNormalizer::normalizePass(std::shared_ptr<CSGNod
 
 entrypoint:
   if (std::dynamic_pointer_cast<CSGLeaf>(node)) goto return_node;
+  if (const auto it = this->normalized_terms.find(node.get()); it != this->normalized_terms.end()) {
+    // A shared subtree, which was already normalized. It still counts
+    // towards the limit, since it's instantiated again in the products.
+    this->nodecount += it->second.size;
+    if (nodecount > this->limit) {
+      LOG(message_group::Warning, "Normalized tree is growing past %1$d elements. Aborting normalization.\n", this->limit);
+      this->aborted = true;
+      return {};
+    }
+    node = it->second.result;
+    goto return_node;
+  }
   do {
     while (node && match_and_replace(node)) {
     }
@@ -117,17 +327,19 @@ return_node:
   if (callstack.empty()) {
     return node;
   } else {
-    stackframe_t frame = callstack.top();
+    auto [parent, is_left] = callstack.top();
     callstack.pop();
-    if (frame.second) { // came from a left call
-      frame.first->left() = node;
-      node = frame.first;
-      goto cont_left;
-    } else { // came from a right call
-      frame.first->right() = node;
-      node = frame.first;
-      goto cont_right;
+    auto& child = is_left ? parent->left() : parent->right();
+    if (std::dynamic_pointer_cast<CSGOperation>(child)) {
+      // Normalizing the result again would not change it either
+      const size_t size = normalizedSize(node);
+      this->normalized_terms.try_emplace(child.get(), NormalizedTerm{child, node, size});
+      if (node) this->normalized_terms.try_emplace(node.get(), NormalizedTerm{node, node, size});
     }
+    child = node;
+    node = parent;
+    if (is_left) goto cont_left;
+    else goto cont_right;
   }
 normalize_left_if_op:
   if (std::shared_ptr<CSGOperation> op = std::dynamic_pointer_cast<CSGOperation>(node)) {
@@ -144,6 +356,32 @@ normalize_right:
   goto entrypoint;
 }
 
+// Like CSGOperation::createCSGNode(), but returns the same node for the same operands
+std::shared_ptr<CSGNode> CSGTreeNormalizer::createCSGNode(OpenSCADOperator type, const std::shared_ptr<CSGNode>& left, const std::shared_ptr<CSGNode>& right)
+{
+  const NodeKey key(static_cast<int>(type), left.get(), right.get());
+  auto [it, inserted] = this->created_nodes.try_emplace(key);
+  if (inserted) {
+    it->second = {left, right, CSGOperation::createCSGNode(type, left, right)};
+  }
+  return it->second.node;
+}
+
+// Operations in a normalized term, counting shared subtrees each time they occur
+size_t CSGTreeNormalizer::normalizedSize(const std::shared_ptr<CSGNode>& node) const
+{
+  const auto op = std::dynamic_pointer_cast<CSGOperation>(node);
+  if (!op) return 0;
+  size_t size = 1;
+  for (const auto& child : {op->left(), op->right()}) {
+    const auto it = this->normalized_terms.find(child.get());
+    if (it != this->normalized_terms.end() && it->second.result == child) size += it->second.size;
+    else size += count(child);
+    size = std::min(size, this->limit + 1);
+  }
+  return size;
+}
+
 std::shared_ptr<CSGNode> CSGTreeNormalizer::collapse_null_terms(const std::shared_ptr<CSGNode>& node)
 {
   std::shared_ptr<CSGOperation> op = std::dynamic_pointer_cast<CSGOperation>(node);
@@ -178,44 +416,44 @@ bool CSGTreeNormalizer::match_and_replace(std::shared_ptr<CSGNode>& node)
 
     // 1.  x - (y + z) -> (x - y) - z
     if (op->getType() == OpenSCADOperator::DIFFERENCE && rightop->getType() == OpenSCADOperator::UNION) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE, x, y),
-                                         z);
+      node = createCSGNode(OpenSCADOperator::DIFFERENCE,
+                           createCSGNode(OpenSCADOperator::DIFFERENCE, x, y),
+                           z);
       return true;
     }
     // 2.  x * (y + z) -> (x * y) + (x * z)
     else if (op->getType() == OpenSCADOperator::INTERSECTION && rightop->getType() == OpenSCADOperator::UNION) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::UNION,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, y),
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, z));
+      node = createCSGNode(OpenSCADOperator::UNION,
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, y),
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, z));
       return true;
     }
     // 3.  x - (y * z) -> (x - y) + (x - z)
     else if (op->getType() == OpenSCADOperator::DIFFERENCE && rightop->getType() == OpenSCADOperator::INTERSECTION) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::UNION,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE, x, y),
-                                         CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE, x, z));
+      node = createCSGNode(OpenSCADOperator::UNION,
+                           createCSGNode(OpenSCADOperator::DIFFERENCE, x, y),
+                           createCSGNode(OpenSCADOperator::DIFFERENCE, x, z));
       return true;
     }
     // 4.  x * (y * z) -> (x * y) * z
     else if (op->getType() == OpenSCADOperator::INTERSECTION && rightop->getType() == OpenSCADOperator::INTERSECTION) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, y),
-                                         z);
+      node = createCSGNode(OpenSCADOperator::INTERSECTION,
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, y),
+                           z);
       return true;
     }
     // 5.  x - (y - z) -> (x - y) + (x * z)
     else if (op->getType() == OpenSCADOperator::DIFFERENCE && rightop->getType() == OpenSCADOperator::DIFFERENCE) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::UNION,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE, x, y),
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, z));
+      node = createCSGNode(OpenSCADOperator::UNION,
+                           createCSGNode(OpenSCADOperator::DIFFERENCE, x, y),
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, z));
       return true;
     }
     // 6.  x * (y - z) -> (x * y) - z
     else if (op->getType() == OpenSCADOperator::INTERSECTION && rightop->getType() == OpenSCADOperator::DIFFERENCE) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, y),
-                                         z);
+      node = createCSGNode(OpenSCADOperator::DIFFERENCE,
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, y),
+                           z);
       return true;
     }
   }
@@ -229,23 +467,23 @@ bool CSGTreeNormalizer::match_and_replace(std::shared_ptr<CSGNode>& node)
 
     // 7. (x - y) * z  -> (x * z) - y
     if (leftop->getType() == OpenSCADOperator::DIFFERENCE && op->getType() == OpenSCADOperator::INTERSECTION) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, z),
-                                         y);
+      node = createCSGNode(OpenSCADOperator::DIFFERENCE,
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, z),
+                           y);
       return true;
     }
     // 8. (x + y) - z  -> (x - z) + (y - z)
     else if (leftop->getType() == OpenSCADOperator::UNION && op->getType() == OpenSCADOperator::DIFFERENCE) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::UNION,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE, x, z),
-                                         CSGOperation::createCSGNode(OpenSCADOperator::DIFFERENCE, y, z));
+      node = createCSGNode(OpenSCADOperator::UNION,
+                           createCSGNode(OpenSCADOperator::DIFFERENCE, x, z),
+                           createCSGNode(OpenSCADOperator::DIFFERENCE, y, z));
       return true;
     }
     // 9. (x + y) * z  -> (x * z) + (y * z)
     else if (leftop->getType() == OpenSCADOperator::UNION && op->getType() == OpenSCADOperator::INTERSECTION) {
-      node = CSGOperation::createCSGNode(OpenSCADOperator::UNION,
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, x, z),
-                                         CSGOperation::createCSGNode(OpenSCADOperator::INTERSECTION, y, z));
+      node = createCSGNode(OpenSCADOperator::UNION,
+                           createCSGNode(OpenSCADOperator::INTERSECTION, x, z),
+                           createCSGNode(OpenSCADOperator::INTERSECTION, y, z));
       return true;
     }
   }
@@ -2,6 +2,13 @@
 
 #include <cstddef>
 #include <memory>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+
+#include "core/enums.h"
 
 class CSGTreeNormalizer
 {
@@ -10,15 +17,38 @@ public:
 
   std::shared_ptr<class CSGNode> normalize(const std::shared_ptr<CSGNode>& term);
 
+  // A lower bound of the number of products term normalizes to, or nullopt if that's too costly to find
+  [[nodiscard]] static std::optional<size_t> estimateProducts(const std::shared_ptr<CSGNode>& term, size_t max_products);
+
 private:
   std::shared_ptr<CSGNode> normalizePass(std::shared_ptr<CSGNode> term);
   bool match_and_replace(std::shared_ptr<class CSGNode>& term);
   std::shared_ptr<CSGNode> collapse_null_terms(const std::shared_ptr<CSGNode>& term);
   std::shared_ptr<CSGNode> cleanup_term(std::shared_ptr<CSGNode>& t);
+  std::shared_ptr<CSGNode> createCSGNode(OpenSCADOperator type, const std::shared_ptr<CSGNode>& left, const std::shared_ptr<CSGNode>& right);
   [[nodiscard]] unsigned int count(const std::shared_ptr<CSGNode>& term) const;
+  [[nodiscard]] size_t normalizedSize(const std::shared_ptr<CSGNode>& term) const;
 
   bool aborted{false};
   size_t limit;
   size_t nodecount{0};
   std::shared_ptr<class CSGNode> rootnode;
+
+  // Nodes created by the rewrite rules, so equal terms are shared instead of
+  // normalized again. The operands are kept, so their addresses stay unique.
+  using NodeKey = std::tuple<int, const CSGNode *, const CSGNode *>;
+  struct CreatedNode {
+    std::shared_ptr<CSGNode> left;
+    std::shared_ptr<CSGNode> right;
+    std::shared_ptr<CSGNode> node;
+  };
+  std::unordered_map<NodeKey, CreatedNode, boost::hash<NodeKey>> created_nodes;
+
+  // Normalized subtrees, and the size of their result
+  struct NormalizedTerm {
+    std::shared_ptr<CSGNode> term;
+    std::shared_ptr<CSGNode> result;
+    size_t size;
+  };
+  std::unordered_map<const CSGNode *, NormalizedTerm> normalized_terms;
 };
@@ -30,10 +30,14 @@
 
 #include "Feature.h"
 #include "geometry/PolySet.h"
+#include "utils/parallel.h"
+#include <boost/functional/hash.hpp>
+#include <algorithm>
 #include <cassert>
 #include <memory>
 #include <memory.h>
 #include <cstddef>
+#include <numeric>
 #include <utility>
 #include <vector>
 
@@ -86,26 +90,130 @@ OpenCSGVBOPrim *createVBOPrimitive(
 
 #endif // ENABLE_OPENCSG
 
+bool OpenCSGVBOCache::Object::operator==(const Object& other) const {
+  if (override_color != other.override_color || csgmode != other.csgmode ||
+      type != other.type || opaque != other.opaque || color != other.color ||
+      matrix.matrix() != other.matrix.matrix()) {
+    return false;
+  }
+  if (polyset == other.polyset) return true;
+  return polyset->getDimension() == other.polyset->getDimension() &&
+         polyset->vertices == other.polyset->vertices &&
+         polyset->indices == other.polyset->indices &&
+         polyset->color_indices == other.polyset->color_indices &&
+         polyset->colors == other.polyset->colors &&
+         polyset->getConvexity() == other.polyset->getConvexity();
+}
+
+bool OpenCSGVBOCache::Key::operator==(const Key& other) const {
+  return has_shader == other.has_shader && color_area == other.color_area &&
+         color_edge == other.color_edge && barycentric == other.barycentric &&
+         objects == other.objects;
+}
+
+// Hashes the sizes rather than the contents of meshes, so keys of unchanged
+// products hash in constant time. Equal keys still compare the contents.
+size_t OpenCSGVBOCache::Key::hash() const {
+  size_t seed = 0;
+  boost::hash_combine(seed, has_shader);
+  boost::hash_combine(seed, color_area);
+  boost::hash_combine(seed, color_edge);
+  boost::hash_combine(seed, barycentric);
+  for (const auto &object : objects) {
+    boost::hash_combine(seed, object.polyset->vertices.size());
+    boost::hash_combine(seed, object.polyset->indices.size());
+    for (int i = 0; i < 16; ++i) {
+      boost::hash_combine(seed, object.matrix.data()[i]);
+    }
+    for (int i = 0; i < 4; ++i) {
+      boost::hash_combine(seed, object.color[i]);
+    }
+    boost::hash_combine(seed, object.override_color);
+    boost::hash_combine(seed, static_cast<int>(object.csgmode));
+    boost::hash_combine(seed, static_cast<int>(object.type));
+    boost::hash_combine(seed, object.opaque);
+  }
+  return seed;
+}
+
+void OpenCSGVBOCache::endGeneration() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second->generation != generation_) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::shared_ptr<OpenCSGVBOCache::Entry> OpenCSGVBOCache::find(const Key& key) {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  const auto [begin, end] = entries_.equal_range(key.hash());
+  for (auto it = begin; it != end; ++it) {
+    auto& entry = it->second;
+    // Identical products of one renderer get a product each, as their leaf indices differ
+    if (entry->generation != generation_ && entry->key == key) {
+      entry->generation = generation_;
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+void OpenCSGVBOCache::insert(std::shared_ptr<Entry> entry) {
+  const size_t hash = entry->key.hash();
+  const std::lock_guard<std::mutex> lock(mutex_);
+  entry->generation = generation_;
+  entries_.emplace(hash, std::move(entry));
+}
+
+bool OpenCSGVBOCache::contains(const Key& key) const {
+  const size_t hash = key.hash();
+  const std::lock_guard<std::mutex> lock(mutex_);
+  const auto [begin, end] = entries_.equal_range(hash);
+  return std::any_of(begin, end, [&key](const auto& it) { return it.second->key == key; });
+}
+
+size_t OpenCSGVBOCache::size() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
 OpenCSGRenderer::OpenCSGRenderer(
     std::shared_ptr<CSGProducts> root_products,
     std::shared_ptr<CSGProducts> highlights_products,
-    std::shared_ptr<CSGProducts> background_products)
-    : root_products_(std::move(root_products)),
+    std::shared_ptr<CSGProducts> background_products,
+    std::shared_ptr<OpenCSGVBOCache> vbo_cache,
+    std::shared_ptr<OpenCSGVBOData> root_vbo_data,
+    std::shared_ptr<OpenCSGVBOData> highlights_vbo_data,
+    std::shared_ptr<OpenCSGVBOData> background_vbo_data)
+    : vbo_cache_(std::move(vbo_cache)),
+      root_products_(std::move(root_products)),
       highlights_products_(std::move(highlights_products)),
-      background_products_(std::move(background_products)) {}
+      background_products_(std::move(background_products)),
+      root_vbo_data_(std::move(root_vbo_data)),
+      highlights_vbo_data_(std::move(highlights_vbo_data)),
+      background_vbo_data_(std::move(background_vbo_data)) {}
 
 void OpenCSGRenderer::prepare(bool /*showedges*/,
                               const RendererUtils::ShaderInfo */*shaderinfo*/) {
   if (vbo_vertex_products_.empty()) {
+    if (vbo_cache_) vbo_cache_->beginGeneration();
     if (root_products_) {
-      createCSGVBOProducts(*root_products_, false, false);
+      createCSGVBOProducts(*root_products_, false, false, root_vbo_data_.get());
     }
     if (background_products_) {
-      createCSGVBOProducts(*background_products_, false, true);
+      createCSGVBOProducts(*background_products_, false, true, background_vbo_data_.get());
     }
     if (highlights_products_) {
-      createCSGVBOProducts(*highlights_products_, true, false);
+      createCSGVBOProducts(*highlights_products_, true, false, highlights_vbo_data_.get());
     }
+    if (vbo_cache_) vbo_cache_->endGeneration();
+    // The data was moved into the products
+    root_vbo_data_.reset();
+    highlights_vbo_data_.reset();
+    background_vbo_data_.reset();
   }
 }
 
@@ -166,224 +274,301 @@ void OpenCSGRenderer::draw(bool showedges, const RendererUtils::ShaderInfo *shad
 // Turn the CSGProducts into VBOs
 // Will create one (temporary) VertexArray and one VBO(+EBO) per product
 // The VBO will be utilized to render multiple objects with correct state
-// management. In the future, we could use a VBO per primitive and potentially
-// reuse VBOs, but that requires some more careful state management.
+// management. Products found in the VBO cache reuse the VBOs of an earlier
+// renderer instead, and products in vbo_data are only uploaded.
 // Note: This function can be called multiple times for different products.
 // Each call will add to vbo_vertex_products_.
 void OpenCSGRenderer::createCSGVBOProducts(
-    const CSGProducts &products, bool highlight_mode, bool background_mode) {
+    const CSGProducts &products, bool highlight_mode, bool background_mode, OpenCSGVBOData *vbo_data) {
+#ifdef ENABLE_OPENCSG
+  const bool has_shader = getShader().progid != 0;
+  if (!has_shader && !products.products.empty()) {
+    LOG("Warning: Shader not available");
+  }
+
+  const size_t product_count = products.products.size();
+  std::vector<std::shared_ptr<OpenCSGVBOCache::Entry>> entries(product_count);
+  std::vector<std::vector<int>> leaf_indices(product_count);
+  std::vector<std::unique_ptr<OpenCSGVBOData::Product>> built(product_count);
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < product_count; ++i) {
+    auto key = productKey(products.products[i], highlight_mode, background_mode, leaf_indices[i]);
+    if (vbo_cache_) entries[i] = vbo_cache_->find(key);
+    if (entries[i]) continue;
+    // Data built for other colors or another shader is built again
+    if (vbo_data && i < vbo_data->products.size() && vbo_data->products[i] && vbo_data->products[i]->key == key) {
+      built[i] = std::move(vbo_data->products[i]);
+    } else {
+      missing.push_back(i);
+    }
+    entries[i] = std::make_shared<OpenCSGVBOCache::Entry>();
+    entries[i]->key = std::move(key);
+  }
+
+  // Elements need GL while building, so their buffers are generated first.
+  // Will default to zeroes, so we don't have to keep checking for the
+  // Indexing feature
+  std::vector<GLuint> elements_vbos(missing.size());
+  if (!missing.empty() && Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
+    glGenBuffers(missing.size(), elements_vbos.data());
+  }
+  const auto build_product = [&](size_t m) {
+    built[missing[m]] = buildVBOProduct(entries[missing[m]]->key, elements_vbos[m]);
+  };
+  std::vector<size_t> indices(missing.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
+    std::for_each(indices.begin(), indices.end(), build_product);
+  } else {
+    parallelizable_for_each(indices.begin(), indices.end(), build_product);
+  }
+
   // We need to manage buffers here since we don't have another suitable
   // container for managing the life cycle of VBOs. We're creating one VBO(+EBO)
-  // per product.
-  std::vector<GLuint> vertices_vbos;
-  std::vector<GLuint> elements_vbos;
-
-  if (const auto vbo_count = products.products.size()) {
-    vertices_vbos.resize(vbo_count);
-    // Will default to zeroes, so we don't have to keep checking for the
-    // Indexing feature
-    elements_vbos.resize(vbo_count);
-    glGenBuffers(vbo_count, vertices_vbos.data());
-    all_vbos_.insert(all_vbos_.end(), vertices_vbos.begin(), vertices_vbos.end());
+  // per product, which the product owns. They're uploaded from this thread,
+  // which holds the GL context.
+  const size_t built_count = std::count_if(built.begin(), built.end(), [](const auto& product) { return product != nullptr; });
+  std::vector<GLuint> vertices_vbos(built_count);
+  if (built_count > 0) glGenBuffers(built_count, vertices_vbos.data());
+  size_t vbo_index = 0;
+  for (size_t i = 0; i < product_count; ++i) {
+    if (!built[i]) continue;
+    auto& product = *built[i];
+    auto& entry = *entries[i];
+    const GLuint vertices_vbo = vertices_vbos[vbo_index++];
+    product.vertex_array->setVerticesVBO(vertices_vbo);
     if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
-      glGenBuffers(vbo_count, elements_vbos.data());
-      all_vbos_.insert(all_vbos_.end(), elements_vbos.begin(), elements_vbos.end());
+      GL_TRACE0("glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0)");
+      GL_CHECKD(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
     }
+    GL_TRACE0("glBindBuffer(GL_ARRAY_BUFFER, 0)");
+    GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    product.vertex_array->createInterleavedVBOs();
+
+    std::vector<OpenCSG::Primitive *> primitives;
+    for (size_t j = 0; j < product.surfaces.size(); ++j) {
+      if (!product.surfaces[j]) continue;
+      const auto& object = entry.key.objects[j];
+      primitives.emplace_back(createVBOPrimitive(
+        product.surfaces[j],
+        object.type == OpenSCADOperator::INTERSECTION ? OpenCSG::Intersection : OpenCSG::Subtraction,
+        object.polyset->getConvexity()));
+    }
+    std::vector<GLuint> vbos{vertices_vbo};
+    if (product.vertex_array->elementsVBO()) vbos.push_back(product.vertex_array->elementsVBO());
+    entry.product = std::make_shared<OpenCSGVBOProduct>(std::move(primitives), std::move(product.states), std::move(vbos));
+    entry.surfaces = std::move(product.surfaces);
+    built[i].reset();
+    if (vbo_cache_) vbo_cache_->insert(entries[i]);
+  }
+  if (vbo_cache_) {
+    PRINTDB("Reused %d of %d VBO products", (product_count - built_count) % product_count);
   }
 
+  for (size_t i = 0; i < product_count; ++i) {
+    // Reused products were built for other leaves, so their indices are set for each renderer
+    const auto& entry = *entries[i];
+    for (size_t j = 0; j < entry.surfaces.size(); ++j) {
+      if (entry.surfaces[j]) entry.surfaces[j]->setCsgObjectIndex(leaf_indices[i][j]);
+    }
+    vbo_vertex_products_.push_back(entry.product);
+  }
+#endif // ENABLE_OPENCSG
+}
+
+std::shared_ptr<OpenCSGVBOData> OpenCSGRenderer::buildVBOData(
+    const CSGProducts &products, bool highlight_mode, bool background_mode) {
 #ifdef ENABLE_OPENCSG
-  for (auto i = 0; i < products.products.size(); ++i) {
-    const auto& product = products.products[i];
-    const auto vertices_vbo = vertices_vbos[i];
-    const auto elements_vbo = elements_vbos[i];
+  if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) return nullptr;
+  auto vbo_data = std::make_shared<OpenCSGVBOData>();
+  vbo_data->products.resize(products.products.size());
+  std::vector<OpenCSGVBOCache::Key> keys;
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < products.products.size(); ++i) {
+    std::vector<int> leaf_indices;
+    auto key = productKey(products.products[i], highlight_mode, background_mode, leaf_indices);
+    if (vbo_cache_ && vbo_cache_->contains(key)) continue;
+    keys.push_back(std::move(key));
+    missing.push_back(i);
+  }
+  std::vector<size_t> indices(missing.size());
+  std::iota(indices.begin(), indices.end(), 0);
+  parallelizable_for_each(indices.begin(), indices.end(), [&](size_t m) {
+    vbo_data->products[missing[m]] = buildVBOProduct(std::move(keys[m]), 0);
+  });
+  return vbo_data;
+#else
+  return nullptr;
+#endif // ENABLE_OPENCSG
+}
 
-    Color4f last_color;
-    std::vector<OpenCSG::Primitive *> primitives;
-    std::unique_ptr<std::vector<std::shared_ptr<VertexState>>> vertex_states =
-        std::make_unique<std::vector<std::shared_ptr<VertexState>>>();
-    VBOBuilder vertex_array(std::make_unique<OpenCSGVertexStateFactory>(),
-                             *(vertex_states.get()), vertices_vbo,
-                             elements_vbo);
-    vertex_array.addSurfaceData();
-    vertex_array.writeSurface();
-    if (getShader().progid != 0) {
-      vertex_array.addShaderData();
+#ifdef ENABLE_OPENCSG
+// Builds the vertices and states of one product. Makes no GL calls unless
+// elements are used. The VBO of the vertices is set when they're uploaded.
+std::unique_ptr<OpenCSGVBOData::Product> OpenCSGRenderer::buildVBOProduct(OpenCSGVBOCache::Key key, GLuint elements_vbo) {
+  auto product = std::make_unique<OpenCSGVBOData::Product>();
+  product->states = std::make_unique<std::vector<std::shared_ptr<VertexState>>>();
+  product->vertex_array = std::make_unique<VBOBuilder>(std::make_unique<OpenCSGVertexStateFactory>(),
+                                                       *product->states, 0, elements_vbo);
+  product->vertex_array->addSurfaceData();
+  product->vertex_array->writeSurface();
+  if (key.has_shader) {
+    product->vertex_array->addShaderData();
+  }
+  createVBOStates(key.objects, *product->vertex_array, product->surfaces);
+  product->key = std::move(key);
+  return product;
+}
+#endif // ENABLE_OPENCSG
+
+// Collects the objects of a product with their resolved colors and modes,
+// and the indices of their leaves.
+OpenCSGVBOCache::Key OpenCSGRenderer::productKey(const CSGProduct &product, bool highlight_mode,
+                                                 bool background_mode, std::vector<int> &leaf_indices) const {
+  OpenCSGVBOCache::Key key;
+  const auto &shader = getShader();
+  key.has_shader = shader.progid != 0;
+  key.color_area = shader.data.color_rendering.color_area;
+  key.color_edge = shader.data.color_rendering.color_edge;
+  key.barycentric = shader.data.color_rendering.barycentric;
+
+  Color4f last_color;
+  const auto add_object = [&](const CSGChainObject &csgobj, OpenSCADOperator type) {
+    if (!csgobj.leaf->polyset) return;
+    const Color4f &c = csgobj.leaf->color;
+
+    ColorMode colormode = ColorMode::NONE;
+    bool override_color;
+    if (highlight_mode) {
+      colormode = ColorMode::HIGHLIGHT;
+      override_color = true;
+    } else if (background_mode) {
+      colormode = ColorMode::BACKGROUND;
+      override_color = true;
+    } else if (type == OpenSCADOperator::DIFFERENCE) {
+      colormode = ColorMode::CUTOUT;
+      override_color = true;
     } else {
-      LOG("Warning: Shader not available");
+      colormode = ColorMode::MATERIAL;
+      override_color = c.isValid();
     }
 
-    size_t num_vertices = 0;
-    for (const auto &csgobj : product.intersections) {
-      if (csgobj.leaf->polyset) {
-        num_vertices += getSurfaceBufferSize(csgobj);
-      }
-    }
-    for (const auto &csgobj : product.subtractions) {
-      if (csgobj.leaf->polyset) {
-        num_vertices += getSurfaceBufferSize(csgobj);
-      }
+    Color4f color;
+    if (getShaderColor(colormode, c, color)) {
+      last_color = color;
     }
 
-    vertex_array.allocateBuffers(num_vertices);
-
-    for (const auto &csgobj : product.intersections) {
-      if (csgobj.leaf->polyset) {
-        const Color4f &c = csgobj.leaf->color;
-        const auto csgmode = RendererUtils::getCsgMode(highlight_mode, background_mode);
-
-        ColorMode colormode = ColorMode::NONE;
-        bool override_color;
-        if (highlight_mode) {
-          colormode = ColorMode::HIGHLIGHT;
-          override_color = true;
-        } else if (background_mode) {
-          colormode = ColorMode::BACKGROUND;
-          override_color = true;
-        } else {
-          colormode = ColorMode::MATERIAL;
-          override_color = c.isValid();
-        }
-
-        Color4f color;
-        if (getShaderColor(colormode, c, color)) {
-          last_color = color;
-        }
-
-        add_color(vertex_array, last_color);
-
-        if (color[3] == 1.0f) {
-          // object is opaque, draw normally
-          create_surface(*csgobj.leaf->polyset, vertex_array, csgmode,
-                         csgobj.leaf->matrix, last_color, override_color);
-          const auto surface = std::dynamic_pointer_cast<OpenCSGVertexState>(
-            vertex_states->back());
-          if (surface != nullptr) {
-            surface->setCsgObjectIndex(csgobj.leaf->index);
-            primitives.emplace_back(
-                createVBOPrimitive(surface, OpenCSG::Intersection,
-                                   csgobj.leaf->polyset->getConvexity()));
-          }
-        } else {
-          // object is transparent, so draw rear faces first.  Issue #1496
-          std::shared_ptr<VertexState> cull = std::make_shared<VertexState>();
-          cull->glBegin().emplace_back([]() {
-            GL_TRACE0("glEnable(GL_CULL_FACE)"); glEnable(GL_CULL_FACE);
-            GL_TRACE0("glCullFace(GL_FRONT)"); glCullFace(GL_FRONT);
-          });
-          vertex_states->emplace_back(std::move(cull));
-
-          create_surface(*csgobj.leaf->polyset, vertex_array, csgmode,
-                         csgobj.leaf->matrix, last_color, override_color);
-          std::shared_ptr<OpenCSGVertexState> surface =
-              std::dynamic_pointer_cast<OpenCSGVertexState>(
-                  vertex_states->back());
-
-          if (surface != nullptr) {
-            surface->setCsgObjectIndex(csgobj.leaf->index);
-
-            primitives.emplace_back(
-                createVBOPrimitive(surface, OpenCSG::Intersection,
-                                   csgobj.leaf->polyset->getConvexity()));
-
-            cull = std::make_shared<VertexState>();
-            cull->glBegin().emplace_back([]() {
-              GL_TRACE0("glCullFace(GL_BACK)");
-              glCullFace(GL_BACK);
-            });
-            vertex_states->emplace_back(std::move(cull));
-
-            vertex_states->emplace_back(surface);
-
-            cull = std::make_shared<VertexState>();
-            cull->glEnd().emplace_back([]() {
-              GL_TRACE0("glDisable(GL_CULL_FACE)");
-              glDisable(GL_CULL_FACE);
-            });
-            vertex_states->emplace_back(std::move(cull));
-          } else {
-            assert(false && "Intersection surface state was nullptr");
-          }
-        }
-      }
+    Transform3d matrix = csgobj.leaf->matrix;
+    if (type == OpenSCADOperator::DIFFERENCE && csgobj.leaf->polyset->getDimension() == 2) {
+      // Scale 2D negative objects 10% in the Z direction to avoid z fighting
+      matrix *= Eigen::Scaling(1.0, 1.0, 1.1);
     }
+    key.objects.push_back({csgobj.leaf->polyset, matrix, last_color, override_color,
+                           RendererUtils::getCsgMode(highlight_mode, background_mode, type), type,
+                           color[3] == 1.0f});
+    leaf_indices.push_back(csgobj.leaf->index);
+  };
+
+  for (const auto &csgobj : product.intersections) {
+    add_object(csgobj, OpenSCADOperator::INTERSECTION);
+  }
+  for (const auto &csgobj : product.subtractions) {
+    add_object(csgobj, OpenSCADOperator::DIFFERENCE);
+  }
+  return key;
+}
 
-    for (const auto &csgobj : product.subtractions) {
-      if (csgobj.leaf->polyset) {
-        const Color4f &c = csgobj.leaf->color;
-        const auto csgmode = RendererUtils::getCsgMode(highlight_mode, background_mode,
-                                         OpenSCADOperator::DIFFERENCE);
-
-        ColorMode colormode = ColorMode::NONE;
-        bool override_color;
-        if (highlight_mode) {
-          colormode = ColorMode::HIGHLIGHT;
-          override_color = true;
-        } else if (background_mode) {
-          colormode = ColorMode::BACKGROUND;
-          override_color = true;
-        } else {
-          colormode = ColorMode::CUTOUT;
-          override_color = true;
-        }
+#ifdef ENABLE_OPENCSG
+// Creates the vertices and states of one product in vertex_array. Makes no
+// GL calls unless elements are used. The surface state of each object, from
+// which its OpenCSG primitive is made, is added to surfaces.
+void OpenCSGRenderer::createVBOStates(
+    const std::vector<OpenCSGVBOCache::Object> &objects, VBOBuilder &vertex_array,
+    std::vector<std::shared_ptr<OpenCSGVertexState>> &surfaces) {
+
+  size_t num_vertices = 0;
+  for (const auto &object : objects) {
+    num_vertices += getSurfaceBufferSize(*object.polyset);
+  }
 
-        Color4f color;
-        if (getShaderColor(colormode, c, color)) {
-          last_color = color;
-        }
+  vertex_array.allocateBuffers(num_vertices);
 
-        add_color(vertex_array, last_color);
+  for (const auto &object : objects) {
+    add_color(vertex_array, object.color);
 
-        // negative objects should only render rear faces
+    if (object.type == OpenSCADOperator::INTERSECTION) {
+      if (object.opaque) {
+        // object is opaque, draw normally
+        create_surface(*object.polyset, vertex_array, object.csgmode,
+                       object.matrix, object.color, object.override_color);
+        const auto surface = std::dynamic_pointer_cast<OpenCSGVertexState>(
+          vertex_array.states().back());
+        surfaces.push_back(surface);
+      } else {
+        // object is transparent, so draw rear faces first.  Issue #1496
         std::shared_ptr<VertexState> cull = std::make_shared<VertexState>();
         cull->glBegin().emplace_back([]() {
-          GL_TRACE0("glEnable(GL_CULL_FACE)");
-          GL_CHECKD(glEnable(GL_CULL_FACE));
-        });
-        cull->glBegin().emplace_back([]() {
-          GL_TRACE0("glCullFace(GL_FRONT)");
-          GL_CHECKD(glCullFace(GL_FRONT));
+          GL_TRACE0("glEnable(GL_CULL_FACE)"); glEnable(GL_CULL_FACE);
+          GL_TRACE0("glCullFace(GL_FRONT)"); glCullFace(GL_FRONT);
         });
-        vertex_states->emplace_back(std::move(cull));
-        Transform3d tmp = csgobj.leaf->matrix;
-        if (csgobj.leaf->polyset->getDimension() == 2) {
-          // Scale 2D negative objects 10% in the Z direction to avoid z fighting
-          tmp *= Eigen::Scaling(1.0, 1.0, 1.1);
-        }
-        create_surface(*csgobj.leaf->polyset, vertex_array, csgmode, tmp,
-                       last_color, override_color);
-        const auto surface = std::dynamic_pointer_cast<OpenCSGVertexState>(
-          vertex_states->back());
+        vertex_array.states().emplace_back(std::move(cull));
+
+        create_surface(*object.polyset, vertex_array, object.csgmode,
+                       object.matrix, object.color, object.override_color);
+        std::shared_ptr<OpenCSGVertexState> surface =
+            std::dynamic_pointer_cast<OpenCSGVertexState>(
+                vertex_array.states().back());
+
+        surfaces.push_back(surface);
         if (surface != nullptr) {
-          surface->setCsgObjectIndex(csgobj.leaf->index);
-          primitives.emplace_back(
-              createVBOPrimitive(surface, OpenCSG::Subtraction,
-                                 csgobj.leaf->polyset->getConvexity()));
+          cull = std::make_shared<VertexState>();
+          cull->glBegin().emplace_back([]() {
+            GL_TRACE0("glCullFace(GL_BACK)");
+            glCullFace(GL_BACK);
+          });
+          vertex_array.states().emplace_back(std::move(cull));
+
+          vertex_array.states().emplace_back(surface);
+
+          cull = std::make_shared<VertexState>();
+          cull->glEnd().emplace_back([]() {
+            GL_TRACE0("glDisable(GL_CULL_FACE)");
+            glDisable(GL_CULL_FACE);
+          });
+          vertex_array.states().emplace_back(std::move(cull));
         } else {
-          assert(false && "Subtraction surface state was nullptr");
+          assert(false && "Intersection surface state was nullptr");
         }
-
-        cull = std::make_shared<VertexState>();
-        cull->glEnd().emplace_back([]() {
-          GL_TRACE0("glDisable(GL_CULL_FACE)");
-          GL_CHECKD(glDisable(GL_CULL_FACE));
-        });
-        vertex_states->emplace_back(std::move(cull));
       }
+    } else {
+      // negative objects should only render rear faces
+      std::shared_ptr<VertexState> cull = std::make_shared<VertexState>();
+      cull->glBegin().emplace_back([]() {
+        GL_TRACE0("glEnable(GL_CULL_FACE)");
+        GL_CHECKD(glEnable(GL_CULL_FACE));
+      });
+      cull->glBegin().emplace_back([]() {
+        GL_TRACE0("glCullFace(GL_FRONT)");
+        GL_CHECKD(glCullFace(GL_FRONT));
+      });
+      vertex_array.states().emplace_back(std::move(cull));
+      create_surface(*object.polyset, vertex_array, object.csgmode, object.matrix,
+                     object.color, object.override_color);
+      const auto surface = std::dynamic_pointer_cast<OpenCSGVertexState>(
+        vertex_array.states().back());
+      surfaces.push_back(surface);
+      assert(surface != nullptr && "Subtraction surface state was nullptr");
+
+      cull = std::make_shared<VertexState>();
+      cull->glEnd().emplace_back([]() {
+        GL_TRACE0("glDisable(GL_CULL_FACE)");
+        GL_CHECKD(glDisable(GL_CULL_FACE));
+      });
+      vertex_array.states().emplace_back(std::move(cull));
     }
-
-    if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
-      GL_TRACE0("glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0)");
-      GL_CHECKD(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
-    }
-    GL_TRACE0("glBindBuffer(GL_ARRAY_BUFFER, 0)");
-    GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
-
-    vertex_array.createInterleavedVBOs();
-    vbo_vertex_products_.emplace_back(std::make_unique<OpenCSGVBOProduct>(
-        std::move(primitives), std::move(vertex_states)));
   }
-#endif // ENABLE_OPENCSG
 }
+#endif // ENABLE_OPENCSG
 
 BoundingBox OpenCSGRenderer::getBoundingBox() const {
   BoundingBox bbox;
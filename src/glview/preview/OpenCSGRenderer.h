@@ -12,6 +12,8 @@
 #include "glview/VBORenderer.h"
 
 #include <cstddef>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 class OpenCSGVertexState : public VertexState
@@ -47,9 +49,16 @@ public:
 class OpenCSGVBOProduct
 {
 public:
-  OpenCSGVBOProduct(std::vector<OpenCSG::Primitive *> primitives, std::unique_ptr<std::vector<std::shared_ptr<VertexState>>> states)
-    : primitives_(std::move(primitives)), states_(std::move(states)) {}
-  virtual ~OpenCSGVBOProduct() = default;
+  OpenCSGVBOProduct(std::vector<OpenCSG::Primitive *> primitives, std::unique_ptr<std::vector<std::shared_ptr<VertexState>>> states,
+                    std::vector<GLuint> vbos = {})
+    : primitives_(std::move(primitives)), states_(std::move(states)), vbos_(std::move(vbos)) {}
+  OpenCSGVBOProduct(const OpenCSGVBOProduct&) = delete;
+  OpenCSGVBOProduct& operator=(const OpenCSGVBOProduct&) = delete;
+  virtual ~OpenCSGVBOProduct() {
+    if (!vbos_.empty()) {
+      glDeleteBuffers(vbos_.size(), vbos_.data());
+    }
+  }
 
   [[nodiscard]] const std::vector<OpenCSG::Primitive *>& primitives() const { return primitives_; }
   [[nodiscard]] const std::vector<std::shared_ptr<VertexState>>& states() const { return *(states_.get()); }
@@ -60,29 +69,145 @@ private:
   // Both may use the same underlying VBOs
   const std::vector<OpenCSG::Primitive *> primitives_;
   const std::unique_ptr<std::vector<std::shared_ptr<VertexState>>> states_;
+  // The VBO(+EBO) holding the vertices of states_, owned by this product
+  const std::vector<GLuint> vbos_;
+};
+
+/*!
+   Keeps the products built by earlier OpenCSGRenderers, so that the next
+   renderer of the same view, e.g. after editing and previewing again, reuses
+   the VBOs of unchanged products and only builds and uploads the others.
+
+   Products are matched by content: the mesh, transformation, color and mode
+   of each object. Meshes are compared by pointer first, which usually
+   suffices since unchanged geometry comes from the geometry cache.
+   Products which the latest renderer didn't use are dropped.
+
+   All renderers sharing a cache must use the same GL context.
+ */
+class OpenCSGVBOCache
+{
+public:
+  // An object of a product, with everything its vertices and states are built from
+  struct Object {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    std::shared_ptr<const PolySet> polyset;
+    Transform3d matrix;
+    Color4f color;
+    bool override_color;
+    RendererUtils::CSGMode csgmode;
+    OpenSCADOperator type; // INTERSECTION or DIFFERENCE
+    bool opaque;
+
+    bool operator==(const Object& other) const;
+  };
+
+  struct Key {
+    std::vector<Object> objects;
+    // Shader locations, which the states of the product refer to
+    bool has_shader;
+    int color_area;
+    int color_edge;
+    int barycentric;
+
+    bool operator==(const Key& other) const;
+    [[nodiscard]] size_t hash() const;
+  };
+
+  struct Entry {
+    Key key;
+    std::shared_ptr<OpenCSGVBOProduct> product;
+    // The surface state of each object, to set the indices of their leaves
+    std::vector<std::shared_ptr<OpenCSGVertexState>> surfaces;
+    unsigned int generation{0};
+  };
+
+  // Starts a new generation, for the products of a new renderer
+  void beginGeneration() { ++generation_; }
+  // Drops the products which weren't used by the current generation
+  void endGeneration();
+
+  // Returns a product with the given key, unless there's none or it's
+  // already used by the current generation, and marks it as used
+  std::shared_ptr<Entry> find(const Key& key);
+  void insert(std::shared_ptr<Entry> entry);
+  // Whether a product with the given key is cached. Unlike the other
+  // functions, this may be called from any thread.
+  [[nodiscard]] bool contains(const Key& key) const;
+
+  [[nodiscard]] size_t size() const;
+
+private:
+  mutable std::mutex mutex_;
+  std::unordered_multimap<size_t, std::shared_ptr<Entry>> entries_;
+  unsigned int generation_{0};
+};
+
+/*!
+   The vertex data of a set of CSG products, built without a GL context so
+   that it can be built on another thread than the one drawing them.
+   OpenCSGRenderer::prepare() allocates the VBOs and uploads the data.
+
+   A product is left out when the VBO cache held it while it was built.
+   prepare() builds the products which are missing, or which were built for
+   other colors or shaders than the renderer's, itself.
+ */
+class OpenCSGVBOData
+{
+public:
+  struct Product {
+    OpenCSGVBOCache::Key key;
+    std::unique_ptr<std::vector<std::shared_ptr<VertexState>>> states;
+    std::unique_ptr<VBOBuilder> vertex_array; // Fills states
+    std::vector<std::shared_ptr<OpenCSGVertexState>> surfaces;
+  };
+
+  // Indexed like the products they were built from
+  std::vector<std::unique_ptr<Product>> products;
 };
 
 class OpenCSGRenderer : public VBORenderer
 {
 public:
+  // The VBO data, if given, is used by prepare() instead of building the products again
   OpenCSGRenderer(std::shared_ptr<CSGProducts> root_products,
                   std::shared_ptr<CSGProducts> highlights_products,
-                  std::shared_ptr<CSGProducts> background_products);
-  ~OpenCSGRenderer() override {
-    if (all_vbos_.size()) {
-      glDeleteBuffers(all_vbos_.size(), all_vbos_.data());
-    }
-  }
+                  std::shared_ptr<CSGProducts> background_products,
+                  std::shared_ptr<OpenCSGVBOCache> vbo_cache = nullptr,
+                  std::shared_ptr<OpenCSGVBOData> root_vbo_data = nullptr,
+                  std::shared_ptr<OpenCSGVBOData> highlights_vbo_data = nullptr,
+                  std::shared_ptr<OpenCSGVBOData> background_vbo_data = nullptr);
   void prepare(bool showedges, const RendererUtils::ShaderInfo *shaderinfo = nullptr) override;
   void draw(bool showedges, const RendererUtils::ShaderInfo *shaderinfo = nullptr) const override;
 
   BoundingBox getBoundingBox() const override;
+
+  /*!
+     Builds the vertex data of products for prepare() of a renderer with the
+     same shader and colors as this one. Makes no GL calls, so it may be
+     called from another thread, as long as this renderer isn't drawn or
+     changed meanwhile. Returns nullptr if the data can't be built without
+     GL, which is the case when elements are used.
+   */
+  std::shared_ptr<OpenCSGVBOData> buildVBOData(const CSGProducts& products, bool highlight_mode, bool background_mode);
+
 private:
-  void createCSGVBOProducts(const CSGProducts& products, bool highlight_mode, bool background_mode);
+  void createCSGVBOProducts(const CSGProducts& products, bool highlight_mode, bool background_mode,
+                            OpenCSGVBOData *vbo_data);
+  OpenCSGVBOCache::Key productKey(const CSGProduct& product, bool highlight_mode, bool background_mode,
+                                  std::vector<int>& leaf_indices) const;
+#ifdef ENABLE_OPENCSG
+  std::unique_ptr<OpenCSGVBOData::Product> buildVBOProduct(OpenCSGVBOCache::Key key, GLuint elements_vbo);
+  void createVBOStates(const std::vector<OpenCSGVBOCache::Object>& objects, VBOBuilder& vertex_array,
+                       std::vector<std::shared_ptr<OpenCSGVertexState>>& surfaces);
+#endif
 
-  std::vector<std::unique_ptr<OpenCSGVBOProduct>> vbo_vertex_products_;
-  std::vector<GLuint> all_vbos_;
+  std::vector<std::shared_ptr<OpenCSGVBOProduct>> vbo_vertex_products_;
+  std::shared_ptr<OpenCSGVBOCache> vbo_cache_;
   std::shared_ptr<CSGProducts> root_products_;
   std::shared_ptr<CSGProducts> highlights_products_;
   std::shared_ptr<CSGProducts> background_products_;
+  std::shared_ptr<OpenCSGVBOData> root_vbo_data_;
+  std::shared_ptr<OpenCSGVBOData> highlights_vbo_data_;
+  std::shared_ptr<OpenCSGVBOData> background_vbo_data_;
 };
@@ -84,6 +84,9 @@ ThrownTogetherRenderer::~ThrownTogetherRenderer()
   if (elements_vbo_) {
     glDeleteBuffers(1, &elements_vbo_);
   }
+  if (instances_vbo_) {
+    glDeleteBuffers(1, &instances_vbo_);
+  }
 }
 
 void ThrownTogetherRenderer::prepare(bool /*showedges*/, const RendererUtils::ShaderInfo * /*shaderinfo*/)
@@ -102,16 +105,38 @@ void ThrownTogetherRenderer::prepare(bool /*showedges*/, const RendererUtils::Sh
       LOG("Warning: Shader not available");
     }
 
+    this->instance_program_ = 0;
+    if (instancing_available()) {
+      if (auto cache = RendererUtils::currentShaderCache()) {
+        this->instance_program_ = cache->program("PreviewInstanced.vert", "PreviewInstanced.frag");
+      } else {
+        this->instance_program_ = RendererUtils::compileShaderProgram(RendererUtils::loadShaderSource("PreviewInstanced.vert"),
+                                                                      RendererUtils::loadShaderSource("PreviewInstanced.frag"));
+      }
+      this->instance_matrix_location_ =
+        this->instance_program_ ? glGetAttribLocation(this->instance_program_, "instance_matrix") : -1;
+    }
+
+    this->polyset_uses_.clear();
+    if (this->root_products_) countPolySetUses(*this->root_products_);
+    if (this->background_products_) countPolySetUses(*this->background_products_);
+    if (this->highlight_products_) countPolySetUses(*this->highlight_products_);
+
+    // Surfaces shared by several leaves are counted once per color, like createSurface() creates them
+    std::set<std::pair<const PolySet *, Color4f>> shared;
     size_t num_vertices = 0;
-    if (this->root_products_) num_vertices += (getSurfaceBufferSize(this->root_products_, true) * 2);
-    if (this->background_products_) num_vertices += getSurfaceBufferSize(this->background_products_, true);
-    if (this->highlight_products_) num_vertices += getSurfaceBufferSize(this->highlight_products_, true);
+    if (this->root_products_) num_vertices += surfaceBufferSize(*this->root_products_, false, false, shared);
+    if (this->background_products_) num_vertices += surfaceBufferSize(*this->background_products_, false, true, shared);
+    if (this->highlight_products_) num_vertices += surfaceBufferSize(*this->highlight_products_, true, false, shared);
 
     vertex_array.allocateBuffers(num_vertices);
 
     if (this->root_products_) createCSGProducts(*this->root_products_, vertex_array, false, false);
     if (this->background_products_) createCSGProducts(*this->background_products_, vertex_array, false, true);
     if (this->highlight_products_) createCSGProducts(*this->highlight_products_, vertex_array, true, false);
+    const size_t num_instanced = createInstanceBatches(vertex_array);
+    this->shared_surfaces_.clear();
+    this->polyset_uses_.clear();
 
     if (Feature::ExperimentalVxORenderersIndexing.is_enabled()) {
       GL_TRACE0("glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0)");
@@ -121,6 +146,9 @@ void ThrownTogetherRenderer::prepare(bool /*showedges*/, const RendererUtils::Sh
     GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
 
     vertex_array.createInterleavedVBOs();
+    // The batches were appended last, so their draw offsets are set with the other states
+    instanced_states_.assign(vertex_states_.end() - num_instanced, vertex_states_.end());
+    vertex_states_.resize(vertex_states_.size() - num_instanced);
   }
 }
 
@@ -156,7 +184,10 @@ void ThrownTogetherRenderer::renderCSGProducts(const std::shared_ptr<CSGProducts
   glDepthFunc(GL_LEQUAL);
   this->geom_visit_mark_.clear();
 
+  // The instance shader replaces any other, so instances are drawn one by one while a shader is used
+  const bool instanced = !instanced_states_.empty() && !(shaderinfo && shaderinfo->progid);
   for (const auto& vs : vertex_states_) {
+    if (instanced && batched_states_.count(vs.get())) continue;
     if (vs) {
       if (const auto csg_vs = std::dynamic_pointer_cast<TTRVertexState>(vs)) {
         if (shaderinfo && shaderinfo->type == RendererUtils::ShaderType::SELECT_RENDERING) {
@@ -177,6 +208,9 @@ void ThrownTogetherRenderer::renderCSGProducts(const std::shared_ptr<CSGProducts
       }
     }
   }
+  if (instanced) {
+    for (const auto& vs : instanced_states_) vs->draw();
+  }
 }
 
 void ThrownTogetherRenderer::createChainObject(VBOBuilder& vertex_array,
@@ -188,28 +222,14 @@ void ThrownTogetherRenderer::createChainObject(VBOBuilder& vertex_array,
     return;
   }
 
-  const auto& leaf_color = csgobj.leaf->color;
   const auto csgmode = RendererUtils::getCsgMode(highlight_mode, background_mode, type);
 
   vertex_array.writeSurface();
 
-  Color4f color;
+  const auto colors = surfaceColors(csgobj, highlight_mode, background_mode, type);
   if (highlight_mode || background_mode) {
-    const ColorMode colormode = getColorMode(csgobj.flags, highlight_mode, background_mode, false, type);
-    getShaderColor(colormode, leaf_color, color);
-
-    add_color(vertex_array, color);
-
-    create_surface(*csgobj.leaf->polyset, vertex_array, csgmode, csgobj.leaf->matrix, color);
-    if (const auto vs = std::dynamic_pointer_cast<TTRVertexState>(vertex_array.states().back())) {
-      vs->setCsgObjectIndex(csgobj.leaf->index);
-    }
+    createSurface(vertex_array, csgobj, csgmode, csgobj.leaf->matrix, colors[0]);
   } else { // root mode
-    ColorMode colormode = getColorMode(csgobj.flags, highlight_mode, background_mode, false, type);
-    getShaderColor(colormode, leaf_color, color);
-
-    add_color(vertex_array, color);
-
     auto cull = std::make_shared<VertexState>();
     cull->glBegin().emplace_back([]() {
       GL_TRACE0("glEnable(GL_CULL_FACE)");
@@ -224,17 +244,7 @@ void ThrownTogetherRenderer::createChainObject(VBOBuilder& vertex_array,
       // Scale 2D negative objects 10% in the Z direction to avoid z fighting
       mat *= Eigen::Scaling(1.0, 1.0, 1.1);
     }
-    create_surface(*csgobj.leaf->polyset, vertex_array, csgmode, mat, color);
-    if (auto vs = std::dynamic_pointer_cast<TTRVertexState>(vertex_array.states().back())) {
-      vs->setCsgObjectIndex(csgobj.leaf->index);
-    }
-
-    color[0] = 1.0; color[1] = 0.0; color[2] = 1.0; // override leaf color on front/back error
-
-    colormode = getColorMode(csgobj.flags, highlight_mode, background_mode, true, type);
-    getShaderColor(colormode, leaf_color, color);
-
-    add_color(vertex_array, color);
+    createSurface(vertex_array, csgobj, csgmode, mat, colors[0], GL_BACK);
 
     cull = std::make_shared<VertexState>();
     cull->glBegin().emplace_back([]() {
@@ -243,15 +253,162 @@ void ThrownTogetherRenderer::createChainObject(VBOBuilder& vertex_array,
     });
     vertex_states_.emplace_back(std::move(cull));
 
-    create_surface(*csgobj.leaf->polyset, vertex_array, csgmode, csgobj.leaf->matrix, color);
-    if (auto vs = std::dynamic_pointer_cast<TTRVertexState>(vertex_array.states().back())) {
-      vs->setCsgObjectIndex(csgobj.leaf->index);
-    }
+    createSurface(vertex_array, csgobj, csgmode, csgobj.leaf->matrix, colors[1], GL_FRONT);
 
-    vertex_states_.back()->glEnd().emplace_back([]() {
+    // A state of its own, since the surface may be drawn by an instance batch instead
+    cull = std::make_shared<VertexState>();
+    cull->glEnd().emplace_back([]() {
       GL_TRACE0("glDisable(GL_CULL_FACE)");
       GL_CHECKD(glDisable(GL_CULL_FACE));
     });
+    vertex_states_.emplace_back(std::move(cull));
+  }
+}
+
+// Creates the surface of a leaf. PolySets used by several leaves, like the
+// children of a for loop, have their vertices created once per color and
+// are transformed by the GPU, since the vertex colors are part of the buffer.
+void ThrownTogetherRenderer::createSurface(VBOBuilder& vertex_array, const CSGChainObject& csgobj,
+                                           RendererUtils::CSGMode csgmode, const Transform3d& m, const Color4f& color,
+                                           GLenum cull_face)
+{
+  const auto& ps = *csgobj.leaf->polyset;
+  if (this->polyset_uses_[&ps] < 2) {
+    add_color(vertex_array, color);
+    create_surface(ps, vertex_array, csgmode, m, color);
+  } else {
+    auto [it, inserted] = this->shared_surfaces_.try_emplace(std::make_pair(&ps, color));
+    auto& shared = it->second;
+    if (inserted) {
+      shared.vertices_offset = vertex_array.verticesOffset();
+      add_color(vertex_array, color);
+      create_surface(ps, vertex_array, csgmode, Transform3d::Identity(), color);
+      shared.state = vertex_array.states().back();
+      add_instance_transform(*shared.state, m);
+    } else {
+      add_color(vertex_array, color, shared.vertices_offset);
+      create_surface_instance(*shared.state, shared.vertices_offset, vertex_array, m);
+    }
+    if (this->instance_program_ && this->instance_matrix_location_ >= 0) {
+      const auto& instance = vertex_array.states().back();
+      this->batched_states_.insert(instance.get());
+      const bool mirrored = m.matrix().determinant() < 0;
+      auto& batch = this->instance_batches_[std::make_tuple(shared.state.get(), cull_face, mirrored)];
+      batch.surface = shared.state;
+      batch.vertices_offset = shared.vertices_offset;
+      batch.matrices.push_back(m);
+    }
+  }
+  if (const auto vs = std::dynamic_pointer_cast<TTRVertexState>(vertex_array.states().back())) {
+    vs->setCsgObjectIndex(csgobj.leaf->index);
+  }
+}
+
+// Appends a state per instance batch, which draws all its instances at once,
+// and uploads their matrices. Returns the number of states appended.
+size_t ThrownTogetherRenderer::createInstanceBatches(VBOBuilder& vertex_array)
+{
+  if (this->instance_batches_.empty()) return 0;
+
+  std::vector<GLfloat> matrices;
+  vertex_array.writeSurface();
+  glGenBuffers(1, &instances_vbo_);
+  for (const auto& [key, batch] : this->instance_batches_) {
+    const auto& [surface, cull_face, mirrored] = key;
+    const size_t first = matrices.size() / 16;
+    for (const auto& m : batch.matrices) {
+      const Eigen::Matrix4f matrix = m.matrix().cast<float>();
+      matrices.insert(matrices.end(), matrix.data(), matrix.data() + 16);
+    }
+    vertex_array.states().emplace_back(vertex_array.createVertexState(
+      surface->drawMode(), surface->drawSize(), surface->drawType(),
+      vertex_array.writeIndex(), surface->elementOffset()));
+    vertex_array.addAttributePointers(batch.vertices_offset);
+    auto& vs = *vertex_array.states().back();
+    if (cull_face) {
+      vs.glBegin().emplace_back([cull_face = cull_face]() {
+        GL_TRACE0("glEnable(GL_CULL_FACE)");
+        GL_CHECKD(glEnable(GL_CULL_FACE));
+        GL_TRACE("glCullFace(%d)", cull_face);
+        GL_CHECKD(glCullFace(cull_face));
+      });
+      vs.glEnd().emplace_back([]() {
+        GL_TRACE0("glDisable(GL_CULL_FACE)");
+        GL_CHECKD(glDisable(GL_CULL_FACE));
+      });
+    }
+    add_instance_matrices(vs, this->instance_program_, this->instance_matrix_location_, instances_vbo_,
+                          first, batch.matrices.size(), mirrored);
+  }
+
+  GL_TRACE("glBindBuffer(GL_ARRAY_BUFFER, %d)", instances_vbo_);
+  GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, instances_vbo_));
+  GL_TRACE("glBufferData(GL_ARRAY_BUFFER, %d, %p, GL_STATIC_DRAW)", (matrices.size() * sizeof(GLfloat)) % matrices.data());
+  GL_CHECKD(glBufferData(GL_ARRAY_BUFFER, matrices.size() * sizeof(GLfloat), matrices.data(), GL_STATIC_DRAW));
+  GL_TRACE0("glBindBuffer(GL_ARRAY_BUFFER, 0)");
+  GL_CHECKD(glBindBuffer(GL_ARRAY_BUFFER, 0));
+
+  const size_t num_batches = this->instance_batches_.size();
+  this->instance_batches_.clear();
+  return num_batches;
+}
+
+// The colors of the surfaces createChainObject() creates for a leaf: in root
+// mode those of its front faces and of its back faces, otherwise just one
+std::vector<Color4f> ThrownTogetherRenderer::surfaceColors(const CSGChainObject& csgobj, bool highlight_mode,
+                                                           bool background_mode, OpenSCADOperator type) const
+{
+  const auto& leaf_color = csgobj.leaf->color;
+  Color4f color;
+  ColorMode colormode = getColorMode(csgobj.flags, highlight_mode, background_mode, false, type);
+  getShaderColor(colormode, leaf_color, color);
+  if (highlight_mode || background_mode) return {color};
+
+  std::vector<Color4f> colors{color};
+  color[0] = 1.0; color[1] = 0.0; color[2] = 1.0; // override leaf color on front/back error
+  colormode = getColorMode(csgobj.flags, highlight_mode, background_mode, true, type);
+  getShaderColor(colormode, leaf_color, color);
+  colors.push_back(color);
+  return colors;
+}
+
+// The vertices createCSGProducts() creates for the products. Shared surfaces
+// already in shared, e.g. from other products, take no vertices.
+size_t ThrownTogetherRenderer::surfaceBufferSize(const CSGProducts& products, bool highlight_mode, bool background_mode,
+                                                 std::set<std::pair<const PolySet *, Color4f>>& shared)
+{
+  size_t buffer_size = 0;
+  this->geom_visit_mark_.clear();
+  for (const auto& product : products.products) {
+    for (const auto& [csgobjs, type] : {std::make_pair(&product.intersections, OpenSCADOperator::INTERSECTION),
+                                        std::make_pair(&product.subtractions, OpenSCADOperator::DIFFERENCE)}) {
+      for (const auto& csgobj : *csgobjs) {
+        const auto *ps = csgobj.leaf->polyset.get();
+        if (!ps || this->geom_visit_mark_[std::make_pair(ps, &csgobj.leaf->matrix)]++ > 0) continue;
+        for (const auto& color : surfaceColors(csgobj, highlight_mode, background_mode, type)) {
+          if (this->polyset_uses_[ps] < 2 || shared.emplace(ps, color).second) {
+            buffer_size += getSurfaceBufferSize(*ps);
+          }
+        }
+      }
+    }
+  }
+  return buffer_size;
+}
+
+// Counts the leaves drawing each PolySet, with the same uniqueness as createChainObject()
+void ThrownTogetherRenderer::countPolySetUses(const CSGProducts& products)
+{
+  this->geom_visit_mark_.clear();
+  for (const auto& product : products.products) {
+    for (const auto *csgobjs : {&product.intersections, &product.subtractions}) {
+      for (const auto& csgobj : *csgobjs) {
+        if (csgobj.leaf->polyset &&
+            this->geom_visit_mark_[std::make_pair(csgobj.leaf->polyset.get(), &csgobj.leaf->matrix)]++ == 0) {
+          ++this->polyset_uses_[csgobj.leaf->polyset.get()];
+        }
+      }
+    }
   }
 }
 
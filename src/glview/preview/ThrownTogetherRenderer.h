@@ -1,7 +1,13 @@
 #pragma once
 
+#include <map>
 #include <memory>
 #include <cstddef>
+#include <set>
+#include <tuple>
+#include <unordered_set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "glview/Renderer.h"
@@ -64,6 +70,38 @@ private:
   void createChainObject(VBOBuilder& vertex_array, const CSGChainObject& csgobj,
                          bool highlight_mode, bool background_mode,
                          OpenSCADOperator type);
+  void createSurface(VBOBuilder& vertex_array, const CSGChainObject& csgobj,
+                     RendererUtils::CSGMode csgmode, const Transform3d& m, const Color4f& color,
+                     GLenum cull_face = 0);
+  size_t createInstanceBatches(VBOBuilder& vertex_array);
+  void countPolySetUses(const CSGProducts& products);
+  std::vector<Color4f> surfaceColors(const CSGChainObject& csgobj, bool highlight_mode, bool background_mode,
+                                     OpenSCADOperator type) const;
+  size_t surfaceBufferSize(const CSGProducts& products, bool highlight_mode, bool background_mode,
+                           std::set<std::pair<const PolySet *, Color4f>>& shared);
+
+  // Vertices of a PolySet used by several leaves, created once in its own
+  // coordinates and drawn with the matrix of each leaf
+  struct SharedSurface {
+    std::shared_ptr<VertexState> state;
+    size_t vertices_offset;
+  };
+  std::unordered_map<const PolySet *, size_t> polyset_uses_;
+  std::map<std::pair<const PolySet *, Color4f>, SharedSurface> shared_surfaces_;
+
+  // The instances of a shared surface with the same face culling and winding.
+  // Unless a shader is in use, they're drawn with one instanced draw call
+  // instead of one draw call per instance.
+  struct InstanceBatch {
+    std::shared_ptr<VertexState> surface;
+    size_t vertices_offset;
+    std::vector<Transform3d> matrices;
+  };
+  std::map<std::tuple<const VertexState *, GLenum, bool>, InstanceBatch> instance_batches_;
+  std::unordered_set<const VertexState *> batched_states_; // Drawn by instanced_states_
+  std::vector<std::shared_ptr<VertexState>> instanced_states_;
+  GLuint instance_program_{0};
+  GLint instance_matrix_location_{-1};
 
   std::vector<std::shared_ptr<VertexState>> vertex_states_;
   std::shared_ptr<CSGProducts> root_products_;
@@ -71,4 +109,5 @@ private:
   std::shared_ptr<CSGProducts> background_products_;
   GLuint vertices_vbo_{0};
   GLuint elements_vbo_{0};
+  GLuint instances_vbo_{0};
 };
@@ -0,0 +1,141 @@
+#include "gui/CSGWorker.h"
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <QThread>
+
+#include "core/CSGNode.h"
+#include "core/CSGTreeEvaluator.h"
+#include "core/Tree.h"
+#include "geometry/GeometryEvaluator.h"
+#include "glview/preview/CSGTreeNormalizer.h"
+#ifdef ENABLE_OPENCSG
+#include "glview/preview/OpenCSGRenderer.h"
+#endif
+#include "core/progress.h"
+#include "utils/printutils.h"
+#include "utils/exceptions.h"
+
+namespace {
+
+// Normalizes the terms into one set of products, or returns nullptr if there are none
+std::shared_ptr<CSGProducts> normalize_terms(CSGTreeNormalizer& normalizer, const std::vector<std::shared_ptr<CSGNode>>& terms,
+                                             const std::atomic<bool>& cancelled)
+{
+  if (terms.empty()) return nullptr;
+  auto products = std::make_shared<CSGProducts>();
+  for (const auto& term : terms) {
+    if (cancelled) break;
+    if (auto nterm = normalizer.normalize(term)) {
+      products->import(nterm);
+    }
+  }
+  return products;
+}
+
+} // namespace
+
+CSGWorker::CSGWorker()
+{
+  this->tree = nullptr;
+  this->thread = new QThread();
+  if (this->thread->stackSize() < 1024 * 1024) this->thread->setStackSize(1024 * 1024);
+  connect(this->thread, SIGNAL(started()), this, SLOT(work()));
+  moveToThread(this->thread);
+}
+
+CSGWorker::~CSGWorker()
+{
+  this->cancelled = true;
+  this->thread->quit();
+  this->thread->wait();
+  delete this->thread;
+}
+
+bool CSGWorker::isRunning() const
+{
+  return this->thread->isRunning();
+}
+
+void CSGWorker::start(const Tree& tree, size_t normalizelimit,
+                      std::shared_ptr<OpenCSGRenderer> vbo_renderer, size_t opencsglimit)
+{
+  this->tree = &tree;
+  this->normalizelimit = normalizelimit;
+  this->vbo_renderer = std::move(vbo_renderer);
+  this->opencsglimit = opencsglimit;
+  this->cancelled = false;
+  this->thread->start();
+}
+
+void CSGWorker::work()
+{
+  // this is a worker thread: we don't want any exceptions escaping and crashing the app.
+  auto preview = std::make_shared<CSGPreview>();
+  try {
+    GeometryEvaluator geomevaluator(*this->tree);
+    CSGTreeEvaluator csgrenderer(*this->tree, &geomevaluator);
+    try {
+#ifdef ENABLE_OPENCSG
+      preview->csgRoot = csgrenderer.buildCSGTree(*this->tree->root());
+#endif
+    } catch (const ProgressCancelException&) {
+      this->cancelled = true;
+    } catch (const HardWarningException&) {
+      LOG("CSG generation cancelled due to hardwarning being enabled.");
+    }
+
+    // OpenCSG is disabled for roots with too many products, so their data isn't built
+    const auto build_vbo_data = [&](const std::shared_ptr<CSGProducts>& products, bool highlight_mode,
+                                    bool background_mode) -> std::shared_ptr<OpenCSGVBOData> {
+#ifdef ENABLE_OPENCSG
+      if (this->vbo_renderer && products && !this->cancelled &&
+          (!preview->root_products || preview->root_products->size() <= this->opencsglimit)) {
+        return this->vbo_renderer->buildVBOData(*products, highlight_mode, background_mode);
+      }
+#endif
+      return nullptr;
+    };
+
+    const auto& highlight_terms = csgrenderer.getHighlightNodes();
+    const auto& background_terms = csgrenderer.getBackgroundNodes();
+    CSGTreeNormalizer normalizer(this->normalizelimit);
+    if (preview->csgRoot && !this->cancelled) {
+      LOG("Compiling design (CSG Products normalization)...");
+      preview->normalizedRoot = normalizer.normalize(preview->csgRoot);
+      if (preview->normalizedRoot) {
+        preview->root_products = std::make_shared<CSGProducts>();
+        preview->root_products->import(preview->normalizedRoot);
+        preview->root_vbo_data = build_vbo_data(preview->root_products, false, false);
+        if (!this->cancelled && (!highlight_terms.empty() || !background_terms.empty())) {
+          emit rootProductsReady(std::make_shared<const CSGPreview>(*preview));
+        }
+      } else {
+        LOG(message_group::Warning, "CSG normalization resulted in an empty tree");
+      }
+    }
+
+    if (!highlight_terms.empty() && !this->cancelled) {
+      LOG("Compiling highlights (%1$d CSG Trees)...", highlight_terms.size());
+      preview->highlights_products = normalize_terms(normalizer, highlight_terms, this->cancelled);
+      preview->highlights_vbo_data = build_vbo_data(preview->highlights_products, true, false);
+    }
+    if (!background_terms.empty() && !this->cancelled) {
+      LOG("Compiling background (%1$d CSG Trees)...", background_terms.size());
+      preview->background_products = normalize_terms(normalizer, background_terms, this->cancelled);
+      preview->background_vbo_data = build_vbo_data(preview->background_products, false, true);
+    }
+  } catch (const HardWarningException&) {
+    preview->hardwarning = true;
+  } catch (const std::exception& e) {
+    LOG(message_group::Error, "CSG generation cancelled by exception %1$s", e.what());
+  } catch (...) {
+    LOG(message_group::Error, "CSG generation cancelled by unknown exception.");
+  }
+
+  this->vbo_renderer.reset();
+  emit done(preview);
+  thread->quit();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QObject>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+class Tree;
+class CSGNode;
+class CSGProducts;
+class OpenCSGRenderer;
+class OpenCSGVBOData;
+
+// The CSG products of a preview, and the trees they were built from
+struct CSGPreview
+{
+  std::shared_ptr<CSGNode> csgRoot; // Result of the CSGTreeEvaluator
+  std::shared_ptr<CSGNode> normalizedRoot;
+  std::shared_ptr<CSGProducts> root_products;
+  std::shared_ptr<CSGProducts> highlights_products;
+  std::shared_ptr<CSGProducts> background_products;
+  // Vertex data of the products, so the GUI thread only uploads it
+  std::shared_ptr<OpenCSGVBOData> root_vbo_data;
+  std::shared_ptr<OpenCSGVBOData> highlights_vbo_data;
+  std::shared_ptr<OpenCSGVBOData> background_vbo_data;
+  bool hardwarning{false}; // Stopped on the first warning
+};
+
+/*!
+   Builds and normalizes the CSG tree of a preview on its own thread, so the
+   GUI stays responsive while it's evaluated.
+
+   When highlights or background follow, rootProductsReady() is emitted as
+   soon as the products of the root are normalized, so they can be shown
+   first. done() is always emitted at the end, also when cancelled.
+
+   If a renderer is given to start(), the OpenCSG vertex data of each set of
+   products is built with its shader and colors after they're normalized,
+   unless the root has more products than opencsglimit.
+ */
+class CSGWorker : public QObject
+{
+  Q_OBJECT;
+public:
+  CSGWorker();
+  ~CSGWorker() override;
+
+  [[nodiscard]] bool isRunning() const;
+  // Stops the preview between normalizations. Evaluation stops when the progress widget is cancelled.
+  void cancel() { this->cancelled = true; }
+  [[nodiscard]] bool isCancelled() const { return this->cancelled; }
+
+public slots:
+  void start(const Tree& tree, size_t normalizelimit,
+             std::shared_ptr<OpenCSGRenderer> vbo_renderer = nullptr, size_t opencsglimit = 0);
+
+protected slots:
+  void work();
+
+signals:
+  void rootProductsReady(std::shared_ptr<const CSGPreview>);
+  void done(std::shared_ptr<const CSGPreview>);
+
+protected:
+
+  class QThread *thread;
+  const class Tree *tree;
+  size_t normalizelimit{0};
+  std::shared_ptr<OpenCSGRenderer> vbo_renderer;
+  size_t opencsglimit{0};
+  std::atomic<bool> cancelled{false};
+};
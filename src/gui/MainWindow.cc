@@ -69,6 +69,8 @@
 #include "core/RenderVariables.h"
 #include "openscad.h"
 #include "geometry/GeometryCache.h"
+#include "core/GlyphCache.h"
+#include "io/ImportCache.h"
 #include "core/SourceFileCache.h"
 #include "gui/OpenSCADApp.h"
 #include "core/parsersettings.h"
@@ -175,6 +177,7 @@ std::string SHA256HashString(std::string aString){
 
 #include "glview/cgal/CGALRenderer.h"
 #include "gui/CGALWorker.h"
+#include "gui/CSGWorker.h"
 
 #ifdef ENABLE_CGAL
 #include "geometry/cgal/cgal.h"
@@ -316,6 +319,7 @@ MainWindow::MainWindow(const QStringList& filenames)
   knownFileExtensions["dxf"] = importStatement;
   knownFileExtensions["svg"] = importStatement;
   knownFileExtensions["amf"] = importStatement;
+  knownFileExtensions["osgeo"] = importStatement;
   knownFileExtensions["dat"] = surfaceStatement;
   knownFileExtensions["png"] = surfaceStatement;
   knownFileExtensions["json"] = importFunction;
@@ -380,6 +384,11 @@ MainWindow::MainWindow(const QStringList& filenames)
   this->cgalworker = new CGALWorker();
   connect(this->cgalworker, SIGNAL(done(std::shared_ptr<const Geometry>)),
           this, SLOT(actionRenderDone(std::shared_ptr<const Geometry>)));
+  this->csgworker = new CSGWorker();
+  connect(this->csgworker, SIGNAL(rootProductsReady(std::shared_ptr<const CSGPreview>)),
+          this, SLOT(csgRootProductsReady(std::shared_ptr<const CSGPreview>)));
+  connect(this->csgworker, SIGNAL(done(std::shared_ptr<const CSGPreview>)),
+          this, SLOT(csgRenderDone(std::shared_ptr<const CSGPreview>)));
 
   root_node = nullptr;
 
@@ -1277,117 +1286,112 @@ void MainWindow::instantiateRoot()
 }
 
 /*!
-   Generates CSG tree for OpenCSG evaluation.
+   Generates CSG tree for OpenCSG evaluation on the CSG worker thread, which
+   calls csgRenderDone() when it's done.
    Assumes that the design has been parsed and evaluated (this->root_node is set)
  */
 void MainWindow::compileCSG()
 {
   OpenSCAD::hardwarnings = Preferences::inst()->getValue("advanced/enableHardwarnings").toBool();
-  try{
-    assert(this->root_node);
-    LOG("Compiling design (CSG Products generation)...");
-    this->processEvents();
+  assert(this->root_node);
+  LOG("Compiling design (CSG Products generation)...");
+  this->processEvents();
 
-    // Main CSG evaluation
-    this->progresswidget = new ProgressWidget(this);
-    connect(this->progresswidget, SIGNAL(requestShow()), this, SLOT(showProgress()));
+  // Main CSG evaluation
+  this->progresswidget = new ProgressWidget(this);
+  connect(this->progresswidget, SIGNAL(requestShow()), this, SLOT(showProgress()));
 
-    GeometryEvaluator geomevaluator(this->tree);
-#ifdef ENABLE_OPENCSG
-    CSGTreeEvaluator csgrenderer(this->tree, &geomevaluator);
-#endif
+  if (!isClosing) progress_report_prep(this->root_node, report_func, this);
+  else return;
 
-    if (!isClosing) progress_report_prep(this->root_node, report_func, this);
-    else return;
-    try {
+  const size_t opencsglimit = Preferences::inst()->getValue("advanced/openCSGLimit").toUInt();
+  size_t normalizelimit = 2ul * opencsglimit;
+  std::shared_ptr<OpenCSGRenderer> vbo_renderer;
 #ifdef ENABLE_OPENCSG
-      this->processEvents();
-      this->csgRoot = csgrenderer.buildCSGTree(*root_node);
-#endif
-      renderStatistic.printCacheStatistic();
-      this->processEvents();
-    } catch (const ProgressCancelException&) {
-      LOG("CSG generation cancelled.");
-    } catch (const HardWarningException&) {
-      LOG("CSG generation cancelled due to hardwarning being enabled.");
-    }
-    progress_report_fin();
-    updateStatusBar(nullptr);
-
-    LOG("Compiling design (CSG Products normalization)...");
-    this->processEvents();
-
-    size_t normalizelimit = 2ul * Preferences::inst()->getValue("advanced/openCSGLimit").toUInt();
-    CSGTreeNormalizer normalizer(normalizelimit);
-
-    if (this->csgRoot) {
-      this->normalizedRoot = normalizer.normalize(this->csgRoot);
-      if (this->normalizedRoot) {
-        this->root_products.reset(new CSGProducts());
-        this->root_products->import(this->normalizedRoot);
-      } else {
-        this->root_products.reset();
-        LOG(message_group::Warning, "CSG normalization resulted in an empty tree");
-        this->processEvents();
-      }
-    }
-
-    const std::vector<std::shared_ptr<CSGNode>>& highlight_terms = csgrenderer.getHighlightNodes();
-    if (highlight_terms.size() > 0) {
-      LOG("Compiling highlights (%1$d CSG Trees)...", highlight_terms.size());
-      this->processEvents();
+  // Builds the vertex data on the worker with the shader and colors the preview will use
+  if (!this->opencsgVBOCache) this->opencsgVBOCache = std::make_shared<OpenCSGVBOCache>();
+  vbo_renderer = std::make_shared<OpenCSGRenderer>(nullptr, nullptr, nullptr, this->opencsgVBOCache);
+  if (this->qglview->colorscheme) vbo_renderer->setColorScheme(*this->qglview->colorscheme);
+#endif // ifdef ENABLE_OPENCSG
+  this->csgworker->start(this->tree, normalizelimit, vbo_renderer, opencsglimit);
+}
 
-      this->highlights_products.reset(new CSGProducts());
-      for (const auto& highlight_term : highlight_terms) {
-        auto nterm = normalizer.normalize(highlight_term);
-        if (nterm) {
-          this->highlights_products->import(nterm);
-        }
-      }
-    } else {
-      this->highlights_products.reset();
-    }
+// Shows the products of the root while highlights and background are normalized
+void MainWindow::csgRootProductsReady(const std::shared_ptr<const CSGPreview>& preview)
+{
+  if (this->csgworker->isCancelled()) return;
+  this->csgRoot = preview->csgRoot;
+  this->normalizedRoot = preview->normalizedRoot;
+  this->root_products = preview->root_products;
+  this->highlights_products.reset();
+  this->background_products.reset();
+  createPreviewRenderers(preview->root_vbo_data);
+  showPreview();
+}
 
-    const auto& background_terms = csgrenderer.getBackgroundNodes();
-    if (background_terms.size() > 0) {
-      LOG("Compiling background (%1$d CSG Trees)...", background_terms.size());
-      this->processEvents();
+void MainWindow::csgRenderDone(const std::shared_ptr<const CSGPreview>& preview)
+{
+  progress_report_fin();
+  updateStatusBar(nullptr);
+  if (preview->hardwarning) {
+    exceptionCleanup();
+    return;
+  }
+  if (this->csgworker->isCancelled()) {
+    LOG("Preview cancelled.");
+    csgRenderFinished();
+    return;
+  }
+  renderStatistic.printCacheStatistic();
 
-      this->background_products.reset(new CSGProducts());
-      for (const auto& background_term : background_terms) {
-        auto nterm = normalizer.normalize(background_term);
-        if (nterm) {
-          this->background_products->import(nterm);
-        }
-      }
-    } else {
-      this->background_products.reset();
-    }
+  this->csgRoot = preview->csgRoot;
+  this->normalizedRoot = preview->normalizedRoot;
+  this->root_products = preview->root_products;
+  this->highlights_products = preview->highlights_products;
+  this->background_products = preview->background_products;
 
-    if (this->root_products &&
-        (this->root_products->size() >
-         Preferences::inst()->getValue("advanced/openCSGLimit").toUInt())) {
-      LOG(message_group::UI_Warning, "Normalized tree has %1$d elements!", this->root_products->size());
-      LOG(message_group::UI_Warning, "OpenCSG rendering has been disabled.");
-    }
+  if (this->root_products &&
+      (this->root_products->size() >
+       Preferences::inst()->getValue("advanced/openCSGLimit").toUInt())) {
+    LOG(message_group::UI_Warning, "Normalized tree has %1$d elements!", this->root_products->size());
+    LOG(message_group::UI_Warning, "OpenCSG rendering has been disabled.");
+  }
 #ifdef ENABLE_OPENCSG
-    else {
-      LOG("Normalized tree has %1$d elements!",
-          (this->root_products ? this->root_products->size() : 0));
-      this->opencsgRenderer = std::make_shared<OpenCSGRenderer>(this->root_products,
-                                                                this->highlights_products,
-                                                                this->background_products);
-    }
+  else {
+    LOG("Normalized tree has %1$d elements!",
+        (this->root_products ? this->root_products->size() : 0));
+  }
 #endif // ifdef ENABLE_OPENCSG
-    this->thrownTogetherRenderer = std::make_shared<ThrownTogetherRenderer>(this->root_products,
-                                                                            this->highlights_products,
-                                                                            this->background_products);
-    LOG("Compile and preview finished.");
-    renderStatistic.printRenderingTime();
-    this->processEvents();
-  } catch (const HardWarningException&) {
-    exceptionCleanup();
+  createPreviewRenderers(preview->root_vbo_data, preview->highlights_vbo_data, preview->background_vbo_data);
+  LOG("Compile and preview finished.");
+  renderStatistic.printRenderingTime();
+  csgRenderFinished();
+}
+
+// Creates the renderers of the current products. OpenCSG is left out when there are too many.
+// The vertex data built by the CSG worker, if any, is uploaded by the OpenCSG renderer.
+void MainWindow::createPreviewRenderers(const std::shared_ptr<OpenCSGVBOData>& root_vbo_data,
+                                        const std::shared_ptr<OpenCSGVBOData>& highlights_vbo_data,
+                                        const std::shared_ptr<OpenCSGVBOData>& background_vbo_data)
+{
+#ifdef ENABLE_OPENCSG
+  this->opencsgRenderer = nullptr;
+  if (!this->root_products ||
+      this->root_products->size() <= Preferences::inst()->getValue("advanced/openCSGLimit").toUInt()) {
+    // Products shown before, e.g. without highlights and background, keep their VBOs
+    if (!this->opencsgVBOCache) this->opencsgVBOCache = std::make_shared<OpenCSGVBOCache>();
+    this->opencsgRenderer = std::make_shared<OpenCSGRenderer>(this->root_products,
+                                                              this->highlights_products,
+                                                              this->background_products,
+                                                              this->opencsgVBOCache,
+                                                              root_vbo_data,
+                                                              highlights_vbo_data,
+                                                              background_vbo_data);
   }
+#endif // ifdef ENABLE_OPENCSG
+  this->thrownTogetherRenderer = std::make_shared<ThrownTogetherRenderer>(this->root_products,
+                                                                          this->highlights_products,
+                                                                          this->background_products);
 }
 
 void MainWindow::actionOpen()
@@ -1966,19 +1970,9 @@ void MainWindow::actionReloadRenderPreview()
 
 void MainWindow::csgReloadRender()
 {
+  this->dumpPreviewFrame = false;
   if (this->root_node) compileCSG();
-
-  // Go to non-CGAL view mode
-  if (viewActionThrownTogether->isChecked()) {
-    viewModeThrownTogether();
-  } else {
-#ifdef ENABLE_OPENCSG
-    viewModePreview();
-#else
-    viewModeThrownTogether();
-#endif
-  }
-  compileEnded();
+  else csgRenderFinished();
 }
 
 void MainWindow::prepareCompile(const char *afterCompileSlot, bool procevents, bool preview)
@@ -1995,19 +1989,17 @@ void MainWindow::prepareCompile(const char *afterCompileSlot, bool procevents, b
 
 void MainWindow::actionRenderPreview()
 {
-  static bool preview_requested;
-
-  preview_requested = true;
+  this->preview_requested = true;
   if (GuiLocker::isLocked()) return;
   GuiLocker::lock();
-  preview_requested = false;
+  this->preview_requested = false;
 
   this->designActionMeasureDist->setEnabled(false);
   this->designActionMeasureAngle->setEnabled(false);
 
   prepareCompile("csgRender", windowActionHideAnimate->isChecked(), true);
   compile(false, false);
-  if (preview_requested) {
+  if (this->preview_requested && !this->csgworker->isRunning()) {
     // if the action was called when the gui was locked, we must request it one more time
     // however, it's not possible to call it directly NOR make the loop
     // it must be called from the mainloop
@@ -2015,11 +2007,48 @@ void MainWindow::actionRenderPreview()
   }
 }
 
+/*!
+   Previews the design after it was changed in the editor or the customizer.
+   A preview which is still running is of the old design, so it's cancelled,
+   and the design is previewed again when it has stopped.
+ */
+void MainWindow::actionRenderChangedPreview()
+{
+  if (this->csgworker->isRunning()) {
+    this->csgworker->cancel();
+    if (this->progresswidget) this->progresswidget->cancel();
+  }
+  actionRenderPreview();
+}
+
 void MainWindow::csgRender()
 {
+  this->dumpPreviewFrame = animateWidget->dumpPictures();
   if (this->root_node) compileCSG();
+  else csgRenderFinished();
+}
+
+// Shows the preview and ends the compile. Starts the next preview if one was requested meanwhile.
+void MainWindow::csgRenderFinished()
+{
+  showPreview();
+
+  if (this->dumpPreviewFrame) {
+    int steps = animateWidget->nextFrame();
+    QImage img = this->qglview->grabFrame();
+    QString filename = QString("frame%1.png").arg(steps, 5, 10, QChar('0'));
+    img.save(filename, "PNG");
+  }
 
-  // Go to non-CGAL view mode
+  compileEnded();
+  if (this->preview_requested) {
+    QTimer::singleShot(0, this, SLOT(actionRenderPreview()));
+  }
+}
+
+// Go to non-CGAL view mode
+void MainWindow::showPreview()
+{
   if (viewActionThrownTogether->isChecked()) {
     viewModeThrownTogether();
   } else {
@@ -2029,15 +2058,6 @@ void MainWindow::csgRender()
     viewModeThrownTogether();
 #endif
   }
-
-  if (animateWidget->dumpPictures() ) {
-    int steps = animateWidget->nextFrame();
-    QImage img = this->qglview->grabFrame();
-    QString filename = QString("frame%1.png").arg(steps, 5, 10, QChar('0'));
-    img.save(filename, "PNG");
-  }
-
-  compileEnded();
 }
 
 std::unique_ptr<ExternalToolInterface> createExternalToolService(
@@ -2820,6 +2840,8 @@ void MainWindow::actionFlushCaches()
 {
   GeometryCache::instance()->clear();
   CGALCache::instance()->clear();
+  GlyphCache::instance()->clear();
+  ImportCache::instance()->clear();
   dxf_dim_cache.clear();
   dxf_cross_cache.clear();
   SourceFileCache::instance()->clear();
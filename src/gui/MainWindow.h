@@ -51,6 +51,8 @@ Q_IMPORT_PLUGIN(QSvgPlugin)
 
 class BuiltinContext;
 class CGALWorker;
+class CSGWorker;
+struct CSGPreview;
 class CSGNode;
 class CSGProducts;
 class FontListDialog;
@@ -91,6 +93,8 @@ public:
   std::shared_ptr<const Geometry> root_geom;
   std::shared_ptr<Renderer> cgalRenderer;
 #ifdef ENABLE_OPENCSG
+  // Keeps the VBOs of unchanged products from one preview to the next
+  std::shared_ptr<class OpenCSGVBOCache> opencsgVBOCache;
   std::shared_ptr<Renderer> opencsgRenderer;
   std::unique_ptr<class MouseSelector> selector;
 #endif
@@ -158,6 +162,10 @@ private:
   void updateCompileResult();
   void compile(bool reload, bool forcedone = false);
   void compileCSG();
+  void createPreviewRenderers(const std::shared_ptr<class OpenCSGVBOData>& root_vbo_data = nullptr,
+                              const std::shared_ptr<class OpenCSGVBOData>& highlights_vbo_data = nullptr,
+                              const std::shared_ptr<class OpenCSGVBOData>& background_vbo_data = nullptr);
+  void showPreview();
   bool checkEditorModified();
   QString dumpCSGTree(const std::shared_ptr<AbstractNode>& root);
 
@@ -262,9 +270,13 @@ protected:
 
 public slots:
   void actionRenderPreview();
+  void actionRenderChangedPreview();
 private slots:
   void csgRender();
   void csgReloadRender();
+  void csgRootProductsReady(const std::shared_ptr<const CSGPreview>&);
+  void csgRenderDone(const std::shared_ptr<const CSGPreview>&);
+  void csgRenderFinished();
   void action3DPrint();
   void sendToExternalTool(class ExternalToolInterface &externalToolService);
   void actionRender();
@@ -391,6 +403,9 @@ private:
   QTemporaryFile *tempFile{nullptr};
   ProgressWidget *progresswidget{nullptr};
   CGALWorker *cgalworker;
+  CSGWorker *csgworker;
+  bool preview_requested{false}; // While the GUI was locked
+  bool dumpPreviewFrame{false}; // Save the preview as an animation frame when it's done
   QMutex consolemutex;
   EditorInterface *renderedEditor; // stores pointer to editor which has been most recently rendered
   time_t includes_mtime{0}; // latest include mod time
@@ -45,6 +45,7 @@ void Measurement::startMeasureDist(void)
   this->qglview->selected_obj.clear();
   this->qglview->update();
   this->qglview->measure_state=MEASURE_DIST1;
+  if (auto renderer = this->qglview->getRenderer()) renderer->prepareFindModelObject();
 }
 
 void Measurement::startMeasureAngle(void)
@@ -52,6 +53,7 @@ void Measurement::startMeasureAngle(void)
   this->qglview->selected_obj.clear();
   this->qglview->update();
   this->qglview->measure_state=MEASURE_ANG1;
+  if (auto renderer = this->qglview->getRenderer()) renderer->prepareFindModelObject();
 }
 QString Measurement::statemachine(QPoint mouse)
 {
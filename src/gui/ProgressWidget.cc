@@ -1,4 +1,5 @@
 #include "gui/ProgressWidget.h"
+#include "core/progress.h"
 #include <QWidget>
 #include <QTimer>
 
@@ -31,6 +32,8 @@ int ProgressWidget::elapsedTime() const
 void ProgressWidget::cancel()
 {
   this->wascanceled = true;
+  // Also stop checkpoints within long operations, which may run on other threads
+  progress_cancel();
 }
 
 void ProgressWidget::setRange(int minimum, int maximum)
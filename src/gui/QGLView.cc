@@ -303,6 +303,7 @@ void QGLView::mouseMoveEvent(QMouseEvent *event)
   double dy = (this_mouse.y() - last_mouse.y()) * 0.7;
   if (mouse_drag_active) {
     mouse_drag_moved = true;
+    camera_moving = true;
     auto button_compare = this->mouseSwapButtons?Qt::RightButton : Qt::LeftButton;
     if (event->buttons() & button_compare
 #ifdef Q_OS_MACOS
@@ -349,6 +350,11 @@ void QGLView::mouseReleaseEvent(QMouseEvent *event)
 {
   mouse_drag_active = false;
   releaseMouse();
+  if (camera_moving) {
+    // Redraw in full detail
+    camera_moving = false;
+    update();
+  }
 
   auto button_right = this->mouseSwapButtons?Qt::LeftButton : Qt::RightButton;
   auto button_left =  this->mouseSwapButtons?Qt::RightButton : Qt::LeftButton;
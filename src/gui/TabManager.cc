@@ -178,7 +178,7 @@ void TabManager::createTab(const QString& filename)
   Preferences::create(editor->colorSchemes()); // needs to be done only once, however handled
   par->activeEditor = editor;
   editor->parameterWidget = new ParameterWidget(par->parameterDock);
-  connect(editor->parameterWidget, SIGNAL(parametersChanged()), par, SLOT(actionRenderPreview()));
+  connect(editor->parameterWidget, SIGNAL(parametersChanged()), par, SLOT(actionRenderChangedPreview()));
   par->parameterDock->setWidget(editor->parameterWidget);
 
   // clearing default mapping of keyboard shortcut for font size
@@ -189,7 +189,7 @@ void TabManager::createTab(const QString& filename)
   qcmd->setKey(0);
 
   connect(editor, SIGNAL(uriDropped(const QUrl&)), par, SLOT(handleFileDrop(const QUrl&)));
-  connect(editor, SIGNAL(previewRequest()), par, SLOT(actionRenderPreview()));
+  connect(editor, SIGNAL(previewRequest()), par, SLOT(actionRenderChangedPreview()));
   connect(editor, SIGNAL(showContextMenuEvent(const QPoint&)), this, SLOT(showContextMenuEvent(const QPoint&)));
   connect(editor, &EditorInterface::focusIn, this, [=]() { par->setLastFocus(editor); });
 
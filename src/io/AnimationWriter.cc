@@ -0,0 +1,271 @@
+#include "io/AnimationWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "utils/printutils.h"
+
+namespace {
+
+constexpr std::string_view PNG_SIGNATURE("\x89PNG\r\n\x1a\n", 8);
+
+struct PngChunk {
+  std::string_view type;
+  std::string_view data;
+};
+
+uint32_t read_be32(std::string_view bytes)
+{
+  const auto b = reinterpret_cast<const unsigned char *>(bytes.data());
+  return (uint32_t(b[0]) << 24) | (uint32_t(b[1]) << 16) | (uint32_t(b[2]) << 8) | uint32_t(b[3]);
+}
+
+void append_be32(std::string& out, uint32_t value)
+{
+  const char bytes[] = {char(value >> 24), char(value >> 16), char(value >> 8), char(value)};
+  out.append(bytes, 4);
+}
+
+void append_be16(std::string& out, uint16_t value)
+{
+  const char bytes[] = {char(value >> 8), char(value)};
+  out.append(bytes, 2);
+}
+
+// Splits a PNG file into its chunks. Returns false if it isn't a valid PNG file.
+bool split_png(std::string_view png, std::vector<PngChunk>& chunks)
+{
+  if (png.substr(0, PNG_SIGNATURE.size()) != PNG_SIGNATURE) return false;
+  size_t pos = PNG_SIGNATURE.size();
+  while (pos + 12 <= png.size()) {
+    const uint32_t length = read_be32(png.substr(pos));
+    if (length > png.size() - pos - 12) return false;
+    chunks.push_back({png.substr(pos + 4, 4), png.substr(pos + 8, length)});
+    pos += 12 + length;
+  }
+  return pos == png.size() && !chunks.empty() && chunks.front().type == "IHDR";
+}
+
+void write_chunk(std::ostream& output, std::string_view type, std::string_view data)
+{
+  std::string chunk;
+  chunk.reserve(12 + data.size());
+  append_be32(chunk, data.size());
+  chunk.append(type);
+  chunk.append(data);
+  const auto crc = crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef *>(chunk.data() + 4), 4 + data.size());
+  append_be32(chunk, crc);
+  output.write(chunk.data(), chunk.size());
+}
+
+// Animation control: the number of frames, played in a loop forever
+std::string actl_chunk(uint32_t num_frames)
+{
+  std::string actl;
+  append_be32(actl, num_frames);
+  append_be32(actl, 0);
+  return actl;
+}
+
+// The acTL chunk follows the signature and the 13 byte IHDR chunk
+constexpr std::streamoff ACTL_OFFSET = PNG_SIGNATURE.size() + 12 + 13;
+
+// Drops the alpha channel, as PNG export does
+std::string to_rgb(const RGBAImage& image)
+{
+  const size_t num_pixels = static_cast<size_t>(image.width) * image.height;
+  std::string rgb(3 * num_pixels, '\0');
+  for (size_t i = 0; i < num_pixels; ++i) {
+    std::memcpy(&rgb[3 * i], &image.pixels[4 * i], 3);
+  }
+  return rgb;
+}
+
+} // namespace
+
+AnimationWriter::AnimationWriter(AnimationFormat format, const std::string& filename, bool is_stdout, unsigned int num_frames, double fps)
+  : format(format), num_frames(num_frames), fps(fps)
+{
+  if (format == AnimationFormat::PNG) return;
+  if (is_stdout) {
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    output = &std::cout;
+    return;
+  }
+  file.open(filename, std::ios::out | std::ios::binary);
+  if (file.is_open()) {
+    output = &file;
+  } else {
+    LOG("Can't open file \"%1$s\" for export", filename);
+  }
+}
+
+AnimationWriter::~AnimationWriter()
+{
+  finish();
+}
+
+size_t AnimationWriter::maxPending()
+{
+  return std::max(2u, std::thread::hardware_concurrency());
+}
+
+bool AnimationWriter::addFrame(RGBAImage image, const std::string& frame_filename)
+{
+  if (!ok || !isOpen()) return false;
+  while (pending.size() >= maxPending()) {
+    ok = writeFrame(pending.front().get()) && ok;
+    pending.pop_front();
+  }
+  // Write frames which are already done, so they aren't held until the queue is full
+  while (!pending.empty() && pending.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+    ok = writeFrame(pending.front().get()) && ok;
+    pending.pop_front();
+  }
+  if (!ok) return false;
+
+  const auto format = this->format;
+  pending.push_back(std::async(std::launch::async, [format, image = std::move(image), frame_filename]() mutable {
+    EncodedFrame frame;
+    if (format == AnimationFormat::RAW) {
+      frame.data = to_rgb(image);
+      frame.ok = true;
+    } else if (format == AnimationFormat::APNG) {
+      std::ostringstream png;
+      frame.ok = write_png(png, image.pixels.data(), image.width, image.height);
+      frame.data = std::move(png).str();
+    } else {
+      std::ofstream png(frame_filename, std::ios::out | std::ios::binary);
+      if (!png.is_open()) {
+        LOG("Can't open file \"%1$s\" for export", frame_filename);
+      } else {
+        frame.ok = write_png(png, image.pixels.data(), image.width, image.height);
+      }
+    }
+    return frame;
+  }));
+  return true;
+}
+
+bool AnimationWriter::finish()
+{
+  if (finished) return ok;
+  finished = true;
+  while (!pending.empty()) {
+    ok = writeFrame(pending.front().get()) && ok;
+    pending.pop_front();
+  }
+  if (!output) return ok && isOpen();
+  if (format == AnimationFormat::APNG && frames_written > 0) {
+    write_chunk(*output, "IEND", "");
+    // When the animation stopped early, the frame count must match the frames
+    // written for the file to be valid. Only files can be rewritten.
+    if (frames_written != num_frames && file.is_open()) {
+      file.seekp(ACTL_OFFSET);
+      write_chunk(file, "acTL", actl_chunk(frames_written));
+      file.seekp(0, std::ios::end);
+    }
+  }
+  output->flush();
+  if (file.is_open()) file.close();
+  return ok && output->good();
+}
+
+bool AnimationWriter::writeFrame(EncodedFrame frame)
+{
+  if (!frame.ok) return false;
+  if (!ok) return false;
+  switch (format) {
+  case AnimationFormat::PNG:
+    return true;
+  case AnimationFormat::RAW:
+    output->write(frame.data.data(), frame.data.size());
+    return output->good();
+  case AnimationFormat::APNG:
+    return writeApngFrame(frame.data);
+  }
+  return false;
+}
+
+/*!
+   Appends a frame, encoded as a PNG file, to the animated PNG. The first frame
+   is written as the default image, with the APNG control chunks added. The
+   image data of the following frames is moved into fdAT chunks.
+ */
+bool AnimationWriter::writeApngFrame(const std::string& png)
+{
+  std::vector<PngChunk> chunks;
+  if (!split_png(png, chunks)) {
+    LOG(message_group::Error, "Invalid PNG image of animation frame %1$d", frames_written);
+    return false;
+  }
+  const auto& ihdr = chunks.front().data;
+  if (frames_written == 0) {
+    header = ihdr;
+  } else if (ihdr != header) {
+    LOG(message_group::Error, "Animation frame %1$d has a different image format than the first frame", frames_written);
+    return false;
+  }
+
+  // Frame control: the full image, replacing the previous one
+  std::string fctl;
+  append_be32(fctl, sequence_number++);
+  fctl.append(ihdr.substr(0, 8)); // width and height
+  append_be32(fctl, 0);
+  append_be32(fctl, 0);
+  const double delay_ms = fps > 0 ? std::round(1000.0 / fps) : 0;
+  append_be16(fctl, static_cast<uint16_t>(std::clamp(delay_ms, 0.0, 65535.0)));
+  append_be16(fctl, 1000);
+  fctl.append(2, '\0'); // APNG_DISPOSE_OP_NONE, APNG_BLEND_OP_SOURCE
+
+  if (frames_written == 0) {
+    output->write(PNG_SIGNATURE.data(), PNG_SIGNATURE.size());
+    bool wrote_fctl = false;
+    for (const auto& chunk : chunks) {
+      if (chunk.type == "IEND") break;
+      if (chunk.type == "IDAT" && !wrote_fctl) {
+        write_chunk(*output, "fcTL", fctl);
+        wrote_fctl = true;
+      } else if (chunk.type != "IDAT" && wrote_fctl) {
+        continue; // Chunks after the image data describe the whole file, not a frame
+      }
+      write_chunk(*output, chunk.type, chunk.data);
+      if (chunk.type == "IHDR") {
+        write_chunk(*output, "acTL", actl_chunk(num_frames));
+      }
+    }
+  } else {
+    write_chunk(*output, "fcTL", fctl);
+    for (const auto& chunk : chunks) {
+      if (chunk.type != "IDAT") continue;
+      std::string fdat;
+      fdat.reserve(4 + chunk.data.size());
+      append_be32(fdat, sequence_number++);
+      fdat.append(chunk.data);
+      write_chunk(*output, "fdAT", fdat);
+    }
+  }
+  ++frames_written;
+  return output->good();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <ostream>
+#include <string>
+
+#include "io/imageutils.h"
+
+// How the frames of an animation are written
+enum class AnimationFormat {
+  PNG,  // A PNG file for each frame
+  APNG, // All frames in one animated PNG
+  RAW,  // Uncompressed 8 bit RGB frames, one after another, e.g. for video encoders
+};
+
+/*!
+   Writes the rendered frames of an animation, encoding them on worker threads
+   so the next frame can be evaluated and rendered meanwhile.
+
+   At most maxPending() frames are held in memory: addFrame() waits for the
+   oldest one to be written when there are more. APNG and raw frames are
+   encoded in parallel too, but written to their single output in order.
+ */
+class AnimationWriter
+{
+public:
+  // filename and is_stdout give the output of the APNG and raw formats
+  AnimationWriter(AnimationFormat format, const std::string& filename, bool is_stdout, unsigned int num_frames, double fps);
+  // Finishes the output if finish() wasn't called, e.g. when an export threw
+  ~AnimationWriter();
+  AnimationWriter(const AnimationWriter&) = delete;
+  AnimationWriter& operator=(const AnimationWriter&) = delete;
+
+  [[nodiscard]] bool isOpen() const { return format == AnimationFormat::PNG || output; }
+
+  /*!
+     Queues a frame for encoding. PNG frames are written to frame_filename.
+     Returns false if this or an earlier frame failed, after which no more
+     frames should be added.
+   */
+  bool addFrame(RGBAImage image, const std::string& frame_filename);
+
+  // Waits for all frames and finishes the output. Returns whether all frames were written.
+  bool finish();
+
+  static size_t maxPending();
+
+private:
+  struct EncodedFrame {
+    bool ok{false};
+    std::string data;
+  };
+
+  bool writeFrame(EncodedFrame frame);
+  bool writeApngFrame(const std::string& png);
+
+  AnimationFormat format;
+  std::ofstream file;
+  std::ostream *output{nullptr};
+  unsigned int num_frames;
+  double fps;
+  std::deque<std::future<EncodedFrame>> pending;
+  bool ok{true};
+  bool finished{false};
+
+  // APNG state
+  unsigned int frames_written{0};
+  uint32_t sequence_number{0};
+  std::string header;
+};
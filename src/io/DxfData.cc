@@ -50,6 +50,7 @@
 #include "core/Value.h"
 #include "geometry/Polygon2d.h"
 #include "io/fileutils.h"
+#include "io/ImportCache.h"
 #include "utils/printutils.h"
 #include "utils/degree_trig.h"
 
@@ -77,6 +78,40 @@ struct Line {
   Line(int i1, int i2) : idx{i1, i2} { }
 };
 
+size_t DxfData::File::memsize() const
+{
+  size_t size = sizeof(*this) + groups.capacity() * sizeof(Group);
+  for (const auto& group : groups) {
+    size += group.value.capacity();
+  }
+  return size;
+}
+
+std::shared_ptr<const DxfData::File> DxfData::readFile(const std::string& filename)
+{
+  std::ifstream stream(filename.c_str());
+  if (!stream.good()) return nullptr;
+
+  auto file = std::make_shared<File>();
+  while (!stream.eof()) {
+    std::string id_str, data;
+    std::getline(stream, id_str);
+    boost::trim(id_str);
+    std::getline(stream, data);
+    boost::trim(data);
+
+    int id;
+    if (!boost::conversion::try_lexical_convert(id_str, id)) {
+      if (!stream.eof()) file->illegal_code = id_str;
+      break;
+    }
+    double number = 0;
+    const bool is_number = boost::conversion::try_lexical_convert(data, number);
+    file->groups.push_back({id, std::move(data), number, is_number});
+  }
+  return file;
+}
+
 /*!
    Reads a layer from the given file, or all layers if layername.empty()
  */
@@ -84,10 +119,15 @@ DxfData::DxfData(double fn, double fs, double fa,
                  const std::string& filename, const std::string& layername,
                  double xorigin, double yorigin, double scale)
 {
-  std::ifstream stream(filename.c_str());
-  if (!stream.good()) {
-    LOG(message_group::Warning, "Can't open DXF file '%1$s'.", filename);
-    return;
+  auto *cache = ImportCache::instance();
+  auto file = cache->getDxfFile(filename);
+  if (!file) {
+    file = readFile(filename);
+    if (!file) {
+      LOG(message_group::Warning, "Can't open DXF file '%1$s'.", filename);
+      return;
+    }
+    cache->insertDxfFile(filename, file);
   }
 
   Grid2d<std::vector<int>> grid(GRID_COARSE);
@@ -138,40 +178,31 @@ DxfData::DxfData(double fn, double fs, double fa,
   //
   // Parse DXF file. Will populate this->points, this->dims, lines and blockdata
   //
-  while (!stream.eof()) {
-    std::string id_str, data;
-    std::getline(stream, id_str);
-    boost::trim(id_str);
-    std::getline(stream, data);
-    boost::trim(data);
-
-    int id;
-    try {
-      id = boost::lexical_cast<int>(id_str);
-    } catch (const boost::bad_lexical_cast& blc) {
-      if (!stream.eof()) {
-        LOG(message_group::Warning, "Illegal ID '%1$s' in `%2$s'", id_str, filename);
-      }
-      break;
-    }
+  for (const auto& group : file->groups) {
+    const int id = group.code;
+    const std::string& data = group.value;
+    const auto number = [&group]() {
+      if (!group.is_number) throw boost::bad_lexical_cast();
+      return group.number;
+    };
     try {
       if (id >= 10 && id <= 16) {
         if (in_blocks_section) {
-          coords[id - 10][0] = boost::lexical_cast<double>(data);
+          coords[id - 10][0] = number();
         } else if (id == 11 || id == 12 || id == 16) {
-          coords[id - 10][0] = boost::lexical_cast<double>(data) * scale;
+          coords[id - 10][0] = number() * scale;
         } else {
-          coords[id - 10][0] = (boost::lexical_cast<double>(data) - xorigin) * scale;
+          coords[id - 10][0] = (number() - xorigin) * scale;
         }
       }
 
       if (id >= 20 && id <= 26) {
         if (in_blocks_section) {
-          coords[id - 20][1] = boost::lexical_cast<double>(data);
+          coords[id - 20][1] = number();
         } else if (id == 21 || id == 22 || id == 26) {
-          coords[id - 20][1] = boost::lexical_cast<double>(data) * scale;
+          coords[id - 20][1] = number() * scale;
         } else {
-          coords[id - 20][1] = (boost::lexical_cast<double>(data) - yorigin) * scale;
+          coords[id - 20][1] = (number() - yorigin) * scale;
         }
       }
 
@@ -329,44 +360,44 @@ DxfData::DxfData(double fn, double fs, double fa,
       case 10: [[fallthrough]];
       case 11:
         if (in_blocks_section) {
-          xverts.push_back((boost::lexical_cast<double>(data)));
+          xverts.push_back((number()));
         } else {
-          xverts.push_back((boost::lexical_cast<double>(data) - xorigin) * scale);
+          xverts.push_back((number() - xorigin) * scale);
         }
         break;
       case 20: [[fallthrough]];
       case 21:
         if (in_blocks_section) {
-          yverts.push_back((boost::lexical_cast<double>(data)));
+          yverts.push_back((number()));
         } else {
-          yverts.push_back((boost::lexical_cast<double>(data) - yorigin) * scale);
+          yverts.push_back((number() - yorigin) * scale);
         }
         break;
       case 40:
         // CIRCLE, ARC: radius
         // ELLIPSE: minor to major ratio
         // DIMENSION (radial, diameter): Leader length
-        radius = boost::lexical_cast<double>(data);
+        radius = number();
         if (!in_blocks_section) radius *= scale;
         break;
       case 41:
         // ELLIPSE: start_angle
         // INSERT: X scale
-        ellipse_start_angle = boost::lexical_cast<double>(data);
+        ellipse_start_angle = number();
         break;
       case 50:
         // ARC: start_angle
         // INSERT: rot angle
         // DIMENSION: linear and rotated: angle
-        arc_start_angle = boost::lexical_cast<double>(data);
+        arc_start_angle = number();
         break;
       case 42:
         // ELLIPSE: stop_angle
         // INSERT: Y scale
-        ellipse_stop_angle = boost::lexical_cast<double>(data);
+        ellipse_stop_angle = number();
         break;
       case 51: // ARC
-        arc_stop_angle = boost::lexical_cast<double>(data);
+        arc_stop_angle = number();
         break;
       case 70:
         // LWPOLYLINE: polyline flag
@@ -380,6 +411,9 @@ DxfData::DxfData(double fn, double fs, double fa,
       LOG(message_group::Warning, "Not enough input values for %1$s. in '%2$s'", data, filename);
     }
   }
+  if (file->illegal_code) {
+    LOG(message_group::Warning, "Illegal ID '%1$s' in `%2$s'", *file->illegal_code, filename);
+  }
 
   for (const auto& i : unsupported_entities_list) {
     if (layername.empty()) {
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include "geometry/linalg.h"
@@ -31,6 +33,24 @@ public:
     }
   };
 
+  /*!
+     A DXF file as read from disk: its group codes and values, with the values
+     converted to numbers where possible. Reading stops at the first group code
+     which isn't a number.
+   */
+  struct File {
+    struct Group {
+      int code;
+      std::string value;
+      double number;
+      bool is_number;
+    };
+    std::vector<Group> groups;
+    std::optional<std::string> illegal_code;
+
+    [[nodiscard]] size_t memsize() const;
+  };
+
   VectorOfVector2d points;
   std::vector<Path> paths;
   std::vector<Dim> dims;
@@ -40,6 +60,9 @@ public:
           const std::string& filename, const std::string& layername = "",
           double xorigin = 0.0, double yorigin = 0.0, double scale = 1.0);
 
+  // Returns nullptr if the file can't be opened
+  static std::shared_ptr<const File> readFile(const std::string& filename);
+
   int addPoint(double x, double y);
 
   void fixup_path_direction();
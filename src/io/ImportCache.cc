@@ -0,0 +1,139 @@
+#include "io/ImportCache.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <ios>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "utils/printutils.h"
+
+ImportCache *ImportCache::inst = nullptr;
+
+namespace {
+
+// Identifies the current content of a file, or returns an empty key if the
+// file can't be accessed. Parts are joined with a separator which can't
+// appear in file names.
+std::string file_key(const std::string& filename)
+{
+  std::error_code ec;
+  const auto time = std::filesystem::last_write_time(filename, ec);
+  if (ec) return {};
+  const auto size = std::filesystem::file_size(filename, ec);
+  if (ec) return {};
+  return STR(filename, '\x1f', time.time_since_epoch().count(), '\x1f', size);
+}
+
+std::string paths_key(const std::string& filename, double fn, double fs, double fa)
+{
+  auto key = file_key(filename);
+  if (key.empty()) return key;
+  // Exact values, as any change in tolerance can change the flattened paths
+  std::ostringstream stream;
+  stream << std::hexfloat << '\x1f' << fn << '\x1f' << fs << '\x1f' << fa;
+  return key + stream.str();
+}
+
+size_t memsize(const libsvg::flattened_paths_t& paths)
+{
+  size_t size = sizeof(paths);
+  for (const auto& entry : paths) {
+    // Approximates the overhead of a hash map node
+    size += sizeof(entry) + 2 * sizeof(void *) + sizeof(libsvg::path_list_t);
+    for (const auto& path : *entry.second) {
+      size += sizeof(path) + path.capacity() * sizeof(Eigen::Vector3d);
+    }
+  }
+  return size;
+}
+
+} // namespace
+
+ImportCache::ImportCache(size_t memorylimit)
+  : svg_cache(memorylimit), svg_paths_cache(memorylimit), dxf_cache(memorylimit)
+{
+}
+
+std::shared_ptr<const libsvg::document> ImportCache::getSvgDocument(const std::string& filename)
+{
+  const auto key = file_key(filename);
+  auto *entry = key.empty() ? nullptr : svg_cache[key];
+  if (!entry) {
+    ++svg_stats.misses;
+    return nullptr;
+  }
+  ++svg_stats.hits;
+  return entry->value;
+}
+
+void ImportCache::insertSvgDocument(const std::string& filename, const std::shared_ptr<const libsvg::document>& document)
+{
+  const auto key = file_key(filename);
+  if (key.empty()) return;
+  svg_cache.insert(key, new cache_entry<libsvg::document>(document), key.size() + document->memsize());
+}
+
+std::shared_ptr<const libsvg::flattened_paths_t> ImportCache::getSvgPaths(const std::string& filename, double fn, double fs, double fa)
+{
+  const auto key = paths_key(filename, fn, fs, fa);
+  auto *entry = key.empty() ? nullptr : svg_paths_cache[key];
+  if (!entry) {
+    ++svg_paths_stats.misses;
+    return nullptr;
+  }
+  ++svg_paths_stats.hits;
+  return entry->value;
+}
+
+void ImportCache::insertSvgPaths(const std::string& filename, double fn, double fs, double fa, const std::shared_ptr<const libsvg::flattened_paths_t>& paths)
+{
+  const auto key = paths_key(filename, fn, fs, fa);
+  if (key.empty()) return;
+  svg_paths_cache.insert(key, new cache_entry<libsvg::flattened_paths_t>(paths), key.size() + memsize(*paths));
+}
+
+std::shared_ptr<const DxfData::File> ImportCache::getDxfFile(const std::string& filename)
+{
+  const auto key = file_key(filename);
+  auto *entry = key.empty() ? nullptr : dxf_cache[key];
+  if (!entry) {
+    ++dxf_stats.misses;
+    return nullptr;
+  }
+  ++dxf_stats.hits;
+  return entry->value;
+}
+
+void ImportCache::insertDxfFile(const std::string& filename, const std::shared_ptr<const DxfData::File>& file)
+{
+  const auto key = file_key(filename);
+  if (key.empty()) return;
+  dxf_cache.insert(key, new cache_entry<DxfData::File>(file), key.size() + file->memsize());
+}
+
+void ImportCache::clear()
+{
+  svg_cache.clear();
+  svg_paths_cache.clear();
+  dxf_cache.clear();
+  svg_stats = {};
+  svg_paths_stats = {};
+  dxf_stats = {};
+}
+
+void ImportCache::print()
+{
+  if (svg_stats.hits + svg_stats.misses > 0) {
+    LOG("SVG documents in cache: %1$d (%2$d hits, %3$d misses)", svg_cache.size(), svg_stats.hits, svg_stats.misses);
+    LOG("Flattened SVG paths in cache: %1$d (%2$d hits, %3$d misses)", svg_paths_cache.size(), svg_paths_stats.hits, svg_paths_stats.misses);
+  }
+  if (dxf_stats.hits + dxf_stats.misses > 0) {
+    LOG("DXF files in cache: %1$d (%2$d hits, %3$d misses)", dxf_cache.size(), dxf_stats.hits, dxf_stats.misses);
+  }
+  if (svg_stats.hits + svg_stats.misses + dxf_stats.hits + dxf_stats.misses > 0) {
+    LOG("Import cache size in bytes: %1$d", svg_cache.totalCost() + svg_paths_cache.totalCost() + dxf_cache.totalCost());
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "Cache.h"
+#include "io/DxfData.h"
+#include "libsvg/libsvg.h"
+
+/*!
+   Caches parsed import files, so importing the same file again, e.g. with a
+   different $fn, id or layer, doesn't need to read and parse it again:
+
+   - Parsed SVG documents.
+   - Flattened SVG paths, for each set of $fn, $fs and $fa.
+   - The group codes and values of DXF files.
+
+   Entries are keyed by file name, modification time and size, so changed
+   files are read again.
+ */
+class ImportCache
+{
+public:
+  ImportCache(size_t memorylimit = 128ul * 1024ul * 1024ul);
+
+  static ImportCache *instance() { if (!inst) inst = new ImportCache; return inst; }
+
+  std::shared_ptr<const libsvg::document> getSvgDocument(const std::string& filename);
+  void insertSvgDocument(const std::string& filename, const std::shared_ptr<const libsvg::document>& document);
+
+  std::shared_ptr<const libsvg::flattened_paths_t> getSvgPaths(const std::string& filename, double fn, double fs, double fa);
+  void insertSvgPaths(const std::string& filename, double fn, double fs, double fa, const std::shared_ptr<const libsvg::flattened_paths_t>& paths);
+
+  std::shared_ptr<const DxfData::File> getDxfFile(const std::string& filename);
+  void insertDxfFile(const std::string& filename, const std::shared_ptr<const DxfData::File>& file);
+
+  void clear();
+  void print();
+
+private:
+  static ImportCache *inst;
+
+  template <typename T>
+  struct cache_entry {
+    std::shared_ptr<const T> value;
+    cache_entry(const std::shared_ptr<const T>& value) : value(value) {}
+  };
+
+  struct Statistics {
+    size_t hits{0};
+    size_t misses{0};
+  };
+
+  Cache<std::string, cache_entry<libsvg::document>> svg_cache;
+  Cache<std::string, cache_entry<libsvg::flattened_paths_t>> svg_paths_cache;
+  Cache<std::string, cache_entry<DxfData::File>> dxf_cache;
+  Statistics svg_stats;
+  Statistics svg_paths_stats;
+  Statistics dxf_stats;
+};
@@ -0,0 +1,39 @@
+#include "io/MappedFile.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace fs = std::filesystem;
+
+MappedFile::MappedFile(const std::string& filename)
+{
+  std::error_code ec;
+  const auto file_size = fs::file_size(filename, ec);
+  if (ec) return;
+  // Empty files can't be mapped, but are valid (empty) input
+  if (file_size == 0) {
+    is_open = true;
+    return;
+  }
+  try {
+    mapping = std::make_unique<boost::interprocess::file_mapping>(filename.c_str(), boost::interprocess::read_only);
+    region = std::make_unique<boost::interprocess::mapped_region>(*mapping, boost::interprocess::read_only);
+    region->advise(boost::interprocess::mapped_region::advice_sequential);
+  } catch (const boost::interprocess::interprocess_exception&) {
+    region.reset();
+    mapping.reset();
+    return;
+  }
+  data_ = static_cast<const char *>(region->get_address());
+  size_ = region->get_size();
+  is_open = true;
+}
+
+MappedFile::~MappedFile() = default;
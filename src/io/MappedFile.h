@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace boost::interprocess {
+class file_mapping;
+class mapped_region;
+}
+
+/*!
+   Read-only memory mapping of a whole file.
+
+   Importers use this to parse large files in place, and in parallel, instead
+   of reading them through a stream. The mapping stays valid for the lifetime of
+   the object.
+ */
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string& filename);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // False if the file couldn't be opened or mapped
+  [[nodiscard]] bool isOpen() const { return is_open; }
+  [[nodiscard]] const char *data() const { return data_; }
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] const char *begin() const { return data_; }
+  [[nodiscard]] const char *end() const { return data_ + size_; }
+
+private:
+  std::unique_ptr<boost::interprocess::file_mapping> mapping;
+  std::unique_ptr<boost::interprocess::mapped_region> region;
+  bool is_open{false};
+  const char *data_{nullptr};
+  size_t size_{0};
+};
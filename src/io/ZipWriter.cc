@@ -0,0 +1,177 @@
+#include "io/ZipWriter.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <zlib.h>
+
+namespace {
+
+constexpr uint32_t LOCAL_FILE_HEADER_SIGNATURE = 0x04034b50;
+constexpr uint32_t DATA_DESCRIPTOR_SIGNATURE = 0x08074b50;
+constexpr uint32_t CENTRAL_DIRECTORY_SIGNATURE = 0x02014b50;
+constexpr uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+constexpr uint16_t ZIP_VERSION = 20;          // 2.0: deflate
+constexpr uint16_t FLAG_DATA_DESCRIPTOR = 0x0008; // crc and sizes follow the data
+constexpr uint16_t METHOD_DEFLATE = 8;
+// Entries are dated 1980-01-01 00:00, so archives only depend on their content
+constexpr uint16_t DOS_TIME = 0;
+constexpr uint16_t DOS_DATE = (1 << 5) | 1;
+// Data passed to write() is compressed in blocks of this size
+constexpr size_t WRITE_BLOCK_SIZE = 1ul << 20;
+
+void put16(std::string& out, uint16_t v)
+{
+  out += static_cast<char>(v & 0xff);
+  out += static_cast<char>(v >> 8);
+}
+
+void put32(std::string& out, uint32_t v)
+{
+  put16(out, v & 0xffff);
+  put16(out, v >> 16);
+}
+
+} // namespace
+
+void ZipWriter::beginEntry(const std::string& name)
+{
+  endEntry();
+  entries.push_back({name, 0, 0, 0, offset});
+  in_entry = true;
+
+  std::string header;
+  put32(header, LOCAL_FILE_HEADER_SIGNATURE);
+  put16(header, ZIP_VERSION);
+  put16(header, FLAG_DATA_DESCRIPTOR);
+  put16(header, METHOD_DEFLATE);
+  put16(header, DOS_TIME);
+  put16(header, DOS_DATE);
+  put32(header, 0); // crc
+  put32(header, 0); // compressed size
+  put32(header, 0); // uncompressed size
+  put16(header, name.size());
+  put16(header, 0); // extra field length
+  header += name;
+  writeBytes(header.data(), header.size());
+}
+
+void ZipWriter::write(std::string_view data)
+{
+  Block block;
+  while (!data.empty()) {
+    const auto size = std::min(data.size(), WRITE_BLOCK_SIZE);
+    block.data.assign(data.data(), size);
+    compress(block);
+    writeBlock(block);
+    data.remove_prefix(size);
+  }
+}
+
+void ZipWriter::compress(Block& block)
+{
+  block.compressed.clear();
+  block.crc = crc32(0, reinterpret_cast<const Bytef *>(block.data.data()), block.data.size());
+  if (block.data.empty()) return;
+
+  z_stream stream{};
+  // Raw deflate, without zlib header and trailer
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+  stream.next_in = reinterpret_cast<Bytef *>(block.data.data());
+  stream.avail_in = block.data.size();
+  size_t used = 0;
+  block.compressed.resize(deflateBound(&stream, block.data.size()) + 16);
+  do {
+    if (used == block.compressed.size()) block.compressed.resize(2 * used);
+    stream.next_out = reinterpret_cast<Bytef *>(&block.compressed[used]);
+    stream.avail_out = block.compressed.size() - used;
+    // Ends on a byte boundary without marking the last block, so blocks can be concatenated
+    deflate(&stream, Z_SYNC_FLUSH);
+    used = block.compressed.size() - stream.avail_out;
+  } while (stream.avail_out == 0);
+  deflateEnd(&stream);
+  block.compressed.resize(used);
+}
+
+void ZipWriter::writeBlock(const Block& block)
+{
+  if (block.data.empty()) return;
+  auto& entry = entries.back();
+  entry.crc = crc32_combine(entry.crc, block.crc, block.data.size());
+  entry.size += block.data.size();
+  entry.compressed_size += block.compressed.size();
+  writeBytes(block.compressed.data(), block.compressed.size());
+}
+
+void ZipWriter::endEntry()
+{
+  if (!in_entry) return;
+  in_entry = false;
+  auto& entry = entries.back();
+
+  // An empty final block ends the deflate stream
+  const char final_block[] = {0x03, 0x00};
+  writeBytes(final_block, sizeof(final_block));
+  entry.compressed_size += sizeof(final_block);
+  if (entry.size > MAX_SIZE || entry.compressed_size > MAX_SIZE) too_large = true;
+
+  std::string descriptor;
+  put32(descriptor, DATA_DESCRIPTOR_SIGNATURE);
+  put32(descriptor, entry.crc);
+  put32(descriptor, entry.compressed_size);
+  put32(descriptor, entry.size);
+  writeBytes(descriptor.data(), descriptor.size());
+}
+
+bool ZipWriter::finish()
+{
+  endEntry();
+
+  const uint64_t directory_offset = offset;
+  std::string directory;
+  for (const auto& entry : entries) {
+    put32(directory, CENTRAL_DIRECTORY_SIGNATURE);
+    put16(directory, ZIP_VERSION); // version made by (MS-DOS)
+    put16(directory, ZIP_VERSION); // version needed to extract
+    put16(directory, FLAG_DATA_DESCRIPTOR);
+    put16(directory, METHOD_DEFLATE);
+    put16(directory, DOS_TIME);
+    put16(directory, DOS_DATE);
+    put32(directory, entry.crc);
+    put32(directory, entry.compressed_size);
+    put32(directory, entry.size);
+    put16(directory, entry.name.size());
+    put16(directory, 0); // extra field length
+    put16(directory, 0); // comment length
+    put16(directory, 0); // disk number
+    put16(directory, 0); // internal attributes
+    put32(directory, 0); // external attributes
+    put32(directory, entry.offset);
+    directory += entry.name;
+  }
+  writeBytes(directory.data(), directory.size());
+
+  std::string end;
+  put32(end, END_OF_CENTRAL_DIRECTORY_SIGNATURE);
+  put16(end, 0); // disk number
+  put16(end, 0); // disk with the central directory
+  put16(end, entries.size());
+  put16(end, entries.size());
+  put32(end, directory.size());
+  put32(end, directory_offset);
+  put16(end, 0); // comment length
+  writeBytes(end.data(), end.size());
+
+  if (offset > MAX_SIZE || entries.size() > 0xffff) too_large = true;
+  output.flush();
+  return output.good() && !too_large;
+}
+
+void ZipWriter::writeBytes(const void *data, size_t size)
+{
+  output.write(static_cast<const char *>(data), size);
+  offset += size;
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "utils/parallel.h"
+
+/*!
+   Writes a ZIP archive of deflated entries to a stream, e.g. for 3MF files.
+
+   The output is written strictly sequentially (sizes and checksums follow each
+   entry's data), so it works on streams which can't seek, and entries can be
+   streamed without holding them in memory.
+
+   Entries are compressed in blocks, each deflated independently (and in
+   parallel by writeChunked()) and flushed to a byte boundary, so the
+   concatenated blocks form a single valid deflate stream. This costs a
+   little compression compared to deflating the entry as a whole.
+
+   ZIP64 is not supported: entries and the archive must stay below 4 GiB.
+ */
+class ZipWriter
+{
+public:
+  // Largest size of an entry or archive which can be written
+  static constexpr uint64_t MAX_SIZE = 0xffffffffu;
+
+  explicit ZipWriter(std::ostream& output) : output(output) {}
+  ZipWriter(const ZipWriter&) = delete;
+  ZipWriter& operator=(const ZipWriter&) = delete;
+
+  // Starts a new entry, finishing the current one
+  void beginEntry(const std::string& name);
+
+  // Appends data to the current entry
+  void write(std::string_view data);
+
+  /*!
+     Appends count items to the current entry, formatted by
+     format(begin, end, out) which appends items [begin, end) to out.
+
+     Like write_chunked(), items are formatted in parallel chunks of
+     chunk_size items, which are also compressed in parallel.
+   */
+  template <typename Format>
+  void writeChunked(size_t count, const Format& format, size_t chunk_size = 16384)
+  {
+    // Number of chunks formatted and compressed in parallel before writing them
+    constexpr size_t batch_chunks = 32;
+    std::vector<Block> blocks(std::min(batch_chunks, (count + chunk_size - 1) / chunk_size));
+    std::vector<size_t> chunks;
+    for (size_t batch = 0; batch < count; batch += batch_chunks * chunk_size) {
+      chunks.clear();
+      for (size_t begin = batch; begin < count && chunks.size() < batch_chunks; begin += chunk_size) {
+        chunks.push_back(begin);
+      }
+      parallelizable_for_each(chunks.begin(), chunks.end(), [&](size_t begin) {
+        auto& block = blocks[(begin - batch) / chunk_size];
+        block.data.clear();
+        format(begin, std::min(begin + chunk_size, count), block.data);
+        compress(block);
+      });
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        writeBlock(blocks[i]);
+      }
+    }
+  }
+
+  /*!
+     Finishes the current entry and writes the central directory.
+     Returns false if writing failed, or the archive became too large.
+   */
+  bool finish();
+
+private:
+  struct Block {
+    std::string data;
+    std::string compressed;
+    uint32_t crc;
+  };
+
+  struct Entry {
+    std::string name;
+    uint32_t crc;
+    uint64_t compressed_size;
+    uint64_t size;
+    uint64_t offset; // of the local file header
+  };
+
+  // Deflates and checksums block.data, thread safe
+  static void compress(Block& block);
+  void writeBlock(const Block& block);
+  void endEntry();
+  void writeBytes(const void *data, size_t size);
+
+  std::ostream& output;
+  std::vector<Entry> entries;
+  bool in_entry{false};
+  bool too_large{false};
+  uint64_t offset{0};
+};
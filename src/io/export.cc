@@ -29,11 +29,21 @@
 #include "core/ColorUtil.h"
 #include "export_enums.h"
 #include "geometry/PolySet.h"
+#include "geometry/PolySetUtils.h"
+#include "utils/parallel.h"
 #include "utils/printutils.h"
 #include "geometry/Geometry.h"
 #include "glview/RenderSettings.h"
 
+#ifdef ENABLE_CGAL
+#include "geometry/cgal/CGAL_Nef_polyhedron.h"
+#endif
+#ifdef ENABLE_MANIFOLD
+#include "geometry/manifold/ManifoldGeometry.h"
+#endif
+
 #include <algorithm>
+#include <chrono>
 #include <functional>
 #include <cassert>
 #include <map>
@@ -45,6 +55,7 @@
 #include <vector>
 #include <filesystem>
 #include <iostream>
+#include <locale>
 
 #ifdef _WIN32
 #include <io.h>
@@ -89,6 +100,7 @@ Containers &containers() {
     add_item(*containers, {FileFormat::PNG, "png", "png", "PNG"});
     add_item(*containers, {FileFormat::PDF, "pdf", "pdf", "PDF"});
     add_item(*containers, {FileFormat::POV, "pov", "pov", "POV"});
+    add_item(*containers, {FileFormat::OSGEO, "osgeo", "osgeo", "OpenSCAD geometry"});
 
     // Alias
     containers->identifierToInfo["stl"] = containers->identifierToInfo["asciistl"];  
@@ -178,6 +190,11 @@ bool is2D(FileFormat format) {
     format == FileFormat::PDF;
 }
 
+// Formats which store 2D and 3D geometry alike
+bool isAnyDimension(FileFormat format) {
+  return format == FileFormat::OSGEO;
+}
+
 }  // namespace FileFormat
 
 ExportInfo createExportInfo(const FileFormat& format, const FileFormatInfo& info, const std::string& filepath, const Camera *camera, const CmdLineExportOptions& cmdLineOptions)
@@ -202,8 +219,28 @@ ExportInfo createExportInfo(const FileFormat& format, const FileFormatInfo& info
   return exportInfo;
 }
 
+namespace {
+
+// Numbers are written with a '.' radix whatever the user's locale. This is set
+// on the stream rather than through setlocale(), which is process-wide and
+// would race with exports running at the same time.
+class ClassicLocale
+{
+public:
+  explicit ClassicLocale(std::ostream& output) : output(output), previous(output.imbue(std::locale::classic())) {}
+  ~ClassicLocale() { output.imbue(previous); }
+  ClassicLocale(const ClassicLocale&) = delete;
+  ClassicLocale& operator=(const ClassicLocale&) = delete;
+private:
+  std::ostream& output;
+  std::locale previous;
+};
+
+} // namespace
+
 void exportFile(const std::shared_ptr<const Geometry>& root_geom, std::ostream& output, const ExportInfo& exportInfo)
 {
+  const ClassicLocale classic_locale(output);
   switch (exportInfo.format) {
   case FileFormat::ASCII_STL:
     export_stl(root_geom, output, false);
@@ -238,6 +275,9 @@ void exportFile(const std::shared_ptr<const Geometry>& root_geom, std::ostream&
   case FileFormat::POV:
     export_pov(root_geom, output, exportInfo);
     break;
+  case FileFormat::OSGEO:
+    export_osgeo(root_geom, output);
+    break;
 #ifdef ENABLE_CGAL
   case FileFormat::NEFDBG:
     export_nefdbg(root_geom, output);
@@ -263,7 +303,7 @@ bool exportFileStdOut(const std::shared_ptr<const Geometry>& root_geom, const Ex
 bool exportFileByName(const std::shared_ptr<const Geometry>& root_geom, const std::string& filename, const ExportInfo& exportInfo)
 {
   std::ios::openmode mode = std::ios::out | std::ios::trunc;
-  if (exportInfo.format == FileFormat::_3MF || exportInfo.format == FileFormat::BINARY_STL || exportInfo.format == FileFormat::PDF) {
+  if (exportInfo.format == FileFormat::_3MF || exportInfo.format == FileFormat::BINARY_STL || exportInfo.format == FileFormat::PDF || exportInfo.format == FileFormat::OSGEO) {
     mode |= std::ios::binary;
   }
   const std::filesystem::path path(filename);
@@ -293,6 +333,125 @@ bool exportFileByName(const std::shared_ptr<const Geometry>& root_geom, const st
 
 namespace {
 
+// Formats written from a mesh, which can share the conversion of Nef and Manifold geometry
+bool exportsMesh(FileFormat format)
+{
+  return format == FileFormat::ASCII_STL ||
+    format == FileFormat::BINARY_STL ||
+    format == FileFormat::OBJ ||
+    format == FileFormat::OFF ||
+    format == FileFormat::WRL ||
+    format == FileFormat::_3MF ||
+    format == FileFormat::POV ||
+    format == FileFormat::OSGEO;
+}
+
+// Mesh formats which tessellate polygonal faces
+bool exportsTriangles(FileFormat format)
+{
+  return format == FileFormat::ASCII_STL ||
+    format == FileFormat::BINARY_STL ||
+    format == FileFormat::_3MF;
+}
+
+// Applies convert to the leaves of geom, keeping the structure of GeometryLists
+template <typename Convert>
+std::shared_ptr<const Geometry> convertLeaves(const std::shared_ptr<const Geometry>& geom, const Convert& convert)
+{
+  if (const auto geomlist = std::dynamic_pointer_cast<const GeometryList>(geom)) {
+    Geometry::Geometries children;
+    for (const auto& item : geomlist->getChildren()) {
+      children.emplace_back(item.first, convertLeaves(item.second, convert));
+    }
+    return std::make_shared<GeometryList>(children);
+  }
+  return convert(geom);
+}
+
+/*!
+   Converts Nef polyhedra and Manifold geometry to the PolySet each mesh
+   exporter would create for itself, printing the warnings the STL and 3MF
+   exporters give for them.
+ */
+std::shared_ptr<const Geometry> createExportMesh(const std::shared_ptr<const Geometry>& geom, bool has_stl, bool has_3mf)
+{
+  return convertLeaves(geom, [&](const std::shared_ptr<const Geometry>& leaf) -> std::shared_ptr<const Geometry> {
+    bool convert = false;
+    bool simple = true;
+#ifdef ENABLE_CGAL
+    if (const auto N = std::dynamic_pointer_cast<const CGAL_Nef_polyhedron>(leaf)) {
+      convert = true;
+      simple = !(has_stl || has_3mf) || !N->p3 || N->p3->is_simple();
+    }
+#endif
+#ifdef ENABLE_MANIFOLD
+    if (const auto mani = std::dynamic_pointer_cast<const ManifoldGeometry>(leaf)) {
+      convert = true;
+      simple = !has_stl || mani->isManifold();
+    }
+#endif
+    if (!convert) return leaf;
+    if (!simple) {
+      LOG(message_group::Export_Warning, "Exported object may not be a valid 2-manifold and may need repair");
+    }
+    return PolySetUtils::getGeometryAsPolySet(leaf);
+  });
+}
+
+// Tessellates the polygonal faces of PolySets
+std::shared_ptr<const Geometry> createExportTriangles(const std::shared_ptr<const Geometry>& geom)
+{
+  return convertLeaves(geom, [](const std::shared_ptr<const Geometry>& leaf) -> std::shared_ptr<const Geometry> {
+    const auto ps = std::dynamic_pointer_cast<const PolySet>(leaf);
+    if (ps && !ps->isTriangular()) return PolySetUtils::tessellate_faces(*ps);
+    return leaf;
+  });
+}
+
+} // namespace
+
+std::vector<ExportResult> exportFiles(const std::shared_ptr<const Geometry>& root_geom, const std::vector<ExportTarget>& targets)
+{
+  const auto count_targets = [&targets](const auto& predicate) {
+    return std::count_if(targets.begin(), targets.end(), [&predicate](const ExportTarget& target) {
+      return predicate(target.exportInfo.format);
+    });
+  };
+  const bool has_stl = count_targets([](FileFormat f) { return f == FileFormat::ASCII_STL || f == FileFormat::BINARY_STL; }) > 0;
+  const bool has_3mf = count_targets([](FileFormat f) { return f == FileFormat::_3MF; }) > 0;
+
+  // Only worth it when several exporters would do the same conversion
+  auto mesh = root_geom;
+  if (count_targets(exportsMesh) > 1) mesh = createExportMesh(root_geom, has_stl, has_3mf);
+  auto triangles = mesh;
+  if (count_targets(exportsTriangles) > 1) triangles = createExportTriangles(mesh);
+
+  std::vector<ExportResult> results(targets.size());
+  const auto run = [&](size_t i) {
+    const auto& target = targets[i];
+    const auto format = target.exportInfo.format;
+    const auto& geom = exportsTriangles(format) ? triangles : exportsMesh(format) ? mesh : root_geom;
+    const auto start = std::chrono::steady_clock::now();
+    const bool success = target.is_stdout ?
+                         exportFileStdOut(geom, target.exportInfo) :
+                         exportFileByName(geom, target.filename, target.exportInfo);
+    results[i] = {success, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)};
+  };
+
+  // Standard output is written last, on this thread
+  std::vector<size_t> files;
+  for (size_t i = 0; i < targets.size(); ++i) {
+    if (!targets[i].is_stdout) files.push_back(i);
+  }
+  parallelizable_for_each(files.begin(), files.end(), run);
+  for (size_t i = 0; i < targets.size(); ++i) {
+    if (targets[i].is_stdout) run(i);
+  }
+  return results;
+}
+
+namespace {
+
 double remove_negative_zero(double x) {
   return x == -0 ? 0 : x;
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <functional>
 #include <iterator>
 #include <map>
 #include <iostream>
@@ -43,7 +45,8 @@ enum class FileFormat {
   PNG,
   PDF,
   POV,
-  PARAM
+  PARAM,
+  OSGEO
 };
 
 struct FileFormatInfo {
@@ -67,6 +70,7 @@ const std::string& toSuffix(FileFormat format);
 bool canPreview(FileFormat format);
 bool is3D(FileFormat format);
 bool is2D(FileFormat format);
+bool isAnyDimension(FileFormat format);
 
 }  // namespace FileFormat
 
@@ -196,9 +200,30 @@ ExportInfo createExportInfo(const FileFormat& format, const FileFormatInfo& info
 bool exportFileByName(const std::shared_ptr<const class Geometry>& root_geom, const std::string& filename, const ExportInfo& exportInfo);
 bool exportFileStdOut(const std::shared_ptr<const class Geometry>& root_geom, const ExportInfo& exportInfo);
 
+// One of the files written by exportFiles()
+struct ExportTarget {
+  ExportInfo exportInfo;
+  std::string filename;
+  bool is_stdout;
+};
+
+struct ExportResult {
+  bool success;
+  std::chrono::milliseconds time;
+};
+
+/*!
+   Exports the same geometry to several files concurrently.
+   Conversions needed by several of the exporters (Nef polyhedra to meshes,
+   tessellation of polygonal faces) are done once up front and shared.
+   Returns the result of each export, in the order of targets.
+ */
+std::vector<ExportResult> exportFiles(const std::shared_ptr<const class Geometry>& root_geom, const std::vector<ExportTarget>& targets);
+
 void export_stl(const std::shared_ptr<const Geometry>& geom, std::ostream& output,
                 bool binary = true);
 void export_3mf(const std::shared_ptr<const Geometry>& geom, std::ostream& output, const ExportInfo& exportInfo);
+bool export_3mf_streaming(const std::shared_ptr<const Geometry>& geom, std::ostream& output, const ExportInfo& exportInfo);
 void export_obj(const std::shared_ptr<const Geometry>& geom, std::ostream& output);
 void export_off(const std::shared_ptr<const Geometry>& geom, std::ostream& output);
 void export_wrl(const std::shared_ptr<const Geometry>& geom, std::ostream& output);
@@ -209,6 +234,7 @@ void export_pov(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
 void export_pdf(const std::shared_ptr<const Geometry>& geom, std::ostream& output, const ExportInfo& exportInfo);
 void export_nefdbg(const std::shared_ptr<const Geometry>& geom, std::ostream& output);
 void export_nef3(const std::shared_ptr<const Geometry>& geom, std::ostream& output);
+void export_osgeo(const std::shared_ptr<const Geometry>& geom, std::ostream& output);
 
 
 enum class Previewer { OPENCSG, THROWNTOGETHER };
@@ -250,9 +276,22 @@ class OffscreenView;
 
 std::string get_current_iso8601_date_time_utc();
 
-std::unique_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& options, Camera& camera);
+std::shared_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& options, Camera& camera);
 bool export_png(const std::shared_ptr<const class Geometry>& root_geom, const ViewOptions& options, Camera& camera, std::ostream& output);
 bool export_png(const OffscreenView& glview, std::ostream& output);
+// Like export_png(), but returns the image without encoding it
+bool render_image(const std::shared_ptr<const class Geometry>& root_geom, const ViewOptions& options, Camera& camera, struct RGBAImage& image);
+bool render_image(const OffscreenView& glview, struct RGBAImage& image);
+// Sets up a view of the rendered geometry like render_image(), without painting it
+std::shared_ptr<OffscreenView> prepare_render(const std::shared_ptr<const class Geometry>& root_geom, const ViewOptions& options, Camera& camera);
+/*!
+   Paints glview from each of the cameras in turn, reusing its renderer, and
+   passes the images to image_ready() until it returns false. The cameras
+   must have the size of the view.
+ */
+bool render_views(OffscreenView& glview, std::vector<Camera>& cameras, const std::function<bool(size_t, struct RGBAImage)>& image_ready);
+// Keeps the offscreen view between PNG exports, so its OpenGL context, shaders and framebuffer are reused
+void keep_offscreen_view(bool keep);
 bool export_param(SourceFile *root, const fs::path& path, std::ostream& output);
 
 std::unique_ptr<PolySet> createSortedPolySet(const PolySet& ps);
@@ -0,0 +1,459 @@
+#include "Feature.h"
+#include "io/export.h"
+#include "io/formatutils.h"
+#include "io/ZipWriter.h"
+#include "export_enums.h"
+#include "geometry/Geometry.h"
+#include "geometry/PolySet.h"
+#include "geometry/PolySetUtils.h"
+#include "core/ColorUtil.h"
+#include "utils/printutils.h"
+#ifdef ENABLE_CGAL
+#include "geometry/cgal/cgalutils.h"
+#include "geometry/cgal/CGAL_Nef_polyhedron.h"
+#endif
+#ifdef ENABLE_MANIFOLD
+#include "geometry/manifold/ManifoldGeometry.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <locale>
+#include <memory>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr auto MODEL_PATH = "3D/3dmodel.model";
+
+constexpr auto CONTENT_TYPES =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+  "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+  "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+  "<Default Extension=\"model\" ContentType=\"application/vnd.ms-package.3dmanufacturing-3dmodel+xml\"/>"
+  "</Types>";
+
+constexpr auto RELATIONSHIPS =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+  "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+  "<Relationship Type=\"http://schemas.microsoft.com/3dmanufacturing/2013/01/3dmodel\" Target=\"/3D/3dmodel.model\" Id=\"rel0\"/>"
+  "</Relationships>";
+
+// A mesh object and its build item
+struct Part {
+  std::shared_ptr<const PolySet> ps; // triangulated
+  std::string name;
+  std::string partnumber;
+  std::vector<int32_t> color_map; // PolySet color index -> property index, or -1
+};
+
+struct StreamContext {
+  std::vector<Part> parts;
+  int modelcount;
+};
+
+void export_3mf_error(std::string msg)
+{
+  LOG(message_group::Export_Error, std::move(msg));
+}
+
+uint8_t get_color_channel(const Color4f& col, int idx)
+{
+  return std::clamp(static_cast<int>(255.0 * col[idx]), 0, 255);
+}
+
+void append_escaped(std::string& out, const std::string& s)
+{
+  for (const char c : s) {
+    switch (c) {
+    case '&': out += "&amp;"; break;
+    case '<': out += "&lt;"; break;
+    case '>': out += "&gt;"; break;
+    case '"': out += "&quot;"; break;
+    case '\'': out += "&apos;"; break;
+    default: out += c;
+    }
+  }
+}
+
+void append_color(std::string& out, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+{
+  char buffer[16];
+  snprintf(buffer, sizeof(buffer), "#%02X%02X%02X%02X", r, g, b, a);
+  out += buffer;
+}
+
+std::string make_uuid()
+{
+  // Several files may be exported concurrently
+  thread_local std::mt19937_64 rng{std::random_device{}()};
+  const uint64_t a = (rng() & ~uint64_t(0xf000)) | 0x4000; // version 4
+  const uint64_t b = (rng() & ~(uint64_t(0xc) << 60)) | (uint64_t(0x8) << 60); // RFC 4122 variant
+  char buffer[40];
+  snprintf(buffer, sizeof(buffer), "%08x-%04x-%04x-%04x-%012llx",
+           static_cast<unsigned>(a >> 32), static_cast<unsigned>((a >> 16) & 0xffff), static_cast<unsigned>(a & 0xffff),
+           static_cast<unsigned>(b >> 48), static_cast<unsigned long long>(b & 0xffffffffffffull));
+  return buffer;
+}
+
+/*!
+   Appends a coordinate like lib3mf does: with a fixed number of decimals,
+   except for values which round to zero.
+ */
+void append_coordinate(std::string& out, float v, int precision, int64_t factor)
+{
+  const double scaled = std::round(static_cast<double>(v) * factor);
+  if (scaled == 0) {
+    out += '0';
+  } else if (std::fabs(scaled) < 9e18) {
+    auto n = static_cast<int64_t>(scaled);
+    if (n < 0) {
+      out += '-';
+      n = -n;
+    }
+    append_int(out, n / factor);
+    if (precision > 0) {
+      out += '.';
+      const auto decimals = std::to_string(n % factor);
+      out.append(precision - decimals.size(), '0');
+      out += decimals;
+    }
+  } else {
+    // Not snprintf(), which would use the radix of the user's locale
+    std::ostringstream oss;
+    oss.imbue(std::locale::classic());
+    oss << std::fixed << std::setprecision(precision) << static_cast<double>(v);
+    out += oss.str();
+  }
+}
+
+size_t count_digits(double v)
+{
+  size_t digits = 1;
+  for (; v >= 10; v /= 10) ++digits;
+  return digits;
+}
+
+/*!
+   Upper bound of the size of a part's mesh XML, used to fall back to lib3mf
+   (which writes ZIP64 archives) if the model may not fit into a plain ZIP.
+ */
+uint64_t estimate_xml_size(const Part& part, int precision)
+{
+  double max_coordinate = 0;
+  for (const auto& v : part.ps->vertices) {
+    max_coordinate = std::max({max_coordinate, std::fabs(v[0]), std::fabs(v[1]), std::fabs(v[2])});
+  }
+  // Sign, integer digits, decimal point and decimals of each coordinate
+  const uint64_t coordinate_size = 2 + count_digits(max_coordinate + 1) + precision;
+  const uint64_t index_size = count_digits(part.ps->vertices.size());
+  const uint64_t vertex_size = 48 + 3 * coordinate_size;
+  const uint64_t triangle_size = 64 + 3 * index_size + 2 * 10;
+  return 4096 + vertex_size * part.ps->vertices.size() + triangle_size * part.ps->indices.size();
+}
+
+bool collect_polyset(const std::shared_ptr<const PolySet>& ps, StreamContext& ctx)
+{
+  const int mesh_count = ctx.parts.size() + 1;
+  Part part;
+  part.ps = ps;
+  if (Feature::ExperimentalPredictibleOutput.is_enabled()) {
+    part.ps = createSortedPolySet(*ps);
+  }
+  part.name = ctx.modelcount == 1 ? "OpenSCAD Model" : "OpenSCAD Model " + std::to_string(mesh_count);
+  part.partnumber = ctx.modelcount == 1 ? "" : "Part " + std::to_string(mesh_count);
+  ctx.parts.push_back(std::move(part));
+  return true;
+}
+
+#ifdef ENABLE_CGAL
+bool collect_nef(const CGAL_Nef_polyhedron& root_N, StreamContext& ctx)
+{
+  if (!root_N.p3) {
+    LOG(message_group::Export_Error, "Export failed, empty geometry.");
+    return false;
+  }
+
+  if (!root_N.p3->is_simple()) {
+    LOG(message_group::Export_Warning, "Exported object may not be a valid 2-manifold and may need repair");
+  }
+
+  if (std::shared_ptr<PolySet> ps = CGALUtils::createPolySetFromNefPolyhedron3(*root_N.p3)) {
+    return collect_polyset(ps, ctx);
+  }
+  export_3mf_error("Error converting NEF Polyhedron.");
+  return false;
+}
+#endif
+
+// Collects the parts to export, like append_3mf() of the lib3mf exporter
+bool collect_3mf(const std::shared_ptr<const Geometry>& geom, StreamContext& ctx)
+{
+  if (const auto geomlist = std::dynamic_pointer_cast<const GeometryList>(geom)) {
+    ctx.modelcount = geomlist->getChildren().size();
+    for (const auto& item : geomlist->getChildren()) {
+      if (!collect_3mf(item.second, ctx)) return false;
+    }
+#ifdef ENABLE_CGAL
+  } else if (const auto N = std::dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
+    return collect_nef(*N, ctx);
+#endif
+#ifdef ENABLE_MANIFOLD
+  } else if (const auto mani = std::dynamic_pointer_cast<const ManifoldGeometry>(geom)) {
+    // Face colors are resolved by toPolySet()
+    return collect_polyset(mani->toPolySet(), ctx);
+#endif
+  } else if (const auto ps = std::dynamic_pointer_cast<const PolySet>(geom)) {
+    return collect_polyset(ps->isTriangular() ? ps : std::shared_ptr<const PolySet>(PolySetUtils::tessellate_faces(*ps)), ctx);
+  } else if (std::dynamic_pointer_cast<const Polygon2d>(geom)) {
+    assert(false && "Unsupported file format");
+  } else {
+    assert(false && "Not implemented");
+  }
+
+  return true;
+}
+
+void write_mesh(ZipWriter& zip, const Part& part, int precision, uint32_t property_id)
+{
+  const auto& ps = *part.ps;
+  int64_t factor = 1;
+  for (int i = 0; i < precision; ++i) factor *= 10;
+
+  zip.write("\t\t\t<mesh>\n\t\t\t\t<vertices>\n");
+  zip.writeChunked(ps.vertices.size(), [&](size_t begin, size_t end, std::string& out) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto v = ps.vertices[i].cast<float>();
+      out += "\t\t\t\t\t<vertex x=\"";
+      append_coordinate(out, v[0], precision, factor);
+      out += "\" y=\"";
+      append_coordinate(out, v[1], precision, factor);
+      out += "\" z=\"";
+      append_coordinate(out, v[2], precision, factor);
+      out += "\"/>\n";
+    }
+  });
+  zip.write("\t\t\t\t</vertices>\n\t\t\t\t<triangles>\n");
+  zip.writeChunked(ps.indices.size(), [&](size_t begin, size_t end, std::string& out) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto& t = ps.indices[i];
+      out += "\t\t\t\t\t<triangle v1=\"";
+      append_int(out, t[0]);
+      out += "\" v2=\"";
+      append_int(out, t[1]);
+      out += "\" v3=\"";
+      append_int(out, t[2]);
+      out += '"';
+      const int color_index = i < ps.color_indices.size() ? ps.color_indices[i] : -1;
+      if (color_index >= 0 && color_index < part.color_map.size() && part.color_map[color_index] >= 0) {
+        out += " pid=\"";
+        append_int(out, property_id);
+        out += "\" p1=\"";
+        append_int(out, part.color_map[color_index]);
+        out += '"';
+      }
+      out += "/>\n";
+    }
+  });
+  zip.write("\t\t\t\t</triangles>\n\t\t\t</mesh>\n");
+}
+
+} // namespace
+
+/*!
+   Writes a 3MF file without building a lib3mf model: the mesh XML is
+   formatted directly from the exported PolySets, and formatted and
+   compressed in parallel chunks while streaming it to the output.
+
+   The output matches the lib3mf v2 exporter. Returns false, without writing
+   anything, if the model is too large for a plain (non ZIP64) archive, in
+   which case the caller should fall back to lib3mf.
+ */
+bool export_3mf_streaming(const std::shared_ptr<const Geometry>& geom, std::ostream& output, const ExportInfo& exportInfo)
+{
+  const auto& options3mf = exportInfo.options3mf ? exportInfo.options3mf : std::make_shared<Export3mfOptions>();
+  // Same range and default as lib3mf's decimal precision
+  const int precision = options3mf->decimalPrecision >= 1 && options3mf->decimalPrecision <= 16 ? options3mf->decimalPrecision : 6;
+
+  StreamContext ctx{
+    .parts = {},
+    .modelcount = 1
+  };
+  if (!collect_3mf(geom, ctx)) {
+    // Errors have been logged, like the lib3mf exporter does
+    return true;
+  }
+
+  uint64_t estimated_size = 0;
+  for (const auto& part : ctx.parts) estimated_size += estimate_xml_size(part, precision);
+  if (estimated_size >= ZipWriter::MAX_SIZE) {
+    PRINTDB("3MF model may exceed %d bytes, falling back to lib3mf", ZipWriter::MAX_SIZE);
+    return false;
+  }
+
+  const auto settingsColor = OpenSCAD::parse_hex_color(options3mf->color);
+
+  // Property resource: the default color, followed by the face colors in order of first use
+  const bool use_properties = options3mf->colorMode != Export3mfColorMode::none &&
+                              (options3mf->materialType == Export3mfMaterialType::basematerial ||
+                               options3mf->materialType == Export3mfMaterialType::color);
+  std::vector<Color4f> property_colors;
+  if (use_properties) {
+    Color4f color;
+    if (options3mf->colorMode == Export3mfColorMode::model) {
+      // use default color that ultimately should come from the color scheme
+      color = exportInfo.defaultColor;
+    } else {
+      // use color selected in the export dialog and stored in settings (if valid)
+      if (!settingsColor) {
+        LOG(message_group::Warning, "Default color in settings is invalid ('%1$s'), using default from model.", options3mf->color);
+      }
+      color = settingsColor.value_or(exportInfo.defaultColor);
+    }
+    property_colors.push_back(color);
+  }
+  if (use_properties && options3mf->colorMode != Export3mfColorMode::selected_only) {
+    std::unordered_map<Color4f, int32_t> color_indices;
+    for (auto& part : ctx.parts) {
+      const auto& ps = *part.ps;
+      part.color_map.assign(ps.colors.size(), -1);
+      for (size_t i = 0; i < ps.indices.size() && i < ps.color_indices.size(); ++i) {
+        const auto color_index = ps.color_indices[i];
+        if (color_index < 0 || color_index >= ps.colors.size() || part.color_map[color_index] >= 0) continue;
+        const auto& col = ps.colors[color_index];
+        const auto [it, inserted] = color_indices.emplace(col, property_colors.size());
+        if (inserted) property_colors.push_back(col);
+        part.color_map[color_index] = it->second;
+      }
+    }
+  }
+  const uint32_t property_id = 1;
+  const uint32_t first_object_id = use_properties ? 2 : 1;
+
+  ZipWriter zip(output);
+  zip.beginEntry("[Content_Types].xml");
+  zip.write(CONTENT_TYPES);
+  zip.beginEntry("_rels/.rels");
+  zip.write(RELATIONSHIPS);
+  zip.beginEntry(MODEL_PATH);
+
+  std::string xml;
+  xml += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+  // Same namespaces as written by lib3mf
+  xml += "<model xmlns=\"http://schemas.microsoft.com/3dmanufacturing/core/2015/02\" unit=\"";
+  switch (options3mf->unit) {
+  case Export3mfUnit::micron:     xml += "micron"; break;
+  case Export3mfUnit::centimeter: xml += "centimeter"; break;
+  case Export3mfUnit::meter:      xml += "meter"; break;
+  case Export3mfUnit::inch:       xml += "inch"; break;
+  case Export3mfUnit::foot:       xml += "foot"; break;
+  default:                        xml += "millimeter"; break;
+  }
+  xml += "\" xml:lang=\"en-US\""
+         " xmlns:m=\"http://schemas.microsoft.com/3dmanufacturing/material/2015/02\""
+         " xmlns:p=\"http://schemas.microsoft.com/3dmanufacturing/production/2015/06\""
+         " xmlns:b=\"http://schemas.microsoft.com/3dmanufacturing/beamlattice/2017/02\""
+         " xmlns:s=\"http://schemas.microsoft.com/3dmanufacturing/slice/2015/07\">\n";
+
+  if (options3mf->addMetaData) {
+    auto add_meta_data = [&xml](const std::string& name, const std::string& value, const std::string& value2 = "") {
+      const std::string& v = value.empty() ? value2 : value;
+      if (v.empty()) return;
+      xml += "\t<metadata name=\"";
+      xml += name;
+      xml += "\" preserve=\"1\" type=\"xs:string\">";
+      append_escaped(xml, v);
+      xml += "</metadata>\n";
+    };
+    add_meta_data("Title", options3mf->metaDataTitle, exportInfo.title);
+    add_meta_data("Application", EXPORT_CREATOR);
+    add_meta_data("CreationDate", get_current_iso8601_date_time_utc());
+    add_meta_data("Designer", options3mf->metaDataDesigner);
+    add_meta_data("Description", options3mf->metaDataDescription);
+    add_meta_data("Copyright", options3mf->metaDataCopyright);
+    add_meta_data("LicenseTerms", options3mf->metaDataLicenseTerms);
+    add_meta_data("Rating", options3mf->metaDataRating);
+  }
+
+  xml += "\t<resources>\n";
+  if (use_properties && options3mf->materialType == Export3mfMaterialType::basematerial) {
+    xml += "\t\t<basematerials id=\"1\">\n";
+    for (size_t i = 0; i < property_colors.size(); ++i) {
+      const auto& col = property_colors[i];
+      xml += "\t\t\t<base name=\"";
+      xml += i == 0 ? "Default" : "Color " + std::to_string(i);
+      xml += "\" displaycolor=\"";
+      // The default material is opaque
+      append_color(xml, get_color_channel(col, 0), get_color_channel(col, 1), get_color_channel(col, 2),
+                   i == 0 ? 0xff : get_color_channel(col, 3));
+      xml += "\"/>\n";
+    }
+    xml += "\t\t</basematerials>\n";
+  } else if (use_properties) {
+    xml += "\t\t<m:colorgroup id=\"1\">\n";
+    for (const auto& col : property_colors) {
+      xml += "\t\t\t<m:color color=\"";
+      append_color(xml, get_color_channel(col, 0), get_color_channel(col, 1), get_color_channel(col, 2),
+                   get_color_channel(col, 3));
+      xml += "\"/>\n";
+    }
+    xml += "\t\t</m:colorgroup>\n";
+  }
+
+  for (size_t i = 0; i < ctx.parts.size(); ++i) {
+    const auto& part = ctx.parts[i];
+    xml += "\t\t<object id=\"";
+    append_int(xml, first_object_id + i);
+    xml += "\" name=\"";
+    append_escaped(xml, part.name);
+    xml += "\" type=\"model\" p:UUID=\"";
+    xml += make_uuid();
+    xml += '"';
+    if (use_properties) {
+      xml += " pid=\"";
+      append_int(xml, property_id);
+      xml += "\" pindex=\"0\"";
+    }
+    xml += ">\n";
+    zip.write(xml);
+    xml.clear();
+
+    write_mesh(zip, part, precision, property_id);
+    xml += "\t\t</object>\n";
+  }
+  xml += "\t</resources>\n";
+
+  xml += "\t<build p:UUID=\"";
+  xml += make_uuid();
+  xml += "\">\n";
+  for (size_t i = 0; i < ctx.parts.size(); ++i) {
+    xml += "\t\t<item objectid=\"";
+    append_int(xml, first_object_id + i);
+    xml += '"';
+    if (!ctx.parts[i].partnumber.empty()) {
+      xml += " partnumber=\"";
+      append_escaped(xml, ctx.parts[i].partnumber);
+      xml += '"';
+    }
+    xml += " p:UUID=\"";
+    xml += make_uuid();
+    xml += "\"/>\n";
+  }
+  xml += "\t</build>\n</model>\n";
+  zip.write(xml);
+
+  if (!zip.finish()) {
+    export_3mf_error("Error writing 3MF model.");
+  }
+  return true;
+}
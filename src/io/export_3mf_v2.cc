@@ -294,6 +294,9 @@ void add_meta_data(Lib3MF::PMetaDataGroup& metadatagroup, const std::string& nam
  */
 void export_3mf(const std::shared_ptr<const Geometry>& geom, std::ostream& output, const ExportInfo& exportInfo)
 {
+  // lib3mf is only needed for models too large for the streaming writer
+  if (export_3mf_streaming(geom, output, exportInfo)) return;
+
   Lib3MF_uint32 interfaceVersionMajor, interfaceVersionMinor, interfaceVersionMicro;
   Lib3MF::PWrapper wrapper;
 
@@ -25,6 +25,7 @@
  */
 
 #include "io/export.h"
+#include "io/formatutils.h"
 
 #include "geometry/Geometry.h"
 
@@ -42,6 +43,8 @@
 #include <memory>
 #include <cstddef>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #define QUOTE(x__) # x__
@@ -49,9 +52,6 @@
 
 struct vertex_str {
   std::string x, y, z;
-  bool operator==(const vertex_str& rhs) {
-    return x == rhs.x && y == rhs.y && z == rhs.z;
-  }
 };
 using vertex_vec = std::vector<vertex_str>;
 
@@ -70,18 +70,20 @@ struct triangle {
 static int objectid;
 
 #ifdef ENABLE_CGAL
-static size_t add_vertex(std::vector<vertex_str>& vertices, const Point& p) {
-  double x = CGAL::to_double(p.x());
-  double y = CGAL::to_double(p.y());
-  double z = CGAL::to_double(p.z());
-  vertex_str vs{STR(x), STR(y), STR(z)};
-  auto vi = std::find(vertices.begin(), vertices.end(), vs);
-  if (vi == vertices.end()) {
-    vertices.push_back(vs);
-    return vertices.size() - 1;
-  } else {
-    return std::distance(vertices.begin(), vi);
+/*!
+   Adds the vertex if there's no vertex with the same formatted coordinates
+   yet, and returns its index.
+ */
+static size_t add_vertex(vertex_vec& vertices, std::unordered_map<std::string, size_t>& vertex_indices, const Point& p) {
+  vertex_str vs;
+  append_double_default(vs.x, CGAL::to_double(p.x()));
+  append_double_default(vs.y, CGAL::to_double(p.y()));
+  append_double_default(vs.z, CGAL::to_double(p.z()));
+  const auto [it, inserted] = vertex_indices.emplace(vs.x + ' ' + vs.y + ' ' + vs.z, vertices.size());
+  if (inserted) {
+    vertices.push_back(std::move(vs));
   }
+  return it->second;
 }
 
 /*!
@@ -99,6 +101,7 @@ static void append_amf(const CGAL_Nef_polyhedron& root_N, std::ostream& output)
     CGALUtils::convertNefToPolyhedron(*root_N.p3, P);
 
     vertex_vec vertices;
+    std::unordered_map<std::string, size_t> vertex_indices;
     std::vector<triangle> triangles;
 
     for (FCI fi = P.facets_begin(); fi != P.facets_end(); ++fi) {
@@ -110,9 +113,9 @@ static void append_amf(const CGAL_Nef_polyhedron& root_N, std::ostream& output)
       do {
         v2 = v3;
         v3 = *VCI((hc++)->vertex());
-        auto vi1 = add_vertex(vertices, v1.point());
-        auto vi2 = add_vertex(vertices, v2.point());
-        auto vi3 = add_vertex(vertices, v3.point());
+        auto vi1 = add_vertex(vertices, vertex_indices, v1.point());
+        auto vi2 = add_vertex(vertices, vertex_indices, v2.point());
+        auto vi3 = add_vertex(vertices, vertex_indices, v3.point());
         if (vi1 != vi2 && vi1 != vi3 && vi2 != vi3) {
           // The above condition ensures that there are 3 distinct vertices, but
           // they may be collinear. If they are, the unit normal is meaningless
@@ -127,22 +130,34 @@ static void append_amf(const CGAL_Nef_polyhedron& root_N, std::ostream& output)
     output << " <object id=\"" << objectid++ << "\">\r\n"
            << "  <mesh>\r\n";
     output << "   <vertices>\r\n";
-    for (const auto& s : vertices) {
-      output << "    <vertex><coordinates>\r\n";
-      output << "     <x>" << s.x << "</x>\r\n";
-      output << "     <y>" << s.y << "</y>\r\n";
-      output << "     <z>" << s.z << "</z>\r\n";
-      output << "    </coordinates></vertex>\r\n";
-    }
+    write_chunked(output, vertices.size(), [&](size_t begin, size_t end, std::string& buffer) {
+      for (size_t i = begin; i < end; ++i) {
+        const auto& s = vertices[i];
+        buffer += "    <vertex><coordinates>\r\n";
+        buffer += "     <x>" + s.x + "</x>\r\n";
+        buffer += "     <y>" + s.y + "</y>\r\n";
+        buffer += "     <z>" + s.z + "</z>\r\n";
+        buffer += "    </coordinates></vertex>\r\n";
+      }
+    });
     output << "   </vertices>\r\n";
     output << "   <volume>\r\n";
-    for (auto t : triangles) {
-      output << "    <triangle>\r\n";
-      output << "     <v1>" << t.vi1 << "</v1>\r\n";
-      output << "     <v2>" << t.vi2 << "</v2>\r\n";
-      output << "     <v3>" << t.vi3 << "</v3>\r\n";
-      output << "    </triangle>\r\n";
-    }
+    write_chunked(output, triangles.size(), [&](size_t begin, size_t end, std::string& buffer) {
+      for (size_t i = begin; i < end; ++i) {
+        const auto& t = triangles[i];
+        buffer += "    <triangle>\r\n";
+        buffer += "     <v1>";
+        append_int(buffer, t.vi1);
+        buffer += "</v1>\r\n";
+        buffer += "     <v2>";
+        append_int(buffer, t.vi2);
+        buffer += "</v2>\r\n";
+        buffer += "     <v3>";
+        append_int(buffer, t.vi3);
+        buffer += "</v3>\r\n";
+        buffer += "    </triangle>\r\n";
+      }
+    });
     output << "   </volume>\r\n";
     output << "  </mesh>\r\n"
            << " </object>\r\n";
@@ -173,7 +188,6 @@ static void append_amf(const std::shared_ptr<const Geometry>& geom, std::ostream
 void export_amf(const std::shared_ptr<const Geometry>& geom, std::ostream& output)
 {
   LOG(message_group::Deprecated, "AMF export is deprecated. Please use 3MF instead.");
-  setlocale(LC_NUMERIC, "C"); // Ensure radix is . (not ,) in output
 
   output << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
          << "<amf unit=\"millimeter\">\r\n"
@@ -187,5 +201,4 @@ void export_amf(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
   append_amf(geom, output);
 
   output << "</amf>\r\n";
-  setlocale(LC_NUMERIC, ""); // Set default locale
 }
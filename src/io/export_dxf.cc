@@ -158,7 +158,6 @@ void export_dxf_header(std::ostream& output, double xMin, double yMin, double xM
 
 void export_dxf(const Polygon2d& poly, std::ostream& output)
 {
-  setlocale(LC_NUMERIC, "C"); // Ensure radix is . (not ,) in output
 
   // find limits
   double xMin, yMin, xMax, yMax;
@@ -234,7 +233,6 @@ void export_dxf(const Polygon2d& poly, std::ostream& output)
   output << "  0\n" << "ENDSEC\n";
   output << "  0\n" << "EOF\n";
 
-  setlocale(LC_NUMERIC, ""); // set default locale
 }
 
 void export_dxf(const std::shared_ptr<const Geometry>& geom, std::ostream& output)
@@ -27,7 +27,10 @@
 
 #include <ostream>
 #include <memory>
+#include <cstddef>
+#include <string>
 #include "io/export.h"
+#include "io/formatutils.h"
 
 #include "geometry/PolySetUtils.h"
 #include "geometry/PolySet.h"
@@ -43,15 +46,29 @@ void export_obj(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
 
   output << "# OpenSCAD obj exporter\n";
 
-  for (const auto &v : out->vertices) {
-    output << "v " <<v[0] << " " << v[1] << " " << v[2] << "\n";
-  }
+  const auto& vertices = out->vertices;
+  write_chunked(output, vertices.size(), [&](size_t begin, size_t end, std::string& buffer) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto& v = vertices[i];
+      buffer += "v ";
+      append_double_default(buffer, v[0]);
+      buffer += ' ';
+      append_double_default(buffer, v[1]);
+      buffer += ' ';
+      append_double_default(buffer, v[2]);
+      buffer += '\n';
+    }
+  });
 
-  for (const auto& poly : out->indices) {
-    output << "f ";
-    for (const auto idx : poly) {
-      output << " " << idx + 1;
+  const auto& indices = out->indices;
+  write_chunked(output, indices.size(), [&](size_t begin, size_t end, std::string& buffer) {
+    for (size_t i = begin; i < end; ++i) {
+      buffer += "f ";
+      for (const auto idx : indices[i]) {
+        buffer += ' ';
+        append_int(buffer, idx + 1);
+      }
+      buffer += '\n';
     }
-    output << "\n";
-  }
+  });
 }
@@ -26,6 +26,7 @@
  */
 
 #include "io/export.h"
+#include "io/formatutils.h"
 #include "geometry/linalg.h"
 #include "Feature.h"
 #include "geometry/Reindexer.h"
@@ -36,6 +37,7 @@
 #include <memory>
 #include <cstddef>
 #include <cstdint>
+#include <string>
 
 uint8_t clamp_color_channel(float value)
 {
@@ -55,29 +57,47 @@ void export_off(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
 
 
   output << "OFF " << numverts << " " << ps->indices.size() << " 0\n";
-  for (size_t i = 0; i < numverts; ++i) {
-    output << v[i][0] << " " << v[i][1] << " " << v[i][2] << " " << "\n";
-  }
+  write_chunked(output, numverts, [&](size_t begin, size_t end, std::string& buffer) {
+    for (size_t i = begin; i < end; ++i) {
+      append_double_default(buffer, v[i][0]);
+      buffer += ' ';
+      append_double_default(buffer, v[i][1]);
+      buffer += ' ';
+      append_double_default(buffer, v[i][2]);
+      buffer += " \n";
+    }
+  });
 
   auto has_color = !ps->color_indices.empty();
-  
-  for (size_t i = 0; i < ps->indices.size(); ++i) {
-    int nverts = ps->indices[i].size();
-    output << nverts;
-    for (size_t n = 0; n < nverts; ++n) output << " " << ps->indices[i][n];
-    if (has_color) {
-      auto color_index = ps->color_indices[i];
-      if (color_index >= 0) {
-        auto color = ps->colors[color_index];
-        auto r = clamp_color_channel(color[0]);
-        auto g = clamp_color_channel(color[1]);
-        auto b = clamp_color_channel(color[2]);
-        auto a = clamp_color_channel(color[3]);
-        output << " " << (int)r << " " << (int)g << " " << (int)b;
-        // Alpha channel is read by apps like MeshLab.
-        if (a != 255) output << " " << (int)a;
+
+  write_chunked(output, ps->indices.size(), [&](size_t begin, size_t end, std::string& buffer) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto& poly = ps->indices[i];
+      append_int(buffer, poly.size());
+      for (const auto idx : poly) {
+        buffer += ' ';
+        append_int(buffer, idx);
       }
+      if (has_color) {
+        auto color_index = ps->color_indices[i];
+        if (color_index >= 0) {
+          auto color = ps->colors[color_index];
+          auto r = clamp_color_channel(color[0]);
+          auto g = clamp_color_channel(color[1]);
+          auto b = clamp_color_channel(color[2]);
+          auto a = clamp_color_channel(color[3]);
+          for (const auto channel : {r, g, b}) {
+            buffer += ' ';
+            append_int(buffer, static_cast<int>(channel));
+          }
+          // Alpha channel is read by apps like MeshLab.
+          if (a != 255) {
+            buffer += ' ';
+            append_int(buffer, static_cast<int>(a));
+          }
+        }
+      }
+      buffer += '\n';
     }
-    output << "\n";
-  }
+  });
 }
@@ -0,0 +1,142 @@
+#include "io/export.h"
+#include "io/osgeo.h"
+#include "geometry/Geometry.h"
+#include "geometry/PolySet.h"
+#include "geometry/PolySetUtils.h"
+#include "geometry/Polygon2d.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace {
+
+static_assert(sizeof(Vector3d) == 3 * sizeof(double));
+static_assert(sizeof(Vector2d) == 2 * sizeof(double));
+static_assert(sizeof(Color4f) == 4 * sizeof(float));
+
+// Face indices are flattened through a buffer of this many indices
+constexpr size_t INDEX_BUFFER_SIZE = 1ul << 16;
+
+class OsgeoWriter
+{
+public:
+  explicit OsgeoWriter(std::ostream& output) : output(output) {}
+
+  void writeHeader() {
+    osgeo::FileHeader header{};
+    std::copy(std::begin(osgeo::MAGIC), std::end(osgeo::MAGIC), header.magic);
+    header.version = osgeo::VERSION;
+    header.byte_order = osgeo::BYTE_ORDER_MARK;
+    writeStruct(header);
+  }
+
+  void writeGeometry(const std::shared_ptr<const Geometry>& geom) {
+    if (!geom) {
+      writeStruct(osgeo::RecordHeader{osgeo::RecordType::Empty, 1});
+    } else if (const auto list = std::dynamic_pointer_cast<const GeometryList>(geom)) {
+      writeStruct(osgeo::RecordHeader{osgeo::RecordType::List, static_cast<int32_t>(list->getConvexity())});
+      writeStruct(osgeo::ListRecord{list->getChildren().size()});
+      for (const auto& item : list->getChildren()) {
+        writeGeometry(item.second);
+      }
+    } else if (const auto poly = std::dynamic_pointer_cast<const Polygon2d>(geom)) {
+      writePolygon2d(*poly);
+    } else if (const auto ps = PolySetUtils::getGeometryAsPolySet(geom)) {
+      // Nef polyhedra and Manifold geometry are stored as their mesh
+      writePolySet(*ps, geom->getConvexity());
+    } else {
+      writeStruct(osgeo::RecordHeader{osgeo::RecordType::Empty, static_cast<int32_t>(geom->getConvexity())});
+    }
+  }
+
+private:
+  void writePolySet(const PolySet& ps, int convexity) {
+    writeStruct(osgeo::RecordHeader{osgeo::RecordType::PolySet, convexity});
+    osgeo::PolySetRecord record{};
+    record.dim = ps.getDimension();
+    record.triangular = ps.isTriangular();
+    const auto convex = ps.convexValue();
+    record.convex = convex ? 1 : !convex ? 0 : 2;
+    record.has_color_indices = !ps.color_indices.empty();
+    record.num_vertices = ps.vertices.size();
+    record.num_faces = ps.indices.size();
+    for (const auto& face : ps.indices) record.num_indices += face.size();
+    record.num_colors = ps.colors.size();
+    writeStruct(record);
+
+    writeArray(ps.vertices.data(), ps.vertices.size());
+    if (!ps.isTriangular()) {
+      std::vector<uint64_t> offsets;
+      offsets.reserve(ps.indices.size() + 1);
+      uint64_t offset = 0;
+      offsets.push_back(offset);
+      for (const auto& face : ps.indices) offsets.push_back(offset += face.size());
+      writeArray(offsets.data(), offsets.size());
+    }
+    std::vector<int32_t> buffer;
+    buffer.reserve(INDEX_BUFFER_SIZE + 4);
+    for (const auto& face : ps.indices) {
+      buffer.insert(buffer.end(), face.begin(), face.end());
+      if (buffer.size() >= INDEX_BUFFER_SIZE) {
+        writeBytes(buffer.data(), buffer.size() * sizeof(int32_t));
+        buffer.clear();
+      }
+    }
+    writeArray(buffer.data(), buffer.size());
+    if (record.has_color_indices) {
+      writeArray(ps.color_indices.data(), ps.color_indices.size());
+    }
+    writeArray(ps.colors.data(), ps.colors.size());
+  }
+
+  void writePolygon2d(const Polygon2d& poly) {
+    writeStruct(osgeo::RecordHeader{osgeo::RecordType::Polygon2d, static_cast<int32_t>(poly.getConvexity())});
+    osgeo::Polygon2dRecord record{};
+    record.num_outlines = poly.outlines().size();
+    record.sanitized = poly.isSanitized();
+    writeStruct(record);
+    for (const auto& outline : poly.outlines()) {
+      osgeo::OutlineRecord outline_record{};
+      outline_record.num_vertices = outline.vertices.size();
+      outline_record.positive = outline.positive;
+      writeStruct(outline_record);
+    }
+    for (const auto& outline : poly.outlines()) {
+      writeArray(outline.vertices.data(), outline.vertices.size());
+    }
+  }
+
+  template <typename T>
+  void writeStruct(const T& value) {
+    writeArray(&value, 1);
+  }
+
+  // Writes count items, padded to the alignment of the next record
+  template <typename T>
+  void writeArray(const T *data, size_t count) {
+    writeBytes(data, count * sizeof(T));
+    const char padding[osgeo::ALIGNMENT] = {};
+    writeBytes(padding, (osgeo::ALIGNMENT - offset % osgeo::ALIGNMENT) % osgeo::ALIGNMENT);
+  }
+
+  void writeBytes(const void *data, size_t size) {
+    output.write(static_cast<const char *>(data), size);
+    offset += size;
+  }
+
+  std::ostream& output;
+  uint64_t offset{0};
+};
+
+} // namespace
+
+void export_osgeo(const std::shared_ptr<const Geometry>& geom, std::ostream& output)
+{
+  OsgeoWriter writer(output);
+  writer.writeHeader();
+  writer.writeGeometry(geom);
+}
@@ -1,10 +1,14 @@
 #include "io/export.h"
+#include "io/imageutils.h"
 #include "utils/printutils.h"
 #include "glview/OffscreenView.h"
 #include "glview/CsgInfo.h"
 #include <ostream>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <memory>
+#include <vector>
 #include "glview/RenderSettings.h"
 
 #ifndef NULLGL
@@ -13,22 +17,43 @@
 
 namespace {
 
+bool keep_view = false;
+std::shared_ptr<OffscreenView> kept_view;
+
 void setupCamera(Camera& cam, const BoundingBox& bbox)
 {
   if (cam.viewall) cam.viewAll(bbox);
 }
 
+// Throws OffscreenViewException if there's no view to reuse and one can't be created
+std::shared_ptr<OffscreenView> get_offscreen_view(uint32_t width, uint32_t height)
+{
+  if (kept_view) {
+    if (kept_view->ctx->makeCurrent() && kept_view->resize(width, height)) return kept_view;
+    kept_view.reset();
+  }
+  auto glview = std::make_shared<OffscreenView>(width, height);
+  if (keep_view) kept_view = glview;
+  return glview;
+}
+
 }  // namespace
 
-bool export_png(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera, std::ostream& output)
+void keep_offscreen_view(bool keep)
 {
-  PRINTD("export_png geom");
-  std::unique_ptr<OffscreenView> glview;
+  keep_view = keep;
+  if (!keep) kept_view.reset();
+}
+
+std::shared_ptr<OffscreenView> prepare_render(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera)
+{
+  PRINTD("prepare_render geom");
+  std::shared_ptr<OffscreenView> glview;
   try {
-    glview = std::make_unique<OffscreenView>(camera.pixel_width, camera.pixel_height);
+    glview = get_offscreen_view(camera.pixel_width, camera.pixel_height);
   } catch (const OffscreenViewException &ex) {
     fprintf(stderr, "Can't create OffscreenView: %s.\n", ex.what());
-    return false;
+    return nullptr;
   }
   std::shared_ptr<Renderer> cgalRenderer;
   cgalRenderer = std::make_shared<CGALRenderer>(root_geom);
@@ -42,26 +67,55 @@ bool export_png(const std::shared_ptr<const Geometry>& root_geom, const ViewOpti
   glview->setShowAxes(options["axes"]);
   glview->setShowScaleProportional(options["scales"]);
   glview->setShowEdges(options["edges"]);
+  return glview;
+}
+
+bool render_image(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera, RGBAImage& image)
+{
+  PRINTD("render_image geom");
+  const auto glview = prepare_render(root_geom, options, camera);
+  if (!glview) return false;
   glview->paintGL();
-  glview->save(output);
+  image = glview->getImage();
   return true;
 }
 
+bool render_views(OffscreenView& glview, std::vector<Camera>& cameras, const std::function<bool(size_t, RGBAImage)>& image_ready)
+{
+  PRINTD("render_views");
+  // The renderer keeps its buffers, so the geometry is only uploaded for the first view
+  const BoundingBox bbox = glview.getRenderer()->getBoundingBox();
+  for (size_t i = 0; i < cameras.size(); ++i) {
+    setupCamera(cameras[i], bbox);
+    glview.setCamera(cameras[i]);
+    glview.paintGL();
+    if (!image_ready(i, glview.getImage())) return false;
+  }
+  return true;
+}
+
+bool export_png(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera, std::ostream& output)
+{
+  RGBAImage image;
+  return render_image(root_geom, options, camera, image) &&
+         write_png(output, image.pixels.data(), image.width, image.height);
+}
+
 #ifdef ENABLE_OPENCSG
 #include "glview/preview/OpenCSGRenderer.h"
 #include <opencsg.h>
 #endif
 #include "glview/preview/ThrownTogetherRenderer.h"
 
-std::unique_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& options, Camera& camera)
+std::shared_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& options, Camera& camera)
 {
   PRINTD("prepare_preview_common");
   CsgInfo csgInfo = CsgInfo();
   csgInfo.compile_products(tree);
 
-  std::unique_ptr<OffscreenView> glview;
+  std::shared_ptr<OffscreenView> glview;
   try {
-    glview = std::make_unique<OffscreenView>(camera.pixel_width, camera.pixel_height);
+    glview = get_offscreen_view(camera.pixel_width, camera.pixel_height);
   } catch (const OffscreenViewException &ex) {
     LOG("Can't create OffscreenView: %1$s.", ex.what());
     return nullptr;
@@ -84,15 +138,16 @@ std::unique_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& op
   glview->setRenderer(renderer);
 
 
-#ifdef ENABLE_OPENCSG
   const BoundingBox bbox = glview->getRenderer()->getBoundingBox();
   setupCamera(camera, bbox);
 
   glview->setCamera(camera);
+#ifdef ENABLE_OPENCSG
   OpenCSG::setContext(0);
   OpenCSG::setOption(OpenCSG::OffscreenSetting, OpenCSG::FrameBufferObject);
 #endif
   glview->setColorScheme(RenderSettings::inst()->colorscheme);
+  glview->setShowCrosshairs(false); // A kept view may have shown them for the previous export
   glview->setShowAxes(options["axes"]);
   glview->setShowScaleProportional(options["scales"]);
   glview->setShowEdges(options["edges"]);
@@ -100,6 +155,12 @@ std::unique_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& op
   return glview;
 }
 
+bool render_image(const OffscreenView& glview, RGBAImage& image)
+{
+  image = glview.getImage();
+  return true;
+}
+
 bool export_png(const OffscreenView& glview, std::ostream& output)
 {
   PRINTD("export_png_preview_common");
@@ -109,8 +170,13 @@ bool export_png(const OffscreenView& glview, std::ostream& output)
 
 #else // NULLGL
 
+std::shared_ptr<OffscreenView> prepare_render(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera) { return nullptr; }
+bool render_image(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera, RGBAImage& image) { return false; }
+bool render_views(OffscreenView& glview, std::vector<Camera>& cameras, const std::function<bool(size_t, RGBAImage)>& image_ready) { return false; }
 bool export_png(const std::shared_ptr<const Geometry>& root_geom, const ViewOptions& options, Camera& camera, std::ostream& output) { return false; }
-std::unique_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& options, Camera& camera) { return nullptr; }
+std::shared_ptr<OffscreenView> prepare_preview(Tree& tree, const ViewOptions& options, Camera& camera) { return nullptr; }
+void keep_offscreen_view(bool keep) {}
+bool render_image(const OffscreenView& glview, RGBAImage& image) { return false; }
 bool export_png(const OffscreenView& glview, std::ostream& output) { return false; }
 
 #endif // NULLGL
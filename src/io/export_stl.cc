@@ -27,14 +27,17 @@
 #include "io/export.h"
 #include "geometry/PolySet.h"
 #include "geometry/PolySetUtils.h"
+#include "io/formatutils.h"
+#include "utils/parallel.h"
 #include <algorithm>
 #include <cassert>
 #include <array>
 #include <ios>
 #include <ostream>
 #include <cstdint>
+#include <cstring>
 #include <memory>
-#include <double-conversion/double-conversion.h>
+#include <utility>
 #ifdef ENABLE_MANIFOLD
 #include "geometry/manifold/ManifoldGeometry.h"
 #endif
@@ -50,36 +53,6 @@
 #include <vector>
 
 namespace {
-/* Define values for double-conversion library. */
-#define DC_BUFFER_SIZE (128)
-#define DC_FLAGS (double_conversion::DoubleToStringConverter::UNIQUE_ZERO)
-#define DC_INF NULL // Only finite values in STL outputs!
-#define DC_NAN NULL
-#define DC_EXP 'e'
-#define DC_DECIMAL_LOW_EXP (-6)
-#define DC_DECIMAL_HIGH_EXP (21)
-#define DC_MAX_LEADING_ZEROES (5)
-#define DC_MAX_TRAILING_ZEROES (0)
-
-std::string toString(const Vector3d& v)
-{
-  double_conversion::DoubleToStringConverter dc(
-    DC_FLAGS, DC_INF, DC_NAN, DC_EXP,
-    DC_DECIMAL_LOW_EXP, DC_DECIMAL_HIGH_EXP, DC_MAX_LEADING_ZEROES, DC_MAX_TRAILING_ZEROES
-  );
-
-  char buffer[DC_BUFFER_SIZE];
-
-  double_conversion::StringBuilder builder(buffer, DC_BUFFER_SIZE);
-  dc.ToShortest(v[0], &builder);
-  builder.AddCharacter(' ');
-  dc.ToShortest(v[1], &builder);
-  builder.AddCharacter(' ');
-  dc.ToShortest(v[2], &builder);
-  builder.Finalize();
-
-  return buffer;
-}
 
 int32_t flipEndianness(int32_t x) {
   return
@@ -87,30 +60,79 @@ int32_t flipEndianness(int32_t x) {
     ((x << 8) & 0xff0000) | ((x >> 8) & 0xff00);
 }
 
-template <size_t N>
-void write_floats(std::ostream& output, const std::array<float, N>& data) {
-  static uint16_t test = 0x0001;
-  static bool isLittleEndian = *reinterpret_cast<char *>(&test) == 1;
+constexpr size_t STL_FACET_NUMBYTES = 4ul * 3ul * 4ul + 2ul;
+// Binary facets are packed into a reusable buffer of this many facets (~3MB)
+constexpr size_t STL_BUFFER_FACETS = 65536;
+// Facets are packed in parallel in slices of this many facets
+constexpr size_t STL_PACK_SLICE_FACETS = 4096;
 
-  if (isLittleEndian) {
-    output.write(reinterpret_cast<char *>(const_cast<float *>(&data[0])), N * sizeof(float));
-  } else {
-    std::array<float, N> copy(data);
+/*!
+   A triangle mesh to be written to STL.
+
+   This is either a triangulated PolySet, or the mesh arrays of a Manifold,
+   which can be written directly without building a PolySet first.
+ */
+class StlMesh
+{
+public:
+  explicit StlMesh(std::shared_ptr<const PolySet> ps) : ps(std::move(ps)) {}
+#ifdef ENABLE_MANIFOLD
+  explicit StlMesh(std::shared_ptr<const manifold::MeshGL64> mesh) : mesh(std::move(mesh)) {}
+#endif
 
-    auto *ints = reinterpret_cast<int32_t *>(&copy[0]);
-    for (size_t i = 0; i < N; i++) {
-      ints[i] = flipEndianness(ints[i]);
+  [[nodiscard]] size_t numVertices() const {
+#ifdef ENABLE_MANIFOLD
+    if (mesh) return mesh->NumVert();
+#endif
+    return ps->vertices.size();
+  }
+
+  [[nodiscard]] Vector3d vertex(size_t i) const {
+#ifdef ENABLE_MANIFOLD
+    if (mesh) {
+      const auto *p = &mesh->vertProperties[i * mesh->numProp];
+      return {p[0], p[1], p[2]};
     }
+#endif
+    return ps->vertices[i];
+  }
 
-    output.write(reinterpret_cast<char *>(&copy[0]), N * sizeof(float));
+  [[nodiscard]] size_t numTriangles() const {
+#ifdef ENABLE_MANIFOLD
+    if (mesh) return mesh->NumTri();
+#endif
+    return ps->indices.size();
   }
-}
 
+  [[nodiscard]] std::array<size_t, 3> triangle(size_t i) const {
+#ifdef ENABLE_MANIFOLD
+    if (mesh) {
+      const auto *t = &mesh->triVerts[3 * i];
+      return {t[0], t[1], t[2]};
+    }
+#endif
+    const auto& t = ps->indices[i];
+    return {static_cast<size_t>(t[0]), static_cast<size_t>(t[1]), static_cast<size_t>(t[2])};
+  }
+
+private:
+  std::shared_ptr<const PolySet> ps;
+#ifdef ENABLE_MANIFOLD
+  std::shared_ptr<const manifold::MeshGL64> mesh;
+#endif
+};
 
-uint64_t append_stl(std::shared_ptr<const PolySet> polyset, std::ostream& output, bool binary)
+Vector3d facetNormal(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2)
 {
-  static_assert(sizeof(float) == 4, "Need 32 bit float");
+  auto normal = (p1 - p0).cross(p2 - p0);
+  if (!normal.isZero(0)) {
+    normal.normalize();
+  }
+  return normal;
+}
 
+void collect_stl_meshes(const std::shared_ptr<const PolySet>& polyset, std::vector<StlMesh>& meshes)
+{
   std::shared_ptr<const PolySet> ps = polyset;
   if (!ps->isTriangular()) {
     ps = PolySetUtils::tessellate_faces(*ps);
@@ -118,146 +140,172 @@ uint64_t append_stl(std::shared_ptr<const PolySet> polyset, std::ostream& output
   if (Feature::ExperimentalPredictibleOutput.is_enabled()) {
     ps = createSortedPolySet(*ps);
   }
-
-  uint64_t triangle_count = 0;
-
-  // In ASCII mode only, convert each vertex to string.
-  std::vector<std::string> vertexStrings;
-  if (!binary) {
-    vertexStrings.resize(ps->vertices.size());
-    std::transform(ps->vertices.begin(), ps->vertices.end(), vertexStrings.begin(),
-      [](const auto& p) { return toString(p); });
-  }
-
-  // Used for binary mode only
-  std::array<float, 4lu * 3> coords;
-
-  for (const auto &t : ps->indices) {
-    const auto &p0 = ps->vertices[t[0]];
-    const auto &p1 = ps->vertices[t[1]];
-    const auto &p2 = ps->vertices[t[2]];
-
-    // Tessellation already eliminated these cases.
-    assert(p0 != p1 && p0 != p2 && p1 != p2);
-
-    auto normal = (p1 - p0).cross(p2 - p0);
-    if (!normal.isZero(0)) {
-      normal.normalize();
-    }
-
-    if (binary) {
-      auto coords_offset = 0;
-      auto addCoords = [&](const auto& v) {
-        for (auto i : {0, 1, 2})
-          coords[coords_offset++] = v[i];
-      };
-      addCoords(normal);
-      addCoords(p0);
-      addCoords(p1);
-      addCoords(p2);
-      assert(coords_offset == 4 * 3);
-      write_floats(output, coords);
-      char attrib[2] = {0, 0};
-      output.write(attrib, 2);
-    } else {
-      const auto &s0 = vertexStrings[t[0]];
-      const auto &s1 = vertexStrings[t[1]];
-      const auto &s2 = vertexStrings[t[2]];
-
-      // Since the points are different, the precision we use to
-      // format them to string should guarantee the strings are
-      // different too.
-      assert(s0 != s1 && s0 != s2 && s1 != s2);
-
-      output << "  facet normal ";
-      output << toString(normal) << "\n";
-      output << "    outer loop\n";
-      output << "      vertex " << s0 << "\n";
-      output << "      vertex " << s1 << "\n";
-      output << "      vertex " << s2 << "\n";
-      output << "    endloop\n";
-      output << "  endfacet\n";
-    }
-    triangle_count++;
-  }
-
-  return triangle_count;
+  meshes.emplace_back(ps);
 }
 
 #ifdef ENABLE_CGAL
-/*!
-    Saves the current 3D CGAL Nef polyhedron as STL to the given file.
-    The file must be open.
- */
-uint64_t append_stl(const CGAL_Nef_polyhedron& root_N, std::ostream& output,
-                    bool binary)
+void collect_stl_meshes(const CGAL_Nef_polyhedron& root_N, std::vector<StlMesh>& meshes)
 {
-  uint64_t triangle_count = 0;
   if (!root_N.p3->is_simple()) {
     LOG(message_group::Export_Warning, "Exported object may not be a valid 2-manifold and may need repair");
   }
 
   if (std::shared_ptr<PolySet> ps = CGALUtils::createPolySetFromNefPolyhedron3(*(root_N.p3))) {
-    triangle_count += append_stl(ps, output, binary);
+    collect_stl_meshes(ps, meshes);
   } else {
     LOG(message_group::Export_Error, "Nef->PolySet failed");
   }
-
-  return triangle_count;
 }
-
 #endif  // ENABLE_CGAL
 
 #ifdef ENABLE_MANIFOLD
-/*!
-   Saves the current 3D Manifold geometry as STL to the given file.
-   The file must be open.
- */
-uint64_t append_stl(const ManifoldGeometry& mani, std::ostream& output,
-                    bool binary)
+void collect_stl_meshes(const ManifoldGeometry& mani, std::vector<StlMesh>& meshes)
 {
-  uint64_t triangle_count = 0;
   if (!mani.isManifold()) {
     LOG(message_group::Export_Warning, "Exported object may not be a valid 2-manifold and may need repair");
   }
 
-  const auto ps = mani.toPolySet();
-  if (ps) {
-    triangle_count += append_stl(ps, output, binary);
+  if (Feature::ExperimentalPredictibleOutput.is_enabled()) {
+    if (const auto ps = mani.toPolySet()) {
+      collect_stl_meshes(ps, meshes);
+    } else {
+      LOG(message_group::Export_Error, "Manifold->PolySet failed");
+    }
   } else {
-    LOG(message_group::Export_Error, "Manifold->PolySet failed");
+    // Same vertices and triangles as ManifoldGeometry::toPolySet(), without copying them
+    meshes.emplace_back(std::make_shared<const manifold::MeshGL64>(mani.getManifold().GetMeshGL64()));
   }
-
-  return triangle_count;
 }
 #endif  // ENABLE_MANIFOLD
 
-
-uint64_t append_stl(const std::shared_ptr<const Geometry>& geom, std::ostream& output,
-                    bool binary)
+/*!
+   Collects the triangle meshes of the given geometry, so the total triangle
+   count is known before writing.
+ */
+void collect_stl_meshes(const std::shared_ptr<const Geometry>& geom, std::vector<StlMesh>& meshes)
 {
-  uint64_t triangle_count = 0;
   if (const auto geomlist = std::dynamic_pointer_cast<const GeometryList>(geom)) {
     for (const Geometry::GeometryItem& item : geomlist->getChildren()) {
-      triangle_count += append_stl(item.second, output, binary);
+      collect_stl_meshes(item.second, meshes);
     }
   } else if (const auto ps = std::dynamic_pointer_cast<const PolySet>(geom)) {
-    triangle_count += append_stl(ps, output, binary);
+    collect_stl_meshes(ps, meshes);
 #ifdef ENABLE_CGAL
   } else if (const auto N = std::dynamic_pointer_cast<const CGAL_Nef_polyhedron>(geom)) {
-    triangle_count += append_stl(*N, output, binary);
+    collect_stl_meshes(*N, meshes);
 #endif
 #ifdef ENABLE_MANIFOLD
   } else if (const auto mani = std::dynamic_pointer_cast<const ManifoldGeometry>(geom)) {
-    triangle_count += append_stl(*mani, output, binary);
+    collect_stl_meshes(*mani, meshes);
 #endif
   } else if (std::dynamic_pointer_cast<const Polygon2d>(geom)) { //NOLINT(bugprone-branch-clone)
     assert(false && "Unsupported file format");
   } else { //NOLINT(bugprone-branch-clone)
     assert(false && "Not implemented");
   }
+}
+
+void pack_facet(const StlMesh& mesh, size_t i, char *out)
+{
+  static_assert(sizeof(float) == 4, "Need 32 bit float");
+  static const uint16_t test = 0x0001;
+  static const bool isLittleEndian = *reinterpret_cast<const char *>(&test) == 1;
+
+  const auto t = mesh.triangle(i);
+  const auto p0 = mesh.vertex(t[0]);
+  const auto p1 = mesh.vertex(t[1]);
+  const auto p2 = mesh.vertex(t[2]);
+  const auto normal = facetNormal(p0, p1, p2);
+
+  std::array<float, 4lu * 3> coords;
+  auto coords_offset = 0;
+  for (const auto *v : {&normal, &p0, &p1, &p2}) {
+    for (auto j : {0, 1, 2}) coords[coords_offset++] = (*v)[j];
+  }
+  if (!isLittleEndian) {
+    auto *ints = reinterpret_cast<int32_t *>(&coords[0]);
+    for (size_t j = 0; j < coords.size(); j++) {
+      ints[j] = flipEndianness(ints[j]);
+    }
+  }
+  memcpy(out, coords.data(), sizeof(coords));
+  // attribute byte count
+  out[48] = 0;
+  out[49] = 0;
+}
+
+/*!
+   Writes the facets of a mesh through a reusable buffer. Each buffer is
+   filled in parallel slices.
+ */
+void write_binary_facets(const StlMesh& mesh, std::ostream& output, std::vector<char>& buffer)
+{
+  const size_t num_triangles = mesh.numTriangles();
+  std::vector<size_t> slices;
+  for (size_t begin = 0; begin < num_triangles; begin += STL_BUFFER_FACETS) {
+    const size_t count = std::min(STL_BUFFER_FACETS, num_triangles - begin);
+    slices.clear();
+    for (size_t slice = 0; slice < count; slice += STL_PACK_SLICE_FACETS) {
+      slices.push_back(slice);
+    }
+    parallelizable_for_each(slices.begin(), slices.end(), [&](size_t slice) {
+      const size_t slice_end = std::min(slice + STL_PACK_SLICE_FACETS, count);
+      for (size_t i = slice; i < slice_end; ++i) {
+        pack_facet(mesh, begin + i, &buffer[i * STL_FACET_NUMBYTES]);
+      }
+    });
+    output.write(buffer.data(), count * STL_FACET_NUMBYTES);
+  }
+}
+
+uint64_t append_stl_ascii(const StlMesh& mesh, std::ostream& output)
+{
+  // Convert each vertex to string.
+  std::vector<std::string> vertexStrings(mesh.numVertices());
+  std::vector<size_t> vertex_chunks;
+  for (size_t begin = 0; begin < vertexStrings.size(); begin += STL_PACK_SLICE_FACETS) {
+    vertex_chunks.push_back(begin);
+  }
+  parallelizable_for_each(vertex_chunks.begin(), vertex_chunks.end(), [&](size_t begin) {
+    const size_t end = std::min(begin + STL_PACK_SLICE_FACETS, vertexStrings.size());
+    for (size_t i = begin; i < end; ++i) {
+      append_vector_shortest(vertexStrings[i], mesh.vertex(i));
+    }
+  });
 
-  return triangle_count;
+  const size_t num_triangles = mesh.numTriangles();
+  write_chunked(output, num_triangles, [&](size_t begin, size_t end, std::string& out) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto t = mesh.triangle(i);
+      const auto p0 = mesh.vertex(t[0]);
+      const auto p1 = mesh.vertex(t[1]);
+      const auto p2 = mesh.vertex(t[2]);
+
+      // Tessellation already eliminated these cases.
+      assert(p0 != p1 && p0 != p2 && p1 != p2);
+
+      const auto &s0 = vertexStrings[t[0]];
+      const auto &s1 = vertexStrings[t[1]];
+      const auto &s2 = vertexStrings[t[2]];
+
+      // Since the points are different, the precision we use to
+      // format them to string should guarantee the strings are
+      // different too.
+      assert(s0 != s1 && s0 != s2 && s1 != s2);
+
+      out += "  facet normal ";
+      append_vector_shortest(out, facetNormal(p0, p1, p2));
+      out += "\n    outer loop\n      vertex ";
+      out += s0;
+      out += "\n      vertex ";
+      out += s1;
+      out += "\n      vertex ";
+      out += s2;
+      out += "\n    endloop\n  endfacet\n";
+    }
+  });
+
+  return num_triangles;
 }
 
 } // namespace
@@ -266,41 +314,37 @@ void export_stl(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
                 bool binary)
 {
   // FIXME: In lazy union mode, should we export multiple solids?
+  std::vector<StlMesh> meshes;
+  collect_stl_meshes(geom, meshes);
+
   if (binary) {
-    std::ostringstream buffer; // Using a memory buffer
-    char header[80] = "OpenSCAD Model\n";
-    buffer.write(header, sizeof(header));
-    
-  // Placeholder for triangle count
-    uint32_t triangle_count = 0;
-    char tmp_triangle_count[4] = {0, 0, 0, 0};
-    buffer.write(tmp_triangle_count, 4);
-
-    // Writing triangles and counting them
-    triangle_count = append_stl(geom, buffer, binary);
-
-  if (triangle_count > 4294967295) {
-    LOG(message_group::Export_Error, "Triangle count exceeded 4294967295, so the STL file is not valid");
+    uint64_t triangle_count = 0;
+    for (const auto& mesh : meshes) {
+      triangle_count += mesh.numTriangles();
+    }
+    if (triangle_count > 4294967295) {
+      LOG(message_group::Export_Error, "Triangle count exceeded 4294967295, so the STL file is not valid");
     }
 
-  // Updating the triangle count in the buffer
+    char header[80] = "OpenSCAD Model\n";
+    output.write(header, sizeof(header));
     char triangle_count_bytes[4] = {
-        static_cast<char>(triangle_count & 0xff),
-        static_cast<char>((triangle_count >> 8) & 0xff),
-        static_cast<char>((triangle_count >> 16) & 0xff),
-        static_cast<char>((triangle_count >> 24) & 0xff)};
-    buffer.seekp(80, std::ios_base::beg);
-    buffer.write(triangle_count_bytes, 4);
-    
-    // Flushing the buffer to the output stream
-    output << buffer.str();
-
+      static_cast<char>(triangle_count & 0xff),
+      static_cast<char>((triangle_count >> 8) & 0xff),
+      static_cast<char>((triangle_count >> 16) & 0xff),
+      static_cast<char>((triangle_count >> 24) & 0xff)};
+    output.write(triangle_count_bytes, 4);
+
+    std::vector<char> buffer(std::min<uint64_t>(triangle_count, STL_BUFFER_FACETS) * STL_FACET_NUMBYTES);
+    for (const auto& mesh : meshes) {
+      write_binary_facets(mesh, output, buffer);
+    }
   } else {
     // ASCII mode: Write directly to the output stream
-    setlocale(LC_NUMERIC, "C"); // Ensure radix is . (not ,) in output
     output << "solid OpenSCAD_Model\n";
-    uint64_t triangle_count = append_stl(geom, output, binary);
+    for (const auto& mesh : meshes) {
+      append_stl_ascii(mesh, output);
+    }
     output << "endsolid OpenSCAD_Model\n";
-    setlocale(LC_NUMERIC, ""); // Restore default locale
   }
 }
@@ -70,7 +70,6 @@ static void append_svg(const std::shared_ptr<const Geometry>& geom, std::ostream
 
 void export_svg(const std::shared_ptr<const Geometry>& geom, std::ostream& output)
 {
-  setlocale(LC_NUMERIC, "C"); // Ensure radix is . (not ,) in output
 
   BoundingBox bbox = geom->getBoundingBox();
   int minx = (int)floor(bbox.min().x());
@@ -91,5 +90,4 @@ void export_svg(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
   append_svg(geom, output);
 
   output << "</svg>\n";
-  setlocale(LC_NUMERIC, ""); // Set default locale
 }
@@ -24,6 +24,7 @@
  */
 
 #include "io/export.h"
+#include "io/formatutils.h"
 
 #include "geometry/PolySet.h"
 #include "geometry/PolySetUtils.h"
@@ -31,6 +32,7 @@
 #include <ostream>
 #include <memory>
 #include <cstddef>
+#include <string>
 
 void export_wrl(const std::shared_ptr<const Geometry>& geom, std::ostream& output)
 {
@@ -58,25 +60,33 @@ void export_wrl(const std::shared_ptr<const Geometry>& geom, std::ostream& outpu
   output << "coord Coordinate { point [\n";
   const auto& v = ps->vertices;
   const size_t numverts = v.size();
-  for (size_t i = 0; i < numverts; ++i) {
-    output << v[i][0] << " " << v[i][1] << " " << v[i][2];
-    if (i < numverts - 1) {
-      output << ",";
+  write_chunked(output, numverts, [&](size_t begin, size_t end, std::string& buffer) {
+    for (size_t i = begin; i < end; ++i) {
+      append_double_default(buffer, v[i][0]);
+      buffer += ' ';
+      append_double_default(buffer, v[i][1]);
+      buffer += ' ';
+      append_double_default(buffer, v[i][2]);
+      if (i < numverts - 1) {
+        buffer += ',';
+      }
+      buffer += '\n';
     }
-    output << "\n";
-  }
+  });
   output << "] }\n\n";
 
   output << "coordIndex [\n";
   const size_t numindices = ps->indices.size();
-  for (size_t i = 0; i < numindices; ++i) {
-    const auto &poly=ps->indices[i];
-    for(size_t j=0;j<poly.size();j++) {
-      output << poly[j];
-        if (j < poly.size() - 1) output << ",";
-      output << "\n";
+  write_chunked(output, numindices, [&](size_t begin, size_t end, std::string& buffer) {
+    for (size_t i = begin; i < end; ++i) {
+      const auto &poly=ps->indices[i];
+      for(size_t j=0;j<poly.size();j++) {
+        append_int(buffer, poly[j]);
+        if (j < poly.size() - 1) buffer += ',';
+        buffer += '\n';
+      }
     }
-  }
+  });
   output << "]\n\n";
 
   output << "}\n\n";
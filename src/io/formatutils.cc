@@ -0,0 +1,57 @@
+#include "io/formatutils.h"
+
+#include <charconv>
+#include <locale>
+#include <sstream>
+#include <string>
+
+#include <double-conversion/double-conversion.h>
+
+namespace {
+
+const double_conversion::DoubleToStringConverter& shortest_converter()
+{
+  // Only finite values in STL outputs!
+  static const double_conversion::DoubleToStringConverter dc(
+    double_conversion::DoubleToStringConverter::UNIQUE_ZERO, nullptr, nullptr, 'e',
+    -6, 21, 5, 0);
+  return dc;
+}
+
+} // namespace
+
+void append_double_default(std::string& out, double v)
+{
+#ifdef __cpp_lib_to_chars
+  char buffer[32];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v, std::chars_format::general, 6);
+  out.append(buffer, result.ptr);
+#else
+  thread_local std::ostringstream oss = [] {
+    std::ostringstream s;
+    s.imbue(std::locale::classic());
+    return s;
+  }();
+  oss.str("");
+  oss << v;
+  out += oss.str();
+#endif
+}
+
+void append_double_shortest(std::string& out, double v)
+{
+  char buffer[128];
+  double_conversion::StringBuilder builder(buffer, sizeof(buffer));
+  shortest_converter().ToShortest(v, &builder);
+  const int length = builder.position();
+  out.append(builder.Finalize(), length);
+}
+
+void append_vector_shortest(std::string& out, const Vector3d& v)
+{
+  append_double_shortest(out, v[0]);
+  out += ' ';
+  append_double_shortest(out, v[1]);
+  out += ' ';
+  append_double_shortest(out, v[2]);
+}
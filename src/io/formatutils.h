@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "geometry/linalg.h"
+#include "utils/parallel.h"
+
+/*
+   Number formatting for the text based exporters.
+
+   Numbers are appended to std::string buffers, so exporters can format large
+   meshes in parallel chunks and write the chunks in order, instead of going
+   through an std::ostream one value at a time. Each function produces exactly
+   the same characters as the stream based code it replaces.
+ */
+
+/*!
+   Appends v formatted like std::ostream << v with default flags and
+   precision (i.e. printf's %g) in the "C" locale.
+ */
+void append_double_default(std::string& out, double v);
+
+/*!
+   Appends the shortest representation of v which reads back to the same
+   double, as written by the STL exporter.
+ */
+void append_double_shortest(std::string& out, double v);
+
+// Appends x y z separated by single spaces, formatted by append_double_shortest()
+void append_vector_shortest(std::string& out, const Vector3d& v);
+
+template <typename T>
+void append_int(std::string& out, T v)
+{
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), v);
+  out.append(buffer, result.ptr);
+}
+
+/*!
+   Writes count items to output, formatted by format(begin, end, out) which
+   appends items [begin, end) to out.
+
+   Items are formatted in parallel chunks of chunk_size items, but written in
+   order, and the chunk buffers are reused so memory use doesn't grow with the
+   size of the output.
+ */
+template <typename Format>
+void write_chunked(std::ostream& output, size_t count, const Format& format, size_t chunk_size = 16384)
+{
+  // Number of chunks formatted in parallel before writing them
+  constexpr size_t batch_chunks = 32;
+  std::vector<std::string> buffers(std::min(batch_chunks, (count + chunk_size - 1) / chunk_size));
+  std::vector<size_t> chunks;
+  for (size_t batch = 0; batch < count; batch += batch_chunks * chunk_size) {
+    chunks.clear();
+    for (size_t begin = batch; begin < count && chunks.size() < batch_chunks; begin += chunk_size) {
+      chunks.push_back(begin);
+    }
+    parallelizable_for_each(chunks.begin(), chunks.end(), [&](size_t begin) {
+      auto& buffer = buffers[(begin - batch) / chunk_size];
+      buffer.clear();
+      format(begin, std::min(begin + chunk_size, count), buffer);
+    });
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      output.write(buffers[i].data(), buffers[i].size());
+    }
+  }
+}
@@ -13,6 +13,15 @@ void flip_image(const unsigned char *src, unsigned char *dst, size_t pixelsize,
   }
 }
 
+void copy_image(const RGBAImage& src, RGBAImage& dst, int x, int y)
+{
+  assert(x >= 0 && y >= 0 && x + src.width <= dst.width && y + src.height <= dst.height);
+  const auto rowBytes = 4ul * src.width;
+  for (int i = 0; i < src.height; ++i) {
+    memcpy(dst.pixels.data() + 4ul * ((y + i) * dst.width + x), src.pixels.data() + i * rowBytes, rowBytes);
+  }
+}
+
 bool write_png(const char *filename, unsigned char *pixels, int width, int height)
 {
   assert(filename && pixels);
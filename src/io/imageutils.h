@@ -1,8 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <vector>
+
+// An 8 bit per channel RGBA image, top row first
+struct RGBAImage
+{
+  std::vector<uint8_t> pixels;
+  int width{0};
+  int height{0};
+};
 
 bool write_png(const char *filename, unsigned char *pixels, int width, int height);
 bool write_png(std::ostream& output, unsigned char *pixels, int width, int height);
+// Copies src into dst, with its top left corner at x, y. src must fit within dst.
+void copy_image(const RGBAImage& src, RGBAImage& dst, int x, int y);
 void flip_image(const unsigned char *src, unsigned char *dst, size_t pixelsize, size_t width, size_t height);
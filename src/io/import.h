@@ -11,6 +11,7 @@ std::unique_ptr<class PolySet> import_obj(const std::string& filename, const Loc
 std::unique_ptr<class PolySet> import_off(const std::string& filename, const Location& loc);
 std::unique_ptr<class PolySet> import_amf(const std::string&, const Location& loc);
 std::unique_ptr<class Geometry> import_3mf(const std::string&, const Location& loc);
+std::unique_ptr<class Geometry> import_osgeo(const std::string& filename, const Location& loc);
 
 std::unique_ptr<class Polygon2d> import_svg(double fn, double fs, double fa,
 					  const std::string& filename,
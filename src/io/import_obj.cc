@@ -1,94 +1,178 @@
 #include "io/import.h"
+#include "io/MappedFile.h"
+#include "io/importutils.h"
+#include "io/scanutils.h"
 #include "geometry/PolySet.h"
-#include "geometry/PolySetBuilder.h"
-#include <ios>
+#include "utils/parallel.h"
+#include "utils/printutils.h"
+#include "core/AST.h"
+
+#include <algorithm>
+#include <cstddef>
 #include <memory>
-#include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <boost/regex.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/split.hpp>
 
-std::unique_ptr<PolySet> import_obj(const std::string& filename, const Location& loc) {
-  PolySetBuilder builder;
+namespace {
+
+// Files are scanned in chunks of roughly this many bytes in parallel
+constexpr size_t OBJ_CHUNK_NUMBYTES = 4ul << 20;
+
+// The lines of an OBJ file which need more than storing a vertex, in file order
+struct ObjLine {
+  enum class Type { Face, BadVertex, BadFace, Unrecognized };
+  Type type;
+  size_t line;                 // line index in the chunk
+  std::string_view text;       // trimmed line
+  size_t vertices;             // vertex lines before this one in the chunk
+  size_t indices_begin, indices_end; // face indices in ObjChunk::indices
+};
+
+struct ObjChunk {
+  std::vector<ObjLine> lines;
+  std::vector<Vector3d> vertices; // one per vertex line
+  std::vector<int> indices;       // 1-based vertex indices of all faces
+  size_t num_lines = 0;
+};
+
+/*!
+   Classifies the lines of a chunk of an OBJ file, parsing vertices and faces.
+   Empty lines, comments and ignored statements (texture coordinates, normals,
+   materials, object names, smoothing and groups) are skipped.
+ */
+ObjChunk scanObjChunk(const char *begin, const char *end)
+{
+  ObjChunk chunk;
+  for (; begin < end; ++chunk.num_lines) {
+    const char *line_end = std::find(begin, end, '\n');
+    const auto line = scan_trim(std::string_view(begin, line_end - begin));
+    begin = line_end == end ? end : line_end + 1;
+
+    using Type = ObjLine::Type;
+    if (line.empty() || line.front() == '#') {
+      continue;
+    } else if (line.size() > 1 && line[0] == 'v' && scan_is_space(line[1])) {
+      auto rest = line.substr(1);
+      std::string_view tokens[3];
+      for (auto& token : tokens) token = scan_token(rest);
+      if (!tokens[2].empty() && scan_trim(rest).empty()) {
+        Vector3d v;
+        if (scan_double(tokens[0], v[0]) && scan_double(tokens[1], v[1]) && scan_double(tokens[2], v[2])) {
+          chunk.vertices.push_back(v);
+        } else {
+          chunk.lines.push_back({Type::BadVertex, chunk.num_lines, line, chunk.vertices.size(), 0, 0});
+        }
+        continue;
+      }
+      // Not three coordinates: falls through to the unrecognized lines below
+    } else if (line.size() > 1 && line[0] == 'f' && scan_is_space(line[1])) {
+      auto rest = line.substr(1);
+      const size_t indices_begin = chunk.indices.size();
+      bool ok = true;
+      for (auto word = scan_token(rest); ok && !word.empty(); word = scan_token(rest)) {
+        // Only the vertex index is used from v/vt/vn
+        int ind;
+        ok = scan_int(word.substr(0, word.find('/')), ind);
+        if (ok) chunk.indices.push_back(ind);
+      }
+      if (ok) {
+        chunk.lines.push_back({Type::Face, chunk.num_lines, line, chunk.vertices.size(), indices_begin, chunk.indices.size()});
+      } else {
+        chunk.indices.resize(indices_begin);
+        chunk.lines.push_back({Type::BadFace, chunk.num_lines, line, chunk.vertices.size(), 0, 0});
+      }
+      continue;
+    }
+    if (scan_starts_with(line, "vt") ||     // ignore texture coords
+        scan_starts_with(line, "vn") ||     // ignore normal coords
+        scan_starts_with(line, "mtllib") || // ignore material lib
+        scan_starts_with(line, "usemtl") || // ignore usemtl
+        line.front() == 'o' ||              // ignore object name
+        line.front() == 's' ||              // ignore smoothing
+        line.front() == 'g') {              // ignore group name
+      continue;
+    }
+    chunk.lines.push_back({Type::Unrecognized, chunk.num_lines, line, chunk.vertices.size(), 0, 0});
+  }
+  return chunk;
+}
 
-  std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary );
-  if (!f.good()) {
+} // namespace
+
+std::unique_ptr<PolySet> import_obj(const std::string& filename, const Location& loc) {
+  const MappedFile file(filename);
+  if (!file.isOpen()) {
     LOG(message_group::Warning,
         "Can't open import file '%1$s', import() at line %2$d",
         filename, loc.firstLine());
     return PolySet::createEmpty();
   }
-  boost::regex ex_comment(R"(^\s*#)");
-  boost::regex ex_v( R"(^\s*v\s+([^\s]+)\s+([^\s]+)\s+([^\s]+)\s*$)");
-  boost::regex ex_f( R"(^\s*f\s+(.*)$)");
-  boost::regex ex_vt( R"(^\s*vt)");
-  boost::regex ex_vn( R"(^\s*vn)");
-  boost::regex ex_mtllib( R"(^\s*mtllib)");
-  boost::regex ex_usemtl( R"(^\s*usemtl)");
-  boost::regex ex_o( R"(^\s*o)");
-  boost::regex ex_s( R"(^\s*s)");
-  boost::regex ex_g( R"(^\s*g)");
-  int lineno = 1;
-  std::string line;
 
-  auto AsciiError = [&](const auto& errstr){
+  auto AsciiError = [&](size_t lineno, std::string_view line, const auto& errstr){
     LOG(message_group::Error, loc, "",
     "OBJ File line %1$s, %2$s line '%3$s' importing file '%4$s'",
-    lineno, errstr, line, filename);
+    lineno, errstr, std::string(line), filename);
   };
-  std::vector<int> vertex_map;
 
-  while (!f.eof()) {
-    lineno++;
-    std::getline(f, line);
-    boost::trim(line);
+  const auto ranges = split_line_chunks(file.begin(), file.end(), OBJ_CHUNK_NUMBYTES);
+  std::vector<ObjChunk> chunks(ranges.size());
+  parallelizable_transform(ranges.begin(), ranges.end(), chunks.begin(), [](const auto& range) {
+    return scanObjChunk(range.first, range.second);
+  });
 
-    boost::smatch results;
-    if (line.length() == 0 || boost::regex_search(line, ex_comment)) {
-      continue;
-    } else if (boost::regex_search(line, results, ex_v) && results.size() >= 4) {
-      try {
-        Vector3d v;
-        for (int i = 0; i < 3; i++) {
-          v[i]= boost::lexical_cast<double>(results[i + 1]);
-        }
-        vertex_map.push_back(builder.vertexIndex(v));
-      } catch (const boost::bad_lexical_cast& blc) {
-        AsciiError("can't parse vertex");
+  // Vertices are welded up front, in the order they are listed
+  std::vector<Vector3d> points;
+  size_t num_points = 0;
+  for (const auto& chunk : chunks) num_points += chunk.vertices.size();
+  points.reserve(num_points);
+  for (const auto& chunk : chunks) points.insert(points.end(), chunk.vertices.begin(), chunk.vertices.end());
+
+  auto ps = std::make_unique<PolySet>(3);
+  const auto vertex_map = weld_vertices(points, ps->vertices);
+
+  bool is_triangular = true;
+  IndexedFace polygon;
+  size_t line_offset = 0;
+  size_t vertex_offset = 0;
+  for (const auto& chunk : chunks) {
+    for (const auto& line : chunk.lines) {
+      // Line numbers are reported one past the actual line, as they always have been
+      const size_t lineno = line_offset + line.line + 2;
+      using Type = ObjLine::Type;
+      if (line.type == Type::BadVertex) {
+        AsciiError(lineno, line.text, "can't parse vertex");
         return PolySet::createEmpty();
-      }
-    } else if (boost::regex_search(line, results, ex_f) && results.size() >= 2) {
-      std::vector<std::string> words;
-      boost::split(words, results[1], boost::is_any_of(" \t"));
-      builder.beginPolygon(words.size());
-      for (const std::string& word : words) {
-        std::vector<std::string> wordindex;
-        boost::split(wordindex, word, boost::is_any_of("/"));
-        if(wordindex.size() < 1)
-          LOG(message_group::Warning, "Invalid Face index in File %1$s in Line %2$d", filename, lineno);
-        else {
-          int ind=boost::lexical_cast<int>(wordindex[0]);
-          if(ind >= 1 && ind  <= vertex_map.size()) {
-            builder.addVertex(vertex_map[ind-1]);
+      } else if (line.type == Type::BadFace) {
+        AsciiError(lineno, line.text, "can't parse face");
+        return PolySet::createEmpty();
+      } else if (line.type == Type::Unrecognized) {
+        LOG(message_group::Warning, "Unrecognized Line  %1$s in line Line %2$d", std::string(line.text), lineno);
+      } else {
+        // Faces may only refer to vertices listed before them
+        const size_t num_vertices = vertex_offset + line.vertices;
+        polygon.clear();
+        for (size_t i = line.indices_begin; i < line.indices_end; ++i) {
+          const int ind = chunk.indices[i];
+          if (ind >= 1 && ind <= num_vertices) {
+            // Skip consecutive duplicate indices, like PolySetBuilder does
+            const int vertex = vertex_map[ind - 1];
+            if (polygon.empty() || (vertex != polygon.back() && vertex != polygon.front())) {
+              polygon.push_back(vertex);
+            }
           } else {
             LOG(message_group::Warning, "Index %1$d out of range in Line %2$d", filename, lineno);
           }
         }
+        if (polygon.size() >= 3) {
+          if (polygon.size() > 3) is_triangular = false;
+          ps->indices.push_back(polygon);
+        }
       }
-
-    } else if (boost::regex_search(line, results, ex_vt)) { // ignore texture coords
-    } else if (boost::regex_search(line, results, ex_vn)) { // ignore normal coords
-    } else if (boost::regex_search(line, results, ex_mtllib)) { // ignore material lib
-    } else if (boost::regex_search(line, results, ex_usemtl)) { // ignore usemtl
-    } else if (boost::regex_search(line, results, ex_o)) { // ignore object name
-    } else if (boost::regex_search(line, results, ex_s)) { // ignore smooting
-    } else if (boost::regex_search(line, results, ex_g)) { // ignore group name
-    } else {
-      LOG(message_group::Warning, "Unrecognized Line  %1$s in line Line %2$d", line, lineno);
     }
+    line_offset += chunk.num_lines;
+    vertex_offset += chunk.vertices.size();
   }
-  return builder.build();
+  ps->setTriangular(is_triangular);
+  return ps;
 }
@@ -1,37 +1,214 @@
 #include "io/import.h"
+#include "io/MappedFile.h"
+#include "io/importutils.h"
+#include "io/scanutils.h"
 #include "Feature.h"
 #include "geometry/PolySet.h"
+#include "utils/parallel.h"
 #include "utils/printutils.h"
 #include "core/AST.h"
 #include <system_error>
-#include <map>
-#include <ios>
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <charconv>
 #include <cstddef>
-#include <fstream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
-#include <boost/regex.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/algorithm/string.hpp>
-#include <boost/algorithm/string/split.hpp>
 
 // References:
 // http://www.geomview.org/docs/html/OFF.html
 
-std::unique_ptr<PolySet> import_off(const std::string& filename, const Location& loc)
+namespace {
+
+// The body is scanned in chunks of roughly this many bytes in parallel
+constexpr size_t OFF_CHUNK_NUMBYTES = 4ul << 20;
+// Vertex and face lines are parsed in batches of this many lines in parallel
+constexpr size_t OFF_BATCH_LINES = 16384;
+
+// Reads lines like std::getline() on a std::ifstream, including when it sets eof
+class OffLineReader
+{
+public:
+  OffLineReader(const char *begin, const char *end) : pos(begin), end(end) {}
+
+  [[nodiscard]] bool eof() const { return is_eof; }
+  [[nodiscard]] const char *position() const { return pos; }
+
+  std::string_view getline()
+  {
+    if (pos == end) {
+      is_eof = true;
+      return {};
+    }
+    const char *line_end = std::find(pos, end, '\n');
+    const std::string_view line(pos, line_end - pos);
+    if (line_end == end) {
+      is_eof = true;
+      pos = end;
+    } else {
+      pos = line_end + 1;
+    }
+    return line;
+  }
+
+private:
+  const char *pos;
+  const char *end;
+  bool is_eof{false};
+};
+
+// Strips comments, DOS line endings and surrounding whitespace
+std::string_view cleanLine(std::string_view line)
+{
+  return scan_trim(line.substr(0, line.find('#')));
+}
+
+// Splits like boost::split() on spaces and tabs with token_compress_on
+void splitWords(std::string_view line, std::vector<std::string_view>& words)
+{
+  words.clear();
+  size_t begin = 0;
+  while (true) {
+    const size_t end = line.find_first_of(" \t", begin);
+    if (end == std::string_view::npos) {
+      words.push_back(line.substr(begin));
+      return;
+    }
+    words.push_back(line.substr(begin, end - begin));
+    begin = line.find_first_not_of(" \t", end);
+    if (begin == std::string_view::npos) {
+      words.emplace_back();
+      return;
+    }
+  }
+}
+
+// A line which isn't empty after cleaning
+struct OffLine {
+  std::string_view text;
+  size_t line; // line index in the chunk, or in the body once chunks are merged
+};
+
+struct OffChunk {
+  std::vector<OffLine> lines;
+  size_t num_lines = 0;
+};
+
+OffChunk scanOffChunk(const char *begin, const char *end)
 {
-  boost::regex ex_magic(R"(^(ST)?(C)?(N)?(4)?(n)?OFF( BINARY)? *)");
-  // XXX: are ST C N always in order?
-  boost::regex ex_cr(R"(\r$)");
-  boost::regex ex_comment(R"(\s*#.*$)");
-  boost::smatch results;
+  OffChunk chunk;
+  for (; begin < end; ++chunk.num_lines) {
+    const char *line_end = std::find(begin, end, '\n');
+    const auto text = cleanLine(std::string_view(begin, line_end - begin));
+    begin = line_end == end ? end : line_end + 1;
+    if (!text.empty()) chunk.lines.push_back({text, chunk.num_lines});
+  }
+  return chunk;
+}
+
+enum class OffVertexStatus : uint8_t { Ok, NotEnoughData, BadData };
 
-  std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary);
+struct OffFace {
+  IndexedFace indices;
+  std::vector<std::string> errors; // logged in order, the last one ends the import if fatal is set
+  bool fatal = false;
+  bool has_color = false;
+  Color4f color;
+};
 
-  int lineno = 0;
+// Returns false if word is not a number
+bool getcolor(std::string_view word, OffFace& face, int& c)
+{
+  if (word.find('.') != std::string_view::npos) {
+    float f;
+#ifdef __cpp_lib_to_chars
+    auto result = std::from_chars(word.data(), word.data() + word.length(), f);
+    if (result.ec != std::errc{}) {
+      face.errors.emplace_back("Parse error");
+      c = 0;
+      return true;
+    }
+#else
+    // fall back for pre C++17
+    std::istringstream istr{std::string(word)};
+    istr.imbue(std::locale("C"));
+    istr >> f;
+    if (istr.peek() != EOF) {
+      face.errors.emplace_back("Parse error");
+      c = 0;
+      return true;
+    }
+#endif
+    c = (int)(f * 255);
+    return true;
+  }
+  return scan_int(word, c);
+}
+
+OffFace parseFace(std::string_view text, unsigned long vertices_count, std::vector<std::string_view>& words)
+{
+  OffFace face;
+  auto fail = [&face](const char *errstr) {
+    face.errors.emplace_back(errstr);
+    face.fatal = true;
+    return std::move(face);
+  };
+
+  splitWords(text, words);
+  unsigned long face_size;
+  if (!scan_int(words[0], face_size)) return fail("can't parse face: bad data");
+  if (words.size() - 1 < face_size) return fail("can't parse face: missing indices");
+  face.indices.reserve(face_size);
+  unsigned long i;
+  for (i = 0; i < face_size; i++) {
+    int ind;
+    if (!scan_int(words[i + 1], ind)) return fail("can't parse face: bad data");
+    if (ind >= 0 && ind < vertices_count) {
+      face.indices.push_back(ind);
+    } else {
+      face.errors.push_back((boost::format("ignored bad face vertex index: %d") % ind).str());
+    }
+  }
+  if (words.size() >= face_size + 4) {
+    i = face_size + 1;
+    // handle optional color info (r g b [a])
+    int r, g, b, a = 255;
+    if (!getcolor(words[i++], face, r) || !getcolor(words[i++], face, g) || !getcolor(words[i++], face, b) ||
+        (i < words.size() && !getcolor(words[i++], face, a))) {
+      return fail("can't parse face: bad data");
+    }
+    face.color = Color4f(r, g, b, a);
+    face.has_color = true;
+  }
+  return face;
+}
+
+/*!
+   Calls op(begin, end, words) for batches of [0, count) in parallel, with a
+   reusable buffer for splitting lines into words.
+ */
+template <typename Op>
+void forEachBatch(size_t count, const Op& op)
+{
+  std::vector<size_t> batches;
+  for (size_t begin = 0; begin < count; begin += OFF_BATCH_LINES) batches.push_back(begin);
+  parallelizable_for_each(batches.begin(), batches.end(), [&](size_t begin) {
+    std::vector<std::string_view> words;
+    op(begin, std::min(begin + OFF_BATCH_LINES, count), words);
+  });
+}
+
+} // namespace
+
+std::unique_ptr<PolySet> import_off(const std::string& filename, const Location& loc)
+{
+  const MappedFile file(filename);
+  OffLineReader reader(file.begin(), file.end());
+
+  size_t lineno = 0;
   std::string line;
 
   auto AsciiError = [&](const auto& errstr){
@@ -43,59 +220,23 @@ std::unique_ptr<PolySet> import_off(const std::string& filename, const Location&
   auto getline_clean = [&](const auto& errstr){
     do {
       lineno++;
-      std::getline(f, line);
-      if (line.empty() && f.eof()) {
+      const auto raw = reader.getline();
+      if (raw.empty() && reader.eof()) {
+        line.clear();
         AsciiError(errstr);
         return false;
       }
-      // strip DOS line endings
-      if (boost::regex_search(line, results, ex_cr)) {
-        line = line.erase(results.position(), results[0].length());
-      }
-      // strip comments
-      if (boost::regex_search(line, results, ex_comment)) {
-        line = line.erase(results.position(), results[0].length());
-      }
-      boost::trim(line);
+      line = std::string(cleanLine(raw));
     } while (line.empty());
 
     return true;
   };
 
-  auto getcolor = [&](const auto& word){
-    int c;
-    if (boost::contains(word, ".")) {
-      float f;
-#ifdef __cpp_lib_to_chars
-      auto result = std::from_chars(word.data(), word.data() + word.length(), f);
-      if (result.ec != std::errc{}) {
-        AsciiError("Parse error");
-        return 0;
-      }
-#else
-      // fall back for pre C++17
-      std::istringstream istr(word);
-      istr.imbue(std::locale("C"));
-      istr >> f;
-      if (istr.peek() != EOF) {
-        AsciiError("Parse error");
-        return 0;
-      }
-#endif
-      c = (int)(f * 255);
-    } else {
-      c = boost::lexical_cast<int>(word);
-    }
-    return c;
-  };
-
-
-  if (!f.good()) {
+  if (!file.isOpen()) {
     AsciiError("File error");
     return PolySet::createEmpty();
   }
 
-  bool got_magic = false;
   // defaults
   bool has_normals = false;
   bool has_color = false;
@@ -108,17 +249,29 @@ std::unique_ptr<PolySet> import_off(const std::string& filename, const Location&
       return PolySet::createEmpty();
   }
 
-  if (boost::regex_search(line, results, ex_magic) > 0) {
-    got_magic = true;
-    // Remove the matched part, we might have numbers next.
-    line = line.erase(0, results[0].length());
-    has_normals = results[3].matched;
-    has_color = results[2].matched;
-    has_textures = results[1].matched;
-    is_binary = results[6].matched;
-    if (results[4].matched)
-      dimension = 4;
-    has_ndim = results[5].matched;
+  {
+    // Magic: (ST)?(C)?(N)?(4)?(n)?OFF( BINARY)? *
+    // XXX: are ST C N always in order?
+    std::string_view magic = line;
+    auto consume = [&magic](std::string_view prefix) {
+      if (!scan_starts_with(magic, prefix)) return false;
+      magic.remove_prefix(prefix.size());
+      return true;
+    };
+    has_textures = consume("ST");
+    has_color = consume("C");
+    has_normals = consume("N");
+    if (consume("4")) dimension = 4;
+    has_ndim = consume("n");
+    if (consume("OFF")) {
+      is_binary = consume(" BINARY");
+      while (consume(" ")) {}
+      // Remove the matched part, we might have numbers next.
+      line.erase(0, line.size() - magic.size());
+    } else {
+      has_textures = has_color = has_normals = has_ndim = false;
+      dimension = 3;
+    }
   }
 
   // TODO: handle binary format
@@ -127,24 +280,25 @@ std::unique_ptr<PolySet> import_off(const std::string& filename, const Location&
     return PolySet::createEmpty();
   }
 
-  std::vector<std::string> words;
+  std::vector<std::string_view> words;
 
   if (has_ndim) {
     if (line.empty() && !getline_clean("bad header: end of file")) {
         return PolySet::createEmpty();
     }
-    boost::split(words, line, boost::is_any_of(" \t"), boost::token_compress_on);
-    if (f.eof() || words.size() < 1) {
+    splitWords(line, words);
+    if (reader.eof() || words.size() < 1) {
       AsciiError("bad header: missing Ndim");
       return PolySet::createEmpty();
     }
-    line = line.erase(0, words[0].length() + ((words.size() > 1) ? 1 : 0));
-    try {
-      dimension = boost::lexical_cast<unsigned int>(words[0]) + dimension - 3;
-    } catch (const boost::bad_lexical_cast& blc) {
+    const std::string ndim(words[0]);
+    line = line.erase(0, ndim.length() + ((words.size() > 1) ? 1 : 0));
+    unsigned int n;
+    if (!scan_int(ndim, n)) {
       AsciiError("bad header: bad data for Ndim");
       return PolySet::createEmpty();
     }
+    dimension = n + dimension - 3;
   }
 
   PRINTDB("Header flags: N:%d C:%d ST:%d Ndim:%d B:%d", has_normals % has_color % has_textures % dimension % is_binary);
@@ -158,8 +312,8 @@ std::unique_ptr<PolySet> import_off(const std::string& filename, const Location&
       return PolySet::createEmpty();
   }
 
-  boost::split(words, line, boost::is_any_of(" \t"), boost::token_compress_on);
-  if (f.eof() || words.size() < 3) {
+  splitWords(line, words);
+  if (reader.eof() || words.size() < 3) {
     AsciiError("bad header: missing data");
     return PolySet::createEmpty();
   }
@@ -167,116 +321,113 @@ std::unique_ptr<PolySet> import_off(const std::string& filename, const Location&
   unsigned long vertices_count;
   unsigned long faces_count;
   unsigned long edges_count;
-  unsigned long vertex = 0;
-  unsigned long face = 0;
-  try {
-    vertices_count = boost::lexical_cast<unsigned long>(words[0]);
-    faces_count = boost::lexical_cast<unsigned long>(words[1]);
-    edges_count = boost::lexical_cast<unsigned long>(words[2]);
-    (void)edges_count; // ignored
-  } catch (const boost::bad_lexical_cast& blc) {
+  if (!scan_int(words[0], vertices_count) || !scan_int(words[1], faces_count) ||
+      !scan_int(words[2], edges_count)) { // edges are ignored
     AsciiError("bad header: bad data");
     return PolySet::createEmpty();
   }
 
-  if (f.eof() || vertices_count < 1 || faces_count < 1) {
+  if (reader.eof() || vertices_count < 1 || faces_count < 1) {
     AsciiError("bad header: not enough data");
     return PolySet::createEmpty();
   }
 
   PRINTDB("%d vertices, %d faces, %d edges.", vertices_count % faces_count % edges_count);
 
-  auto ps = PolySet::createEmpty();
-  ps->vertices.reserve(vertices_count);
-  ps->indices.reserve(faces_count);
+  // The rest of the file is cleaned and parsed in parallel, then checked in
+  // order, with the same results as reading it line by line
+  const char *body = reader.position();
+  const size_t body_lineno = lineno;
+  const auto ranges = split_line_chunks(body, file.end(), OFF_CHUNK_NUMBYTES);
+  std::vector<OffChunk> chunks(ranges.size());
+  parallelizable_transform(ranges.begin(), ranges.end(), chunks.begin(), [](const auto& range) {
+    return scanOffChunk(range.first, range.second);
+  });
+  std::vector<OffLine> lines;
+  size_t body_lines = 0;
+  for (const auto& chunk : chunks) {
+    for (const auto& l : chunk.lines) lines.push_back({l.text, body_lines + l.line});
+    body_lines += chunk.num_lines;
+  }
+  chunks.clear();
+  // Reading the last line sets eof if it has no line break
+  const bool unterminated = body != file.end() && file.end()[-1] != '\n';
+  auto is_last_line = [&](size_t i) { return unterminated && lines[i].line + 1 == body_lines; };
+
+  const size_t vertex_lines = std::min<size_t>(vertices_count, lines.size());
+  std::vector<Vector3d> vertices(vertex_lines);
+  std::vector<OffVertexStatus> vertex_status(vertex_lines);
+  forEachBatch(vertex_lines, [&](size_t begin, size_t end, auto& words) {
+    for (size_t i = begin; i < end; ++i) {
+      splitWords(lines[i].text, words);
+      if (words.size() < 3) {
+        vertex_status[i] = OffVertexStatus::NotEnoughData;
+        continue;
+      }
+      auto& v = vertices[i];
+      const bool ok = scan_double(words[0], v[0]) && scan_double(words[1], v[1]) && scan_double(words[2], v[2]);
+      vertex_status[i] = ok ? OffVertexStatus::Ok : OffVertexStatus::BadData;
+      // TODO: normals, colors (Meshlab appends color there, probably to allow gradients) and textures
+    }
+  });
 
-  while ((!f.eof()) && (vertex++ < vertices_count)) {
-    if (!getline_clean("reading vertices: end of file")) {
-      return PolySet::createEmpty();
+  const size_t face_lines = std::min<size_t>(faces_count, lines.size() - vertex_lines);
+  std::vector<OffFace> faces(face_lines);
+  forEachBatch(face_lines, [&](size_t begin, size_t end, auto& words) {
+    for (size_t i = begin; i < end; ++i) {
+      faces[i] = parseFace(lines[vertex_lines + i].text, vertices_count, words);
     }
+  });
 
-    boost::split(words, line, boost::is_any_of(" \t"), boost::token_compress_on);
-    if (words.size() < 3) {
-      AsciiError("can't parse vertex: not enough data");
+  auto set_line = [&](size_t i) {
+    lineno = body_lineno + lines[i].line + 1;
+    line = std::string(lines[i].text);
+  };
+  auto end_of_file = [&](const char *errstr) {
+    lineno = body_lineno + body_lines + 1;
+    line.clear();
+    AsciiError(errstr);
+  };
+
+  auto ps = PolySet::createEmpty();
+  ps->vertices.reserve(vertex_lines);
+  ps->indices.reserve(face_lines);
+
+  size_t next = 0;
+  bool eof = false;
+  for (unsigned long vertex = 0; !eof && vertex < vertices_count; ++vertex, ++next) {
+    if (next == lines.size()) {
+      end_of_file("reading vertices: end of file");
       return PolySet::createEmpty();
     }
-
-    try {
-      Vector3d v = {0, 0, 0};
-      int i;
-      for (i = 0; i < dimension; i++) {
-        v[i]= boost::lexical_cast<double>(words[i]);
-      }
-      //PRINTDB("Vertex[%ld] = { %f, %f, %f }", vertex % v[0] % v[1] % v[2]);
-      if (has_normals) {
-        ; // TODO words[i++]
-        i += 0;
-      }
-      if (has_color) {
-        ; // TODO: Meshlab appends color there, probably to allow gradients
-        i += 3; // 4?
-      }
-      if (has_textures) {
-        ; // TODO words[i++]
-      }
-      ps->vertices.push_back(v);
-    } catch (const boost::bad_lexical_cast& blc) {
-      AsciiError("can't parse vertex: bad data");
+    eof = is_last_line(next);
+    if (vertex_status[next] != OffVertexStatus::Ok) {
+      set_line(next);
+      AsciiError(vertex_status[next] == OffVertexStatus::NotEnoughData ?
+                 "can't parse vertex: not enough data" : "can't parse vertex: bad data");
       return PolySet::createEmpty();
     }
+    ps->vertices.push_back(vertices[next]);
   }
 
-  auto logged_color_warning = false;
-
-  while (!f.eof() && (face++ < faces_count)) {
-    if (!getline_clean("reading faces: end of file")) {
+  for (unsigned long face = 0; !eof && face < faces_count; ++face, ++next) {
+    if (next == lines.size()) {
+      end_of_file("reading faces: end of file");
       return PolySet::createEmpty();
     }
-
-    boost::split(words, line, boost::is_any_of(" \t"), boost::token_compress_on);
-    if (words.size() < 1) {
-      AsciiError("can't parse face: not enough data");
-      return PolySet::createEmpty();
+    eof = is_last_line(next);
+    auto& f = faces[next - vertex_lines];
+    if (!f.errors.empty()) {
+      set_line(next);
+      for (const auto& errstr : f.errors) AsciiError(errstr);
+      if (f.fatal) return PolySet::createEmpty();
     }
-
-    std::map<Color4f, int32_t> color_indices;
-    try {
-      unsigned long face_size=boost::lexical_cast<unsigned long>(words[0]);
-      unsigned long i;
-      if (words.size() - 1 < face_size) {
-        AsciiError("can't parse face: missing indices");
-        return PolySet::createEmpty();
-      }
-      size_t face_idx = ps->indices.size();
-      ps->indices.emplace_back().reserve(face_size);
-      //PRINTDB("Index[%d] [%d] = { ", face % n);
-      for (i = 0; i < face_size; i++) {
-        int ind=boost::lexical_cast<int>(words[i+1]);
-        //PRINTDB("%d, ", ind);
-        if (ind >= 0 && ind < vertices_count) {
-          ps->indices.back().push_back(ind);
-        } else {
-          AsciiError((boost::format("ignored bad face vertex index: %d") % ind).str().c_str());
-        }
-      }
-      //PRINTD("}");
-      if (words.size() >= face_size + 4) {
-        i = face_size + 1;
-        // handle optional color info (r g b [a])
-        int r=getcolor(words[i++]);
-        int g=getcolor(words[i++]);
-        int b=getcolor(words[i++]);
-        int a=i < words.size() ? getcolor(words[i++]) : 255;
-        Color4f color(r, g, b, a);
-
-        auto iter_pair = color_indices.insert_or_assign(color, ps->colors.size());
-        if (iter_pair.second) ps->colors.push_back(color); // inserted
-        ps->color_indices.resize(face_idx, -1);
-        ps->color_indices.push_back(iter_pair.first->second);
-      }
-    } catch (const boost::bad_lexical_cast& blc) {
-      AsciiError("can't parse face: bad data");
-      return PolySet::createEmpty();
+    const size_t face_idx = ps->indices.size();
+    ps->indices.push_back(std::move(f.indices));
+    if (f.has_color) {
+      ps->color_indices.resize(face_idx, -1);
+      ps->color_indices.push_back(ps->colors.size());
+      ps->colors.push_back(f.color);
     }
   }
   if (!ps->color_indices.empty()) {
@@ -0,0 +1,212 @@
+#include "io/import.h"
+#include "io/MappedFile.h"
+#include "io/osgeo.h"
+#include "geometry/Geometry.h"
+#include "geometry/PolySet.h"
+#include "geometry/Polygon2d.h"
+#include "utils/parallel.h"
+#include "utils/printutils.h"
+#include "core/AST.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+static_assert(sizeof(Vector3d) == 3 * sizeof(double));
+static_assert(sizeof(Vector2d) == 2 * sizeof(double));
+static_assert(sizeof(Color4f) == 4 * sizeof(float));
+
+// Faces are built and checked in parallel chunks of this many faces
+constexpr size_t FACE_CHUNK_SIZE = 1ul << 16;
+// Guards against running out of stack on corrupt files
+constexpr int MAX_LIST_DEPTH = 1000;
+
+class OsgeoError : public std::runtime_error
+{
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/*!
+   Reads the records of a memory mapped .osgeo file.
+
+   Arrays are used in place from the mapping, and copied into the geometry with
+   a single bulk copy each, rather than parsed element by element. All sizes
+   and indices are checked, so corrupt files fail with an OsgeoError.
+ */
+class OsgeoReader
+{
+public:
+  OsgeoReader(const char *begin, const char *end) : begin(begin), pos(begin), end(end) {}
+
+  void readHeader() {
+    const auto header = readStruct<osgeo::FileHeader>();
+    if (!std::equal(std::begin(osgeo::MAGIC), std::end(osgeo::MAGIC), header.magic)) {
+      throw OsgeoError("not an OpenSCAD geometry file");
+    }
+    if (header.byte_order != osgeo::BYTE_ORDER_MARK) {
+      throw OsgeoError("written on a machine with a different byte order");
+    }
+    if (header.version != osgeo::VERSION) {
+      throw OsgeoError("unsupported version " + std::to_string(header.version));
+    }
+  }
+
+  std::unique_ptr<Geometry> readGeometry(int depth = 0) {
+    const auto header = readStruct<osgeo::RecordHeader>();
+    std::unique_ptr<Geometry> geom;
+    switch (header.type) {
+    case osgeo::RecordType::Empty:
+      geom = PolySet::createEmpty();
+      break;
+    case osgeo::RecordType::List:
+      if (depth >= MAX_LIST_DEPTH) throw OsgeoError("lists nested too deeply");
+      geom = readList(depth);
+      break;
+    case osgeo::RecordType::PolySet:
+      geom = readPolySet();
+      break;
+    case osgeo::RecordType::Polygon2d:
+      geom = readPolygon2d();
+      break;
+    default:
+      throw OsgeoError("unknown record type " + std::to_string(static_cast<uint32_t>(header.type)));
+    }
+    geom->setConvexity(header.convexity);
+    return geom;
+  }
+
+  [[nodiscard]] bool atEnd() const { return pos == end; }
+
+private:
+  std::unique_ptr<Geometry> readList(int depth) {
+    const auto record = readStruct<osgeo::ListRecord>();
+    Geometry::Geometries children;
+    for (uint64_t i = 0; i < record.count; ++i) {
+      children.emplace_back(nullptr, readGeometry(depth + 1));
+    }
+    return std::make_unique<GeometryList>(children);
+  }
+
+  std::unique_ptr<Geometry> readPolySet() {
+    const auto record = readStruct<osgeo::PolySetRecord>();
+    if (record.dim != 2 && record.dim != 3) throw OsgeoError("invalid PolySet dimension");
+    // Every face takes some space in the file, which bounds the allocations below
+    if (record.num_faces > static_cast<uint64_t>(end - pos)) throw OsgeoError("unexpected end of file");
+    const boost::tribool convex = record.convex == 0 ? boost::tribool(false) :
+                                  record.convex == 1 ? boost::tribool(true) : boost::tribool(unknown);
+    auto ps = std::make_unique<PolySet>(record.dim, convex);
+    ps->setTriangular(record.triangular);
+
+    const auto vertices = readArray<Vector3d>(record.num_vertices);
+    ps->vertices.assign(vertices, vertices + record.num_vertices);
+
+    const uint64_t *offsets = nullptr;
+    if (!record.triangular) {
+      offsets = readArray<uint64_t>(record.num_faces + 1);
+    } else if (record.num_indices != 3 * record.num_faces) {
+      throw OsgeoError("triangular PolySet with non-triangle faces");
+    }
+    const auto indices = readArray<int32_t>(record.num_indices);
+    const int32_t *color_indices = record.has_color_indices ? readArray<int32_t>(record.num_faces) : nullptr;
+    const auto colors = readArray<Color4f>(record.num_colors);
+    ps->colors.assign(colors, colors + record.num_colors);
+
+    std::vector<size_t> chunks;
+    for (size_t begin = 0; begin < record.num_faces; begin += FACE_CHUNK_SIZE) chunks.push_back(begin);
+    std::vector<char> chunk_ok(chunks.size());
+    ps->indices.resize(record.num_faces);
+    if (color_indices) ps->color_indices.resize(record.num_faces);
+    parallelizable_transform(chunks.begin(), chunks.end(), chunk_ok.begin(), [&](size_t begin) -> char {
+      const size_t chunk_end = std::min<size_t>(begin + FACE_CHUNK_SIZE, record.num_faces);
+      for (size_t i = begin; i < chunk_end; ++i) {
+        const uint64_t face_begin = offsets ? offsets[i] : 3 * i;
+        const uint64_t face_end = offsets ? offsets[i + 1] : 3 * i + 3;
+        if (face_begin > face_end || face_end > record.num_indices) return false;
+        for (uint64_t j = face_begin; j < face_end; ++j) {
+          if (indices[j] < 0 || static_cast<uint64_t>(indices[j]) >= record.num_vertices) return false;
+        }
+        ps->indices[i].assign(indices + face_begin, indices + face_end);
+        if (color_indices) {
+          const auto color_index = color_indices[i];
+          if (color_index < -1 || color_index >= static_cast<int64_t>(record.num_colors)) return false;
+          ps->color_indices[i] = color_index;
+        }
+      }
+      return true;
+    });
+    if (!std::all_of(chunk_ok.begin(), chunk_ok.end(), [](char ok) { return ok; })) {
+      throw OsgeoError("invalid PolySet face");
+    }
+    return ps;
+  }
+
+  std::unique_ptr<Geometry> readPolygon2d() {
+    const auto record = readStruct<osgeo::Polygon2dRecord>();
+    const auto outlines = readArray<osgeo::OutlineRecord>(record.num_outlines);
+    auto poly = std::make_unique<Polygon2d>();
+    for (uint64_t i = 0; i < record.num_outlines; ++i) {
+      Outline2d outline;
+      const auto vertices = readArray<Vector2d>(outlines[i].num_vertices);
+      outline.vertices.assign(vertices, vertices + outlines[i].num_vertices);
+      outline.positive = outlines[i].positive;
+      poly->addOutline(std::move(outline));
+    }
+    poly->setSanitized(record.sanitized);
+    return poly;
+  }
+
+  template <typename T>
+  T readStruct() {
+    T value;
+    std::memcpy(&value, readArray<T>(1), sizeof(T));
+    return value;
+  }
+
+  // Returns count items in place, skipping the padding after them
+  template <typename T>
+  const T *readArray(uint64_t count) {
+    const uint64_t available = end - pos;
+    if (count > available / sizeof(T)) throw OsgeoError("unexpected end of file");
+    const auto data = reinterpret_cast<const T *>(pos);
+    const uint64_t size = count * sizeof(T);
+    const uint64_t padding = (osgeo::ALIGNMENT - (pos - begin + size) % osgeo::ALIGNMENT) % osgeo::ALIGNMENT;
+    pos += std::min(size + padding, available);
+    return data;
+  }
+
+  const char *begin;
+  const char *pos;
+  const char *end;
+};
+
+} // namespace
+
+std::unique_ptr<Geometry> import_osgeo(const std::string& filename, const Location& loc)
+{
+  const MappedFile file(filename);
+  if (!file.isOpen()) {
+    LOG(message_group::Warning,
+        "Can't open import file '%1$s', import() at line %2$d",
+        filename, loc.firstLine());
+    return PolySet::createEmpty();
+  }
+
+  try {
+    OsgeoReader reader(file.begin(), file.end());
+    reader.readHeader();
+    auto geom = reader.readGeometry();
+    if (!reader.atEnd()) throw OsgeoError("trailing data");
+    return geom;
+  } catch (const OsgeoError& e) {
+    LOG(message_group::Error, loc, "", "Invalid geometry file '%1$s': %2$s", filename, e.what());
+    return PolySet::createEmpty();
+  }
+}
@@ -1,20 +1,23 @@
 #include "io/import.h"
+#include "io/MappedFile.h"
+#include "io/importutils.h"
+#include "io/scanutils.h"
 #include "geometry/PolySet.h"
-#include "geometry/PolySetBuilder.h"
+#include "utils/parallel.h"
 #include "utils/printutils.h"
 #include "core/AST.h"
 
+#include <algorithm>
 #include <array>
-#include <ios>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <cstddef>
-#include <fstream>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 #include <boost/predef.h>
-#include <boost/regex.hpp>
-#include <boost/lexical_cast.hpp>
-#include <boost/algorithm/string.hpp>
 
 #if !defined(BOOST_ENDIAN_BIG_BYTE_AVAILABLE) && !defined(BOOST_ENDIAN_LITTLE_BYTE_AVAILABLE)
 #error Byte order undefined or unknown. Currently only BOOST_ENDIAN_BIG_BYTE and BOOST_ENDIAN_LITTLE_BYTE are supported.
@@ -57,11 +60,8 @@ static void uint32_byte_swap(uint32_t& x) {
 }
 #endif // if BOOST_ENDIAN_BIG_BYTE
 
-static void read_stl_facet(std::ifstream& f, stl_facet& facet) {
-  f.read((char *)facet.data8, STL_FACET_NUMBYTES);
-  if (static_cast<size_t>(f.gcount()) < STL_FACET_NUMBYTES) {
-    throw std::ios_base::failure("facet data truncated");
-  }
+static void read_stl_facet(const char *data, stl_facet& facet) {
+  memcpy(facet.data8, data, STL_FACET_NUMBYTES);
 #if BOOST_ENDIAN_BIG_BYTE
   for (int i = 0; i < 12; ++i) {
     uint32_byte_swap(facet.data8 + i * 4);
@@ -70,135 +70,206 @@ static void read_stl_facet(std::ifstream& f, stl_facet& facet) {
 #endif
 }
 
+namespace {
+
+constexpr size_t STL_HEADER_NUMBYTES = 80ul + 4ul;
+// Binary facets are converted in chunks of this many facets in parallel
+constexpr size_t STL_BINARY_CHUNK_FACETS = 65536;
+// ASCII files are scanned in chunks of roughly this many bytes in parallel
+constexpr size_t STL_ASCII_CHUNK_NUMBYTES = 4ul << 20;
+
+/*!
+   Builds a PolySet from a triangle soup, welding identical vertices.
+   Degenerate triangles are dropped, so the result is identical to adding the
+   triangles one by one through PolySetBuilder.
+ */
+std::unique_ptr<PolySet> createPolySetFromTriangles(const std::vector<Vector3d>& corners)
+{
+  auto ps = std::make_unique<PolySet>(3);
+  const auto corner_vertex = weld_vertices(corners, ps->vertices);
+
+  ps->indices.reserve(corners.size() / 3);
+  for (size_t c = 0; c + 2 < corners.size(); c += 3) {
+    const int a = corner_vertex[c];
+    const int b = corner_vertex[c + 1];
+    const int d = corner_vertex[c + 2];
+    if (a != b && b != d && d != a) {
+      ps->indices.push_back({a, b, d});
+    }
+  }
+  ps->setTriangular(true);
+  return ps;
+}
+
+// The lines of an ASCII STL file which affect parsing, in file order
+struct AsciiStlLine {
+  enum class Type { OuterLoop, EndLoop, EndSolid, Vertex, BadVertex, Other };
+  Type type;
+  const char *begin; // start of the line in the file
+  size_t line; // line number, counted from the start of the chunk
+};
+
+struct AsciiStlChunk {
+  std::vector<AsciiStlLine> lines;
+  std::vector<Vector3d> vertices; // one per Vertex line
+  size_t newlines{0};
+};
+
+/*!
+   Classifies the lines of a chunk of an ASCII STL file, parsing vertex
+   coordinates. Empty lines and "solid", "facet" and "endfacet" lines are
+   skipped.
+ */
+AsciiStlChunk scanAsciiStlChunk(const char *begin, const char *end)
+{
+  AsciiStlChunk chunk;
+  while (begin < end) {
+    const char *line_end = std::find(begin, end, '\n');
+    const auto line = scan_trim(std::string_view(begin, line_end - begin));
+    const char *line_begin = begin;
+    const size_t line_number = chunk.newlines;
+    begin = line_end == end ? end : line_end + 1;
+    if (line_end != end) ++chunk.newlines;
+
+    using Type = AsciiStlLine::Type;
+    if (line.empty() || scan_starts_with(line, "solid") ||
+        scan_starts_with(line, "facet") || scan_starts_with(line, "endfacet")) {
+      continue;
+    } else if (line == "outer loop") {
+      chunk.lines.push_back({Type::OuterLoop, line_begin, line_number});
+    } else if (line == "endloop") {
+      chunk.lines.push_back({Type::EndLoop, line_begin, line_number});
+    } else if (scan_starts_with(line, "endsolid")) {
+      chunk.lines.push_back({Type::EndSolid, line_begin, line_number});
+    } else if (scan_starts_with(line, "vertex") && line.size() > 6 && scan_is_space(line[6])) {
+      auto rest = line.substr(6);
+      const std::array<std::string_view, 3> tokens{scan_token(rest), scan_token(rest), scan_token(rest)};
+      if (tokens[2].empty() || !scan_trim(rest).empty()) {
+        // Not three coordinates: not a vertex line
+        chunk.lines.push_back({Type::Other, line_begin, line_number});
+        continue;
+      }
+      Vector3d v;
+      bool ok = true;
+      for (int i = 0; i < 3; ++i) ok = ok && scan_double(tokens[i], v[i]);
+      if (ok) {
+        chunk.lines.push_back({Type::Vertex, line_begin, line_number});
+        chunk.vertices.push_back(v);
+      } else {
+        chunk.lines.push_back({Type::BadVertex, line_begin, line_number});
+      }
+    } else {
+      chunk.lines.push_back({Type::Other, line_begin, line_number});
+    }
+  }
+  return chunk;
+}
+
+} // namespace
+
 std::unique_ptr<PolySet> import_stl(const std::string& filename, const Location& loc) {
-  // Open file and position at the end
-  std::ifstream f(filename.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
-  if (!f.good()) {
+  const MappedFile file(filename);
+  if (!file.isOpen()) {
     LOG(message_group::Warning,
         "Can't open import file '%1$s', import() at line %2$d",
         filename, loc.firstLine());
     return PolySet::createEmpty();
   }
 
-  uint32_t facenum = 0;
-  boost::regex ex_sfe(R"(^\s*solid|^\s*facet|^\s*endfacet)");
-  boost::regex ex_outer("^\\s*outer loop$");
-  boost::regex ex_loopend("^\\s*endloop$");
-  boost::regex ex_vertex("^\\s*vertex");
-  boost::regex ex_vertices(
-    R"(^\s*vertex\s+([^\s]+)\s+([^\s]+)\s+([^\s]+)\s*$)");
-  boost::regex ex_endsolid("^\\s*endsolid");
-
   bool binary = false;
-  std::streampos file_size = f.tellg();
-  f.seekg(80);
-  if (f.good() && !f.eof()) {
-    f.read((char *)&facenum, sizeof(uint32_t));
+  uint32_t facenum = 0;
+  if (file.size() >= STL_HEADER_NUMBYTES) {
+    memcpy(&facenum, file.data() + 80, sizeof(uint32_t));
 #if BOOST_ENDIAN_BIG_BYTE
     uint32_byte_swap(facenum);
 #endif
-    if (file_size == static_cast<std::streamoff>(80ul + 4ul + 50ul * facenum)) {
+    if (file.size() == STL_HEADER_NUMBYTES + STL_FACET_NUMBYTES * facenum) {
       binary = true;
     }
   }
-  if(!binary) facenum=0;
-  PolySetBuilder builder(0, facenum);
-  f.seekg(0);
 
-  char data[5];
-  f.read(data, 5);
-  if (!binary && !f.eof() && f.good() && !memcmp(data, "solid", 5)) {
-    int i = 0;
-    int lineno = 1;
-    std::array<std::array<double, 3>, 3> vdata;
-    std::string line;
+  std::vector<Vector3d> corners;
+  if (!binary && file.size() >= 5 && !memcmp(file.data(), "solid", 5)) {
+    const char *body = std::find(file.begin(), file.end(), '\n');
+    // Line numbers are counted on from the first line after the header
+    size_t chunk_lineno = 1;
+    if (body != file.end()) {
+      ++body;
+      ++chunk_lineno;
+    }
 
-    auto AsciiError = [&](const auto& errstr){
+    auto AsciiError = [&](const char *line_begin, size_t lineno, const auto& errstr) {
+        const char *line_end = std::find(line_begin, file.end(), '\n');
+        const auto line = scan_trim(std::string_view(line_begin, line_end - line_begin));
         LOG(message_group::Error, loc, "",
             "STL line %1$s, %2$s line '%3$s' importing file '%4$s'",
-            lineno, errstr, line, filename);
+            lineno, errstr, std::string(line), filename);
       };
 
-    std::getline(f, line);
-    bool reached_end = false;
-    while (!f.eof()) {
-      lineno++;
-      std::getline(f, line);
-      boost::trim(line);
-      boost::smatch results;
+    const auto ranges = split_line_chunks(body, file.end(), STL_ASCII_CHUNK_NUMBYTES);
+    std::vector<AsciiStlChunk> chunks(ranges.size());
+    parallelizable_transform(ranges.begin(), ranges.end(), chunks.begin(), [](const auto& range) {
+      return scanAsciiStlChunk(range.first, range.second);
+    });
 
-      if (line.length() == 0 || boost::regex_search(line, ex_sfe)) {
-        continue;
-      } else if (boost::regex_search(line, ex_outer)) {
-        i = 0;
-        continue;
-      } else if (boost::regex_search(line, ex_loopend)) {
-        if (i < 3) {
-          AsciiError("missing vertex");
-        }
-        continue;
-      } else if (boost::regex_search(line, ex_endsolid)) {
-        reached_end = true;
-        break;
-      } else if (i >= 3) {
-        AsciiError("extra vertex");
-        return PolySet::createEmpty();
-      } else if (boost::regex_search(line, results, ex_vertices) &&
-                 results.size() >= 4) {
-        try {
-          for (int v = 0; v < 3; ++v) {
-            vdata.at(i).at(v) = boost::lexical_cast<double>(results[v + 1]);
+    int i = 0;
+    std::array<Vector3d, 3> vdata;
+    bool reached_end = false;
+    for (const auto& chunk : chunks) {
+      auto vertex = chunk.vertices.begin();
+      for (const auto& line : chunk.lines) {
+        using Type = AsciiStlLine::Type;
+        if (line.type == Type::OuterLoop) {
+          i = 0;
+        } else if (line.type == Type::EndLoop) {
+          if (i < 3) {
+            AsciiError(line.begin, chunk_lineno + line.line, "missing vertex");
           }
+        } else if (line.type == Type::EndSolid) {
+          reached_end = true;
+          break;
+        } else if (i >= 3) {
+          AsciiError(line.begin, chunk_lineno + line.line, "extra vertex");
+          return PolySet::createEmpty();
+        } else if (line.type == Type::BadVertex) {
+          AsciiError(line.begin, chunk_lineno + line.line, "can't parse vertex");
+          return PolySet::createEmpty();
+        } else if (line.type == Type::Vertex) {
+          vdata[i] = *vertex++;
           if (++i == 3) {
-            builder.beginPolygon(3);
-            for(int j=0;j<3;j++) {
-              builder.addVertex(Vector3d(vdata[j][0], vdata[j][1], vdata[j][2]));
-            }
+            corners.insert(corners.end(), vdata.begin(), vdata.end());
           }
-        } catch (const boost::bad_lexical_cast& blc) {
-          AsciiError("can't parse vertex");
-          return PolySet::createEmpty();
         }
       }
+      if (reached_end) break;
+      chunk_lineno += chunk.newlines;
     }
     if (!reached_end) {
-      AsciiError("file incomplete");
+      // Like reading line by line, report the last (possibly empty) line of the file
+      const char *last_line = file.end();
+      while (last_line != file.begin() && last_line[-1] != '\n') --last_line;
+      AsciiError(last_line, chunk_lineno, "file incomplete");
+    }
+  } else if (binary) {
+    corners.resize(3ul * facenum);
+    std::vector<size_t> chunk_begins;
+    for (size_t begin = 0; begin < facenum; begin += STL_BINARY_CHUNK_FACETS) {
+      chunk_begins.push_back(begin);
     }
-  } else if (binary && !f.eof() && f.good()) {
-    try {
-      f.ignore(80 - 5 + 4);
-      while (!f.eof() ) {
+    parallelizable_for_each(chunk_begins.begin(), chunk_begins.end(), [&](size_t begin) {
+      const size_t end = std::min<size_t>(begin + STL_BINARY_CHUNK_FACETS, facenum);
+      for (size_t f = begin; f < end; ++f) {
         stl_facet facet;
-        try {
-          read_stl_facet(f, facet);
-        } catch (const std::ios_base::failure& ex) {
-          if (f.eof()) break;
-          throw;
-        }
-        builder.appendPolygon({
-                Vector3d(facet.data.x1, facet.data.y1, facet.data.z1),
-                Vector3d(facet.data.x2, facet.data.y2, facet.data.z2),
-                Vector3d(facet.data.x3, facet.data.y3, facet.data.z3)
-        });
+        read_stl_facet(file.data() + STL_HEADER_NUMBYTES + f * STL_FACET_NUMBYTES, facet);
+        corners[3 * f + 0] = Vector3d(facet.data.x1, facet.data.y1, facet.data.z1);
+        corners[3 * f + 1] = Vector3d(facet.data.x2, facet.data.y2, facet.data.z2);
+        corners[3 * f + 2] = Vector3d(facet.data.x3, facet.data.y3, facet.data.z3);
       }
-    } catch (const std::ios_base::failure& ex) {
-      int64_t offset = -1;
-      try { offset = f.tellg(); } catch (...) {}
-      if (offset < 0) {
-        LOG(message_group::Error, loc, "",
-            "Binary STL '%1$s' error: %3$s",
-            filename, ex.what());
-      } else {
-        LOG(message_group::Error, loc, "",
-            "Binary STL '%1$s' error at byte %2$s: %3$s",
-            filename, offset, ex.what());
-      }
-      return PolySet::createEmpty();
-    }
+    });
   } else {
     LOG(message_group::Error, loc, "",
         "STL format not recognized in '%1$s'.", filename);
     return PolySet::createEmpty();
   }
-  return builder.build();
+  return createPolySetFromTriangles(corners);
 }
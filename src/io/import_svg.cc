@@ -32,6 +32,7 @@
 #include <string>
 #include <vector>
 #include "io/import.h"
+#include "io/ImportCache.h"
 #include "geometry/Polygon2d.h"
 #include "utils/printutils.h"
 #include "libsvg/libsvg.h"
@@ -128,7 +129,18 @@ std::unique_ptr<Polygon2d> import_svg(double fn, double fs, double fa,
       match_args += "layer = \"" + layer.get() + "\"";
     }
 
-    const auto shapes = libsvg::libsvg_read_file(filename.c_str(), (void *) &scadContext);
+    auto *cache = ImportCache::instance();
+    auto document = cache->getSvgDocument(filename);
+    if (!document) {
+      document = libsvg::libsvg_parse_file(filename.c_str());
+      cache->insertSvgDocument(filename, document);
+    }
+    auto paths = cache->getSvgPaths(filename, fn, fs, fa);
+    const auto cached_paths = paths;
+    const auto shapes = libsvg::libsvg_read_document(*document, (void *) &scadContext, paths);
+    if (paths != cached_paths) {
+      cache->insertSvgPaths(filename, fn, fs, fa, paths);
+    }
     if (!match_args.empty() && !scadContext.has_matches()) {
       LOG(message_group::Warning, loc, "", "import() filter %2$s did not match anything", filename, match_args);
     }
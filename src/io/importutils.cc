@@ -0,0 +1,72 @@
+#include "io/importutils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "utils/parallel.h"
+
+std::vector<std::pair<const char *, const char *>> split_line_chunks(const char *begin, const char *end, size_t chunk_size)
+{
+  std::vector<std::pair<const char *, const char *>> chunks;
+  while (begin < end) {
+    const char *chunk_end = begin + std::min<size_t>(chunk_size, end - begin);
+    chunk_end = std::find(chunk_end, end, '\n');
+    if (chunk_end != end) ++chunk_end;
+    chunks.emplace_back(begin, chunk_end);
+    begin = chunk_end;
+  }
+  return chunks;
+}
+
+std::vector<int> weld_vertices(const std::vector<Vector3d>& points, std::vector<Vector3d>& vertices)
+{
+  // Total order which also keeps NaN coordinates from breaking the sort
+  const auto less = [](double a, double b) { return a < b || (std::isnan(b) && !std::isnan(a)); };
+  // NaN equals nothing, so like in PolySetBuilder, points with NaN coordinates are never welded
+  const auto equal = [](const Vector3d& a, const Vector3d& b) { return a == b; };
+
+  // Sort point indices by position, ties broken by index, in parallel
+  std::vector<uint32_t> order(points.size());
+  std::iota(order.begin(), order.end(), 0);
+  parallelizable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    const auto& va = points[a];
+    const auto& vb = points[b];
+    for (int i = 0; i < 3; ++i) {
+      if (less(va[i], vb[i])) return true;
+      if (less(vb[i], va[i])) return false;
+    }
+    return a < b;
+  });
+
+  // Group identical points, remembering the first point of each group
+  std::vector<uint32_t> point_group(points.size());
+  std::vector<uint32_t> group_first_point;
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (i == 0 || !equal(points[order[i - 1]], points[order[i]])) {
+      group_first_point.push_back(order[i]);
+    }
+    point_group[order[i]] = group_first_point.size() - 1;
+  }
+
+  // Number the groups in order of first use
+  std::vector<int> group_vertex(group_first_point.size());
+  vertices.reserve(vertices.size() + group_first_point.size());
+  for (uint32_t p = 0; p < points.size(); ++p) {
+    const auto group = point_group[p];
+    if (group_first_point[group] == p) {
+      group_vertex[group] = vertices.size();
+      vertices.push_back(points[p]);
+    }
+  }
+
+  std::vector<int> point_vertex(points.size());
+  for (size_t p = 0; p < points.size(); ++p) {
+    point_vertex[p] = group_vertex[point_group[p]];
+  }
+  return point_vertex;
+}
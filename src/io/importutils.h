@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "geometry/linalg.h"
+
+/*
+   Helpers for the mesh importers which parse memory mapped files in parallel.
+ */
+
+/*!
+   Splits [begin, end) into chunks of roughly chunk_size bytes, each ending
+   after a newline (or at end), so chunks can be parsed line by line in parallel.
+ */
+std::vector<std::pair<const char *, const char *>> split_line_chunks(const char *begin, const char *end, size_t chunk_size);
+
+/*!
+   Welds identical points into vertices.
+
+   Returns the index into vertices of each point. Vertices are numbered in order
+   of first use, so the result is the same as looking up each point in turn
+   through PolySetBuilder::vertexIndex(), without hashing each point.
+ */
+std::vector<int> weld_vertices(const std::vector<Vector3d>& points, std::vector<Vector3d>& vertices);
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*!
+   Layout of .osgeo files, OpenSCAD's native binary geometry format.
+
+   Unlike the mesh interchange formats, it stores geometry exactly as it is
+   held in memory: PolySet vertex, face and color arrays (keeping topology,
+   polygonal faces and colors), Polygon2d outlines, and the structure of
+   GeometryLists, e.g. from lazy union.
+
+   A file is a FileHeader followed by the root record. Each record starts with
+   a RecordHeader and the struct for its type; a list record is followed by its
+   children. Every struct and array starts on an ALIGNMENT boundary, so arrays
+   can be used in place from a memory mapped file. Numbers are stored in the
+   byte order of the writing machine, and readers reject the other one.
+ */
+namespace osgeo {
+
+constexpr char MAGIC[8] = {'O', 'S', 'G', 'E', 'O', '\r', '\n', '\x1a'};
+constexpr uint32_t VERSION = 1;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t ALIGNMENT = 8;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+};
+
+enum class RecordType : uint32_t {
+  Empty = 0,
+  List = 1,
+  PolySet = 2,
+  Polygon2d = 3,
+};
+
+struct RecordHeader {
+  RecordType type;
+  int32_t convexity;
+};
+
+// Followed by count child records
+struct ListRecord {
+  uint64_t count;
+};
+
+/*!
+   Followed by the arrays:
+   - vertices: double[3 * num_vertices]
+   - face offsets: uint64_t[num_faces + 1], the start of each face in indices.
+     Omitted for triangular PolySets, whose faces all have three indices.
+   - indices: int32_t[num_indices]
+   - color indices: int32_t[num_faces], if has_color_indices
+   - colors: float[4 * num_colors], RGBA
+ */
+struct PolySetRecord {
+  uint32_t dim;
+  uint8_t triangular;
+  uint8_t convex; // 0: false, 1: true, 2: unknown
+  uint8_t has_color_indices;
+  uint8_t reserved;
+  uint64_t num_vertices;
+  uint64_t num_faces;
+  uint64_t num_indices;
+  uint64_t num_colors;
+};
+
+// Followed by OutlineRecord[num_outlines], then the vertices of each outline
+struct Polygon2dRecord {
+  uint64_t num_outlines;
+  uint8_t sanitized;
+  uint8_t reserved[7];
+};
+
+// The vertices are double[2 * num_vertices]
+struct OutlineRecord {
+  uint64_t num_vertices;
+  uint8_t positive;
+  uint8_t reserved[7];
+};
+
+static_assert(sizeof(FileHeader) % ALIGNMENT == 0);
+static_assert(sizeof(RecordHeader) % ALIGNMENT == 0);
+static_assert(sizeof(ListRecord) % ALIGNMENT == 0);
+static_assert(sizeof(PolySetRecord) % ALIGNMENT == 0);
+static_assert(sizeof(Polygon2dRecord) % ALIGNMENT == 0);
+static_assert(sizeof(OutlineRecord) % ALIGNMENT == 0);
+
+} // namespace osgeo
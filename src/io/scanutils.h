@@ -0,0 +1,146 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <locale>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+/*
+   Allocation-free helpers for scanning ASCII model files in place, e.g. from a
+   MappedFile. Whitespace is what std::isspace() considers whitespace in the "C"
+   locale, matching boost::trim() and the \s class of the regexes these replace.
+ */
+
+inline bool scan_is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+inline std::string_view scan_trim(std::string_view s)
+{
+  while (!s.empty() && scan_is_space(s.front())) s.remove_prefix(1);
+  while (!s.empty() && scan_is_space(s.back())) s.remove_suffix(1);
+  return s;
+}
+
+inline bool scan_starts_with(std::string_view s, std::string_view prefix)
+{
+  return s.substr(0, prefix.size()) == prefix;
+}
+
+/*!
+   Parses a complete token as an integer, returning false if it isn't one.
+   Like boost::lexical_cast, a leading '+' is accepted, and unsigned types
+   accept a leading '-', negating the value modulo 2^n.
+ */
+template <typename T>
+bool scan_int(std::string_view token, T& result)
+{
+  static_assert(std::is_integral_v<T>);
+  const bool negative = !token.empty() && token.front() == '-';
+  if (!token.empty() && (token.front() == '+' || (negative && std::is_unsigned_v<T>))) {
+    token.remove_prefix(1);
+    if (token.empty() || token.front() == '+' || token.front() == '-') return false;
+  }
+  T value;
+  const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+  if (ec != std::errc{} || ptr != token.data() + token.size()) return false;
+  result = (std::is_unsigned_v<T> && negative) ? static_cast<T>(0 - value) : value;
+  return true;
+}
+
+/*!
+   Splits the next whitespace separated token off the front of s.
+   Returns an empty token if s has no more tokens.
+ */
+inline std::string_view scan_token(std::string_view& s)
+{
+  size_t begin = 0;
+  while (begin < s.size() && scan_is_space(s[begin])) ++begin;
+  size_t end = begin;
+  while (end < s.size() && !scan_is_space(s[end])) ++end;
+  const auto token = s.substr(begin, end - begin);
+  s.remove_prefix(end);
+  return token;
+}
+
+/*!
+   Parses a complete token as a double, returning false if it isn't one.
+
+   Plain decimals with at most 19 significant digits and a small exponent are
+   converted exactly using a single floating point multiplication or division
+   (Clinger's fast path), which covers nearly all numbers written by exporters.
+   Everything else goes through the standard library's correctly rounded parser.
+ */
+inline bool scan_double(std::string_view token, double& result)
+{
+  if (token.empty()) return false;
+  const bool negative = token.front() == '-';
+  // Leading '+' is accepted like boost::lexical_cast does, but not by std::from_chars
+  if (negative || token.front() == '+') token.remove_prefix(1);
+  if (token.empty() || token.front() == '+' || token.front() == '-') return false;
+
+  {
+    static constexpr double powers_of_ten[] = {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any_digits = false;
+    size_t i = 0;
+    for (; i < token.size() && token[i] >= '0' && token[i] <= '9'; ++i) {
+      any_digits = true;
+      if (mantissa != 0 || token[i] != '0') ++digits;
+      mantissa = mantissa * 10 + (token[i] - '0');
+    }
+    if (i < token.size() && token[i] == '.') {
+      for (++i; i < token.size() && token[i] >= '0' && token[i] <= '9'; ++i) {
+        any_digits = true;
+        if (mantissa != 0 || token[i] != '0') ++digits;
+        mantissa = mantissa * 10 + (token[i] - '0');
+        --exponent;
+      }
+    }
+    if (any_digits && i < token.size() && (token[i] == 'e' || token[i] == 'E')) {
+      size_t j = i + 1;
+      const bool exp_negative = j < token.size() && token[j] == '-';
+      if (j < token.size() && (token[j] == '-' || token[j] == '+')) ++j;
+      int exp_value = 0;
+      const size_t exp_begin = j;
+      for (; j < token.size() && token[j] >= '0' && token[j] <= '9' && exp_value < 10000; ++j) {
+        exp_value = exp_value * 10 + (token[j] - '0');
+      }
+      if (j > exp_begin) {
+        exponent += exp_negative ? -exp_value : exp_value;
+        i = j;
+      }
+    }
+    if (any_digits && i == token.size() && digits <= 19 &&
+        mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+      double value = static_cast<double>(mantissa);
+      value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+      result = negative ? -value : value;
+      return true;
+    }
+  }
+
+  double value;
+#ifdef __cpp_lib_to_chars
+  const auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+  if (ec != std::errc{} || ptr != token.data() + token.size()) return false;
+#else
+  std::istringstream istr{std::string(token)};
+  istr.imbue(std::locale::classic());
+  istr >> value;
+  if (istr.fail() || istr.peek() != EOF) return false;
+#endif
+  result = negative ? -value : value;
+  return true;
+}
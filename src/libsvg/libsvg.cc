@@ -24,6 +24,7 @@
  */
 #include "libsvg/libsvg.h"
 
+#include <cstddef>
 #include <utility>
 #include <iostream>
 #include <memory>
@@ -37,7 +38,9 @@
 
 
 #include "libsvg/shape.h"
+#include "libsvg/path.h"
 #include "libsvg/use.h"
+#include "utils/parallel.h"
 
 namespace libsvg {
 
@@ -75,24 +78,17 @@ attr_map_t read_attributes(xmlTextReaderPtr reader)
   return attrs;
 }
 
-void processNode(xmlTextReaderPtr reader, shapes_defs_list_t *defs_lookup_list, shapes_list_t *temp_defs_storage, void *context)
+void processNode(const document::node& node, size_t index, shapes_defs_list_t *defs_lookup_list, shapes_list_t *temp_defs_storage, void *context)
 {
-  const char *name = reinterpret_cast<const char *>(xmlTextReaderName(reader));
-  if (name == nullptr) name = reinterpret_cast<const char *>(xmlStrdup(BAD_CAST "--"));
+  const char *name = node.name.c_str();
 
-  bool isEmpty;
-  xmlChar *value = xmlTextReaderValue(reader);
-  int node_type = xmlTextReaderNodeType(reader);
-  switch (node_type) {
+  switch (node.type) {
   case XML_READER_TYPE_ELEMENT:
-    isEmpty = xmlTextReaderIsEmptyElement(reader);
     {
 #if SVG_DEBUG
-      printf("XML_READER_TYPE_ELEMENT (%s %s): %d %d %s\n",
+      printf("XML_READER_TYPE_ELEMENT (%s %s): %d\n",
              dump_stack().c_str(), name,
-             xmlTextReaderDepth(reader),
-             xmlTextReaderNodeType(reader),
-             value);
+             node.type);
 #endif
 
       if (std::string("defs") == name) {
@@ -101,7 +97,7 @@ void processNode(xmlTextReaderPtr reader, shapes_defs_list_t *defs_lookup_list,
 
       auto s = std::shared_ptr<shape>(shape::create_from_name(name));
       if (s) {
-        attr_map_t attrs = read_attributes(reader);
+        attr_map_t attrs = node.attrs;
         if (!stack.empty()) {
           stack.back()->add_child(s.get());
         }
@@ -109,6 +105,9 @@ void processNode(xmlTextReaderPtr reader, shapes_defs_list_t *defs_lookup_list,
         if (s->is_container()) {
           stack.push_back(s);
         }
+        if (auto *p = dynamic_cast<path *>(s.get())) {
+          p->set_node(index);
+        }
 
         //handle the "use" tag
         if (use::name == s->get_name()) {
@@ -131,7 +130,7 @@ void processNode(xmlTextReaderPtr reader, shapes_defs_list_t *defs_lookup_list,
         }
       }
     }
-    if (!isEmpty) {
+    if (!node.is_empty) {
       break;
     }
   /* fall through */
@@ -148,18 +147,15 @@ void processNode(xmlTextReaderPtr reader, shapes_defs_list_t *defs_lookup_list,
       stack.pop_back();
     }
 #if SVG_DEBUG
-    printf("XML_READER_TYPE_END_ELEMENT (%s %s): %d %d %s\n",
+    printf("XML_READER_TYPE_END_ELEMENT (%s %s): %d\n",
            dump_stack().c_str(), name,
-           xmlTextReaderDepth(reader),
-           xmlTextReaderNodeType(reader),
-           value);
+           node.type);
 #endif
   }
   break;
   case XML_READER_TYPE_TEXT:
   {
-    attr_map_t attrs;
-    attrs["text"] = reinterpret_cast<const char *>(value);
+    attr_map_t attrs = node.attrs;
     auto s = std::shared_ptr<shape>(shape::create_from_name("data"));
     if (!stack.empty()) {
       stack.back()->add_child(s.get());
@@ -173,25 +169,39 @@ void processNode(xmlTextReaderPtr reader, shapes_defs_list_t *defs_lookup_list,
   }
   break;
   }
-
-  xmlFree(value);
-  xmlFree((void *) (name));
 }
 
-int streamFile(const char *filename, void *context)
+document::node readNode(xmlTextReaderPtr reader)
 {
-  xmlTextReaderPtr reader;
-  // The temp storage is needed for items in a def that don't have an id, but have a parent with an id
-  shapes_list_t temp_defs_storage;
-  shapes_defs_list_t defs_lookup_list;
+  document::node node{xmlTextReaderNodeType(reader), "--", {}, false};
+  xmlChar *name = xmlTextReaderName(reader);
+  if (name != nullptr) node.name = reinterpret_cast<const char *>(name);
+  xmlFree(name);
 
-  in_defs = false;
-  reader = xmlNewTextReaderFilename(filename);
-  xmlTextReaderSetParserProp(reader, XML_PARSER_SUBST_ENTITIES, 1);
+  if (node.type == XML_READER_TYPE_ELEMENT) {
+    node.is_empty = xmlTextReaderIsEmptyElement(reader);
+    node.attrs = read_attributes(reader);
+  } else if (node.type == XML_READER_TYPE_TEXT) {
+    xmlChar *value = xmlTextReaderValue(reader);
+    node.attrs["text"] = value != nullptr ? reinterpret_cast<const char *>(value) : "";
+    xmlFree(value);
+  }
+  return node;
+}
+
+std::shared_ptr<const document> parseFile(const char *filename)
+{
+  auto doc = std::make_shared<document>();
+  xmlTextReaderPtr reader = xmlNewTextReaderFilename(filename);
   if (reader != nullptr) {
+    xmlTextReaderSetParserProp(reader, XML_PARSER_SUBST_ENTITIES, 1);
     int ret = xmlTextReaderRead(reader);
     while (ret == 1) {
-      processNode(reader, &defs_lookup_list, &temp_defs_storage, context);
+      const int node_type = xmlTextReaderNodeType(reader);
+      // Only these node types create or close shapes
+      if (node_type == XML_READER_TYPE_ELEMENT || node_type == XML_READER_TYPE_END_ELEMENT || node_type == XML_READER_TYPE_TEXT) {
+        doc->nodes.push_back(readNode(reader));
+      }
       ret = xmlTextReaderRead(reader);
     }
     xmlFreeTextReader(reader);
@@ -201,12 +211,52 @@ int streamFile(const char *filename, void *context)
   } else {
     throw SvgException((boost::format("Can't open file '%1%'") % filename).str());
   }
+  return doc;
+}
 
-  for (const auto& shape : (*shape_list)) {
-    shape->apply_transform();
+void readDocument(const document& doc, void *context, std::shared_ptr<const flattened_paths_t>& flattened)
+{
+  // The temp storage is needed for items in a def that don't have an id, but have a parent with an id
+  shapes_list_t temp_defs_storage;
+  shapes_defs_list_t defs_lookup_list;
+
+  in_defs = false;
+  stack.clear();
+  for (size_t i = 0; i < doc.nodes.size(); ++i) {
+    processNode(doc.nodes[i], i, &defs_lookup_list, &temp_defs_storage, context);
   }
 
-  return 0;
+  // Paths are flattened independently of each other. Excluded shapes are
+  // skipped, as their path lists aren't used.
+  std::vector<std::shared_ptr<const path_list_t>> new_paths(shape_list->size());
+  std::vector<size_t> indices(shape_list->size());
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = i;
+  parallelizable_for_each(indices.begin(), indices.end(), [&](size_t i) {
+    const auto& shape = (*shape_list)[i];
+    auto *p = dynamic_cast<path *>(shape.get());
+    if (p && !shape->is_excluded()) {
+      std::shared_ptr<const path_list_t> paths;
+      if (flattened) {
+        const auto it = flattened->find(p->get_node());
+        if (it != flattened->end()) paths = it->second;
+      }
+      if (paths) {
+        p->set_path_list(*paths);
+      } else {
+        p->flatten(context);
+        new_paths[i] = std::make_shared<const path_list_t>(p->get_path_list());
+      }
+    }
+    shape->apply_transform();
+  });
+
+  std::shared_ptr<flattened_paths_t> updated;
+  for (size_t i = 0; i < new_paths.size(); ++i) {
+    if (!new_paths[i]) continue;
+    if (!updated) updated = flattened ? std::make_shared<flattened_paths_t>(*flattened) : std::make_shared<flattened_paths_t>();
+    updated->emplace(dynamic_cast<path *>((*shape_list)[i].get())->get_node(), new_paths[i]);
+  }
+  if (updated) flattened = updated;
 }
 
 void dump(int idx, shape *s) {
@@ -219,11 +269,31 @@ void dump(int idx, shape *s) {
   }
 }
 
+size_t
+document::memsize() const
+{
+  size_t size = sizeof(*this) + nodes.capacity() * sizeof(node);
+  for (const auto& node : nodes) {
+    size += node.name.capacity();
+    for (const auto& attr : node.attrs) {
+      // Approximates the overhead of a map node
+      size += attr.first.capacity() + attr.second.capacity() + 4 * sizeof(void *);
+    }
+  }
+  return size;
+}
+
+std::shared_ptr<const document>
+libsvg_parse_file(const char *filename)
+{
+  return parseFile(filename);
+}
+
 shapes_list_t *
-libsvg_read_file(const char *filename, void *context)
+libsvg_read_document(const document& doc, void *context, std::shared_ptr<const flattened_paths_t>& flattened)
 {
   shape_list = new shapes_list_t();
-  streamFile(filename, context);
+  readDocument(doc, context, flattened);
 
 //#ifdef DEBUG
 //	if (!shape_list->empty()) {
@@ -234,6 +304,13 @@ libsvg_read_file(const char *filename, void *context)
   return shape_list;
 }
 
+shapes_list_t *
+libsvg_read_file(const char *filename, void *context)
+{
+  std::shared_ptr<const flattened_paths_t> flattened;
+  return libsvg_read_document(*libsvg_parse_file(filename), context, flattened);
+}
+
 void
 libsvg_free(shapes_list_t *shapes)
 {
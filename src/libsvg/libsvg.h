@@ -24,10 +24,12 @@
  */
 #pragma once
 
+#include <cstddef>
 #include <exception>
 #include <utility>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "libsvg/shape.h"
@@ -50,6 +52,38 @@ private:
 
 using shapes_list_t = std::vector<std::shared_ptr<shape>>;
 
+/*!
+   A parsed SVG file: the XML nodes in document order, from which shapes can
+   be created repeatedly, e.g. for different $fn, id or layer values, without
+   reading and parsing the file again.
+ */
+struct document {
+  struct node {
+    int type;
+    std::string name;
+    attr_map_t attrs; // The attributes of elements, or "text" for text nodes
+    bool is_empty;
+  };
+
+  std::vector<node> nodes;
+
+  [[nodiscard]] size_t memsize() const;
+};
+
+// Flattened path data by node index, valid for one set of $fn, $fs and $fa
+using flattened_paths_t = std::unordered_map<size_t, std::shared_ptr<const path_list_t>>;
+
+std::shared_ptr<const document>
+libsvg_parse_file(const char *filename);
+
+/*!
+   Creates the shapes of a parsed document. The paths of shapes which aren't
+   excluded are flattened in parallel. Paths found in flattened are reused, and
+   flattened is replaced with a copy including the newly flattened ones.
+ */
+shapes_list_t *
+libsvg_read_document(const document& doc, void *context, std::shared_ptr<const flattened_paths_t>& flattened);
+
 shapes_list_t *
 libsvg_read_file(const char *filename, void *context);
 
@@ -222,10 +222,18 @@ static std::vector<std::string> split_dots(const std::string& str)
 void
 path::set_attrs(attr_map_t& attrs, void *context)
 {
-  std::string commands = "-zmlcqahvstZMLCQAHVST";
-
   shape::set_attrs(attrs, context);
   this->data = attrs["d"];
+}
+
+void
+path::flatten(void *context)
+{
+  if (this->data.empty()) {
+    return;
+  }
+
+  std::string commands = "-zmlcqahvstZMLCQAHVST";
 
   boost::char_separator<char> sep(" ,", commands.c_str());
   tokenizer tokens(this->data, sep);
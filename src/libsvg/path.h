@@ -25,6 +25,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstddef>
 #include <string>
 #include "libsvg/shape.h"
 
@@ -34,6 +35,7 @@ class path : public shape
 {
 protected:
   std::string data;
+  size_t node{0};
 
 private:
   [[nodiscard]] inline double t(double t, int exp) const {
@@ -52,6 +54,14 @@ public:
   [[nodiscard]] const std::string dump() const override;
   [[nodiscard]] const std::string& get_name() const override { return path::name; }
 
+  // Creates the path list from the path data set by set_attrs()
+  void flatten(void *context);
+  void set_path_list(const path_list_t& paths) { path_list = paths; }
+
+  // The index of the document node this path was created from
+  [[nodiscard]] size_t get_node() const { return node; }
+  void set_node(size_t index) { node = index; }
+
   static const std::string name;
 
   [[nodiscard]] shape *clone() const override { return new path(*this); }
@@ -27,11 +27,17 @@
 #include "openscad.h"
 
 #include <chrono>
+#include <cmath>
+#include <algorithm>
 #include <iomanip>
 #include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
 #include <string>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 #include "ColorUtil.h"
 #include "Context.h"
 #include "Settings.h"
@@ -66,7 +72,9 @@
 #include "glview/OffscreenView.h"
 #include "glview/RenderSettings.h"
 #include "handle_dep.h"
+#include "io/AnimationWriter.h"
 #include "io/export.h"
+#include "io/imageutils.h"
 #include "LibraryInfo.h"
 #include "openscad_gui.h"
 #include "openscad_mimalloc.h"
@@ -136,8 +144,7 @@ bool useGUI()
 }
 #endif // OPENSCAD_NOGUI
 
-bool checkAndExport(const std::shared_ptr<const Geometry>& root_geom, unsigned dimensions,
-                    ExportInfo& exportInfo, const bool is_stdout, const std::string& filename)
+bool checkExportable(const std::shared_ptr<const Geometry>& root_geom, unsigned dimensions)
 {
   if (root_geom->getDimension() != dimensions) {
     LOG("Current top level object is not a %1$dD object.", dimensions);
@@ -147,13 +154,6 @@ bool checkAndExport(const std::shared_ptr<const Geometry>& root_geom, unsigned d
     LOG("Current top level object is empty.");
     return false;
   }
-
-  if (is_stdout) {
-    exportFileStdOut(root_geom, exportInfo);
-  }
-  else {
-    exportFileByName(root_geom, filename, exportInfo);
-  }
   return true;
 }
 
@@ -273,6 +273,17 @@ struct AnimateArgs {
   unsigned frames = 0;
   unsigned num_shards = 1;
   unsigned shard = 1;
+  AnimationFormat format = AnimationFormat::PNG;
+  double fps = 10;
+};
+
+// Several views of the design, rendered to PNG from one evaluation
+struct ViewsArgs {
+  std::vector<Camera> cameras; // Given like --camera
+  unsigned turntable = 0;      // Views around the z axis, starting from the camera of the design
+  bool sheet = false;          // Tile the views into one image instead of writing a file for each
+
+  [[nodiscard]] bool empty() const { return cameras.empty() && turntable == 0; }
 };
 
 struct CommandLine
@@ -289,6 +300,7 @@ struct CommandLine
   const boost::optional<FileFormat> export_format;
   const CmdLineExportOptions& exportOptions;
   const AnimateArgs animate;
+  const ViewsArgs views;
   const std::vector<std::string> summaryOptions;
   const std::string summaryFile;
 };
@@ -318,10 +330,31 @@ AnimateArgs get_animate(const po::variables_map& vm) {
       exit(1);
     }
   }
+  if (vm.count("animate_format")) {
+    const auto& format = vm["animate_format"].as<std::string>();
+    if (format == "png") {
+      animate.format = AnimationFormat::PNG;
+    } else if (format == "apng") {
+      animate.format = AnimationFormat::APNG;
+    } else if (format == "raw") {
+      animate.format = AnimationFormat::RAW;
+    } else {
+      LOG("--animate_format must be one of png, apng or raw");
+      exit(1);
+    }
+  }
+  if (vm.count("animate_fps")) {
+    animate.fps = vm["animate_fps"].as<double>();
+    if (!(animate.fps > 0)) {
+      LOG("--animate_fps must be positive");
+      exit(1);
+    }
+  }
   return animate;
 }
 
-Camera get_camera(const po::variables_map& vm)
+// Returns boost::none if the options are invalid
+boost::optional<Camera> get_camera(const po::variables_map& vm)
 {
   Camera camera;
 
@@ -340,7 +373,7 @@ Camera get_camera(const po::variables_map& vm)
       }
     } else {
       LOG("Camera setup requires either 7 numbers for Gimbal Camera or 6 numbers for Vector Camera");
-      exit(1);
+      return boost::none;
     }
   } else {
     camera.viewall = true;
@@ -363,7 +396,7 @@ Camera get_camera(const po::variables_map& vm)
       camera.projection = Camera::ProjectionType::PERSPECTIVE;
     } else {
       LOG("projection needs to be 'o' or 'p' for ortho or perspective\n");
-      exit(1);
+      return boost::none;
     }
   }
 
@@ -374,7 +407,7 @@ Camera get_camera(const po::variables_map& vm)
     boost::split(strs, vm["imgsize"].as<std::string>(), boost::is_any_of(","));
     if (strs.size() != 2) {
       LOG("Need 2 numbers for imgsize");
-      exit(1);
+      return boost::none;
     } else {
       try {
         w = boost::lexical_cast<int>(strs[0]);
@@ -390,8 +423,136 @@ Camera get_camera(const po::variables_map& vm)
   return camera;
 }
 
-int do_export(const CommandLine& cmd, const RenderVariables& render_variables, FileFormat export_format, SourceFile *root_file)
+/*!
+   Reads --views, either a list of cameras separated by ';', each given like
+   --camera, or turntable:N. The views get the size and projection of camera.
+   Returns boost::none if the options are invalid.
+ */
+boost::optional<ViewsArgs> get_views(const po::variables_map& vm, const Camera& camera)
+{
+  ViewsArgs views;
+  if (vm.count("views_layout")) {
+    const auto& layout = vm["views_layout"].as<std::string>();
+    if (layout == "sheet") {
+      views.sheet = true;
+    } else if (layout != "files") {
+      LOG("--views_layout must be files or sheet");
+      return boost::none;
+    }
+  }
+  if (!vm.count("views")) return views;
+
+  const auto& spec = vm["views"].as<std::string>();
+  if (boost::starts_with(spec, "turntable:")) {
+    try {
+      views.turntable = boost::lexical_cast<unsigned>(spec.substr(10));
+    } catch (const boost::bad_lexical_cast&) {
+    }
+    if (views.turntable == 0) {
+      LOG("--views=turntable:N needs a positive number of views");
+      return boost::none;
+    }
+    return views;
+  }
+
+  std::vector<std::string> camera_strs;
+  boost::split(camera_strs, spec, boost::is_any_of(";"));
+  for (const auto& camera_str : camera_strs) {
+    std::vector<std::string> strs;
+    boost::split(strs, camera_str, boost::is_any_of(","));
+    if (strs.size() != 6 && strs.size() != 7) {
+      LOG("Each of --views requires either 7 numbers for Gimbal Camera or 6 numbers for Vector Camera");
+      return boost::none;
+    }
+    std::vector<double> cam_parameters;
+    try {
+      for (const auto& s : strs) {
+        cam_parameters.push_back(boost::lexical_cast<double>(s));
+      }
+    } catch (const boost::bad_lexical_cast&) {
+      LOG("--views requires numbers as camera parameters");
+      return boost::none;
+    }
+    Camera view = camera;
+    view.setup(cam_parameters);
+    view.viewall = vm.count("viewall");
+    view.autocenter = vm.count("autocenter");
+    views.cameras.push_back(view);
+  }
+  return views;
+}
+
+/*!
+   Writes the views of an evaluated design to output, from the one view
+   holding its renderer. A file is written for each view, numbered like
+   animation frames and encoded on worker threads while the next view is
+   rendered, or the views are tiled into one contact sheet.
+ */
+bool export_views(const CommandLine& cmd, const std::string& output, const Camera& camera, OffscreenView& glview)
+{
+  std::vector<Camera> cameras = cmd.views.cameras;
+  for (unsigned i = 0; i < cmd.views.turntable; ++i) {
+    Camera view = camera;
+    const auto vpr = camera.getVpr();
+    view.setVpr(vpr.x(), vpr.y(), vpr.z() + 360.0 * i / cmd.views.turntable);
+    cameras.push_back(view);
+  }
+
+  if (!cmd.views.sheet) {
+    if (cmd.is_stdout) {
+      LOG("Option --views can only export to stdout with --views_layout sheet.");
+      return false;
+    }
+    AnimationWriter writer(AnimationFormat::PNG, output, false, cameras.size(), 0);
+    const bool rendered = render_views(glview, cameras, [&writer, &output](size_t i, RGBAImage image) {
+      std::ostringstream oss;
+      oss << std::setw(5) << std::setfill('0') << i;
+      auto view_file = fs::path(output);
+      auto extension = view_file.extension();
+      view_file.replace_extension();
+      view_file += oss.str();
+      view_file.replace_extension(extension);
+      return writer.addFrame(std::move(image), view_file.generic_string());
+    });
+    return writer.finish() && rendered;
+  }
+
+  // Rows of the sheet are filled first, leaving the rest of the last row blank
+  const int columns = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(cameras.size()))));
+  const int rows = (static_cast<int>(cameras.size()) + columns - 1) / columns;
+  RGBAImage sheet;
+  sheet.width = columns * camera.pixel_width;
+  sheet.height = rows * camera.pixel_height;
+  sheet.pixels.resize(4ul * sheet.width * sheet.height);
+  const auto *colorscheme = ColorMap::inst()->findColorScheme(RenderSettings::inst()->colorscheme);
+  const Color4f background = ColorMap::getColor(colorscheme ? *colorscheme : ColorMap::inst()->defaultColorScheme(), RenderColor::BACKGROUND_COLOR);
+  for (size_t i = 0; i < sheet.pixels.size(); ++i) {
+    sheet.pixels[i] = static_cast<uint8_t>(std::clamp(background[i % 4], 0.0f, 1.0f) * 255 + 0.5f);
+  }
+  const bool rendered = render_views(glview, cameras, [&sheet, columns](size_t i, RGBAImage image) {
+    copy_image(image, sheet, (i % columns) * image.width, (i / columns) * image.height);
+    return true;
+  });
+  if (!rendered) return false;
+  bool success = true;
+  const bool wrote = with_output(cmd.is_stdout, output, [&success, &sheet](std::ostream& stream) {
+    success = write_png(stream, sheet.pixels.data(), sheet.width, sheet.height);
+  }, std::ios::out | std::ios::binary);
+  return wrote && success;
+}
+
+/*!
+   Exports the given outputs from one evaluation of the design. All but the
+   first output must have formats for which can_share_geometry() is true.
+
+   PNG outputs with an entry in frame_writers are rendered and handed to that
+   writer, which encodes and writes them in the background.
+ */
+int do_export(const std::vector<CommandLine>& cmds, const RenderVariables& render_variables, const std::vector<FileFormat>& export_formats, SourceFile *root_file,
+              const std::vector<AnimationWriter *>& frame_writers = {})
 {
+  const auto& cmd = cmds.front();
+  const auto export_format = export_formats.front();
   auto filename_str = fs::path(cmd.output_file).generic_string();
   // Avoid possibility of fs::absolute throwing when passed an empty path
   auto fpath = cmd.filename.empty() ? fs::current_path() : fs::absolute(fs::path(cmd.filename));
@@ -478,7 +639,7 @@ int do_export(const CommandLine& cmd, const RenderVariables& render_variables, F
     // start measuring render time
     RenderStatistic renderStatistic;
     GeometryEvaluator geomevaluator(tree);
-    std::unique_ptr<OffscreenView> glview;
+    std::shared_ptr<OffscreenView> glview;
     std::shared_ptr<const Geometry> root_geom;
     if ((export_format == FileFormat::ECHO || export_format == FileFormat::PNG) && (cmd.viewOptions.renderer == RenderType::OPENCSG || cmd.viewOptions.renderer == RenderType::THROWNTOGETHER)) {
       // OpenCSG or throwntogether png -> just render a preview
@@ -507,61 +668,153 @@ int do_export(const CommandLine& cmd, const RenderVariables& render_variables, F
       }
     }
 
+    // A failing output doesn't stop the others which share the evaluation
+    int rc = 0;
     const std::string input_filename = cmd.is_stdin ? "<stdin>" : cmd.filename;
-    const int dim = fileformat::is3D(export_format) ? 3 : fileformat::is2D(export_format) ? 2 : 0;
-    ExportInfo exportInfo = createExportInfo(export_format, fileformat::info(export_format), input_filename, &cmd.camera, cmd.exportOptions);
-    if (dim > 0 && !checkAndExport(root_geom, dim, exportInfo, cmd.is_stdout, filename_str)) {
-      return 1;
+    std::vector<ExportTarget> targets;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+      const auto format = export_formats[i];
+      const int dim = fileformat::isAnyDimension(format) ? root_geom->getDimension() :
+                      fileformat::is3D(format) ? 3 : fileformat::is2D(format) ? 2 : 0;
+      if (dim == 0) continue;
+      if (!checkExportable(root_geom, dim)) {
+        rc = 1;
+        continue;
+      }
+      targets.push_back({createExportInfo(format, fileformat::info(format), input_filename, &cmd.camera, cmd.exportOptions),
+                         fs::path(cmds[i].output_file).generic_string(), cmds[i].is_stdout});
+    }
+    const auto results = exportFiles(root_geom, targets);
+    for (size_t i = 0; i < targets.size(); ++i) {
+      if (!results[i].success) {
+        rc = 1;
+        continue;
+      }
+      renderStatistic.addExportTime(targets[i].is_stdout ? "<stdout>" : targets[i].filename, results[i].time);
     }
 
-    if (export_format == FileFormat::PNG) {
+    // Rendered on this thread, as it needs an OpenGL context
+    for (size_t i = 0; i < cmds.size(); ++i) {
+      if (export_formats[i] != FileFormat::PNG) continue;
+      const auto start = std::chrono::steady_clock::now();
+      const auto png_filename = fs::path(cmds[i].output_file).generic_string();
+      const bool geometry_view = cmd.viewOptions.renderer == RenderType::BACKEND_SPECIFIC || cmd.viewOptions.renderer == RenderType::GEOMETRY;
+      if (!cmds[i].views.empty()) {
+        // All views share the renderer, so the geometry is uploaded once
+        const auto views_glview = geometry_view ? prepare_render(root_geom, cmd.viewOptions, camera) : glview;
+        if (!views_glview || !export_views(cmds[i], png_filename, camera, *views_glview)) {
+          rc = 1;
+          continue;
+        }
+        renderStatistic.addExportTime(cmds[i].is_stdout ? "<stdout>" : png_filename,
+                                      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start));
+        continue;
+      }
+      if (i < frame_writers.size() && frame_writers[i]) {
+        RGBAImage image;
+        const bool rendered = geometry_view ? render_image(root_geom, cmd.viewOptions, camera, image) : render_image(*glview, image);
+        if (!rendered || !frame_writers[i]->addFrame(std::move(image), png_filename)) {
+          rc = 1;
+          continue;
+        }
+        renderStatistic.addExportTime(cmds[i].is_stdout ? "<stdout>" : png_filename,
+                                      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start));
+        continue;
+      }
       bool success = true;
-      bool wrote = with_output(cmd.is_stdout, filename_str, [&success, &root_geom, &cmd, &camera, &glview](std::ostream& stream) {
-        if (cmd.viewOptions.renderer == RenderType::BACKEND_SPECIFIC || cmd.viewOptions.renderer == RenderType::GEOMETRY) {
+      bool wrote = with_output(cmds[i].is_stdout, png_filename, [&success, &root_geom, &cmd, &camera, &glview, geometry_view](std::ostream& stream) {
+        if (geometry_view) {
           success = export_png(root_geom, cmd.viewOptions, camera, stream);
         } else {
           success = export_png(*glview, stream);
         }
       }, std::ios::out | std::ios::binary);
       if (!success || !wrote) {
-        return 1;
+        rc = 1;
+        continue;
       }
+      renderStatistic.addExportTime(cmds[i].is_stdout ? "<stdout>" : png_filename,
+                                    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start));
     }
 
     renderStatistic.printAll(root_geom, camera, cmd.summaryOptions, cmd.summaryFile);
+    return rc;
   }
   return 0;
 }
 
-int cmdline(const CommandLine& cmd)
+std::string output_suffix(const std::string& output_file)
 {
-  FileFormat export_format;
+  const auto path = fs::path(output_file);
+  std::string suffix = path.has_extension() ? path.extension().generic_string().substr(1) : "";
+  boost::algorithm::to_lower(suffix);
+  return suffix;
+}
 
-  // Determine output file format and assign it to formatName
+// The format given by --export-format, else by the file extension
+boost::optional<FileFormat> get_export_format(const CommandLine& cmd)
+{
   if (cmd.export_format.is_initialized()) {
-    export_format = cmd.export_format.get();
-  } else {
-    // else extract format from file extension
-    const auto path = fs::path(cmd.output_file);
-    std::string suffix = path.has_extension() ? path.extension().generic_string().substr(1) : "";
-    boost::algorithm::to_lower(suffix);
-
-    if (!fileformat::fromIdentifier(suffix, export_format)) {
-      LOG("Invalid suffix %1$s. Either add a valid suffix or specify one using the --export-format option.", suffix);
-      return 1;
-    }
+    return cmd.export_format.get();
   }
+  FileFormat export_format;
+  if (!fileformat::fromIdentifier(output_suffix(cmd.output_file), export_format)) {
+    return boost::none;
+  }
+  return export_format;
+}
 
-  // Do some minimal checking of output directory before rendering (issue #432)
-  auto output_dir = fs::path(cmd.output_file).parent_path();
-  if (output_dir.empty()) {
-    // If output_file_str has no directory prefix, set output directory to current directory.
-    output_dir = fs::current_path();
+/*!
+   Formats exported from the rendered geometry alone, without evaluating the
+   design differently. Outputs of these formats share one evaluation.
+ */
+bool can_share_geometry(FileFormat format, const ViewOptions& viewOptions)
+{
+  if (format == FileFormat::PNG) {
+    return viewOptions.renderer != RenderType::OPENCSG && viewOptions.renderer != RenderType::THROWNTOGETHER;
   }
-  if (!fs::is_directory(output_dir)) {
-    LOG("\n'%1$s' is not a directory for output file %2$s - Skipping\n", output_dir.generic_string(), cmd.output_file);
-    return 1;
+  return fileformat::is3D(format) || fileformat::is2D(format) || fileformat::isAnyDimension(format);
+}
+
+/*!
+   Evaluates the design and exports it to the given outputs. Several outputs
+   are only passed together if can_share_geometry() is true for their formats.
+ */
+int cmdline(const std::vector<CommandLine>& all_cmds)
+{
+  int rc = 0;
+  std::vector<CommandLine> cmds;
+  std::vector<FileFormat> export_formats;
+  for (const auto& cmd : all_cmds) {
+    const auto export_format = get_export_format(cmd);
+    if (!export_format) {
+      LOG("Invalid suffix %1$s. Either add a valid suffix or specify one using the --export-format option.", output_suffix(cmd.output_file));
+      rc = 1;
+      continue;
+    }
+    if (!cmd.views.empty() && *export_format != FileFormat::PNG) {
+      LOG("Option --views can only export PNG images, not %1$s.", cmd.output_file);
+      rc = 1;
+      continue;
+    }
+
+    // Do some minimal checking of output directory before rendering (issue #432)
+    auto output_dir = fs::path(cmd.output_file).parent_path();
+    if (output_dir.empty()) {
+      // If output_file_str has no directory prefix, set output directory to current directory.
+      output_dir = fs::current_path();
+    }
+    if (!fs::is_directory(output_dir)) {
+      LOG("\n'%1$s' is not a directory for output file %2$s - Skipping\n", output_dir.generic_string(), cmd.output_file);
+      rc = 1;
+      continue;
+    }
+    cmds.push_back(cmd);
+    export_formats.push_back(*export_format);
   }
+  if (cmds.empty()) return rc;
+  const auto& cmd = cmds.front();
+  const auto export_format = export_formats.front();
 
   set_render_color_scheme(arg_colorscheme, true);
 
@@ -610,6 +863,8 @@ int cmdline(const CommandLine& cmd)
     LOG("Can't parse file '%1$s'!\n", cmd.filename);
     return 1;
   }
+  // Freed after exporting, as batch mode parses many files in one process
+  const std::unique_ptr<SourceFile> root_file_owner(root_file);
 
   // add parameter to AST
   CommentParser::collectParameters(text.c_str(), root_file);
@@ -638,41 +893,117 @@ int cmdline(const CommandLine& cmd)
 
   if (cmd.animate.frames == 0) {
     render_variables.time = 0;
-    return do_export(cmd, render_variables, export_format, root_file);
+    return rc | do_export(cmds, render_variables, export_formats, root_file);
   } else {
     // export the requested number of animated frames
     const unsigned start_frame = ((cmd.animate.shard - 1) * cmd.animate.frames)
       / cmd.animate.num_shards;
     const unsigned limit_frame = (cmd.animate.shard * cmd.animate.frames)
       / cmd.animate.num_shards;
+
+    // PNG frames are encoded in the background while the next frame is rendered
+    std::vector<std::unique_ptr<AnimationWriter>> writers;
+    std::vector<AnimationWriter *> frame_writers;
+    for (size_t i = 0; i < cmds.size(); ++i) {
+      if (export_formats[i] != FileFormat::PNG) {
+        if (cmds[i].is_stdout) {
+          LOG("Option --animate only supports exporting PNG frames to stdout, with --animate_format apng or raw.");
+          return 1;
+        }
+        frame_writers.push_back(nullptr);
+        continue;
+      }
+      writers.push_back(std::make_unique<AnimationWriter>(cmd.animate.format, cmds[i].output_file, cmds[i].is_stdout,
+                                                          limit_frame - start_frame, cmd.animate.fps));
+      if (!writers.back()->isOpen()) return 1;
+      frame_writers.push_back(writers.back().get());
+    }
+
     for (unsigned frame = start_frame; frame < limit_frame; ++frame) {
       render_variables.time = frame * (1.0 / cmd.animate.frames);
 
       std::ostringstream oss;
       oss << std::setw(5) << std::setfill('0') << frame;
 
-      auto frame_file = fs::path(cmd.output_file);
-      auto extension = frame_file.extension();
-      frame_file.replace_extension();
-      frame_file += oss.str();
-      frame_file.replace_extension(extension);
-      std::string frame_str = frame_file.generic_string();
+      std::vector<CommandLine> frame_cmds;
+      for (size_t i = 0; i < cmds.size(); ++i) {
+        const auto& output_cmd = cmds[i];
+        frame_cmds.push_back(output_cmd);
+        // APNG and raw frames all go to the one output
+        if (export_formats[i] == FileFormat::PNG && cmd.animate.format != AnimationFormat::PNG) continue;
+
+        auto frame_file = fs::path(output_cmd.output_file);
+        auto extension = frame_file.extension();
+        frame_file.replace_extension();
+        frame_file += oss.str();
+        frame_file.replace_extension(extension);
+        frame_cmds.back().output_file = frame_file.generic_string();
+      }
 
       LOG("Exporting %1$s...", cmd.filename);
 
-      CommandLine frame_cmd = cmd;
-      frame_cmd.output_file = frame_str;
-
-      int r = do_export(frame_cmd, render_variables, export_format, root_file);
+      // Stops at the first failing frame, but still finishes the outputs
+      const int r = do_export(frame_cmds, render_variables, export_formats, root_file, frame_writers);
       if (r != 0) {
-        return r;
+        rc = r;
+        break;
       }
     }
 
-    return 0;
+    for (const auto& writer : writers) {
+      if (!writer->finish()) rc = 1;
+    }
+    return rc;
   }
 }
 
+/*!
+   Exports the design to each of the output files. Outputs which can share one
+   evaluation of the design are exported together. cmd gives the options of
+   all outputs.
+ */
+int cmdline_outputs(const std::vector<std::string>& output_files, const CommandLine& cmd)
+{
+  std::vector<std::vector<CommandLine>> output_groups;
+  boost::optional<size_t> shared_group;
+  for (const auto& filename : output_files) {
+    const bool is_stdout = filename == "-";
+    const std::string output_file = is_stdout ? "<stdout>" : filename;
+    const CommandLine output_cmd{
+      cmd.is_stdin,
+      cmd.filename,
+      is_stdout,
+      output_file,
+      cmd.original_path,
+      cmd.parameterFile,
+      cmd.setName,
+      cmd.viewOptions,
+      cmd.camera,
+      cmd.export_format,
+      cmd.exportOptions,
+      cmd.animate,
+      cmd.views,
+      cmd.summaryOptions,
+      cmd.summaryFile
+    };
+    const auto format = get_export_format(output_cmd);
+    if (format && can_share_geometry(*format, cmd.viewOptions)) {
+      if (!shared_group) {
+        shared_group = output_groups.size();
+        output_groups.emplace_back();
+      }
+      output_groups[*shared_group].push_back(output_cmd);
+    } else {
+      output_groups.push_back({output_cmd});
+    }
+  }
+  int rc = 0;
+  for (const auto& cmds : output_groups) {
+    rc |= cmdline(cmds);
+  }
+  return rc;
+}
+
 #ifdef Q_OS_MACOS
 std::pair<std::string, std::string> customSyntax(const std::string& s)
 {
@@ -743,6 +1074,157 @@ CmdLineExportOptions convert_export_options(const po::variables_map& vm)
   return map;
 }
 
+ViewOptions get_view_options(const po::variables_map& vm)
+{
+  ViewOptions viewOptions{};
+  if (vm.count("preview")) {
+    if (vm["preview"].as<std::string>() == "throwntogether") viewOptions.renderer = RenderType::THROWNTOGETHER;
+  } else if (vm.count("render")) {
+    // Note: "cgal" is here for backwards compatibility, can probably be removed soon
+    if (vm["render"].as<std::string>() == "cgal" || vm["render"].as<std::string>() == "force") {
+      viewOptions.renderer = RenderType::BACKEND_SPECIFIC;
+    } else {
+      viewOptions.renderer = RenderType::GEOMETRY;
+    }
+  }
+
+  viewOptions.previewer = (viewOptions.renderer == RenderType::THROWNTOGETHER) ? Previewer::THROWNTOGETHER : Previewer::OPENCSG;
+  if (vm.count("view")) {
+    const auto& viewOptionValues = vm["view"].as<CommaSeparatedVector>();
+
+    for (const auto& option : viewOptionValues.values) {
+      try {
+        viewOptions[option] = true;
+      } catch (const std::out_of_range& e) {
+        LOG("Unknown --view option '%1$s' ignored. Use -h to list available options.", option);
+      }
+    }
+  }
+  return viewOptions;
+}
+
+/*!
+   Runs one job of --batch. line holds the options and input file of a
+   command line, and defaults the options given to the batch process.
+ */
+bool batch_job(const std::string& line, const po::options_description& options, const po::positional_options_description& positional,
+               const po::parsed_options& defaults, const fs::path& original_path, const std::string& commands)
+{
+  // Options which only apply to the whole process, or need stdin or stdout, aren't accepted
+  static const std::set<std::string> job_options = {
+    "o", "O", "D", "p", "P", "export-format", "camera", "autocenter", "viewall", "imgsize",
+    "views", "views_layout",
+    "render", "preview", "view", "projection", "colorscheme", "summary", "summary-file", "input-file",
+  };
+
+  po::variables_map vm;
+  try {
+    const auto parsed = po::command_line_parser(po::split_unix(line)).options(options).positional(positional).run();
+    for (const auto& option : parsed.options) {
+      if (!job_options.count(option.string_key)) {
+        LOG("Option --%1$s isn't supported in batch jobs", option.string_key);
+        return false;
+      }
+    }
+    po::store(parsed, vm);
+    // Values of the job are stored first, so they take precedence
+    commandline_commands = commands;
+    if (vm.count("D")) {
+      for (const auto& cmd : vm["D"].as<std::vector<std::string>>()) {
+        commandline_commands += cmd;
+        commandline_commands += ";\n";
+      }
+    }
+    po::store(defaults, vm);
+  } catch (const std::exception& e) {
+    LOG("%1$s", e.what());
+    return false;
+  }
+
+  const auto input_files = vm.count("input-file") ? vm["input-file"].as<std::vector<std::string>>() : std::vector<std::string>{};
+  const auto output_files = vm.count("o") ? vm["o"].as<std::vector<std::string>>() : std::vector<std::string>{};
+  if (input_files.size() != 1 || output_files.empty()) {
+    LOG("Batch jobs need one input file and at least one output file (-o)");
+    return false;
+  }
+  if (input_files[0] == "-" || std::find(output_files.begin(), output_files.end(), "-") != output_files.end()) {
+    LOG("Batch jobs can't read from stdin or export to stdout");
+    return false;
+  }
+
+  arg_colorscheme = vm.count("colorscheme") ? vm["colorscheme"].as<std::string>() : "";
+  if (!arg_colorscheme.empty() && !ColorMap::inst()->findColorScheme(arg_colorscheme)) {
+    LOG("Unknown color scheme '%1$s'", arg_colorscheme);
+    return false;
+  }
+  RenderSettings::inst()->colorscheme = ColorMap::inst()->defaultColorSchemeName();
+
+  boost::optional<FileFormat> export_format;
+  if (vm.count("export-format")) {
+    FileFormat format;
+    if (!fileformat::fromIdentifier(vm["export-format"].as<std::string>(), format)) {
+      LOG("Unknown --export-format option '%1$s'", vm["export-format"].as<std::string>());
+      return false;
+    }
+    export_format.emplace(format);
+  }
+
+  const auto camera = get_camera(vm);
+  if (!camera) return false;
+  const auto views = get_views(vm, *camera);
+  if (!views) return false;
+  const auto viewOptions = get_view_options(vm);
+  const auto export_options = convert_export_options(vm);
+  const CommandLine cmd{
+    false,
+    input_files[0],
+    false,
+    "",
+    original_path,
+    vm.count("p") ? vm["p"].as<std::string>() : "",
+    vm.count("P") ? vm["P"].as<std::string>() : "",
+    viewOptions,
+    *camera,
+    export_format,
+    export_options,
+    AnimateArgs{},
+    *views,
+    vm.count("summary") ? vm["summary"].as<std::vector<std::string>>() : std::vector<std::string>{},
+    vm.count("summary-file") ? vm["summary-file"].as<std::string>() : ""
+  };
+  try {
+    return cmdline_outputs(output_files, cmd) == 0;
+  } catch (const HardWarningException&) {
+  } catch (const std::exception& e) {
+    LOG("%1$s", e.what());
+  }
+  fs::current_path(original_path);
+  return false;
+}
+
+/*!
+   Reads jobs from stdin, one per line, and exports them in this process, so
+   OpenGL context, shaders, framebuffer and caches are reused between them.
+   Prints "ok" or "error" to stdout when each job is done. Empty lines and
+   lines starting with # are skipped.
+ */
+int batch(const po::options_description& options, const po::positional_options_description& positional,
+          const po::parsed_options& defaults, const fs::path& original_path)
+{
+  keep_offscreen_view(true);
+  const std::string commands = commandline_commands;
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    boost::algorithm::trim(line);
+    if (line.empty() || line[0] == '#') continue;
+    const bool ok = batch_job(line, options, positional, defaults, original_path, commands);
+    std::cout << (ok ? "ok" : "error") << std::endl;
+  }
+  keep_offscreen_view(false);
+  commandline_commands = commands;
+  return 0;
+}
+
 // OpenSCAD
 int main(int argc, char **argv)
 {
@@ -784,7 +1266,6 @@ int main(int argc, char **argv)
   const char *deps_output_file = nullptr;
   boost::optional<FileFormat> export_format;
 
-  ViewOptions viewOptions{};
   po::options_description desc("Allowed options");
   desc.add_options()
     ("export-format", po::value<std::string>(), "overrides format of exported scad file when using option '-o', arg can be any of its supported file extensions.  For ascii stl export, specify 'asciistl', and for binary stl export, specify 'binstl'.  Ascii export is the current stl default, but binary stl is planned as the future default so asciistl should be explicitly specified in scripts when needed.\n")
@@ -809,13 +1290,17 @@ int main(int argc, char **argv)
     ("camera", po::value<std::string>(), "camera parameters when exporting png: =translate_x,y,z,rot_x,y,z,dist or =eye_x,y,z,center_x,y,z")
     ("autocenter", "adjust camera to look at object's center")
     ("viewall", "adjust camera to fit object")
+    ("views", po::value<std::string>(), "render several views to png from one evaluation: =cam;cam;... with each camera given like --camera, or =turntable:N for N views around the z axis from the camera of the design")
+    ("views_layout", po::value<std::string>(), "how --views are written: files (default) writes a numbered png for each view, sheet tiles them into one png")
     ("backend", po::value<std::string>(), "3D rendering backend to use: 'CGAL' (old/slow) [default] or 'Manifold' (new/fast)")
     ("imgsize", po::value<std::string>(), "=width,height of exported png")
     ("render", po::value<std::string>()->implicit_value(""), "for full geometry evaluation when exporting png")
     ("preview", po::value<std::string>()->implicit_value(""), "[=throwntogether] -for ThrownTogether preview png")
     ("animate", po::value<unsigned>(), "export N animated frames")
     ("animate_sharding", po::value<std::string>(), "Parameter <shard>/<num_shards> - Divide work into <num_shards> and only output frames for <shard>. E.g. 2/5 only outputs the second 1/5 of frames. Use to parallelize work on multiple cores or machines.")
-    ("view", po::value<CommaSeparatedVector>(), ("=view options: " + boost::algorithm::join(viewOptions.names(), " | ")).c_str())
+    ("animate_format", po::value<std::string>(), "How animated PNG frames are written: png (default) writes a file for each frame, apng writes one animated PNG, raw writes uncompressed 8 bit RGB frames one after another, e.g. to stdout (-) for piping into a video encoder.")
+    ("animate_fps", po::value<double>(), "frame rate of animations written with --animate_format apng, default 10")
+    ("view", po::value<CommaSeparatedVector>(), ("=view options: " + boost::algorithm::join(ViewOptions{}.names(), " | ")).c_str())
     ("projection", po::value<std::string>(), "=(o)rtho or (p)erspective when exporting png")
     ("csglimit", po::value<unsigned int>(), "=n -stop rendering at n CSG elements when exporting png")
     ("summary", po::value<std::vector<std::string>>(), "enable additional render summary and statistics: all | cache | time | camera | geometry | bounding-box | area")
@@ -826,6 +1311,7 @@ int main(int argc, char **argv)
     return (colorScheme == ColorMap::inst()->defaultColorSchemeName() ? "*" : "") + colorScheme;
   }) +
                                           "\n").c_str())
+    ("batch", "read export jobs from stdin, one per line, each with the options and input file of a command line, and run them in one process which keeps its OpenGL context and caches. Prints ok or error for each job. Options given with --batch are defaults for all jobs\n")
     ("d,d", po::value<std::string>(), "deps_file -generate a dependency file for make")
     ("m,m", po::value<std::string>(), "make_cmd -runs make_cmd file if file is missing")
     ("quiet,q", "quiet mode (don't print anything *except* errors)")
@@ -856,8 +1342,10 @@ int main(int argc, char **argv)
   all_options.add(desc).add(hidden);
 
   po::variables_map vm;
+  po::parsed_options parsed(&all_options);
   try {
-    po::store(po::command_line_parser(argc, argv).options(all_options).positional(p).extra_parser(customSyntax).run(), vm);
+    parsed = po::command_line_parser(argc, argv).options(all_options).positional(p).extra_parser(customSyntax).run();
+    po::store(parsed, vm);
   } catch (const std::exception& e) { // Catches e.g. unknown options
     LOG("%1$s\n", e.what());
     help(argv[0], desc, true);
@@ -909,29 +1397,8 @@ int main(int argc, char **argv)
     RenderSettings::inst()->backend3D = renderBackend3DFromString(vm["backend"].as<std::string>());
   }
 
-  if (vm.count("preview")) {
-    if (vm["preview"].as<std::string>() == "throwntogether") viewOptions.renderer = RenderType::THROWNTOGETHER;
-  } else if (vm.count("render")) {
-    // Note: "cgal" is here for backwards compatibility, can probably be removed soon
-    if (vm["render"].as<std::string>() == "cgal" || vm["render"].as<std::string>() == "force") {
-      viewOptions.renderer = RenderType::BACKEND_SPECIFIC;
-    } else {
-      viewOptions.renderer = RenderType::GEOMETRY;
-    }
-  }
+  const ViewOptions viewOptions = get_view_options(vm);
 
-  viewOptions.previewer = (viewOptions.renderer == RenderType::THROWNTOGETHER) ? Previewer::THROWNTOGETHER : Previewer::OPENCSG;
-  if (vm.count("view")) {
-    const auto& viewOptionValues = vm["view"].as<CommaSeparatedVector>();
-
-    for (const auto& option : viewOptionValues.values) {
-      try {
-        viewOptions[option] = true;
-      } catch (const std::out_of_range& e) {
-        LOG("Unknown --view option '%1$s' ignored. Use -h to list available options.", option);
-      }
-    }
-  }
 
   if (vm.count("csglimit")) {
     RenderSettings::inst()->openCSGTermLimit = vm["csglimit"].as<unsigned int>();
@@ -1011,12 +1478,19 @@ int main(int argc, char **argv)
   }
 
   AnimateArgs animate = get_animate(vm);
-  Camera camera = get_camera(vm);
+  const auto camera = get_camera(vm);
+  if (!camera) return 1;
+  const auto views = get_views(vm, *camera);
+  if (!views) return 1;
+  if (animate.frames && !views->empty()) {
+    LOG("Options --animate and --views can't be combined.");
+    return 1;
+  }
 
   if (animate.frames) {
     for (const auto& filename : output_files) {
-      if (filename == "-") {
-        LOG("Option --animate is not supported when exporting to stdout.");
+      if (filename == "-" && animate.format == AnimationFormat::PNG) {
+        LOG("Option --animate is not supported when exporting to stdout, except with --animate_format apng or raw.");
         return 1;
       }
     }
@@ -1028,43 +1502,45 @@ int main(int argc, char **argv)
   PRINTDB("Application location detected as %s", applicationPath);
 
   auto cmdlinemode = false;
-  if (!output_files.empty()) { // cmd-line mode
+  const bool batchmode = vm.count("batch");
+  if (batchmode) {
+    if (!output_files.empty() || !inputFiles.empty()) help(argv[0], desc, true);
+  } else if (!output_files.empty()) { // cmd-line mode
     cmdlinemode = true;
     if (!inputFiles.size()) help(argv[0], desc, true);
   }
 
-  if (arg_info || cmdlinemode) {
+  if (arg_info || cmdlinemode || batchmode) {
     if (inputFiles.size() > 1) help(argv[0], desc, true);
     try {
       parser_init();
       localization_init();
       if (arg_info) {
         rc = info();
+      } else if (batchmode) {
+        rc = batch(all_options, p, parsed, original_path);
       } else {
-        for (const auto& filename : output_files) {
-          const bool is_stdin = inputFiles[0] == "-";
-          const std::string input_file = is_stdin ? "<stdin>" : inputFiles[0];
-          const bool is_stdout = filename == "-";
-          const std::string output_file = is_stdout ? "<stdout>" : filename;
-          const auto export_options = convert_export_options(vm);
-          const CommandLine cmd{
-            is_stdin,
-            input_file,
-            is_stdout,
-            output_file,
-            original_path,
-            parameterFile,
-            parameterSet,
-            viewOptions,
-            camera,
-            export_format,
-            export_options,
-            animate,
-            vm.count("summary") ? vm["summary"].as<std::vector<std::string>>() : std::vector<std::string>{},
-            vm.count("summary-file") ? vm["summary-file"].as<std::string>() : ""
-          };
-          rc |= cmdline(cmd);
-        }
+        const bool is_stdin = inputFiles[0] == "-";
+        const std::string input_file = is_stdin ? "<stdin>" : inputFiles[0];
+        const auto export_options = convert_export_options(vm);
+        const CommandLine cmd{
+          is_stdin,
+          input_file,
+          false,
+          "",
+          original_path,
+          parameterFile,
+          parameterSet,
+          viewOptions,
+          *camera,
+          export_format,
+          export_options,
+          animate,
+          *views,
+          vm.count("summary") ? vm["summary"].as<std::vector<std::string>>() : std::vector<std::string>{},
+          vm.count("summary-file") ? vm["summary-file"].as<std::string>() : ""
+        };
+        rc = cmdline_outputs(output_files, cmd);
       }
     } catch (const HardWarningException&) {
       rc = 1;
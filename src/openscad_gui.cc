@@ -39,6 +39,7 @@
 #include "FontCache.h"
 #include "geometry/Geometry.h"
 #include "gui/AppleEvents.h"
+#include "gui/CSGWorker.h"
 #include "gui/LaunchingScreen.h"
 #include "gui/MainWindow.h"
 #include "gui/OpenSCADApp.h"
@@ -66,6 +67,7 @@
 
 Q_DECLARE_METATYPE(Message);
 Q_DECLARE_METATYPE(std::shared_ptr<const Geometry>);
+Q_DECLARE_METATYPE(std::shared_ptr<const CSGPreview>);
 
 extern std::string arg_colorscheme;
 
@@ -179,6 +181,7 @@ int gui(std::vector<std::string>& inputFiles, const std::filesystem::path& origi
   // Other global settings
   qRegisterMetaType<Message>();
   qRegisterMetaType<std::shared_ptr<const Geometry>>();
+  qRegisterMetaType<std::shared_ptr<const CSGPreview>>();
 
   FontCache::registerProgressHandler(dialogInitHandler);
 
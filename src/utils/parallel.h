@@ -6,6 +6,7 @@
 #if ENABLE_TBB
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_for_each.h>
+#include <tbb/parallel_sort.h>
 #endif
 
 template <class InputIterator, class OutputIterator, class Operation>
@@ -25,6 +26,30 @@ void parallelizable_transform(const InputIterator begin1,
   std::transform(begin1, end1, out, op);
 }
 
+template <class InputIterator, class Operation>
+void parallelizable_for_each(const InputIterator begin, const InputIterator end,
+                             const Operation &op) {
+#if ENABLE_TBB
+  if (!getenv("OPENSCAD_NO_PARALLEL")) {
+    tbb::parallel_for_each(begin, end, op);
+    return;
+  }
+#endif
+  std::for_each(begin, end, op);
+}
+
+template <class RandomAccessIterator, class Compare>
+void parallelizable_sort(const RandomAccessIterator begin,
+                         const RandomAccessIterator end, const Compare &comp) {
+#if ENABLE_TBB
+  if (!getenv("OPENSCAD_NO_PARALLEL")) {
+    tbb::parallel_sort(begin, end, comp);
+    return;
+  }
+#endif
+  std::sort(begin, end, comp);
+}
+
 template <class Container1, class Container2, class OutputIterator,
           class Operation>
 void parallelizable_cross_product_transform(const Container1 &cont1,
@@ -4,6 +4,7 @@
 #include <set>
 #include <list>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <cstdio>
 #include <boost/algorithm/string.hpp>
@@ -37,6 +38,8 @@ int count = 0;
 namespace {
 bool no_throw;
 bool deferred;
+// Messages may be printed concurrently, e.g. by parallel exports
+std::recursive_mutex print_mutex;
 }
 
 void set_output_handler(OutputHandlerFunc *newhandler, OutputHandlerFunc2 *newhandler2, void *userdata)
@@ -80,6 +83,7 @@ void print_messages_pop()
 void PRINT(const Message& msgObj)
 {
   if (msgObj.msg.empty() && msgObj.group != message_group::Echo) return;
+  const std::lock_guard<std::recursive_mutex> lock(print_mutex);
 
   if (print_messages_stack.size() > 0) {
     if (!print_messages_stack.back().empty()) {
@@ -101,6 +105,7 @@ void PRINT(const Message& msgObj)
 void PRINT_NOCACHE(const Message& msgObj)
 {
   if (msgObj.msg.empty() && msgObj.group != message_group::Echo) return;
+  const std::lock_guard<std::recursive_mutex> lock(print_mutex);
 
   const auto msg = msgObj.str();
 
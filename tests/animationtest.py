@@ -0,0 +1,168 @@
+#!/usr/bin/env python
+
+# Animation export test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports PNG frames of an animated model with --animate and verifies that:
+# - --animate_format png writes a PNG file for each frame
+# - --animate_format raw writes every frame as 8 bit RGB, to a file or stdout
+# - --animate_format apng writes one valid animated PNG, with the frame delay
+#   of --animate_fps
+# - invalid --animate_format and --animate_fps values are rejected
+# - when a frame fails, the APNG and raw outputs are still finished, with the
+#   frames before it
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, struct, zlib, argparse
+
+WIDTH, HEIGHT = 40, 30
+FRAME_SIZE = WIDTH * HEIGHT * 3
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting animationtest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def run(inputfile, output, *options):
+    cmd = [args.openscad, inputfile, '-o', output, '--imgsize=%d,%d' % (WIDTH, HEIGHT),
+           '--viewall', '--autocenter'] + list(options) + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    print(result.stderr.decode(errors='replace'), file=sys.stderr)
+    return result
+
+def read(filename):
+    with open(filename, 'rb') as f:
+        return f.read()
+
+def remove(filename):
+    if os.path.exists(filename): os.unlink(filename)
+
+# Returns the chunks of a PNG file as (type, data) tuples
+def png_chunks(name, data):
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        failquit(name + ': no PNG signature')
+    chunks = []
+    pos = 8
+    while pos < len(data):
+        if pos + 12 > len(data):
+            failquit(name + ': truncated chunk')
+        length, = struct.unpack('>I', data[pos:pos + 4])
+        chunk_type = data[pos + 4:pos + 8]
+        chunk_data = data[pos + 8:pos + 8 + length]
+        crc, = struct.unpack('>I', data[pos + 8 + length:pos + 12 + length])
+        if crc != zlib.crc32(chunk_type + chunk_data):
+            failquit('%s: bad CRC of %s chunk' % (name, chunk_type))
+        chunks.append((chunk_type.decode('ascii'), chunk_data))
+        pos += 12 + length
+    if not chunks or chunks[0][0] != 'IHDR' or chunks[-1][0] != 'IEND':
+        failquit(name + ': not a complete PNG file')
+    width, height = struct.unpack('>II', chunks[0][1][:8])
+    if (width, height) != (WIDTH, HEIGHT):
+        failquit('%s: image size is %dx%d' % (name, width, height))
+    return chunks
+
+# Checks an animated PNG and its frame count and delay
+def check_apng(name, data, frames, delay):
+    chunks = png_chunks(name, data)
+    types = [chunk_type for chunk_type, _ in chunks]
+    if types[1] != 'acTL':
+        failquit(name + ': no acTL chunk after IHDR')
+    num_frames, num_plays = struct.unpack('>II', chunks[1][1])
+    if num_frames != frames:
+        failquit('%s: acTL has %d frames instead of %d' % (name, num_frames, frames))
+    fctls = [data for chunk_type, data in chunks if chunk_type == 'fcTL']
+    if len(fctls) != frames:
+        failquit('%s: %d fcTL chunks instead of %d' % (name, len(fctls), frames))
+    if types.index('fcTL') > types.index('IDAT'):
+        failquit(name + ': the first frame must be the default image')
+    for fctl in fctls:
+        delay_num, delay_den = struct.unpack('>HH', fctl[20:24])
+        if (delay_num, delay_den) != (delay, 1000):
+            failquit('%s: frame delay %d/%d instead of %d/1000' % (name, delay_num, delay_den, delay))
+    sequence = [struct.unpack('>I', data[:4])[0] for chunk_type, data in chunks if chunk_type in ('fcTL', 'fdAT')]
+    if sequence != list(range(len(sequence))):
+        failquit(name + ': sequence numbers are not consecutive')
+    if frames > 1 and 'fdAT' not in types:
+        failquit(name + ': no fdAT chunks')
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = remaining_args[0]
+basename = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+# A file for each frame
+output = basename + '-frame.png'
+frames = [basename + '-frame%05d.png' % i for i in range(2)]
+for frame in frames: remove(frame)
+if run(inputfile, output, '--animate=2').returncode != 0:
+    failquit('failed to export PNG frames')
+for frame in frames:
+    if not os.path.exists(frame):
+        failquit(frame + ' was not written')
+    png_chunks(frame, read(frame))
+    os.unlink(frame)
+
+# Raw frames, to a file and to stdout
+output = basename + '-raw.png'
+remove(output)
+if run(inputfile, output, '--animate=3', '--animate_format=raw').returncode != 0:
+    failquit('failed to export raw frames')
+raw = read(output)
+os.unlink(output)
+if len(raw) != 3 * FRAME_SIZE:
+    failquit('raw output has %d bytes instead of %d' % (len(raw), 3 * FRAME_SIZE))
+if len(set(raw[i * FRAME_SIZE:(i + 1) * FRAME_SIZE] for i in range(3))) != 3:
+    failquit('raw frames of the animation are not different')
+result = run(inputfile, '-', '--export-format=png', '--animate=3', '--animate_format=raw')
+if result.returncode != 0 or result.stdout != raw:
+    failquit('raw frames on stdout differ from those in a file')
+
+# Animated PNG, with the default and a given frame rate
+output = basename + '-apng.png'
+for fps, delay in [(None, 100), (25, 40)]:
+    remove(output)
+    options = ['--animate=4', '--animate_format=apng'] + (['--animate_fps=%s' % fps] if fps else [])
+    if run(inputfile, output, *options).returncode != 0:
+        failquit('failed to export an animated PNG')
+    check_apng(output, read(output), 4, delay)
+    os.unlink(output)
+result = run(inputfile, '-', '--export-format=png', '--animate=4', '--animate_format=apng')
+if result.returncode != 0:
+    failquit('failed to export an animated PNG to stdout')
+check_apng('stdout', result.stdout, 4, 100)
+
+# Invalid options
+for options in [['--animate_format=gif'], ['--animate_fps=0'], ['--animate_fps=-5']]:
+    remove(output)
+    if run(inputfile, output, '--animate=2', '--animate_format=apng', *options).returncode == 0:
+        failquit('invalid option accepted: ' + ' '.join(options))
+remove(output)
+
+# A frame which fails half way through the animation
+failing = basename + '-failing.scad'
+with open(failing, 'w') as f:
+    f.write('if ($t >= 0.5) echo(unknown_variable);\ncube(10);\n')
+output = basename + '-failing.png'
+remove(output)
+if run(failing, output, '--hardwarnings', '--animate=4', '--animate_format=apng').returncode == 0:
+    failquit('the failing animation did not fail')
+check_apng(output, read(output), 2, 100)
+remove(output)
+if run(failing, output, '--hardwarnings', '--animate=4', '--animate_format=raw').returncode == 0:
+    failquit('the failing animation did not fail')
+if len(read(output)) != 2 * FRAME_SIZE:
+    failquit('raw output of the failing animation has %d bytes instead of %d' % (len(read(output)), 2 * FRAME_SIZE))
+os.unlink(output)
+os.unlink(failing)
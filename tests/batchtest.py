@@ -0,0 +1,104 @@
+#!/usr/bin/env python
+
+# Batch mode test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Runs several export jobs of the input file in one --batch process and
+# verifies that:
+# - each job prints ok or error, in order, and comments and empty lines don't
+# - invalid jobs fail without writing anything, and don't stop the jobs after them
+# - options given with --batch are defaults, which a job's own options override
+# - the images are the same as those exported by separate processes
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, shlex, struct, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting batchtest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def read(filename):
+    with open(filename, 'rb') as f:
+        return f.read()
+
+def remove(filename):
+    if os.path.exists(filename): os.unlink(filename)
+
+def png_size(filename):
+    data = read(filename)
+    if data[:8] != b'\x89PNG\r\n\x1a\n' or data[12:16] != b'IHDR':
+        failquit(filename + ' is not a PNG file')
+    return struct.unpack('>II', data[16:24])
+
+# Exports the input file in a process of its own
+def export(output, *options):
+    cmd = [args.openscad, inputfile, '-o', output] + list(options) + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    if subprocess.call(cmd) != 0:
+        failquit('failed to export ' + output)
+    return read(output)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+view = ['--viewall', '--autocenter']
+small, large, stl = basename + '-small.png', basename + '-large.png', basename + '-both.stl'
+both = basename + '-both.png'
+invalid = [basename + '-invalid-%d.png' % i for i in range(3)]
+for output in [small, large, stl, both] + invalid: remove(output)
+
+# Each job with the output expected on stdout, or None if it prints nothing
+quoted = shlex.quote(inputfile)
+jobs = [
+    ('# A comment', None),
+    ('', None),
+    ('%s -o %s %s' % (quoted, shlex.quote(small), ' '.join(view)), 'ok'),
+    ('%s -o %s --imgsize=64,48 %s' % (quoted, shlex.quote(large), ' '.join(view)), 'ok'),
+    ('%s -o %s --animate=2' % (quoted, shlex.quote(invalid[0])), 'error'),
+    (quoted, 'error'),
+    ('%s -o %s' % (shlex.quote(basename + '-missing.scad'), shlex.quote(invalid[1])), 'error'),
+    ('%s -o %s -o %s' % (quoted, shlex.quote(invalid[2]), '-'), 'error'),
+    ('%s -o %s -o %s %s' % (quoted, shlex.quote(both), shlex.quote(stl), ' '.join(view)), 'ok'),
+]
+stdin = ''.join(job + '\n' for job, _ in jobs)
+print('Batch jobs:\n' + stdin, file=sys.stderr)
+# The image size given to the batch process is the default of its jobs
+result = subprocess.run([args.openscad, '--batch', '--imgsize=40,30'] + remaining_args, input=stdin,
+                        stdout=subprocess.PIPE, text=True)
+if result.returncode != 0:
+    failquit('batch process returned %d' % result.returncode)
+lines = result.stdout.split()
+expected = [status for _, status in jobs if status]
+if lines != expected:
+    failquit('batch process printed %s instead of %s' % (lines, expected))
+
+for output in invalid:
+    if os.path.exists(output):
+        failquit(output + ' was written by an invalid job')
+for output, size in [(small, (40, 30)), (large, (64, 48)), (both, (40, 30))]:
+    if png_size(output) != size:
+        failquit('%s is %dx%d instead of %dx%d' % ((output,) + png_size(output) + size))
+
+# The same images and model as separate processes export
+if read(small) != export(basename + '-expected-small.png', '--imgsize=40,30', *view):
+    failquit(small + ' differs from the output of a separate process')
+if read(large) != export(basename + '-expected-large.png', '--imgsize=64,48', *view):
+    failquit(large + ' differs from the output of a separate process')
+if read(both) != read(small):
+    failquit(both + ' differs from ' + small)
+if read(stl) != export(basename + '-expected.stl'):
+    failquit(stl + ' differs from the output of a separate process')
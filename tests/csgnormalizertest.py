@@ -0,0 +1,51 @@
+#!/usr/bin/env python
+
+# CSG normalization estimate test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Previews the input file, and verifies that for each tree which is normalized,
+# the number of products estimated before normalizing it is at most the number
+# it normalized to. Oversize trees are rejected by the estimate, so an estimate
+# which is too high would reject trees which could be previewed.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse, re
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting csgnormalizertest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+# The trees are normalized before the offscreen view is created, so the
+# image itself doesn't matter
+output = basename + '.png'
+cmd = [args.openscad, inputfile, '-o', output, '--preview=throwntogether', '--imgsize=64,64',
+       '--debug=CSGTreeNormalizer'] + remaining_args
+print('Running OpenSCAD:', file=sys.stderr)
+print(' '.join(cmd), file=sys.stderr)
+result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+if os.path.exists(output): os.unlink(output)
+
+counts = [(int(m.group(1)), int(m.group(2)))
+          for m in re.finditer(r'Estimated at least (\d+) products, normalized to (\d+)', result.stderr)]
+if not counts:
+    print(result.stderr, file=sys.stderr)
+    failquit('no CSG tree was normalized')
+for estimate, actual in counts:
+    print('Estimated %d products, normalized to %d' % (estimate, actual), file=sys.stderr)
+    if estimate > actual:
+        failquit('the estimate of %d products exceeds the %d products normalized' % (estimate, actual))
@@ -0,0 +1,168 @@
+#!/usr/bin/env python
+
+# 3MF round-trip test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the input file to 3MF and to OFF, and verifies that:
+# - the 3MF is a valid ZIP archive, whose entries all pass their CRC checks
+# - the content types and relationships point to a model which exists
+# - the model XML parses, its triangles only use vertices of their mesh, and
+#   its properties and build items only refer to resources which exist
+# - importing the 3MF gives the same volume and bounding box as the OFF
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse, zipfile
+import xml.etree.ElementTree as ET
+
+CORE = '{http://schemas.microsoft.com/3dmanufacturing/core/2015/02}'
+MATERIAL = '{http://schemas.microsoft.com/3dmanufacturing/material/2015/02}'
+RELS = '{http://schemas.openxmlformats.org/package/2006/relationships}'
+CONTENT_TYPES = '{http://schemas.openxmlformats.org/package/2006/content-types}'
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting export3mftest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def export(input, output):
+    if os.path.exists(output): os.unlink(output)
+    cmd = [args.openscad, input, '-o', output] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    if subprocess.call(cmd) != 0 or not os.path.exists(output):
+        failquit('failed to export ' + output)
+
+def parse(archive, name):
+    try:
+        return ET.fromstring(archive.read(name))
+    except ET.ParseError as e:
+        failquit('%s is not valid XML: %s' % (name, e))
+
+# Checks the archive and the model, and returns the number of triangles
+def validate(filename):
+    if not zipfile.is_zipfile(filename):
+        failquit(filename + ' is not a ZIP archive')
+    with zipfile.ZipFile(filename) as archive:
+        bad = archive.testzip()
+        if bad is not None:
+            failquit('CRC check failed for ' + bad)
+        names = archive.namelist()
+        for name in ['[Content_Types].xml', '_rels/.rels']:
+            if name not in names:
+                failquit('missing ' + name)
+
+        types = parse(archive, '[Content_Types].xml')
+        extensions = {d.get('Extension').lower() for d in types.iter(CONTENT_TYPES + 'Default')}
+        if not {'rels', 'model'} <= extensions:
+            failquit('content types lack rels or model: %s' % extensions)
+
+        models = [r.get('Target').lstrip('/') for r in parse(archive, '_rels/.rels').iter(RELS + 'Relationship')
+                  if r.get('Type', '').endswith('/3dmodel')]
+        if len(models) != 1 or models[0] not in names:
+            failquit('relationships point to no model, or a missing one: %s' % models)
+
+        model = parse(archive, models[0])
+        if model.tag != CORE + 'model':
+            failquit('unexpected root element ' + model.tag)
+        for metadata in model.iter(CORE + 'metadata'):
+            if not metadata.get('name'):
+                failquit('metadata without a name')
+
+        resources = model.find(CORE + 'resources')
+        properties = {}
+        for group in resources.iter(CORE + 'basematerials'):
+            properties[group.get('id')] = len(group.findall(CORE + 'base'))
+        for group in resources.iter(MATERIAL + 'colorgroup'):
+            properties[group.get('id')] = len(group.findall(MATERIAL + 'color'))
+
+        def check_property(element, pid, *indices):
+            if pid is None: return
+            if pid not in properties:
+                failquit('%s refers to missing property group %s' % (element, pid))
+            for index in indices:
+                if index is not None and not 0 <= int(index) < properties[pid]:
+                    failquit('%s refers to missing property %s of group %s' % (element, index, pid))
+
+        objects = set()
+        triangles = 0
+        for obj in resources.iter(CORE + 'object'):
+            objects.add(obj.get('id'))
+            check_property('object ' + obj.get('id'), obj.get('pid'), obj.get('pindex'))
+            mesh = obj.find(CORE + 'mesh')
+            if mesh is None:
+                failquit('object %s has no mesh' % obj.get('id'))
+            numverts = len(mesh.find(CORE + 'vertices').findall(CORE + 'vertex'))
+            for triangle in mesh.find(CORE + 'triangles').iter(CORE + 'triangle'):
+                triangles += 1
+                if any(not 0 <= int(triangle.get(v)) < numverts for v in ['v1', 'v2', 'v3']):
+                    failquit('triangle uses a missing vertex: %s' % triangle.attrib)
+                check_property('triangle', triangle.get('pid', obj.get('pid')),
+                               triangle.get('p1'), triangle.get('p2'), triangle.get('p3'))
+
+        items = model.find(CORE + 'build').findall(CORE + 'item')
+        if not items:
+            failquit('empty build')
+        for item in items:
+            if item.get('objectid') not in objects:
+                failquit('build item refers to missing object ' + item.get('objectid'))
+        return triangles
+
+# Returns the volume and the bounding box of an OFF file
+def measure(filename):
+    with open(filename) as f:
+        tokens = f.read().split('\n', 1)
+    header = tokens[0].split()
+    if header[0] != 'OFF':
+        failquit(filename + ' is not an OFF file')
+    numverts, numfaces = int(header[1]), int(header[2])
+    lines = [line.split() for line in tokens[1].splitlines() if line.strip()]
+    vertices = [[float(c) for c in line[:3]] for line in lines[:numverts]]
+    if not vertices:
+        failquit(filename + ' is empty')
+    volume = 0.0
+    for line in lines[numverts:numverts + numfaces]:
+        n = int(line[0])
+        face = [vertices[int(i)] for i in line[1:n + 1]]
+        # Signed volumes of the tetrahedra of a fan triangulation and the origin
+        for b, c in zip(face[1:-1], face[2:]):
+            a = face[0]
+            volume += (a[0] * (b[1] * c[2] - b[2] * c[1]) -
+                       a[1] * (b[0] * c[2] - b[2] * c[0]) +
+                       a[2] * (b[0] * c[1] - b[1] * c[0])) / 6.0
+    bbox = [min(v[i] for v in vertices) for i in range(3)] + [max(v[i] for v in vertices) for i in range(3)]
+    return volume, bbox
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+threemf, off, imported = basename + '.3mf', basename + '.off', basename + '-imported.off'
+importfile = basename + '-import.scad'
+export(inputfile, threemf)
+export(inputfile, off)
+print('3MF model has %d triangles' % validate(threemf), file=sys.stderr)
+
+with open(importfile, 'w') as f:
+    f.write('import("%s");\n' % threemf.replace('\\', '/'))
+export(importfile, imported)
+
+expected_volume, expected_bbox = measure(off)
+volume, bbox = measure(imported)
+for filename in [threemf, off, imported, importfile]: os.unlink(filename)
+print('Volumes: exported %g, imported %g' % (expected_volume, volume), file=sys.stderr)
+if abs(volume - expected_volume) > 1e-4 * abs(expected_volume):
+    failquit('volumes differ: exported %g, imported %g' % (expected_volume, volume))
+size = max(expected_bbox[i + 3] - expected_bbox[i] for i in range(3))
+if any(abs(a - b) > 1e-4 * size for a, b in zip(bbox, expected_bbox)):
+    failquit('bounding boxes differ: exported %s, imported %s' % (expected_bbox, bbox))
@@ -0,0 +1,101 @@
+/*
+   Checks Frustum::intersects against boxes in front of, behind, beside and
+   straddling the view of a perspective and an orthographic projection.
+
+   Returns non-zero if any box gives the wrong result.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+#include <Eigen/Core>
+
+#include "glview/Frustum.h"
+
+namespace {
+
+// As glFrustum()
+Eigen::Matrix4d perspective(double fovy_degrees, double aspect, double near, double far)
+{
+  const double f = 1 / std::tan(fovy_degrees * M_PI / 360);
+  Eigen::Matrix4d m = Eigen::Matrix4d::Zero();
+  m(0, 0) = f / aspect;
+  m(1, 1) = f;
+  m(2, 2) = (far + near) / (near - far);
+  m(2, 3) = 2 * far * near / (near - far);
+  m(3, 2) = -1;
+  return m;
+}
+
+// As glOrtho()
+Eigen::Matrix4d ortho(double left, double right, double bottom, double top, double near, double far)
+{
+  Eigen::Matrix4d m = Eigen::Matrix4d::Identity();
+  m(0, 0) = 2 / (right - left);
+  m(1, 1) = 2 / (top - bottom);
+  m(2, 2) = -2 / (far - near);
+  m(0, 3) = -(right + left) / (right - left);
+  m(1, 3) = -(top + bottom) / (top - bottom);
+  m(2, 3) = -(far + near) / (far - near);
+  return m;
+}
+
+// The camera at z = 10, looking down the z axis
+Eigen::Matrix4d modelview()
+{
+  Eigen::Matrix4d m = Eigen::Matrix4d::Identity();
+  m(2, 3) = -10;
+  return m;
+}
+
+BoundingBox box(const Vector3d& center, double size)
+{
+  return {center - Vector3d::Constant(size / 2), center + Vector3d::Constant(size / 2)};
+}
+
+int failures = 0;
+
+void check(const std::string& name, const Frustum& frustum, const BoundingBox& box, bool expected)
+{
+  if (frustum.intersects(box) != expected) {
+    std::printf("%s: expected %s\n", name.c_str(), expected ? "visible" : "hidden");
+    ++failures;
+  }
+}
+
+} // namespace
+
+int main()
+{
+  // 90 degrees wide, from 1 to 100 units in front of the camera
+  const Frustum perspective_frustum(perspective(90, 1, 1, 100) * modelview());
+  check("perspective: at the center", perspective_frustum, box({0, 0, 0}, 2), true);
+  check("perspective: far in front", perspective_frustum, box({0, 0, -80}, 2), true);
+  check("perspective: wider than the view", perspective_frustum, box({0, 0, 0}, 1000), true);
+  check("perspective: behind the camera", perspective_frustum, box({0, 0, 20}, 2), false);
+  check("perspective: between camera and near plane", perspective_frustum, box({0, 0, 9.5}, 0.5), false);
+  check("perspective: beyond the far plane", perspective_frustum, box({0, 0, -100}, 2), false);
+  check("perspective: left of the view", perspective_frustum, box({-15, 0, 0}, 2), false);
+  check("perspective: above the view", perspective_frustum, box({0, 15, 0}, 2), false);
+  check("perspective: straddling the left side", perspective_frustum, box({-10, 0, 0}, 2), true);
+  check("perspective: straddling the far plane", perspective_frustum, box({0, 0, -90}, 2), true);
+  check("perspective: empty", perspective_frustum, BoundingBox(), false);
+
+  // 20 by 10 units, from 1 to 100 units in front of the camera
+  const Frustum ortho_frustum(ortho(-10, 10, -5, 5, 1, 100) * modelview());
+  check("ortho: at the center", ortho_frustum, box({0, 0, 0}, 2), true);
+  check("ortho: far in front", ortho_frustum, box({8, 3, -80}, 2), true);
+  check("ortho: behind the camera", ortho_frustum, box({0, 0, 20}, 2), false);
+  check("ortho: beyond the far plane", ortho_frustum, box({0, 0, -100}, 2), false);
+  check("ortho: right of the view", ortho_frustum, box({12, 0, -50}, 2), false);
+  check("ortho: below the view", ortho_frustum, box({0, -7, -50}, 2), false);
+  check("ortho: straddling the top", ortho_frustum, box({0, 5, -50}, 2), true);
+  check("ortho: empty", ortho_frustum, BoundingBox(), false);
+
+  if (failures > 0) {
+    std::printf("%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,64 @@
+#!/usr/bin/env python
+
+# Glyph cache test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the input file, and verifies from the cache statistics that the
+# shaped texts, glyphs and glyph outlines of text() were all found in the
+# font cache at least once, in the log as well as in the JSON summary.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse, re, json
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting glyphcachetest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def export(extra_args):
+    output = basename + '.svg'
+    if os.path.exists(output): os.unlink(output)
+    cmd = [args.openscad, inputfile, '-o', output] + extra_args + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    print(result.stderr, file=sys.stderr)
+    if result.returncode != 0 or not os.path.exists(output):
+        failquit('failed to export ' + output)
+    os.unlink(output)
+    return result.stderr
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+log = export([])
+total_hits = 0
+for level in ['Shaped texts', 'Glyphs', 'Glyph outlines']:
+    m = re.search(level + r' in font cache: \d+ \((\d+) hits, (\d+) misses\)', log)
+    if not m:
+        failquit('no font cache statistics for ' + level.lower())
+    hits, misses = int(m.group(1)), int(m.group(2))
+    if hits == 0 or misses == 0:
+        failquit('%s: expected both hits and misses, got %d hits and %d misses' % (level, hits, misses))
+    total_hits += hits
+
+summary = basename + '.json'
+export(['--summary=cache', '--summary-file=' + summary])
+with open(summary) as f:
+    font_cache = json.load(f).get('cache', {}).get('font_cache')
+os.unlink(summary)
+if font_cache is None:
+    failquit('the summary has no font cache statistics')
+if font_cache['hits'] != total_hits or font_cache['entries'] == 0:
+    failquit('unexpected font cache summary %s, the log had %d hits' % (font_cache, total_hits))
@@ -0,0 +1,95 @@
+#!/usr/bin/env python
+
+# Import cache test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> --changed=<file> [<openscad args>] tmpfilebasename
+#
+# Imports a copy of the input file twice in one --batch process, replacing
+# the copy with the changed file between the two jobs, and verifies that the
+# second job reads the changed file instead of reusing the cached import.
+# Both outputs are compared to the output of a separate process.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, shlex, shutil, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting importcachetest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def read(filename):
+    with open(filename, 'rb') as f:
+        return f.read()
+
+# Runs a job in the batch process and returns whether it succeeded
+def batch_job(process, job):
+    print('Batch job: ' + job, file=sys.stderr)
+    process.stdin.write(job + '\n')
+    process.stdin.flush()
+    for line in process.stdout:
+        line = line.strip()
+        print(line, file=sys.stderr)
+        if line in ('ok', 'error'):
+            return line == 'ok'
+    failquit('batch process exited before finishing the job')
+
+# Exports the model in a process of its own
+def export(model, output):
+    cmd = [args.openscad, model, '-o', output] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    if subprocess.call(cmd) != 0:
+        failquit('failed to export ' + model)
+    return read(output)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+parser.add_argument('--changed', required=True, help='File which replaces the input file between the imports.')
+args,remaining_args = parser.parse_known_args()
+inputfile = remaining_args[0]
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+for filename in [inputfile, args.changed]:
+    if not os.path.exists(filename):
+        failquit('cant find input file named: ' + filename)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+if read(inputfile) == read(args.changed):
+    failquit('the changed file must differ from the input file')
+
+importfile = basename + '-import' + os.path.splitext(inputfile)[1]
+model = basename + '.scad'
+with open(model, 'w') as f:
+    f.write('import("%s");\n' % os.path.basename(importfile))
+
+shutil.copyfile(inputfile, importfile)
+expected = [export(model, basename + '-expected-0.svg')]
+shutil.copyfile(args.changed, importfile)
+expected.append(export(model, basename + '-expected-1.svg'))
+if expected[0] == expected[1]:
+    failquit('the changed file must give a different output')
+
+shutil.copyfile(inputfile, importfile)
+process = subprocess.Popen([args.openscad, '--batch'] + remaining_args,
+                           stdin=subprocess.PIPE, stdout=subprocess.PIPE, text=True)
+outputs = []
+for i in range(2):
+    if i == 1:
+        # Also move the modification time on by two seconds, as the cached
+        # geometry of import() is keyed on the time in seconds
+        mtime = os.stat(importfile).st_mtime
+        shutil.copyfile(args.changed, importfile)
+        os.utime(importfile, (mtime + 2, mtime + 2))
+    outputs.append(basename + '-batch-%d.svg' % i)
+    # Twice each, so the second job may be served from the cache
+    for _ in range(2):
+        if not batch_job(process, '%s -o %s' % (shlex.quote(model), shlex.quote(outputs[i]))):
+            failquit('batch job %d failed' % i)
+        if read(outputs[i]) != expected[i]:
+            failquit('%s differs from the output of a separate process' % outputs[i])
+process.stdin.close()
+if process.wait() != 0:
+    failquit('batch process returned %d' % process.returncode)
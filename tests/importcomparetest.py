@@ -0,0 +1,61 @@
+#!/usr/bin/env python
+
+# Import comparison test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> --reference=<file> [<openscad args>] tmpfilebasename
+#
+# Imports the input file and a reference file of the same format and
+# verifies that both give the same mesh, without warnings. Used for files
+# which only differ in line endings, comments and whitespace.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting importcomparetest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+# Exports the imported file to OFF and returns the output and the console messages
+def import_export(openscad, inputfile, basename, extra_args):
+    scadfile = basename + '.scad'
+    offfile = basename + '.off'
+    with open(scadfile, 'w') as f:
+        f.write('import("' + os.path.abspath(inputfile).replace('\\', '/') + '");\n')
+    export_cmd = [openscad, scadfile, '-o', offfile] + extra_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(export_cmd), file=sys.stderr)
+    sys.stderr.flush()
+    result = subprocess.run(export_cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    print(result.stdout, file=sys.stderr)
+    if result.returncode != 0:
+        failquit('OpenSCAD failed with return code ' + str(result.returncode))
+    with open(offfile) as f:
+        output = f.read()
+    os.unlink(scadfile)
+    os.unlink(offfile)
+    return output, result.stdout
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+parser.add_argument('--reference', required=True, help='Specify the file to compare the import with.')
+args,remaining_args = parser.parse_known_args()
+inputfile = remaining_args[0]
+basename = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+for f in [inputfile, args.reference, args.openscad]:
+    if not os.path.exists(f):
+        failquit('cant find file named: ' + f)
+
+actual, messages = import_export(args.openscad, inputfile, basename + '-input', remaining_args)
+expected, _ = import_export(args.openscad, args.reference, basename + '-reference', remaining_args)
+
+if 'WARNING' in messages or 'ERROR' in messages:
+    failquit('import of ' + inputfile + ' reported problems')
+header = expected.split('\n', 1)[0].split() # OFF <vertices> <faces> <edges>
+if len(header) < 3 or int(header[2]) == 0:
+    failquit('reference import is empty')
+if actual != expected:
+    failquit('imports of ' + inputfile + ' and ' + args.reference + ' differ')
@@ -0,0 +1,137 @@
+/*
+   Checks simplifyMesh() on a finely tessellated sphere: the number of
+   triangles must be near the target, the vertices near the original surface,
+   and the color indices of the faces must be kept. Meshes which are already
+   small enough aren't simplified.
+
+   Returns non-zero if any check fails.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <set>
+#include <vector>
+
+#include "geometry/MeshSimplification.h"
+
+namespace {
+
+struct TestMesh {
+  std::vector<Vector3d> vertices;
+  PolygonIndices indices;
+  std::vector<int32_t> color_indices;
+};
+
+// A sphere with quads between its rings, and triangles at the poles. The
+// upper half has color index 1, the lower half 0.
+TestMesh sphere(double r, int resolution)
+{
+  TestMesh mesh;
+  const int rings = resolution / 2;
+  mesh.vertices.emplace_back(0, 0, -r);
+  for (int i = 1; i < rings; ++i) {
+    const double phi = M_PI * i / rings;
+    for (int j = 0; j < resolution; ++j) {
+      const double theta = 2 * M_PI * j / resolution;
+      mesh.vertices.push_back(r * Vector3d(std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), -std::cos(phi)));
+    }
+  }
+  mesh.vertices.emplace_back(0, 0, r);
+  const int top = static_cast<int>(mesh.vertices.size()) - 1;
+  const auto ring = [resolution](int i, int j) { return 1 + i * resolution + j % resolution; };
+  for (int j = 0; j < resolution; ++j) {
+    mesh.indices.push_back({0, ring(0, j + 1), ring(0, j)});
+    mesh.color_indices.push_back(0);
+    for (int i = 0; i + 2 < rings; ++i) {
+      mesh.indices.push_back({ring(i, j), ring(i, j + 1), ring(i + 1, j + 1), ring(i + 1, j)});
+      mesh.color_indices.push_back(2 * (i + 1) >= rings ? 1 : 0);
+    }
+    mesh.indices.push_back({top, ring(rings - 2, j), ring(rings - 2, j + 1)});
+    mesh.color_indices.push_back(1);
+  }
+  return mesh;
+}
+
+size_t countTriangles(const PolygonIndices& indices)
+{
+  size_t count = 0;
+  for (const auto& face : indices) count += face.size() - 2;
+  return count;
+}
+
+int failures = 0;
+
+void fail(const char *message)
+{
+  std::printf("%s\n", message);
+  ++failures;
+}
+
+} // namespace
+
+int main()
+{
+  const double r = 10;
+  const auto mesh = sphere(r, 256);
+  const size_t num_triangles = countTriangles(mesh.indices);
+
+  if (simplifyMesh(mesh.vertices, mesh.indices, mesh.color_indices, num_triangles)) {
+    fail("a mesh with few enough triangles was simplified");
+  }
+  if (simplifyMesh(mesh.vertices, mesh.indices, mesh.color_indices, 0)) {
+    fail("a mesh was simplified to no triangles");
+  }
+
+  for (const size_t target : {size_t(500), size_t(5000)}) {
+    const auto simplified = simplifyMesh(mesh.vertices, mesh.indices, mesh.color_indices, target);
+    if (!simplified) {
+      fail("the mesh wasn't simplified");
+      continue;
+    }
+    std::printf("%zu triangles simplified to %zu, for a target of %zu\n",
+                num_triangles, simplified->indices.size(), target);
+    if (simplified->indices.size() > target + target / 2 || simplified->indices.size() < target / 4) {
+      fail("the number of triangles is far from the target");
+    }
+
+    double max_error = 0;
+    for (const auto& v : simplified->vertices) max_error = std::max(max_error, std::abs(v.norm() - r));
+    const double cell_size = std::sqrt(4 * M_PI * r * r * 2 / target);
+    std::printf("Largest distance of a vertex from the sphere: %g\n", max_error);
+    if (max_error > cell_size / 2) fail("a vertex is far from the sphere");
+
+    if (simplified->color_indices.size() != simplified->indices.size()) {
+      fail("the color indices don't match the faces");
+      continue;
+    }
+    std::set<int32_t> colors;
+    for (size_t i = 0; i < simplified->indices.size(); ++i) {
+      const auto& face = simplified->indices[i];
+      if (face.size() != 3) {
+        fail("a face isn't a triangle");
+        break;
+      }
+      colors.insert(simplified->color_indices[i]);
+      // Faces well away from the equator keep the color of their half
+      double z = 0;
+      for (const int v : face) z += simplified->vertices[v][2] / 3;
+      if (std::abs(z) > cell_size && simplified->color_indices[i] != (z > 0 ? 1 : 0)) {
+        fail("a face has the color of the other half of the sphere");
+        break;
+      }
+    }
+    if (colors != std::set<int32_t>{0, 1}) fail("colors were lost");
+  }
+
+  // Without color indices, none are returned
+  const auto uncolored = simplifyMesh(mesh.vertices, mesh.indices, {}, 1000);
+  if (!uncolored || !uncolored->color_indices.empty()) fail("color indices of an uncolored mesh");
+
+  if (failures > 0) {
+    std::printf("%d checks failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+
+# Manifold minkowski test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the input file with the Manifold and the CGAL backends, and verifies that:
+# - Manifold computes the minkowski sums itself, without falling back to Nef polyhedra
+# - both results have the same volume and bounding box
+#
+# The input should contain minkowski sums of non-convex objects, whose convex
+# parts are hulled pairwise and unioned.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting minkowskitest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+# Exports the input file with the given backend, and returns the log
+def export(output, backend):
+    if os.path.exists(output): os.unlink(output)
+    cmd = [args.openscad, inputfile, '-o', output, '--backend=' + backend] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    print(result.stderr, file=sys.stderr)
+    if result.returncode != 0 or not os.path.exists(output):
+        failquit('failed to export ' + output)
+    return result.stderr
+
+# Returns the volume and the bounding box of an OFF file
+def measure(filename):
+    with open(filename) as f:
+        tokens = f.read().split('\n', 1)
+    header = tokens[0].split()
+    if header[0] != 'OFF':
+        failquit(filename + ' is not an OFF file')
+    numverts, numfaces = int(header[1]), int(header[2])
+    lines = [line.split() for line in tokens[1].splitlines() if line.strip()]
+    vertices = [[float(c) for c in line[:3]] for line in lines[:numverts]]
+    if not vertices:
+        failquit(filename + ' is empty')
+    volume = 0.0
+    for line in lines[numverts:numverts + numfaces]:
+        n = int(line[0])
+        face = [vertices[int(i)] for i in line[1:n + 1]]
+        # Signed volumes of the tetrahedra of a fan triangulation and the origin
+        for b, c in zip(face[1:-1], face[2:]):
+            a = face[0]
+            volume += (a[0] * (b[1] * c[2] - b[2] * c[1]) -
+                       a[1] * (b[0] * c[2] - b[2] * c[0]) +
+                       a[2] * (b[0] * c[1] - b[1] * c[0])) / 6.0
+    bbox = [min(v[i] for v in vertices) for i in range(3)] + [max(v[i] for v in vertices) for i in range(3)]
+    return volume, bbox
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+manifold_log = export(basename + '-manifold.off', 'manifold')
+if 'falling back to Nef' in manifold_log:
+    failquit('Manifold fell back to Nef polyhedra')
+export(basename + '-cgal.off', 'cgal')
+
+manifold_volume, manifold_bbox = measure(basename + '-manifold.off')
+cgal_volume, cgal_bbox = measure(basename + '-cgal.off')
+os.unlink(basename + '-manifold.off')
+os.unlink(basename + '-cgal.off')
+print('Volumes: manifold %g, cgal %g' % (manifold_volume, cgal_volume), file=sys.stderr)
+if abs(manifold_volume - cgal_volume) > 1e-6 * abs(cgal_volume):
+    failquit('volumes differ: manifold %g, cgal %g' % (manifold_volume, cgal_volume))
+size = max(cgal_bbox[i + 3] - cgal_bbox[i] for i in range(3))
+if any(abs(m - c) > 1e-6 * size for m, c in zip(manifold_bbox, cgal_bbox)):
+    failquit('bounding boxes differ: manifold %s, cgal %s' % (manifold_bbox, cgal_bbox))
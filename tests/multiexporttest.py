@@ -0,0 +1,145 @@
+#!/usr/bin/env python
+
+# Multiple output export test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the input file to several 2D and 3D formats in one run, with one
+# -o option per output, and verifies that:
+# - every format which can be exported on its own is written, identical to
+#   the output of a run with only that format
+# - formats of the wrong dimension are skipped, without stopping the others,
+#   and make the run return non-zero
+# - --summary time lists the export time of each written file, both in the
+#   log and in the --summary-file JSON
+# - when the formats are exported at the same time in a locale with a ','
+#   radix, numbers are still written with a '.'
+#
+# This script should return 0 on success, not-0 on error.
+
+import json, sys, subprocess, os, re, locale, argparse
+
+FORMATS = ['stl', 'off', 'obj', 'svg', 'dxf']
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting multiexporttest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def run(cmd):
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    print(result.stdout, file=sys.stderr)
+    return result
+
+def read(filename):
+    with open(filename, 'rb') as f:
+        return f.read()
+
+# A locale installed on this system which writes 0.5 as 0,5
+def comma_locale():
+    for name in ['de_DE.UTF-8', 'de_DE.utf8', 'fr_FR.UTF-8', 'fr_FR.utf8', 'nl_NL.UTF-8', 'German_Germany.1252']:
+        try:
+            locale.setlocale(locale.LC_NUMERIC, name)
+        except locale.Error:
+            continue
+        radix = locale.localeconv()['decimal_point']
+        locale.setlocale(locale.LC_NUMERIC, 'C')
+        if radix == ',': return name
+    return None
+
+def remove(filenames):
+    for filename in filenames:
+        if os.path.exists(filename): os.unlink(filename)
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = remaining_args[0]
+basename = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+# Reference outputs, one format per run
+single = {}
+for fmt in FORMATS:
+    output = basename + '-single.' + fmt
+    remove([output])
+    if run([args.openscad, inputfile, '-o', output] + remaining_args).returncode == 0:
+        single[fmt] = read(output)
+    remove([output])
+if not single:
+    failquit('no format could be exported')
+skipped = [fmt for fmt in FORMATS if fmt not in single]
+print('exportable: %s, skipped: %s' % (' '.join(single), ' '.join(skipped)), file=sys.stderr)
+
+outputs = {fmt: basename + '-multi.' + fmt for fmt in FORMATS}
+summaryfile = basename + '-summary.json'
+remove(list(outputs.values()) + [summaryfile])
+cmd = [args.openscad, inputfile]
+for fmt in FORMATS:
+    cmd += ['-o', outputs[fmt]]
+
+# All outputs in one run, with the time summary in the log
+result = run(cmd + ['--summary', 'time'] + remaining_args)
+if (result.returncode != 0) != bool(skipped):
+    failquit('unexpected return code %d' % result.returncode)
+for fmt in FORMATS:
+    if fmt in skipped:
+        if os.path.exists(outputs[fmt]):
+            failquit(outputs[fmt] + ' should not have been written')
+        continue
+    if not os.path.exists(outputs[fmt]):
+        failquit(outputs[fmt] + ' was not written')
+    if read(outputs[fmt]) != single[fmt]:
+        failquit(outputs[fmt] + ' differs from the output of a single export')
+    if ('Export time for ' + outputs[fmt] + ':') not in result.stdout:
+        failquit('no export time logged for ' + outputs[fmt])
+remove(list(outputs.values()))
+
+# The same with the time summary written to a JSON file
+result = run(cmd + ['--summary', 'time', '--summary-file', summaryfile] + remaining_args)
+if (result.returncode != 0) != bool(skipped):
+    failquit('unexpected return code %d' % result.returncode)
+with open(summaryfile) as f:
+    summary = json.load(f)
+exports = summary.get('time', {}).get('exports', [])
+files = [export['file'] for export in exports]
+if sorted(files) != sorted(outputs[fmt] for fmt in single):
+    failquit('unexpected export times in ' + summaryfile + ': ' + ' '.join(files))
+if any(not isinstance(export.get('total'), int) or export['total'] < 0 for export in exports):
+    failquit('bad export time in ' + summaryfile)
+remove(list(outputs.values()) + [summaryfile])
+
+# Fractional coordinates exported together, with the user's locale using ','
+name = comma_locale()
+if not name:
+    print('no locale with a comma radix is installed, skipping the locale check', file=sys.stderr)
+    sys.exit(0)
+env = dict(os.environ, LC_ALL=name, LANG=name, LC_NUMERIC=name)
+for model, formats in [('translate([0.5, 0.25]) square([10.5, 2.25]);\n', ['svg', 'dxf']),
+                       ('translate([0.5, 0.25, 0.125]) cube([10.5, 2.25, 3.5]);\n', ['stl', 'off', 'obj', 'amf'])]:
+    scad = basename + '-fraction.scad'
+    with open(scad, 'w') as f:
+        f.write(model)
+    outputs = {fmt: basename + '-fraction.' + fmt for fmt in formats}
+    remove(outputs.values())
+    cmd = [args.openscad, scad]
+    for fmt in formats:
+        cmd += ['-o', outputs[fmt]]
+    print('LC_ALL=' + name, file=sys.stderr)
+    result = subprocess.run(cmd + remaining_args, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    print(result.stdout, file=sys.stderr)
+    if result.returncode != 0:
+        failquit('failed to export fractional coordinates in locale ' + name)
+    for fmt in formats:
+        text = read(outputs[fmt]).decode()
+        if '0.5' not in text or re.search(r'\d,\d', text):
+            failquit('%s is not written with a . radix in locale %s' % (outputs[fmt], name))
+    remove(list(outputs.values()) + [scad])
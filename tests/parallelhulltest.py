@@ -0,0 +1,94 @@
+#!/usr/bin/env python
+
+# Parallel hull test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the input file to OFF with reference=false and with reference=true,
+# and verifies that:
+# - only the first export takes the parallel hull path, with its point prefilter
+# - both hulls have the same number of vertices, volume and bounding box
+#
+# The input should hull enough points for the parallel path, and with
+# reference=true, hull the same points in groups which are too small for it.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting parallelhulltest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+# Exports the input file, and returns whether the parallel hull path was taken
+def export(output, reference):
+    if os.path.exists(output): os.unlink(output)
+    cmd = [args.openscad, inputfile, '-o', output, '-D', 'reference=' + reference, '--debug=cgalutils-hull'] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE, universal_newlines=True)
+    if result.returncode != 0 or not os.path.exists(output):
+        print(result.stderr, file=sys.stderr)
+        failquit('failed to export ' + output)
+    prefiltered = [line for line in result.stderr.splitlines() if 'Hull: prefilter kept' in line]
+    for line in prefiltered:
+        print(line, file=sys.stderr)
+    return len(prefiltered) > 0
+
+# Returns the number of vertices, the volume and the bounding box of an OFF file
+def measure(filename):
+    with open(filename) as f:
+        tokens = f.read().split('\n', 1)
+    header = tokens[0].split()
+    if header[0] != 'OFF':
+        failquit(filename + ' is not an OFF file')
+    numverts, numfaces = int(header[1]), int(header[2])
+    lines = [line.split() for line in tokens[1].splitlines() if line.strip()]
+    vertices = [[float(c) for c in line[:3]] for line in lines[:numverts]]
+    if not vertices:
+        failquit(filename + ' is empty')
+    volume = 0.0
+    for line in lines[numverts:numverts + numfaces]:
+        n = int(line[0])
+        face = [vertices[int(i)] for i in line[1:n + 1]]
+        # Signed volumes of the tetrahedra of a fan triangulation and the origin
+        for b, c in zip(face[1:-1], face[2:]):
+            a = face[0]
+            volume += (a[0] * (b[1] * c[2] - b[2] * c[1]) -
+                       a[1] * (b[0] * c[2] - b[2] * c[0]) +
+                       a[2] * (b[0] * c[1] - b[1] * c[0])) / 6.0
+    bbox = [min(v[i] for v in vertices) for i in range(3)] + [max(v[i] for v in vertices) for i in range(3)]
+    return numverts, volume, bbox
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+parallel, serial = basename + '-parallel.off', basename + '-serial.off'
+if not export(parallel, 'false'):
+    failquit('the hull did not take the parallel path')
+if export(serial, 'true'):
+    failquit('the reference hulls took the parallel path')
+parallel_vertices, parallel_volume, parallel_bbox = measure(parallel)
+serial_vertices, serial_volume, serial_bbox = measure(serial)
+os.unlink(parallel)
+os.unlink(serial)
+
+print('Vertices: parallel %d, serial %d' % (parallel_vertices, serial_vertices), file=sys.stderr)
+print('Volumes: parallel %.9g, serial %.9g' % (parallel_volume, serial_volume), file=sys.stderr)
+# Both take the hull of the same points with the same kernel, so the hulls are the same
+if parallel_vertices != serial_vertices:
+    failquit('numbers of vertices differ: parallel %d, serial %d' % (parallel_vertices, serial_vertices))
+if abs(parallel_volume - serial_volume) > 1e-9 * abs(serial_volume):
+    failquit('volumes differ: parallel %.9g, serial %.9g' % (parallel_volume, serial_volume))
+if parallel_bbox != serial_bbox:
+    failquit('bounding boxes differ: parallel %s, serial %s' % (parallel_bbox, serial_bbox))
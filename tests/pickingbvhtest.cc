@@ -0,0 +1,259 @@
+/*
+   Compares the vertex, edge and triangle picking of PickingBVH with a
+   brute-force search over every vertex, edge and triangle, and reports the
+   time of both.
+
+   Usage: pickingbvhtest [<resolution> [<rays>]]
+
+   The scene is a grid of spheres, with about 2 * resolution^2 triangles each.
+   Half the rays are aimed at vertices, the others pass through random points
+   of the scene. Returns non-zero if any query gives a different result.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "glview/PickingBVH.h"
+#include "glview/cgal/CGALRenderUtils.h"
+
+namespace {
+
+struct TestMesh {
+  std::vector<Vector3d> vertices;
+  PolygonIndices indices;
+};
+
+// A sphere with quads between its rings, and triangles at the poles
+std::shared_ptr<TestMesh> sphere(const Vector3d& center, double r, int resolution)
+{
+  auto mesh = std::make_shared<TestMesh>();
+  const int rings = resolution / 2;
+  mesh->vertices.push_back(center + Vector3d(0, 0, -r));
+  for (int i = 1; i < rings; ++i) {
+    const double phi = M_PI * i / rings;
+    for (int j = 0; j < resolution; ++j) {
+      const double theta = 2 * M_PI * j / resolution;
+      mesh->vertices.push_back(center + r * Vector3d(std::sin(phi) * std::cos(theta), std::sin(phi) * std::sin(theta), -std::cos(phi)));
+    }
+  }
+  mesh->vertices.push_back(center + Vector3d(0, 0, r));
+  const int top = static_cast<int>(mesh->vertices.size()) - 1;
+  const auto ring = [resolution](int i, int j) { return 1 + i * resolution + j % resolution; };
+  for (int j = 0; j < resolution; ++j) {
+    mesh->indices.push_back({0, ring(0, j + 1), ring(0, j)});
+    for (int i = 0; i + 2 < rings; ++i) {
+      mesh->indices.push_back({ring(i, j), ring(i, j + 1), ring(i + 1, j + 1), ring(i + 1, j)});
+    }
+    mesh->indices.push_back({top, ring(rings - 2, j), ring(rings - 2, j + 1)});
+  }
+  return mesh;
+}
+
+// Deterministic, so failures can be reproduced
+class Random
+{
+public:
+  double next() {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<double>(state >> 11) / static_cast<double>(1ULL << 53);
+  }
+  Vector3d point(const BoundingBox& box) {
+    return box.min() + Vector3d(next(), next(), next()).cwiseProduct(box.sizes());
+  }
+private:
+  uint64_t state{42};
+};
+
+// The position along the segment of the nearest vertex within tolerance
+std::optional<double> bruteForceVertex(const std::vector<std::shared_ptr<TestMesh>>& meshes,
+                                       const Vector3d& near_pt, const Vector3d& far_pt, double tolerance)
+{
+  const double length = (far_pt - near_pt).norm();
+  std::optional<double> best;
+  for (const auto& mesh : meshes) {
+    for (const auto& pt : mesh->vertices) {
+      double dist_near;
+      const double dist = calculateLinePointDistance(near_pt, far_pt, pt, dist_near);
+      if (dist < tolerance && (!best || dist_near / length < *best)) best = dist_near / length;
+    }
+  }
+  return best;
+}
+
+// The position along the segment of the nearest edge within tolerance
+std::optional<double> bruteForceEdge(const std::vector<std::shared_ptr<TestMesh>>& meshes,
+                                     const Vector3d& near_pt, const Vector3d& far_pt, double tolerance)
+{
+  const Vector3d dir = far_pt - near_pt;
+  std::optional<double> best;
+  for (const auto& mesh : meshes) {
+    for (const auto& face : mesh->indices) {
+      for (size_t i = 0; i < face.size(); ++i) {
+        const auto& a = mesh->vertices[face[i]];
+        const Vector3d u = mesh->vertices[face[(i + 1) % face.size()]] - a;
+        const Vector3d w = a - near_pt;
+        const double uu = u.dot(u), ud = u.dot(dir), dd = dir.dot(dir), uw = u.dot(w), dw = dir.dot(w);
+        const double denominator = uu * dd - ud * ud;
+        if (denominator <= 1e-12 * uu * dd) continue;
+        const double s = (ud * dw - dd * uw) / denominator;
+        const double t = (uu * dw - ud * uw) / denominator;
+        if (s < 0 || s > 1 || t < 0 || t > 1) continue;
+        if ((a + s * u - (near_pt + t * dir)).norm() < tolerance && (!best || t < *best)) best = t;
+      }
+    }
+  }
+  return best;
+}
+
+// The position along the segment of the first triangle it hits
+std::optional<double> bruteForceTriangle(const std::vector<std::shared_ptr<TestMesh>>& meshes,
+                                         const Vector3d& near_pt, const Vector3d& far_pt)
+{
+  const Vector3d dir = far_pt - near_pt;
+  std::optional<double> best;
+  for (const auto& mesh : meshes) {
+    for (const auto& face : mesh->indices) {
+      for (size_t i = 2; i < face.size(); ++i) {
+        const auto& a = mesh->vertices[face[0]];
+        const Vector3d e1 = mesh->vertices[face[i - 1]] - a;
+        const Vector3d e2 = mesh->vertices[face[i]] - a;
+        const Vector3d p = dir.cross(e2);
+        const double det = e1.dot(p);
+        if (det == 0) continue;
+        const Vector3d s = near_pt - a;
+        const double u = s.dot(p) / det;
+        const Vector3d q = s.cross(e1);
+        const double v = dir.dot(q) / det;
+        const double t = e2.dot(q) / det;
+        if (u < 0 || u > 1 || v < 0 || u + v > 1 || t < 0 || t > 1) continue;
+        if (!best || t < *best) best = t;
+      }
+    }
+  }
+  return best;
+}
+
+bool same(const std::optional<double>& a, const std::optional<double>& b)
+{
+  return a.has_value() == b.has_value() && (!a || std::abs(*a - *b) <= 1e-9);
+}
+
+double seconds(std::chrono::steady_clock::duration duration)
+{
+  return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+  const int resolution = argc > 1 ? std::max(8, std::atoi(argv[1])) : 64;
+  const int num_rays = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+
+  std::vector<std::shared_ptr<TestMesh>> meshes;
+  BoundingBox scene;
+  for (int x = 0; x < 3; ++x) {
+    for (int y = 0; y < 3; ++y) {
+      meshes.push_back(sphere(Vector3d(x * 25, y * 25, (x + y) % 2 * 10), 10, resolution));
+      for (const auto& pt : meshes.back()->vertices) scene.extend(pt);
+    }
+  }
+  std::vector<PickingBVH::Mesh> bvh_meshes;
+  size_t num_faces = 0;
+  for (const auto& mesh : meshes) {
+    bvh_meshes.push_back({mesh, &mesh->vertices, &mesh->indices});
+    num_faces += mesh->indices.size();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  const PickingBVH bvh(std::move(bvh_meshes));
+  const double build_time = seconds(std::chrono::steady_clock::now() - start);
+
+  // The segments span the whole scene, like those between the clipping planes
+  Random random;
+  const double span = scene.sizes().norm();
+  std::vector<std::pair<Vector3d, Vector3d>> rays;
+  for (int i = 0; i < num_rays; ++i) {
+    const Vector3d target = i % 2 == 0
+      ? meshes[i / 2 % meshes.size()]->vertices[static_cast<size_t>(random.next() * meshes[i / 2 % meshes.size()]->vertices.size())]
+      : random.point(scene);
+    const Vector3d dir = (Vector3d(random.next(), random.next(), random.next()) - Vector3d::Constant(0.5)).normalized();
+    rays.emplace_back(target - 2 * span * dir, target + 2 * span * dir);
+  }
+  const double tolerance = 0.05;
+
+  int failures = 0;
+  int vertex_hits = 0, edge_hits = 0, triangle_hits = 0;
+  std::chrono::steady_clock::duration bvh_time{}, brute_time{};
+  for (const auto& [near_pt, far_pt] : rays) {
+    start = std::chrono::steady_clock::now();
+    const auto vertex = bvh.findVertex(near_pt, far_pt, tolerance);
+    const auto edge = bvh.findEdge(near_pt, far_pt, tolerance);
+    const auto hit = bvh.intersect(near_pt, far_pt);
+    bvh_time += std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    const auto brute_vertex = bruteForceVertex(meshes, near_pt, far_pt, tolerance);
+    const auto brute_edge = bruteForceEdge(meshes, near_pt, far_pt, tolerance);
+    const auto brute_triangle = bruteForceTriangle(meshes, near_pt, far_pt);
+    brute_time += std::chrono::steady_clock::now() - start;
+
+    const double length = (far_pt - near_pt).norm();
+    std::optional<double> vertex_t, edge_t;
+    if (vertex) {
+      double dist_near;
+      calculateLinePointDistance(near_pt, far_pt, *vertex, dist_near);
+      vertex_t = dist_near / length;
+    }
+    if (edge) {
+      // The position of the edge is checked through the brute-force search's formula
+      const Vector3d u = edge->second - edge->first;
+      const Vector3d dir = far_pt - near_pt;
+      const Vector3d w = edge->first - near_pt;
+      const double uu = u.dot(u), ud = u.dot(dir), dd = dir.dot(dir), uw = u.dot(w), dw = dir.dot(w);
+      edge_t = (uu * dw - ud * uw) / (uu * dd - ud * ud);
+    }
+    if (!same(vertex_t, brute_vertex)) {
+      std::printf("Vertex mismatch for the ray from [%g, %g, %g] to [%g, %g, %g]\n",
+                  near_pt[0], near_pt[1], near_pt[2], far_pt[0], far_pt[1], far_pt[2]);
+      ++failures;
+    }
+    if (!same(edge_t, brute_edge)) {
+      std::printf("Edge mismatch for the ray from [%g, %g, %g] to [%g, %g, %g]\n",
+                  near_pt[0], near_pt[1], near_pt[2], far_pt[0], far_pt[1], far_pt[2]);
+      ++failures;
+    }
+    const auto triangle_t = hit ? std::optional<double>(hit->t) : std::nullopt;
+    if (!same(triangle_t, brute_triangle) ||
+        (hit && (hit->point - (near_pt + hit->t * (far_pt - near_pt))).norm() > 1e-9)) {
+      std::printf("Triangle mismatch for the ray from [%g, %g, %g] to [%g, %g, %g]\n",
+                  near_pt[0], near_pt[1], near_pt[2], far_pt[0], far_pt[1], far_pt[2]);
+      ++failures;
+    }
+    if (vertex) ++vertex_hits;
+    if (edge) ++edge_hits;
+    if (hit) ++triangle_hits;
+  }
+
+  std::printf("%zu meshes, %zu faces, %d rays: %d vertices, %d edges and %d triangles found\n",
+              meshes.size(), num_faces, num_rays, vertex_hits, edge_hits, triangle_hits);
+  std::printf("Build: %.3fs, BVH queries: %.3fs, brute force: %.3fs (%.0fx)\n", build_time,
+              seconds(bvh_time), seconds(brute_time), seconds(brute_time) / std::max(seconds(bvh_time), 1e-9));
+  if (vertex_hits == 0 || edge_hits == 0 || triangle_hits == 0) {
+    std::printf("No vertex, edge or triangle was found, so the comparison is meaningless\n");
+    return 1;
+  }
+  if (failures > 0) {
+    std::printf("%d queries differ from the brute-force search\n", failures);
+    return 1;
+  }
+  return 0;
+}
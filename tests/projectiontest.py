@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+
+# Projection comparison test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the projections of the input file to SVG with the CGAL and the
+# Manifold backend and verifies that both have the same outlines and area.
+# The area is summed with the winding of each outline, so a hole which is
+# filled in shows up as a difference.
+#
+# This script should return 0 on success, not-0 on error.
+
+import re, sys, subprocess, os, argparse
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting projectiontest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+# Returns the signed areas of the outlines of an SVG exported by OpenSCAD
+def outline_areas(svgfile):
+    with open(svgfile) as f:
+        data = f.read()
+    areas = []
+    for outline in re.findall(r'M([^z]*)z', data):
+        points = [tuple(float(c) for c in p.split(',')) for p in re.findall(r'[-\d.e+]+,[-\d.e+]+', outline)]
+        area = 0.0
+        for i in range(len(points)):
+            x0, y0 = points[i]
+            x1, y1 = points[(i + 1) % len(points)]
+            area += x0 * y1 - x1 * y0
+        areas.append(area / 2)
+    return areas
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = remaining_args[0]
+basename = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+results = {}
+for backend in ['cgal', 'manifold']:
+    svgfile = basename + '-' + backend + '.svg'
+    export_cmd = [args.openscad, inputfile, '-o', svgfile, '--backend=' + backend] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(export_cmd), file=sys.stderr)
+    sys.stderr.flush()
+    subprocess.check_call(export_cmd)
+    results[backend] = outline_areas(svgfile)
+    os.unlink(svgfile)
+
+cgal, manifold = results['cgal'], results['manifold']
+print('cgal outlines: %d, area: %g' % (len(cgal), abs(sum(cgal))), file=sys.stderr)
+print('manifold outlines: %d, area: %g' % (len(manifold), abs(sum(manifold))), file=sys.stderr)
+if len(cgal) != len(manifold):
+    failquit('different number of outlines')
+if abs(abs(sum(cgal)) - abs(sum(manifold))) > 1e-6 * max(1.0, abs(sum(manifold))):
+    failquit('different projected area')
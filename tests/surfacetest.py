@@ -0,0 +1,149 @@
+#!/usr/bin/env python
+
+# surface() heightmap test
+#
+# Usage: <script> <datfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports surface() of the heightmap to OFF, with and without a tolerance,
+# and verifies that:
+# - every mesh is closed, with each edge used once in each direction
+# - without tolerance, the volume is that of four triangles per cell meeting
+#   at the average height of the cell's corners, and the top has a vertex at
+#   every grid point
+# - with tolerance, flat regions are meshed with fewer faces, no vertex leaves
+#   the range of the heightmap, and the volume changes by at most the
+#   tolerance times the area. A tolerance below the smallest step in the
+#   heightmap only simplifies exactly flat regions, so it keeps the volume.
+# - a negative tolerance is ignored with a warning
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse
+from collections import Counter
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting surfacetest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def read_dat(filename):
+    rows = []
+    with open(filename) as f:
+        for line in f:
+            line = line.strip()
+            if line and not line.startswith('#'):
+                rows.append([float(value) for value in line.split()])
+    return rows
+
+def read_off(filename):
+    with open(filename) as f:
+        tokens = f.read().split()
+    if tokens[0] != 'OFF':
+        failquit(filename + ' is not an OFF file')
+    nverts, nfaces = int(tokens[1]), int(tokens[2])
+    pos = 4
+    vertices = []
+    for _ in range(nverts):
+        vertices.append(tuple(float(c) for c in tokens[pos:pos + 3]))
+        pos += 3
+    faces = []
+    for _ in range(nfaces):
+        n = int(tokens[pos])
+        faces.append([int(i) for i in tokens[pos + 1:pos + 1 + n]])
+        pos += 1 + n
+    return vertices, faces
+
+# Every edge must be used once in each direction
+def check_closed(name, faces):
+    edges = Counter()
+    for face in faces:
+        for i in range(len(face)):
+            edges[(face[i], face[(i + 1) % len(face)])] += 1
+    for (a, b), count in edges.items():
+        if count != 1 or edges[(b, a)] != 1:
+            failquit('%s: mesh is not closed at edge %d-%d' % (name, a, b))
+
+def volume(vertices, faces):
+    total = 0.0
+    for face in faces:
+        p0 = vertices[face[0]]
+        for i in range(1, len(face) - 1):
+            p1, p2 = vertices[face[i]], vertices[face[i + 1]]
+            total += (p0[0] * (p1[1] * p2[2] - p1[2] * p2[1])
+                      - p0[1] * (p1[0] * p2[2] - p1[2] * p2[0])
+                      + p0[2] * (p1[0] * p2[1] - p1[1] * p2[0]))
+    return total / 6
+
+def run(tolerance):
+    model = '%s-%s.scad' % (basename, tolerance)
+    output = '%s-%s.off' % (basename, tolerance)
+    with open(model, 'w') as f:
+        f.write('surface("%s", tolerance=%s);\n' % (os.path.abspath(datfile).replace('\\', '/'), tolerance))
+    if os.path.exists(output): os.unlink(output)
+    cmd = [args.openscad, model, '-o', output] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    print(result.stdout, file=sys.stderr)
+    if result.returncode != 0:
+        failquit('failed to export surface with tolerance ' + str(tolerance))
+    vertices, faces = read_off(output)
+    os.unlink(model)
+    os.unlink(output)
+    check_closed('tolerance=%s' % tolerance, faces)
+    return vertices, faces, result.stdout
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+datfile = remaining_args[0]
+basename = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(datfile):
+    failquit('cant find input file named: ' + datfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+heights = read_dat(datfile)
+lines, columns = len(heights), len(heights[0])
+if any(len(row) != columns for row in heights):
+    failquit('rows of the heightmap must have the same length')
+cells = (lines - 1) * (columns - 1)
+maxh = max(max(row) for row in heights)
+values = sorted(set(h for row in heights for h in row))
+min_step = min(b - a for a, b in zip(values, values[1:]))
+
+# Without tolerance
+vertices, faces, _ = run(0)
+bottom = min(v[2] for v in vertices)
+expected = sum((heights[r][c] + heights[r][c + 1] + heights[r + 1][c] + heights[r + 1][c + 1]) / 4 - bottom
+               for r in range(lines - 1) for c in range(columns - 1))
+reference = volume(vertices, faces)
+if abs(reference - expected) > 1e-6 * expected:
+    failquit('volume %g differs from the expected %g' % (reference, expected))
+top = set(vertices)
+for r in range(lines):
+    for c in range(columns):
+        if (float(c), float(r), heights[r][c]) not in top:
+            failquit('no vertex at grid point %d,%d' % (c, r))
+nfaces = len(faces)
+
+# A negative tolerance is ignored
+vertices, faces, log = run(-1)
+if 'must not be negative' not in log:
+    failquit('no warning for a negative tolerance')
+if len(faces) != nfaces or abs(volume(vertices, faces) - reference) > 1e-6 * reference:
+    failquit('a negative tolerance changed the mesh')
+
+for tolerance in [min_step / 2, 0.25, 1]:
+    vertices, faces, _ = run(tolerance)
+    if len(faces) >= nfaces:
+        failquit('tolerance=%s: %d faces, not fewer than the %d without tolerance' % (tolerance, len(faces), nfaces))
+    if any(v[2] < bottom or v[2] > maxh for v in vertices):
+        failquit('tolerance=%s: vertex outside of the heights of the heightmap' % tolerance)
+    difference = abs(volume(vertices, faces) - reference)
+    limit = 1e-6 * reference if tolerance < min_step else tolerance * cells
+    if difference > limit:
+        failquit('tolerance=%s: volume changed by %g, more than %g' % (tolerance, difference, limit))
@@ -0,0 +1,83 @@
+#!/usr/bin/env python
+
+# Tiled 2D union test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Exports the input file to SVG with reference=false and with reference=true,
+# and verifies that both have the same area, bounding box and number of
+# outlines. The input should union enough operands to be split into spatial
+# tiles, and with reference=true, union the same operands in groups which are
+# too small to be tiled.
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, argparse, re
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting tiledunionstest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def export(output, reference):
+    if os.path.exists(output): os.unlink(output)
+    cmd = [args.openscad, inputfile, '-o', output, '-D', 'reference=' + reference] + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    if subprocess.call(cmd) != 0 or not os.path.exists(output):
+        failquit('failed to export ' + output)
+
+# Returns the signed area, the bounding box and the number of outlines of an SVG file
+def measure(filename):
+    with open(filename) as f:
+        svg = f.read()
+    area = 0.0
+    outlines = 0
+    points = []
+    for d in re.findall(r'<path d="([^"]*)"', svg):
+        for outline in d.split('z'):
+            vertices = [(float(x), float(y)) for x, y in re.findall(r'[ML]\s*([-+0-9.eE]+),([-+0-9.eE]+)', outline)]
+            if not vertices: continue
+            outlines += 1
+            points += vertices
+            # Holes wind the other way round, so they are subtracted
+            for (x1, y1), (x2, y2) in zip(vertices, vertices[1:] + vertices[:1]):
+                area += (x1 * y2 - x2 * y1) / 2
+    if not points:
+        failquit(filename + ' is empty')
+    bbox = [min(p[i] for p in points) for i in range(2)] + [max(p[i] for p in points) for i in range(2)]
+    return area, bbox, outlines
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = os.path.abspath(remaining_args[0])
+basename = os.path.abspath(remaining_args[-1])
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+tiled, reference = basename + '-tiled.svg', basename + '-reference.svg'
+export(tiled, 'false')
+export(reference, 'true')
+tiled_area, tiled_bbox, tiled_outlines = measure(tiled)
+reference_area, reference_bbox, reference_outlines = measure(reference)
+os.unlink(tiled)
+os.unlink(reference)
+
+print('Areas: tiled %.9g, reference %.9g' % (tiled_area, reference_area), file=sys.stderr)
+print('Outlines: tiled %d, reference %d' % (tiled_outlines, reference_outlines), file=sys.stderr)
+if tiled_outlines < 2:
+    failquit('the result has no holes, so the seams between tiles are not tested')
+if tiled_outlines != reference_outlines:
+    failquit('numbers of outlines differ: tiled %d, reference %d' % (tiled_outlines, reference_outlines))
+# The tiles are unioned again at the same scale, so only intersections along their seams may be rounded differently
+if abs(tiled_area - reference_area) > 1e-6 * abs(reference_area):
+    failquit('areas differ: tiled %.9g, reference %.9g' % (tiled_area, reference_area))
+size = max(reference_bbox[i + 2] - reference_bbox[i] for i in range(2))
+if any(abs(t - r) > 1e-6 * size for t, r in zip(tiled_bbox, reference_bbox)):
+    failquit('bounding boxes differ: tiled %s, reference %s' % (tiled_bbox, reference_bbox))
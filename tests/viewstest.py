@@ -0,0 +1,193 @@
+#!/usr/bin/env python
+
+# Multiple views test
+#
+# Usage: <script> <inputfile> --openscad=<executable-path> [<openscad args>] tmpfilebasename
+#
+# Renders several views of the input file with --views and verifies that:
+# - --views_layout files writes a numbered PNG for each camera, the same as
+#   exporting with that --camera
+# - --views_layout sheet tiles the views into one PNG, row by row, leaving
+#   the rest of the last row as background, to a file or stdout
+# - --views=turntable:N writes N views, turned around the z axis from --camera
+# - --views is rejected for outputs which aren't PNG, and for invalid values
+#
+# This script should return 0 on success, not-0 on error.
+
+import sys, subprocess, os, struct, zlib, math, argparse
+
+WIDTH, HEIGHT = 40, 30
+CAMERAS = ['0,0,0,55,0,25,140', '0,0,0,90,0,0,140', '0,0,0,0,0,0,140']
+
+def failquit(*args):
+    if len(args)!=0: print(*args, file=sys.stderr)
+    print('exiting viewstest.py with failure', file=sys.stderr)
+    sys.exit(1)
+
+def run(output, *options):
+    cmd = [args.openscad, inputfile, '-o', output, '--imgsize=%d,%d' % (WIDTH, HEIGHT)] + list(options) + remaining_args
+    print('Running OpenSCAD:', file=sys.stderr)
+    print(' '.join(cmd), file=sys.stderr)
+    sys.stderr.flush()
+    result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    print(result.stderr.decode(errors='replace'), file=sys.stderr)
+    return result
+
+def read(filename):
+    with open(filename, 'rb') as f:
+        return f.read()
+
+def remove(filename):
+    if os.path.exists(filename): os.unlink(filename)
+
+# Decodes an 8 bit RGB or RGBA PNG image to its size and rows of RGB pixels
+def decode_png(name, data):
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        failquit(name + ': no PNG signature')
+    pos, idat, header = 8, b'', None
+    while pos + 12 <= len(data):
+        length, = struct.unpack('>I', data[pos:pos + 4])
+        chunk_type, chunk_data = data[pos + 4:pos + 8], data[pos + 8:pos + 8 + length]
+        if chunk_type == b'IHDR': header = struct.unpack('>IIBBBBB', chunk_data)
+        elif chunk_type == b'IDAT': idat += chunk_data
+        pos += 12 + length
+    if not header:
+        failquit(name + ': no IHDR chunk')
+    width, height, bitdepth, colortype, _, _, interlace = header
+    if bitdepth != 8 or colortype not in (2, 6) or interlace != 0:
+        failquit('%s: unsupported PNG format' % name)
+    bpp = 3 if colortype == 2 else 4
+    raw = zlib.decompress(idat)
+    stride = width * bpp
+    rows, prev = [], bytearray(stride)
+    for y in range(height):
+        filter_type = raw[y * (stride + 1)]
+        row = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for x in range(stride):
+            a = row[x - bpp] if x >= bpp else 0
+            b = prev[x]
+            c = prev[x - bpp] if x >= bpp else 0
+            if filter_type == 1: row[x] = (row[x] + a) & 0xff
+            elif filter_type == 2: row[x] = (row[x] + b) & 0xff
+            elif filter_type == 3: row[x] = (row[x] + (a + b) // 2) & 0xff
+            elif filter_type == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                row[x] = (row[x] + (a if pa <= pb and pa <= pc else b if pb <= pc else c)) & 0xff
+        rows.append(bytes(px for i in range(0, stride, bpp) for px in row[i:i + 3]))
+        prev = row
+    return width, height, rows
+
+def decode(filename):
+    if not os.path.exists(filename):
+        failquit(filename + ' was not written')
+    return decode_png(filename, read(filename))
+
+# The image of a single --camera export
+def single_view(camera):
+    output = basename + '-single.png'
+    remove(output)
+    if run(output, '--camera=' + camera).returncode != 0:
+        failquit('failed to export a view with --camera=' + camera)
+    image = decode(output)
+    os.unlink(output)
+    return image
+
+# Checks numbered files against the given images, and removes them
+def check_files(output, images):
+    for i, image in enumerate(images):
+        view = output[:-4] + '%05d.png' % i
+        if decode(view) != image:
+            failquit('%s differs from the view exported on its own' % view)
+        os.unlink(view)
+    if os.path.exists(output[:-4] + '%05d.png' % len(images)):
+        failquit('more than %d views were written' % len(images))
+
+# Checks a sheet of tiles against the given images
+def check_sheet(name, sheet, images):
+    width, height, rows = sheet
+    columns = math.ceil(math.sqrt(len(images)))
+    if (width, height) != (columns * WIDTH, (len(images) + columns - 1) // columns * HEIGHT):
+        failquit('%s: sheet of %d views is %dx%d' % (name, len(images), width, height))
+    background = None
+    for i in range((height // HEIGHT) * columns):
+        x, y = i % columns * WIDTH, i // columns * HEIGHT
+        tile = [row[3 * x:3 * (x + WIDTH)] for row in rows[y:y + HEIGHT]]
+        if i < len(images):
+            if tile != images[i][2]:
+                failquit('%s: tile %d differs from the view exported on its own' % (name, i))
+            background = images[i][2][0][:3]
+        elif set(tile) != {background * WIDTH}:
+            failquit('%s: tile %d is not blank' % (name, i))
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--openscad', required=True, help='Specify OpenSCAD executable.')
+args,remaining_args = parser.parse_known_args()
+inputfile = remaining_args[0]
+basename = remaining_args[-1]
+remaining_args = remaining_args[1:-1] # Passed on to the OpenSCAD executable
+
+if not os.path.exists(inputfile):
+    failquit('cant find input file named: ' + inputfile)
+if not os.path.exists(args.openscad):
+    failquit('cant find openscad executable named: ' + args.openscad)
+
+images = [single_view(camera) for camera in CAMERAS]
+if len(set(str(image) for image in images)) != len(images):
+    failquit('the views of the model are not different')
+
+# A file for each view
+output = basename + '-files.png'
+for views, layout in [(CAMERAS[:2], []), (CAMERAS, ['--views_layout=files'])]:
+    if run(output, '--views=' + ';'.join(views), *layout).returncode != 0:
+        failquit('failed to export views to files')
+    check_files(output, images[:len(views)])
+if os.path.exists(output):
+    failquit(output + ' was written for views in files')
+
+# A sheet of three views, to a file and stdout
+output = basename + '-sheet.png'
+remove(output)
+if run(output, '--views=' + ';'.join(CAMERAS), '--views_layout=sheet').returncode != 0:
+    failquit('failed to export a sheet of views')
+check_sheet(output, decode(output), images)
+result = run('-', '--export-format=png', '--views=' + ';'.join(CAMERAS), '--views_layout=sheet')
+if result.returncode != 0 or result.stdout != read(output):
+    failquit('the sheet of views on stdout differs from the one in a file')
+os.unlink(output)
+
+# A turntable from the given camera, a quarter turn apart
+turntable = [single_view('0,0,0,55,0,%d,140' % (25 + 90 * i)) for i in range(4)]
+output = basename + '-turntable.png'
+if run(output, '--camera=' + CAMERAS[0], '--views=turntable:4').returncode != 0:
+    failquit('failed to export a turntable')
+check_files(output, turntable)
+remove(output)
+if run(output, '--camera=' + CAMERAS[0], '--views=turntable:4', '--views_layout=sheet').returncode != 0:
+    failquit('failed to export a turntable sheet')
+check_sheet(output, decode(output), turntable)
+os.unlink(output)
+
+# Outputs which can't hold views, and invalid options
+for output, options in [(basename + '-views.stl', ['--views=turntable:2']),
+                        (basename + '-views.png', ['--views=turntable:0']),
+                        (basename + '-views.png', ['--views=1,2,3']),
+                        (basename + '-views.png', ['--views=turntable:2', '--views_layout=grid'])]:
+    remove(output)
+    if run(output, *options).returncode == 0:
+        failquit('invalid views accepted: %s %s' % (output, ' '.join(options)))
+    for name in [output, output[:-4] + '00000.png', output[:-4] + '00000.stl']:
+        if os.path.exists(name):
+            failquit(name + ' was written for invalid views')
+if run('-', '--export-format=png', '--views=turntable:2').returncode == 0:
+    failquit('views in files were exported to stdout')
+
+# Only the PNG output of several gets the views
+stl, png = basename + '-mixed.stl', basename + '-mixed.png'
+remove(stl)
+cmd_result = run(png, '-o', stl, '--camera=' + CAMERAS[0], '--views=turntable:2')
+if cmd_result.returncode == 0:
+    failquit('views were accepted for an STL output')
+if os.path.exists(stl):
+    failquit(stl + ' was written with views')
+check_files(png, turntable[::2])